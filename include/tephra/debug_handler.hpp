@@ -63,8 +63,45 @@ enum class StatisticEventType {
     /// On tp::Device::enqueueJob, reports the number of bytes actually committed to job-local images for the job.
     /// May be lower than tp::StatisticEventType::JobLocalImageRequestedBytes thanks to resource aliasing and reuse.
     JobLocalImageCommittedBytes,
+    /// On tp::Device::submitQueuedJobs, reports the total number of jobs created with tp::JobFlag::CachedBarriers
+    /// submitted to the job's queue so far, that could reuse the barriers prepared for an earlier job.
+    JobBarrierCacheHits,
+    /// On tp::Device::submitQueuedJobs, reports the total number of jobs created with tp::JobFlag::CachedBarriers
+    /// submitted to the job's queue so far, that needed their barriers prepared from scratch.
+    JobBarrierCacheMisses,
+    /// On tp::Device::submitQueuedJobs, reports the estimated number of pipeline barriers saved by reordering the
+    /// commands of a job created with tp::JobFlag::ReorderCommands.
+    JobPipelineBarriersSavedByReordering,
+    /// On tp::Device::submitQueuedJobs, reports the number of buffer memory barriers of the job that were replaced by
+    /// global memory barriers, as configured by tp::JobResourcePoolSetup::globalBufferBarrierThreshold. These are not
+    /// counted towards tp::StatisticEventType::JobBufferMemoryBarriersInserted.
+    JobBufferMemoryBarriersFolded,
+    /// On tp::Device::enqueueJob, reports the CPU time in nanoseconds spent allocating the job-local resources of the
+    /// job.
+    JobResourceAllocationNanoseconds,
+    /// On tp::Device::enqueueJob, reports the CPU time in nanoseconds spent broadcasting the resource exports of the
+    /// job to the other queues.
+    JobExportBroadcastNanoseconds,
+    /// On tp::Device::submitQueuedJobs, reports the CPU time in nanoseconds spent preparing the barriers of the job.
+    JobBarrierPreparationNanoseconds,
+    /// On tp::Device::submitQueuedJobs, reports the CPU time in nanoseconds spent recording the Vulkan command buffers
+    /// of the job.
+    JobCommandRecordingNanoseconds,
+    /// On tp::Device::submitQueuedJobs, reports the CPU time in nanoseconds spent submitting the compiled jobs to the
+    /// Vulkan queue. The object name is that of the queue.
+    QueueSubmitNanoseconds,
+    /// On tp::Device::enqueueJob, reports the number of bytes freed from the job's tp::JobResourcePool by its
+    /// tp::JobResourcePoolTrimPolicy. Only reported when the policy actually freed some memory.
+    JobResourcePoolTrimmedBytes,
+    /// On tp::Device::submitQueuedJobs, reports the Vulkan pipeline stage mask at which the job waits for the jobs of
+    /// another queue. Reported once for each waited queue, using its name as the object name.
+    JobSemaphoreWaitStageMask,
+    /// On tp::Device::submitQueuedJobs, reports the number of pipeline barriers of the job that were split into a
+    /// Vulkan event signal and wait, as configured by tp::JobResourcePoolSetup::splitBarrierCommandDistance. These are
+    /// still counted towards tp::StatisticEventType::JobPipelineBarriersInserted.
+    JobPipelineBarriersSplit,
 };
-TEPHRA_MAKE_CONTIGUOUS_ENUM_VIEW(StatisticEventTypeEnumView, StatisticEventType, JobLocalImageCommittedBytes);
+TEPHRA_MAKE_CONTIGUOUS_ENUM_VIEW(StatisticEventTypeEnumView, StatisticEventType, JobPipelineBarriersSplit);
 
 /// Information about the report of a statistic event.
 struct StatisticEventInfo {
@@ -78,6 +115,25 @@ struct StatisticEventInfo {
     const char* objectName;
 };
 
+/// The counters of the statistic events reported by a tp::Device, aggregated for each tp::StatisticEventType.
+/// @see tp::Device::getStatisticCounters
+struct StatisticCounters {
+    /// The number of events reported for each type, indexed by tp::StatisticEventType.
+    uint64_t eventCounts[StatisticEventTypeEnumView::size()] = {};
+    /// The sum of the counter values of the events reported for each type, indexed by tp::StatisticEventType.
+    uint64_t counterTotals[StatisticEventTypeEnumView::size()] = {};
+
+    /// Returns the number of events reported with the given type.
+    uint64_t getEventCount(StatisticEventType type) const {
+        return eventCounts[static_cast<std::size_t>(type)];
+    }
+
+    /// Returns the sum of the counter values of the events reported with the given type.
+    uint64_t getCounterTotal(StatisticEventType type) const {
+        return counterTotals[static_cast<std::size_t>(type)];
+    }
+};
+
 /// A base class for debug report handlers, containing callbacks through which debug messages and runtime errors
 /// are reported.
 class DebugReportHandler {
@@ -492,6 +492,9 @@ struct OverallocationBehavior {
     float requestFactor;
     float growFactor;
     uint64_t minAllocationSize;
+    uint32_t demandWindowSize;
+    uint32_t targetAllocationCount;
+    float targetWasteRatio;
 
     /// Creates the specified overallocation behavior.
     ///
@@ -519,8 +522,57 @@ struct OverallocationBehavior {
     ///     The size of all allocations made by the pool so far.
     uint64_t apply(uint64_t requestedSize, uint64_t poolSize) const;
 
+    /// Applies the overallocation behavior to the requested size, also taking into account the demand observed by the
+    /// pool, returning the desired allocation size.
+    /// @param requestedSize
+    ///     The requested size of the allocation.
+    /// @param poolSize
+    ///     The size of all allocations made by the pool so far.
+    /// @param peakDemand
+    ///     The largest amount of memory the pool needed at once within the last `demandWindowSize` jobs, including
+    ///     the current one.
+    /// @remarks
+    ///     If the behavior isn't adaptive, `peakDemand` is ignored.
+    uint64_t apply(uint64_t requestedSize, uint64_t poolSize, uint64_t peakDemand) const;
+
+    /// Returns `true` if the behavior adapts to the observed demand.
+    /// @see tp::OverallocationBehavior::Adaptive
+    bool isAdaptive() const {
+        return demandWindowSize > 0;
+    }
+
     /// Creates a behavior of no overallocation that allocates exactly the requested amount.
     static OverallocationBehavior Exact();
+
+    /// Creates a behavior that chooses the allocation sizes based on the demand observed by the pool, rather than on
+    /// fixed factors. The pool keeps track of the largest amount of memory it needed at once within a moving window
+    /// of recent jobs. New allocations are then sized so that this peak demand, plus a fraction of it as headroom,
+    /// would be covered by the target number of equally sized allocations, without allocating more than the pool is
+    /// missing to reach it:
+    /// `max(requestedSize, min(ceil(targetPoolSize / targetAllocationCount), targetPoolSize - poolSize),
+    /// minAllocationSize)`
+    /// where `targetPoolSize = peakDemand * (1 + targetWasteRatio)` and `poolSize` is the sum of all allocations made
+    /// by the pool.
+    ///
+    /// @param demandWindowSize
+    ///     The number of most recent jobs whose demand is considered. Must be at least 1.
+    /// @param targetAllocationCount
+    ///     The number of allocations the peak demand should be split into. Smaller values result in fewer, larger
+    ///     allocations. Must be at least 1.
+    /// @param targetWasteRatio
+    ///     The fraction of the peak demand that may be allocated on top of it as headroom for future growth.
+    /// @param minAllocationSize
+    ///     The size of the smallest allocation allowed to be made. The units are dependent on the specific pool.
+    /// @remarks
+    ///     Demand is tracked by the pools of job-local and preinitialized buffers of tp::JobResourcePool, where it is
+    ///     also reported by tp::JobResourcePoolStatistics, and by tp::utils::AutoRingBuffer, where each call to
+    ///     tp::utils::AutoRingBuffer::pop counts as the end of a job. Other pools treat adaptive behaviors as if
+    ///     `requestFactor` and `growFactor` were both 1.
+    static OverallocationBehavior Adaptive(
+        uint32_t demandWindowSize = 16,
+        uint32_t targetAllocationCount = 1,
+        float targetWasteRatio = 0.25f,
+        uint64_t minAllocationSize = 65536);
 };
 
 /// Used as configuration for creating a new tp::DescriptorPool object.
@@ -91,6 +91,8 @@ struct DeviceSetup {
     const VkFeatureMap* vkFeatureMap;
     MemoryAllocatorSetup memoryAllocatorSetup;
     void* vkCreateInfoExtPtr;
+    uint32_t recordingThreadCount;
+    ArrayView<const DeviceQueue> backgroundCompileQueues;
 
     /// @param physicalDevice
     ///     The physical device used by the Device. It needs to be one of the pointers returned by
@@ -111,6 +113,24 @@ struct DeviceSetup {
     ///     The configuration of the device-wide Vulkan Memory Allocator.
     /// @param vkCreateInfoExtPtr
     ///     The pointer to additional Vulkan setup structure to be passed in `pNext` of @vksymbol{VkDeviceCreateInfo}.
+    /// @param recordingThreadCount
+    ///     The number of worker threads the Device spawns for recording the command buffers of submitted jobs in
+    ///     parallel. Set to 0 to record all jobs on the thread calling tp::Device::submitQueuedJobs.
+    ///     Jobs created with tp::JobFlag::ParallelRecording will also use these threads to record their own commands.
+    /// @param backgroundCompileQueues
+    ///     A subset of `queues` that will each get a dedicated thread compiling the jobs enqueued to them in the
+    ///     background, as soon as they get enqueued. tp::Device::submitQueuedJobs then only waits for the compilation
+    ///     to finish and submits the recorded command buffers, hiding the compilation cost behind the application's
+    ///     own work.
+    /// @remarks
+    ///     Jobs compiled in the background still use deferred command lists the same way, but those jobs only get
+    ///     compiled once their submission is requested. Callbacks of inline passes get invoked from the background
+    ///     thread.
+    /// @remarks
+    ///     Jobs compiled in the background can't account for the semaphores passed to tp::Device::submitQueuedJobs.
+    ///     If the jobs waited on only in this way export resources to the queue, the submit throws
+    ///     tp::UnsupportedOperationError, as those resources wouldn't get acquired. Pass such semaphores to
+    ///     tp::Device::enqueueJob instead.
     /// @remarks
     ///     The number of requested queues of a particular type can be greater than the number of queues exposed
     ///     by the physical device, as long as at least one queue is exposed. In that case the "logical" queues will
@@ -121,7 +141,9 @@ struct DeviceSetup {
         ArrayView<const char* const> extensions = {},
         const VkFeatureMap* vkFeatureMap = nullptr,
         MemoryAllocatorSetup memoryAllocatorSetup = {},
-        void* vkCreateInfoExtPtr = nullptr);
+        void* vkCreateInfoExtPtr = nullptr,
+        uint32_t recordingThreadCount = 0,
+        ArrayView<const DeviceQueue> backgroundCompileQueues = {});
 };
 
 /// Represents a connection to a tp::PhysicalDevice, through which its functionality can be accessed.
@@ -339,6 +361,10 @@ public:
     ///     tp::Device::submitQueuedJobs before this job gets submitted. The same applies to `waitExternalSemaphores`,
     ///     which must have a signalling operation submitted before this job.
     /// @remarks
+    ///     The job waits on `waitJobSemaphores` at the top of the pipe, which also orders all jobs submitted to the
+    ///     queue after it behind the waited work. Jobs created with tp::JobFlag::NarrowSemaphoreWaits only wait at the
+    ///     stages of their dependent accesses instead, see its description for the requirements on the later jobs.
+    /// @remarks
     ///     It is recommended to call tp::Device::submitQueuedJobs within a reasonable timeframe.
     ///     Jobs that are hanging in the enqueued state may prevent some resources from being deallocated.
     JobSemaphore enqueueJob(
@@ -348,6 +374,40 @@ public:
         ArrayParameter<const ExternalSemaphore> waitExternalSemaphores = {},
         ArrayParameter<const ExternalSemaphore> signalExternalSemaphores = {});
 
+    /// Enqueues the given tp::Job created with tp::JobFlag::Reusable to the specified queue, keeping the ownership
+    /// of the handle with the user so that it can be enqueued again later.
+    ///
+    /// On the first call, the job's local resources get created and the job transitions to the enqueued state just
+    /// like with tp::Device::enqueueJob. Its commands get compiled once, when the job first gets submitted with
+    /// tp::Device::submitQueuedJobs, and the resulting command buffers get reused by all subsequent submissions.
+    ///
+    /// @param queue
+    ///     The queue that the job will be submitted to. The queue must match the queue used for creating the
+    ///     tp::JobResourcePool object that is the parent of the enqueued job.
+    /// @param job
+    ///     The tp::Job object to enqueue. It must have been created with tp::JobFlag::Reusable.
+    /// @param waitJobSemaphores
+    ///     A list of job semaphores that this submission of the job will wait on before executing on the device.
+    /// @param waitExternalSemaphores
+    ///     A list of external semaphores this submission of the job will wait on before executing on the device.
+    /// @param signalExternalSemaphores
+    ///     A list of external semaphores this submission of the job will signal once it finishes executing.
+    /// @returns
+    ///     Returns a job semaphore that will be signalled once this submission of the job finishes executing.
+    /// @remarks
+    ///     The job must have been submitted through tp::Device::submitQueuedJobs before it can be enqueued again,
+    ///     otherwise tp::UnsupportedOperationError is thrown. Its previous submissions don't need to have finished
+    ///     executing.
+    /// @remarks
+    ///     No more commands may be recorded to the job after it has been enqueued for the first time. The job's
+    ///     resources are released once the handle is destroyed and all of its submissions have finished executing.
+    JobSemaphore enqueueReusableJob(
+        const DeviceQueue& queue,
+        Job& job,
+        ArrayParameter<const JobSemaphore> waitJobSemaphores = {},
+        ArrayParameter<const ExternalSemaphore> waitExternalSemaphores = {},
+        ArrayParameter<const ExternalSemaphore> signalExternalSemaphores = {});
+
     /// Submits all tp::Job objects previously enqueued to the specified queue and schedules them to be executed
     /// on the device.
     /// @param queue
@@ -364,6 +424,12 @@ public:
     ///     This method is **not** thread-safe between calls with the same `queue` parameter. However, through the
     ///     use of the `lastJobToSubmit` parameter, it is safe to enqueue jobs asynchronously to submitting them within
     ///     the same queue.
+    /// @remarks
+    ///     For queues listed in tp::DeviceSetup::backgroundCompileQueues, the jobs have already been compiled in the
+    ///     background after being enqueued and this method only waits for their compilation to finish. If the
+    ///     compilation of a job has thrown an exception, it gets rethrown here after all the jobs were submitted. The
+    ///     failed job gets submitted without any commands, so its semaphore still gets signalled, but the resources
+    ///     it accesses are left in an unspecified state.
     void submitQueuedJobs(
         const DeviceQueue& queue,
         const JobSemaphore& lastJobToSubmit = {},
@@ -516,6 +582,16 @@ public:
     ///     tp::MemoryLocation.
     MemoryHeapStatistics getMemoryHeapStatistics(uint32_t memoryHeapIndex) const;
 
+    /// Returns a snapshot of the counters of all statistic events reported by this device so far, aggregated for each
+    /// tp::StatisticEventType.
+    /// @remarks
+    ///     The counters are only gathered when #TEPHRA_ENABLE_DEBUG_STATISTIC_EVENTS is defined, otherwise they all
+    ///     remain zero. They do not depend on tp::DebugReportHandler::callbackStatisticEvent being implemented.
+    /// @remarks
+    ///     The counters are updated without locking. A snapshot taken while other threads report events may include
+    ///     only some of them.
+    StatisticCounters getStatisticCounters() const;
+
     /// Returns the Vulkan @vksymbol{VkDevice} handle.
     VkDeviceHandle vkGetDeviceHandle() const;
 
@@ -20,6 +20,59 @@ enum class JobFlag {
     /// Hints that the job will not take a significant amount of time or resources when executed on the device.
     /// This may allow optimizations that aim to reduce the overhead of a job submission.
     Small,
+    /// Allows the commands of the job to be recorded in parallel. The job gets cut at the boundaries of its pipeline
+    /// barriers into segments that are recorded on separate threads into their own primary command buffers. Only has
+    /// an effect when the device was created with a non-zero tp::DeviceSetup::recordingThreadCount.
+    /// @remarks
+    ///     Recommended for large jobs with many compute or render passes, where the cost of recording outweighs the
+    ///     overhead of the additional command buffers.
+    ParallelRecording,
+    /// Allows the job to be enqueued repeatedly with tp::Device::enqueueReusableJob. Its commands get compiled to
+    /// Vulkan command buffers only once, on its first submission. Each further submission only compares the states of
+    /// the job's resources to the ones the compiled commands expect and inserts a barrier to resolve any difference.
+    /// @remarks
+    ///     Reusable jobs cannot allocate job-local buffers, images or acceleration structures, build acceleration
+    ///     structures or write queries, either directly or in the command lists they execute.
+    /// @remarks
+    ///     Recommended for static workloads that get submitted many times, such as post-processing chains.
+    Reusable,
+    /// Allows the barriers prepared for the job to be reused by later jobs submitted to the same queue with the same
+    /// structure, meaning the same sequence of commands accessing the same resource ranges, where the resources start
+    /// out in the same states. The analysis of the job's accesses can then be skipped, but it still needs to be
+    /// inspected to find a matching set of barriers.
+    /// @remarks
+    ///     Jobs that receive resources exported from other queues always have their barriers prepared from scratch.
+    /// @remarks
+    ///     Recommended for jobs that get recorded the same way over and over, such as the per-frame jobs of a renderer.
+    CachedBarriers,
+    /// Allows the commands of the job to be reordered before compilation to reduce the number of pipeline barriers
+    /// needed between them. Transfer commands and compute and render passes may get moved ahead of the commands that
+    /// precede them, as long as they don't access any of the same resource ranges as them in a conflicting way.
+    /// Exports, imports, discards, debug labels, queries and acceleration structure operations are kept in place and
+    /// no command gets moved across them.
+    /// @remarks
+    ///     The resource accesses of compute and render passes are only known from the accesses declared when
+    ///     executing them. The passes must not access any other resources, that aren't synchronized by other means.
+    ReorderCommands,
+    /// Identifies the resource accesses of each command as it gets recorded, instead of during the compilation of the
+    /// job. This moves most of the work of analyzing the accesses from the thread that submits the job to the thread
+    /// that records it, at the cost of some additional memory used for storing the accesses.
+    /// @remarks
+    ///     Recommended for large jobs recorded on worker threads, when compilation on the submitting thread becomes the
+    ///     bottleneck.
+    PrecomputedAccesses,
+    /// Lets the job wait on the job semaphores of other queues only at the pipeline stages where it accesses resources
+    /// exported from those queues, writes to any resource or transitions the layout of an image, instead of at the
+    /// top of the pipe. This allows the earlier stages of the job to overlap with the waited work.
+    /// @remarks
+    ///     The semaphore waits of a job also order the jobs submitted to the same queue after it. With this flag,
+    ///     later jobs are only ordered after the waited work at the stages of this job's accesses. They must not
+    ///     write to resources that the waited queues may still be accessing at any other stage, unless they wait on
+    ///     those queues themselves.
+    /// @remarks
+    ///     Recommended for jobs consuming the results of async compute in their late pipeline stages, such as
+    ///     graphics jobs sampling the produced textures in fragment shaders.
+    NarrowSemaphoreWaits,
 };
 TEPHRA_MAKE_ENUM_BIT_MASK(JobFlagMask, JobFlag)
 
@@ -44,7 +97,8 @@ struct JobData;
 /// @remarks
 ///     All methods of tp::Job and tp::Device::enqueueJob also access the parent tp::JobResourcePool that the job was
 ///     created from. This access must be synchronized - no two threads may operate on jobs that were created from
-///     the same pool at the same time.
+///     the same pool at the same time. Recording commands into sub-jobs created with tp::Job::createSubJob is exempt
+///     from this requirement.
 ///
 /// @see tp::JobResourcePool::createJob
 /// @see tp::Device::enqueueJob
@@ -141,6 +195,27 @@ public:
     /// @see @vksymbol{VkCommandPool}
     CommandPool* createCommandPool(const char* debugName = nullptr);
 
+    /// Creates a sub-job that records a separate stream of commands, to be merged into this job later with
+    /// tp::Job::mergeSubJobs.
+    /// @remarks
+    ///     Commands can be recorded into different sub-jobs of the same job from multiple threads at the same time,
+    ///     without synchronizing with each other or with the parent tp::JobResourcePool. Creating the sub-job and
+    ///     merging it must still be synchronized like any other method of this job.
+    /// @remarks
+    ///     Sub-jobs may use the job-local resources of this job, but they cannot allocate resources or command pools
+    ///     of their own, build acceleration structures or create further sub-jobs.
+    /// @remarks
+    ///     Sub-jobs cannot be enqueued. A sub-job that gets destroyed without being merged discards its commands.
+    Job createSubJob();
+
+    /// Appends the commands recorded in the given sub-jobs to this job, in the order of the array.
+    /// @param subJobs
+    ///     The sub-jobs created from this job with tp::Job::createSubJob. They are consumed by the merge and left in
+    ///     a null state.
+    /// @remarks
+    ///     Recording into the sub-jobs must be finished before they are merged.
+    void mergeSubJobs(ArrayView<Job> subJobs);
+
     /// Prepares a buffer for future read-only usages.
     ///
     /// Makes the results of all previous accesses of the resource in this queue visible to the specified future read
@@ -246,9 +321,13 @@ public:
     /// @param data
     ///     The data to update. The length of the array defines the size of the range to be updated.
     /// @remarks
-    ///     The size of the data array must be less or equal to 65536 bytes. For larger updates, use
-    ///     tp::HostWritableMemory. A copy of the data is made upon this call, which is later copied again to a Vulkan
-    ///     command buffer. It should therefore only be used for very small amounts of data.
+    ///     Data larger than tp::JobResourcePoolSetup::stagedUpdateThreshold is written to a preinitialized buffer right
+    ///     away and copied from it with @vksymbol{vkCmdCopyBuffer}. Consecutive updates of the same buffer get
+    ///     combined into a single copy. Smaller updates make a copy of the data upon this call, which is later copied
+    ///     again to a Vulkan command buffer.
+    /// @remarks
+    ///     Sub-jobs created with tp::Job::createSubJob never stage their updates. The size of the data array must then
+    ///     be less or equal to 65536 bytes.
     /// @remarks
     ///     The size of the `data` array must be a multiple of 4 and smaller or equal to the size of `dstBuffer`.
     /// @see @vksymbol{vkCmdUpdateBuffer}
@@ -599,10 +678,62 @@ enum class JobResourcePoolFlag {
     /// @remarks
     ///     This can be useful for debugging, since it allows passing debug names to those Vulkan resources as long as
     ///     #TEPHRA_ENABLE_DEBUG_NAMES and tp::ApplicationExtension::EXT_DebugUtils are enabled.
-    DisableSuballocation
+    DisableSuballocation,
+    /// Normally, job-local images can only alias the array layers of images with matching type, usage, format,
+    /// extent, mip level count and sample level. By specifying this flag, job-local images are instead created as
+    /// separate Vulkan images placed into shared blocks of device memory, so that any job-local images whose usage
+    /// doesn't overlap within the job can alias the same memory regardless of their properties.
+    /// @remarks
+    ///     This can significantly reduce the memory footprint of jobs with many differently sized transient images,
+    ///     at the cost of creating new Vulkan images every time the job is enqueued.
+    /// @remarks
+    ///     The contents of job-local images are undefined at the start of the job. With this flag, the first access
+    ///     of each job-local image must also write to it, otherwise it may still be in use by another job-local
+    ///     image aliasing the same memory.
+    /// @remarks
+    ///     Images whose memory type can't be spanned by a buffer to track their accesses fall back to aliasing
+    ///     through array layers as if the flag wasn't specified.
+    /// @remarks
+    ///     Ignored if tp::JobResourcePoolFlag::DisableSuballocation is also specified.
+    AliasImageMemory
 };
 TEPHRA_MAKE_ENUM_BIT_MASK(JobResourcePoolFlagMask, JobResourcePoolFlag)
 
+/// Specifies when a tp::JobResourcePool should free its unused backing allocations on its own, without having to call
+/// tp::JobResourcePool::trim manually.
+/// @see tp::JobResourcePoolSetup
+struct JobResourcePoolTrimPolicy {
+    uint32_t unusedJobCount;
+    float heapUsageHighWatermark;
+    float heapUsageLowWatermark;
+
+    /// @param unusedJobCount
+    ///     If not zero, the backing allocations of job-local buffers, images and acceleration structures that haven't
+    ///     been used by any of the last `unusedJobCount` jobs enqueued from the pool get freed once the device is done
+    ///     with them. Each enqueue of a tp::JobFlag::Reusable job counts as one job.
+    /// @param heapUsageHighWatermark
+    ///     If not zero, all unused backing allocations of the pool, including those of preinitialized buffers, get
+    ///     freed whenever the process usage of the tp::MemoryLocation::DeviceLocal memory heap exceeds this fraction
+    ///     of its budget after allocating the resources of an enqueued job.
+    /// @param heapUsageLowWatermark
+    ///     After the pool has freed memory due to `heapUsageHighWatermark`, it won't be trimmed for that reason again
+    ///     until the process usage of the heap falls below this fraction of its budget. Must be less than or equal
+    ///     to `heapUsageHighWatermark`.
+    /// @remarks
+    ///     The usage of the heap is measured across the whole process, so the pool may get trimmed due to memory
+    ///     allocated elsewhere. The low watermark prevents the pool from then freeing and reallocating its backing
+    ///     memory on every job.
+    /// @remarks
+    ///     The heap budget is only accurate when tp::DeviceExtension::EXT_MemoryBudget is enabled.
+    explicit JobResourcePoolTrimPolicy(
+        uint32_t unusedJobCount,
+        float heapUsageHighWatermark = 0.0f,
+        float heapUsageLowWatermark = 0.0f);
+
+    /// Creates a policy that never trims the pool automatically.
+    static JobResourcePoolTrimPolicy Manual();
+};
+
 /// Used as configuration for creating a new tp::JobResourcePool object.
 /// @see tp::Device::createJobResourcePool
 struct JobResourcePoolSetup {
@@ -611,6 +742,10 @@ struct JobResourcePoolSetup {
     OverallocationBehavior bufferOverallocationBehavior;
     OverallocationBehavior preinitBufferOverallocationBehavior;
     OverallocationBehavior descriptorOverallocationBehavior;
+    uint32_t globalBufferBarrierThreshold;
+    uint64_t stagedUpdateThreshold;
+    JobResourcePoolTrimPolicy trimPolicy;
+    uint32_t splitBarrierCommandDistance;
 
     /// @param queue
     ///     The device queue that the pool will be associated to. Jobs allocated from this pool can then only be
@@ -623,12 +758,34 @@ struct JobResourcePoolSetup {
     ///     The overallocation behavior of preinitialized buffers.
     /// @param descriptorOverallocationBehavior
     ///     The overallocation behavior of job-local descriptor sets.
+    /// @param globalBufferBarrierThreshold
+    ///     The maximum number of buffer memory barriers recorded within a single Vulkan pipeline barrier of a job.
+    ///     If a pipeline barrier would need more of them, they get replaced by a single global memory barrier.
+    /// @remarks
+    ///     Many implementations don't synchronize individual buffer ranges any more precisely than a global memory
+    ///     barrier would, but building a large number of buffer memory barriers still costs CPU time. Buffer memory
+    ///     barriers that transfer queue family ownership are always kept. Use `~0` to never replace them.
+    /// @param stagedUpdateThreshold
+    ///     The size in bytes above which the data passed to tp::Job::cmdUpdateBuffer gets written to a preinitialized
+    ///     buffer and copied from there, instead of being recorded into the command buffer. Use `~0` to never stage
+    ///     the updates.
+    /// @param trimPolicy
+    ///     The policy for automatically freeing unused backing allocations of the pool. By default, the pool only
+    ///     gets trimmed through explicit calls to tp::JobResourcePool::trim.
+    /// @param splitBarrierCommandDistance
+    ///     The minimum number of independent commands between the source accesses of a barrier and its first dependent
+    ///     command for the barrier to get split into a Vulkan event signal and wait. Fewer commands are unlikely to
+    ///     hide the cost of the event. Use `~0` to never split barriers.
     JobResourcePoolSetup(
         DeviceQueue queue,
         JobResourcePoolFlagMask flags = {},
         OverallocationBehavior bufferOverallocationBehavior = { 1.25f, 1.5f, 65536 },
         OverallocationBehavior preinitBufferOverallocationBehavior = { 3.0f, 1.5f, 65536 },
-        OverallocationBehavior descriptorOverallocationBehavior = { 3.0f, 1.5f, 128 });
+        OverallocationBehavior descriptorOverallocationBehavior = { 3.0f, 1.5f, 128 },
+        uint32_t globalBufferBarrierThreshold = 64,
+        uint64_t stagedUpdateThreshold = 4096,
+        JobResourcePoolTrimPolicy trimPolicy = JobResourcePoolTrimPolicy::Manual(),
+        uint32_t splitBarrierCommandDistance = 2);
 };
 
 /// Contains statistics about the current allocations of a tp::JobResourcePool.
@@ -646,17 +803,41 @@ struct JobResourcePoolStatistics {
     uint32_t preinitBufferAllocationCount;
     /// The size of all backing allocations made for preinitialized buffers.
     uint64_t preinitBufferAllocationBytes;
+    /// The largest number of bytes committed to the job-local buffers of a single job within the demand window of
+    /// tp::JobResourcePoolSetup::bufferOverallocationBehavior, or of the last job if the behavior isn't adaptive.
+    uint64_t bufferDemandBytes;
+    /// The size of the most recent backing allocation made for job-local buffers.
+    uint64_t bufferLastAllocationBytes;
+    /// The largest number of bytes of preinitialized buffers in use by jobs in flight at once within the demand
+    /// window of tp::JobResourcePoolSetup::preinitBufferOverallocationBehavior, or as of the last job if the behavior
+    /// isn't adaptive.
+    uint64_t preinitBufferDemandBytes;
+    /// The size of the most recent backing allocation made for preinitialized buffers.
+    uint64_t preinitBufferLastAllocationBytes;
 
     /// The total size of all backing allocations made for all job resources.
     uint64_t getTotalAllocationBytes() const {
         return bufferAllocationBytes + imageAllocationBytes + preinitBufferAllocationBytes;
     }
+
+    /// The size of the backing allocations made for job-local and preinitialized buffers in excess of their demand.
+    uint64_t getBufferWastedBytes() const {
+        uint64_t wastedBytes = 0;
+        if (bufferAllocationBytes > bufferDemandBytes)
+            wastedBytes += bufferAllocationBytes - bufferDemandBytes;
+        if (preinitBufferAllocationBytes > preinitBufferDemandBytes)
+            wastedBytes += preinitBufferAllocationBytes - preinitBufferDemandBytes;
+        return wastedBytes;
+    }
 };
 
 /// Manages the job-local resources used by tp::Job objects created from it. Enables efficient allocation and reuse
 /// of these resources between consecutive jobs. Jobs created from a tp::JobResourcePool can only be enqueued to the
 /// same device queue that the pool was created for, allowing the allocator to better reuse resources. Similar jobs
 /// that are submitted periodically therefore benefit from being allocated from the same tp::JobResourcePool.
+/// @remarks
+///     The memory backing the job-local resources of a job can be reused by the next enqueued job even while the
+///     previous one is still executing. Synchronization between them is handled by the barriers of the next job.
 /// @see tp::Device::createJobResourcePool
 class JobResourcePool : public Ownable {
 public:
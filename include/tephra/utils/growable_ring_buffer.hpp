@@ -138,6 +138,8 @@ namespace utils {
 
         /// Frees all of the allocations with a timestamp value less or equal to `upToTimestamp`, allowing their memory
         /// regions to be reused.
+        /// @remarks
+        ///     Each call also marks the end of a job for the purposes of an adaptive tp::OverallocationBehavior.
         void pop(uint64_t upToTimestamp);
 
         /// Attempts to free up unused memory regions. Returns the number of bytes freed.
@@ -163,6 +165,10 @@ namespace utils {
             return growableBuffer.getAllocationSize();
         }
 
+        /// Returns the largest total size of allocations in bytes observed right before a call to
+        /// tp::utils::AutoRingBuffer::pop, within the demand window of the overallocation behavior.
+        uint64_t getPeakDemand() const;
+
     private:
         tp::Device* device;
         tp::BufferUsageMask usage;
@@ -173,6 +179,7 @@ namespace utils {
         GrowableRingBuffer growableBuffer;
         std::vector<tp::OwningPtr<tp::Buffer>> regionBuffers;
         std::deque<uint64_t> allocationTimestamps;
+        std::deque<uint64_t> demandSamples;
     };
 
 }
@@ -63,6 +63,7 @@ using VkDescriptorSetLayoutHandle = VkObjectHandle<VkDescriptorSetLayout, VK_OBJ
 using VkDescriptorUpdateTemplateHandle =
     VkObjectHandle<VkDescriptorUpdateTemplate, VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE>;
 using VkDeviceHandle = VkObjectHandle<VkDevice, VK_OBJECT_TYPE_DEVICE>;
+using VkEventHandle = VkObjectHandle<VkEvent, VK_OBJECT_TYPE_EVENT>;
 using VkImageHandle = VkObjectHandle<VkImage, VK_OBJECT_TYPE_IMAGE>;
 using VkImageViewHandle = VkObjectHandle<VkImageView, VK_OBJECT_TYPE_IMAGE_VIEW>;
 using VkAccelerationStructureHandleKHR =
@@ -1,6 +1,7 @@
 
 #include "buffer_impl.hpp"
 #include "device/device_container.hpp"
+#include "job/local_buffers.hpp"
 #include <tephra/format_compatibility.hpp>
 
 namespace tp {
@@ -27,6 +28,8 @@ BufferImpl::BufferImpl(
 
     if (bufferSetup.usage.containsAny(BufferUsage::DeviceAddress | BufferUsage::AccelerationStructureInputKHR))
         deviceAddress = deviceImpl->getLogicalDevice()->getBufferDeviceAddress(this->bufferHandle.vkGetHandle());
+
+    resourceId = deviceImpl->getResourceIdAllocator()->allocateId(this->bufferHandle.vkGetHandle());
 }
 
 MemoryLocation BufferImpl::getMemoryLocation_() const {
@@ -85,6 +88,10 @@ void BufferImpl::destroyHandles(bool immediately) {
     }
     texelViewHandleMap.clear();
 
+    // Non-owned handles don't go through the deferred destructor, which would otherwise recycle the resource id
+    if (bufferHandle.isNonOwning())
+        deviceImpl->getResourceIdAllocator()->freeId(bufferHandle.vkGetHandle());
+
     bufferHandle.destroyHandle(immediately);
     memoryAllocationHandle.destroyHandle(immediately);
 }
@@ -107,6 +114,24 @@ BufferImpl& BufferImpl::getBufferImpl(const BufferView& bufferView) {
     return *std::get<BufferImpl*>(bufferView.buffer);
 }
 
+BufferView BufferImpl::getWholeBufferView(const BufferView& bufferView, uint64_t* offset) {
+    TEPHRA_ASSERT(!bufferView.isNull());
+    *offset = bufferView.offset;
+    if (bufferView.viewsJobLocalBuffer()) {
+        return std::get<JobLocalBufferImpl*>(bufferView.buffer)->getDefaultView();
+    } else {
+        return getBufferImpl(bufferView).getDefaultView_();
+    }
+}
+
+uint32_t BufferImpl::resolveResourceId(const BufferView& bufferView) {
+    if (bufferView.viewsJobLocalBuffer()) {
+        return getBufferImpl(JobLocalBufferImpl::getViewToUnderlyingBuffer(bufferView)).getResourceId();
+    } else {
+        return getBufferImpl(bufferView).getResourceId();
+    }
+}
+
 uint64_t BufferImpl::getRequiredViewAlignment_(
     const DeviceContainer* deviceImpl,
     BufferUsageMask usage,
@@ -83,12 +83,24 @@ public:
         return bufferHandle.vkGetHandle();
     }
 
+    // Returns the compact device-wide id used to index the buffer's synchronization state
+    uint32_t getResourceId() const {
+        return resourceId;
+    }
+
     void destroyHandles(bool immediately);
 
     static VkBufferViewHandle vkGetBufferViewHandle(const BufferView& bufferView);
 
     static BufferImpl& getBufferImpl(const BufferView& bufferView);
 
+    // Returns the view of the whole buffer that the given view is a part of, including job-local buffers, along with
+    // the offset of the given view within it
+    static BufferView getWholeBufferView(const BufferView& bufferView, uint64_t* offset);
+
+    // Returns the resource id of the buffer the view ultimately refers to, resolving job-local buffers
+    static uint32_t resolveResourceId(const BufferView& bufferView);
+
     static uint64_t getRequiredViewAlignment_(
         const DeviceContainer* deviceImpl,
         BufferUsageMask usage,
@@ -109,6 +121,7 @@ private:
     Lifeguard<VkBufferHandle> bufferHandle;
     BufferSetup bufferSetup;
     DeviceAddress deviceAddress = 0;
+    uint32_t resourceId;
 
     TexelViewHandleMap texelViewHandleMap;
     // For internal synchronization of memory mapping. In most cases the memory is coherent and the mutex won't be used
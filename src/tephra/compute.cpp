@@ -21,7 +21,7 @@ void ComputeList::beginRecording(CommandPool* commandPool) {
     VkCommandBufferBeginInfo beginInfo;
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.pNext = nullptr;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.flags = commandPool->getCommandBufferUsage();
     beginInfo.pInheritanceInfo = nullptr;
 
     throwRetcodeErrors(vkiCommands->beginCommandBuffer(vkCommandBufferHandle, &beginInfo));
@@ -104,6 +104,14 @@ void ComputeList::cmdPipelineBarrier(
 
 void ComputeList::cmdWriteTimestamp(const TimestampQuery& query, PipelineStage stage) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "cmdWriteTimestamp", nullptr);
+    if constexpr (TephraValidationEnabled) {
+        if (queryRecorder->isRecordingReusable()) {
+            reportDebugMessage(
+                DebugMessageSeverity::Error,
+                DebugMessageType::Validation,
+                "Timestamp queries cannot be used in command lists executed by a Job created with JobFlag::Reusable.");
+        }
+    }
     queryRecorder->sampleTimestampQuery(
         vkiCommands, vkCommandBufferHandle, QueryRecorder::getQueryHandle(query), stage, 1);
 }
@@ -205,7 +205,13 @@ void reportDebugMessageRaw(
 #endif
 
 #ifdef TEPHRA_ENABLE_DEBUG_STATISTIC_EVENTS
-void reportStatisticEvent(StatisticEventType type, uint64_t counter, const char* objectName) {
+void reportStatisticEvent(
+    StatisticAggregator* aggregator,
+    StatisticEventType type,
+    uint64_t counter,
+    const char* objectName) {
+    aggregator->addEvent(type, counter);
+
     auto context = DebugContext::getCurrentContext();
     if (context != nullptr) {
         context->reportStatisticEvent(type, counter, objectName);
@@ -2,6 +2,8 @@
 
 #include <tephra/debug_handler.hpp>
 #include <tephra/errors.hpp>
+#include <atomic>
+#include <chrono>
 #include <memory>
 
 #ifdef TEPHRA_ENABLE_DEBUG
@@ -273,10 +275,63 @@ template <typename... TArgs>
 void reportDebugMessage(DebugMessageSeverity severity, DebugMessageType type, const TArgs&... args) noexcept {}
 #endif
 
+// Aggregates the counters of the statistic events reported within a device. Events may get reported from multiple
+// threads, so the counters are atomic and only updated with relaxed ordering
+class StatisticAggregator {
+public:
+    void addEvent(StatisticEventType type, uint64_t counter) {
+        auto typeIndex = static_cast<std::size_t>(type);
+        eventCounts[typeIndex].fetch_add(1, std::memory_order_relaxed);
+        counterTotals[typeIndex].fetch_add(counter, std::memory_order_relaxed);
+    }
+
+    StatisticCounters getSnapshot() const {
+        StatisticCounters snapshot;
+        for (std::size_t typeIndex = 0; typeIndex < StatisticEventTypeEnumView::size(); typeIndex++) {
+            snapshot.eventCounts[typeIndex] = eventCounts[typeIndex].load(std::memory_order_relaxed);
+            snapshot.counterTotals[typeIndex] = counterTotals[typeIndex].load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+private:
+    std::atomic<uint64_t> eventCounts[StatisticEventTypeEnumView::size()] = {};
+    std::atomic<uint64_t> counterTotals[StatisticEventTypeEnumView::size()] = {};
+};
+
+// Measures the CPU time elapsed since its construction for timing statistic events. Doesn't read the clock at all
+// when statistic events are disabled
+class StatisticTimer {
+public:
+    StatisticTimer() {
+        if constexpr (StatisticEventsEnabled)
+            startTime = std::chrono::steady_clock::now();
+    }
+
+    uint64_t getElapsedNanoseconds() const {
+        if constexpr (StatisticEventsEnabled) {
+            auto elapsed = std::chrono::steady_clock::now() - startTime;
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+        return 0;
+    }
+
+private:
+    std::chrono::steady_clock::time_point startTime;
+};
+
 #ifdef TEPHRA_ENABLE_DEBUG_STATISTIC_EVENTS
-void reportStatisticEvent(StatisticEventType type, uint64_t counter, const char* objectName = nullptr);
+void reportStatisticEvent(
+    StatisticAggregator* aggregator,
+    StatisticEventType type,
+    uint64_t counter,
+    const char* objectName = nullptr);
 #else
-inline void reportStatisticEvent(StatisticEventType type, uint64_t counter, const char* objectName = nullptr) {}
+inline void reportStatisticEvent(
+    StatisticAggregator* aggregator,
+    StatisticEventType type,
+    uint64_t counter,
+    const char* objectName = nullptr) {}
 #endif
 
 }
@@ -4,7 +4,12 @@
 namespace tp {
 
 OverallocationBehavior::OverallocationBehavior(float requestFactor, float growFactor, uint64_t minAllocationSize)
-    : requestFactor(requestFactor), growFactor(growFactor), minAllocationSize(minAllocationSize) {}
+    : requestFactor(requestFactor),
+      growFactor(growFactor),
+      minAllocationSize(minAllocationSize),
+      demandWindowSize(0),
+      targetAllocationCount(1),
+      targetWasteRatio(0.0f) {}
 
 uint64_t OverallocationBehavior::apply(uint64_t requestedSize, uint64_t poolSize) const {
     uint64_t request = std::max(static_cast<uint64_t>(requestedSize * requestFactor), requestedSize);
@@ -12,10 +17,36 @@ uint64_t OverallocationBehavior::apply(uint64_t requestedSize, uint64_t poolSize
     return std::max(std::max(request, growth), minAllocationSize);
 }
 
+uint64_t OverallocationBehavior::apply(uint64_t requestedSize, uint64_t poolSize, uint64_t peakDemand) const {
+    if (!isAdaptive())
+        return apply(requestedSize, poolSize);
+
+    // Split the peak demand along with its headroom into the target number of equally sized allocations, but only
+    // allocate what the pool is still missing to reach that size
+    uint64_t targetPoolSize = static_cast<uint64_t>(peakDemand * (1.0 + std::max(targetWasteRatio, 0.0f)));
+    uint64_t allocationCount = std::max(targetAllocationCount, 1u);
+    uint64_t targetSize = (targetPoolSize + allocationCount - 1) / allocationCount;
+    uint64_t missingSize = targetPoolSize > poolSize ? targetPoolSize - poolSize : 0;
+    return std::max(std::max(requestedSize, std::min(targetSize, missingSize)), minAllocationSize);
+}
+
 OverallocationBehavior OverallocationBehavior::Exact() {
     return OverallocationBehavior(1.0f, 1.0f, 0);
 }
 
+OverallocationBehavior OverallocationBehavior::Adaptive(
+    uint32_t demandWindowSize,
+    uint32_t targetAllocationCount,
+    float targetWasteRatio,
+    uint64_t minAllocationSize) {
+    // The factors only apply to pools that don't track their demand
+    OverallocationBehavior behavior = OverallocationBehavior(1.0f, 1.0f, minAllocationSize);
+    behavior.demandWindowSize = std::max(demandWindowSize, 1u);
+    behavior.targetAllocationCount = std::max(targetAllocationCount, 1u);
+    behavior.targetWasteRatio = targetWasteRatio;
+    return behavior;
+}
+
 DescriptorPoolSetup::DescriptorPoolSetup(OverallocationBehavior overallocationBehavior)
     : overallocationBehavior(overallocationBehavior) {}
 
@@ -12,12 +12,14 @@ CommandPool::CommandPool(
       commandPoolPool(commandPoolPool),
       queueType(queueType),
       queryRecorder(queryRecorder),
+      vkCommandBufferUsage(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT),
       usedPrimaryBuffers(0),
       usedSecondaryBuffers(0) {}
 
 void CommandPool::reset() {
     commandPoolPool->resetCommandPool(vkCommandPoolHandle, false);
     queryRecorder.reset();
+    vkCommandBufferUsage = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     usedPrimaryBuffers = 0;
     usedSecondaryBuffers = 0;
 }
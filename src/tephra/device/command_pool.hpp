@@ -27,6 +27,18 @@ public:
     // Returns a free secondary command buffer handle, allocating new ones if necessary
     VkCommandBufferHandle acquireSecondaryCommandBuffer(const char* debugName);
 
+    // Returns the usage flags that command buffers acquired from this pool should begin recording with
+    VkCommandBufferUsageFlags getCommandBufferUsage() const {
+        return vkCommandBufferUsage;
+    }
+
+    // Allows the command buffers recorded from this pool to be submitted repeatedly, even while they are still
+    // pending execution. Lasts until the pool is reset
+    void makeCommandBuffersReusable() {
+        vkCommandBufferUsage = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+        queryRecorder.markReusable();
+    }
+
     // Returns the associated query recorder
     QueryRecorder& getQueryRecorder() {
         return queryRecorder;
@@ -47,6 +59,7 @@ private:
     CommandPoolPool* commandPoolPool;
     QueueType queueType;
     QueryRecorder queryRecorder;
+    VkCommandBufferUsageFlags vkCommandBufferUsage;
     std::vector<VkCommandBufferHandle> primaryBuffers;
     uint32_t usedPrimaryBuffers;
     std::vector<VkCommandBufferHandle> secondaryBuffers;
@@ -6,113 +6,206 @@
 
 namespace tp {
 
-template <typename TResourceAccess>
-void CrossQueueSync::broadcastResourceExport(
-    const JobSemaphore& semaphore,
-    const TResourceAccess& exportedAccess,
-    uint32_t dstQueueFamilyIndex) {
-    uint32_t srcQueueFamilyIndex = deviceImpl->getQueueMap()->getQueueInfo(semaphore.queue).queueFamilyIndex;
+bool doesExportContainAnother(
+    const QueueExportLog::ExportEntry& exportEntry,
+    const QueueExportLog::ExportEntry& other) {
+    if (std::holds_alternative<NewBufferAccess>(exportEntry.access)) {
+        return doesAccessRangeContainAnother(
+            std::get<NewBufferAccess>(exportEntry.access).range, std::get<NewBufferAccess>(other.access).range);
+    } else {
+        return doesAccessRangeContainAnother(
+            std::get<NewImageAccess>(exportEntry.access).range, std::get<NewImageAccess>(other.access).range);
+    }
+}
 
-    std::lock_guard<Mutex> resourceLock(mutex);
-    std::vector<ExportEntry>& resourceEntry = exportedResources[exportedAccess.vkResourceHandle];
+QueueExportLog::QueueExportLog(std::vector<uint32_t> queueFamilyIndices)
+    : queueFamilyIndices(std::move(queueFamilyIndices)), queriedTimestamps(this->queueFamilyIndices.size(), 0) {}
+
+void QueueExportLog::addExport(const ExportEntry& exportEntry) {
+    VkResourceHandle vkResourceHandle = getResourceHandle(exportEntry);
+    std::lock_guard<Mutex> logLock(mutex);
+
+    // Supersede fully overlapped exports of the same resource, stopping once all of its live exports were visited
+    uint32_t& liveExportCount = liveExportCounts[vkResourceHandle];
+    uint32_t exportsToVisit = liveExportCount;
+    for (auto it = exports.rbegin(); it != exports.rend() && exportsToVisit > 0; ++it) {
+        if (!it->isLive || getResourceHandle(it->entry) != vkResourceHandle)
+            continue;
+
+        exportsToVisit--;
+        if (it->entry.semaphore.timestamp <= exportEntry.semaphore.timestamp &&
+            doesExportContainAnother(exportEntry, it->entry)) {
+            it->isLive = false;
+            liveExportCount--;
+            deadExportCount++;
+        }
+    }
+    liveExportCount++;
+
+    // Exports of a queue arrive in timestamp order, so this will almost always insert at the end
+    auto insertIt = exports.end();
+    while (insertIt != exports.begin() &&
+           std::prev(insertIt)->entry.semaphore.timestamp > exportEntry.semaphore.timestamp)
+        --insertIt;
+    exports.insert(insertIt, LoggedExport{ exportEntry, true });
+}
 
-    // Check for and remove fully overlapping accesses
-    auto removeIt = std::remove_if(resourceEntry.begin(), resourceEntry.end(), [&exportedAccess](const auto& entry) {
-        return doesAccessRangeContainAnother(exportedAccess.range, std::get<TResourceAccess>(entry.access).range);
-    });
-    resourceEntry.erase(removeIt, resourceEntry.end());
+void QueueExportLog::queryExports(
+    uint64_t fromTimestamp,
+    uint64_t toTimestamp,
+    uint32_t dstQueueIndex,
+    ScratchVector<ExportEntry>& incomingExports) {
+    uint32_t dstQueueFamilyIndex = queueFamilyIndices[dstQueueIndex];
+    std::lock_guard<Mutex> logLock(mutex);
 
-    // Add the new entry
-    ExportEntry newEntry{ semaphore, exportedAccess, srcQueueFamilyIndex, dstQueueFamilyIndex };
-    resourceEntry.push_back(newEntry);
+    auto comp = [](uint64_t value, const LoggedExport& element) {
+        return value < element.entry.semaphore.timestamp;
+    };
+    auto startIt = std::upper_bound(exports.begin(), exports.end(), fromTimestamp, comp);
+    for (auto it = startIt; it != exports.end() && it->entry.semaphore.timestamp <= toTimestamp; ++it) {
+        ExportEntry& exportEntry = it->entry;
+        if (it->isLive && exportEntry.dstQueueFamilyIndex == dstQueueFamilyIndex) {
+            incomingExports.push_back(exportEntry);
+            // Assume the queue family ownership transfer will be done upon return
+            exportEntry.currentQueueFamilyIndex = exportEntry.dstQueueFamilyIndex;
+        }
+    }
 
-    // And add it to the export cache - assume it should be near the end of the sorted list
-    ExportCacheEntry cacheEntry{ semaphore, dstQueueFamilyIndex, exportedAccess.vkResourceHandle };
+    queriedTimestamps[dstQueueIndex] = tp::max(queriedTimestamps[dstQueueIndex], toTimestamp);
+    trimExports();
+}
+
+bool QueueExportLog::hasExports(uint64_t fromTimestamp, uint64_t toTimestamp, uint32_t dstQueueIndex) {
+    uint32_t dstQueueFamilyIndex = queueFamilyIndices[dstQueueIndex];
+    std::lock_guard<Mutex> logLock(mutex);
+
+    auto comp = [](uint64_t value, const LoggedExport& element) {
+        return value < element.entry.semaphore.timestamp;
+    };
+    auto startIt = std::upper_bound(exports.begin(), exports.end(), fromTimestamp, comp);
+    for (auto it = startIt; it != exports.end() && it->entry.semaphore.timestamp <= toTimestamp; ++it) {
+        if (it->isLive && it->entry.dstQueueFamilyIndex == dstQueueFamilyIndex)
+            return true;
+    }
+    return false;
+}
+
+void QueueExportLog::forgetResource(const VkResourceHandle& vkResourceHandle) {
+    std::lock_guard<Mutex> logLock(mutex);
+    auto countIt = liveExportCounts.find(vkResourceHandle);
+    if (countIt == liveExportCounts.end())
+        return;
+
+    for (LoggedExport& loggedExport : exports) {
+        if (loggedExport.isLive && getResourceHandle(loggedExport.entry) == vkResourceHandle) {
+            loggedExport.isLive = false;
+            deadExportCount++;
+        }
+    }
+    liveExportCounts.erase(countIt);
+    trimExports();
+}
+
+void QueueExportLog::trimExports() {
+    while (!exports.empty()) {
+        LoggedExport& loggedExport = exports.front();
+        if (loggedExport.isLive) {
+            if (!isQueriedByAllDstQueues(loggedExport.entry))
+                break;
 
-    if (exportCache.size() >= ExportCacheSize) {
-        exportCache.pop_front();
+            auto countIt = liveExportCounts.find(getResourceHandle(loggedExport.entry));
+            TEPHRA_ASSERT(countIt != liveExportCounts.end());
+            if (--countIt->second == 0)
+                liveExportCounts.erase(countIt);
+        } else {
+            deadExportCount--;
+        }
+        exports.pop_front();
     }
 
-    auto insertIt = exportCache.rbegin();
-    for (; insertIt != exportCache.rend(); ++insertIt) {
-        if (insertIt->semaphore.timestamp <= semaphore.timestamp)
-            break;
+    // A queue that doesn't query for a while can hold back the trimming of dead exports behind its own
+    if (deadExportCount > exports.size() / 2) {
+        auto removeIt = std::remove_if(
+            exports.begin(), exports.end(), [](const LoggedExport& loggedExport) { return !loggedExport.isLive; });
+        exports.erase(removeIt, exports.end());
+        deadExportCount = 0;
     }
+}
 
-    exportCache.insert(insertIt.base(), cacheEntry);
+bool QueueExportLog::isQueriedByAllDstQueues(const ExportEntry& exportEntry) const {
+    for (std::size_t queueIndex = 0; queueIndex < queueFamilyIndices.size(); queueIndex++) {
+        if (queueFamilyIndices[queueIndex] == exportEntry.dstQueueFamilyIndex &&
+            queriedTimestamps[queueIndex] < exportEntry.semaphore.timestamp)
+            return false;
+    }
+    return true;
+}
+
+QueueExportLog::VkResourceHandle QueueExportLog::getResourceHandle(const ExportEntry& exportEntry) {
+    if (std::holds_alternative<NewBufferAccess>(exportEntry.access))
+        return std::get<NewBufferAccess>(exportEntry.access).vkResourceHandle;
+    else
+        return std::get<NewImageAccess>(exportEntry.access).vkResourceHandle;
+}
+
+CrossQueueSync::CrossQueueSync(DeviceContainer* deviceImpl) : deviceImpl(deviceImpl) {
+    std::vector<uint32_t> queueFamilyIndices;
+    for (const QueueInfo& queueInfo : deviceImpl->getQueueMap()->getQueueInfos()) {
+        queueFamilyIndices.push_back(queueInfo.queueFamilyIndex);
+    }
+
+    for (std::size_t queueIndex = 0; queueIndex < queueFamilyIndices.size(); queueIndex++) {
+        queueExportLogs.push_back(std::make_unique<QueueExportLog>(queueFamilyIndices));
+    }
+}
+
+template <typename TResourceAccess>
+void CrossQueueSync::broadcastResourceExport(
+    const JobSemaphore& semaphore,
+    const TResourceAccess& exportedAccess,
+    uint32_t dstQueueFamilyIndex) {
+    uint32_t srcQueueIndex = deviceImpl->getQueueMap()->getQueueUniqueIndex(semaphore.queue);
+    uint32_t srcQueueFamilyIndex = deviceImpl->getQueueMap()->getQueueInfos()[srcQueueIndex].queueFamilyIndex;
+
+    ExportEntry newEntry{ semaphore, exportedAccess, srcQueueFamilyIndex, dstQueueFamilyIndex };
+    queueExportLogs[srcQueueIndex]->addExport(newEntry);
 }
 
 template <typename TResourceHandle>
 void CrossQueueSync::broadcastResourceForget(const TResourceHandle& vkResourceHandle) {
-    {
-        std::lock_guard<Mutex> resourceLock(mutex);
-        exportedResources.erase(vkResourceHandle);
+    for (std::unique_ptr<QueueExportLog>& exportLog : queueExportLogs) {
+        exportLog->forgetResource(vkResourceHandle);
     }
 
-    // Remove it from per-queue synchronization state as well
+    // Recycle its id and remove it from per-queue synchronization state as well
+    uint32_t resourceId = deviceImpl->getResourceIdAllocator()->freeId(vkResourceHandle);
+    if (resourceId == ResourceIdAllocator::InvalidId)
+        return;
+
     for (uint32_t queueIndex = 0; queueIndex < deviceImpl->getQueueMap()->getQueueInfos().size(); queueIndex++) {
-        deviceImpl->getQueueState(queueIndex)->forgetResource(vkResourceHandle);
+        deviceImpl->getQueueState(queueIndex)->forgetResource(vkResourceHandle, resourceId);
     }
 }
 
 void CrossQueueSync::queryIncomingExports(
     ArrayParameter<const TimelinePeriod> periods,
-    uint32_t dstQueueFamilyIndex,
+    uint32_t dstQueueIndex,
     ScratchVector<ExportEntry>& incomingExports) {
-    std::lock_guard<Mutex> resourceLock(mutex);
-
-    auto isSemaphoreInRange = [&](const JobSemaphore& semaphore) -> bool {
-        for (const TimelinePeriod& period : periods) {
-            if (period.srcQueue == semaphore.queue && semaphore.timestamp > period.fromTimestamp &&
-                semaphore.timestamp <= period.toTimestamp)
-                return true;
-        }
-        return false;
-    };
-
-    auto processExports = [&](std::vector<ExportEntry>& resourceEntry) {
-        for (ExportEntry& exportEntry : resourceEntry) {
-            // Consider only relevant entries
-            if (exportEntry.dstQueueFamilyIndex == dstQueueFamilyIndex && isSemaphoreInRange(exportEntry.semaphore)) {
-                incomingExports.push_back(exportEntry);
-                // Assume the queue family ownership transfer will be done upon return
-                exportEntry.currentQueueFamilyIndex = exportEntry.dstQueueFamilyIndex;
-            }
-        }
-    };
-
-    // Iterate over exports within the largest from - to timestamp range
-    uint64_t minFromTimestamp = ~0;
-    uint64_t maxToTimestamp = 0;
+    // Only the logs of the queried timelines need to be locked
     for (const TimelinePeriod& period : periods) {
-        minFromTimestamp = tp::min(minFromTimestamp, period.fromTimestamp);
-        maxToTimestamp = tp::max(maxToTimestamp, period.toTimestamp);
+        uint32_t srcQueueIndex = deviceImpl->getQueueMap()->getQueueUniqueIndex(period.srcQueue);
+        queueExportLogs[srcQueueIndex]->queryExports(
+            period.fromTimestamp, period.toTimestamp, dstQueueIndex, incomingExports);
     }
+}
 
-    auto comp = [](uint64_t value, const ExportCacheEntry& element) {
-        return value < element.semaphore.timestamp;
-    };
-    auto startIt = std::upper_bound(exportCache.begin(), exportCache.end(), minFromTimestamp, comp);
-    if (startIt == exportCache.begin() && exportCache.size() >= ExportCacheSize) {
-        // Outside the range of the cache, fall back to iterating over all resources
-        for (auto& el : exportedResources)
-            processExports(el.second);
-    } else {
-        // Iterate over the relevant range of the cache
-        for (auto it = startIt; it != exportCache.end(); ++it) {
-            const ExportCacheEntry& entry = *it;
-            if (entry.semaphore.timestamp > maxToTimestamp)
-                break;
-
-            if (entry.dstQueueFamilyIndex == dstQueueFamilyIndex && isSemaphoreInRange(entry.semaphore)) {
-                auto entryHit = exportedResources.find(entry.vkResourceHandle);
-                if (entryHit != exportedResources.end()) {
-                    // Otherwise the entry was forgotten, but is still in cache
-                    processExports(entryHit->second);
-                }
-            }
-        }
+bool CrossQueueSync::hasIncomingExports(ArrayParameter<const TimelinePeriod> periods, uint32_t dstQueueIndex) {
+    for (const TimelinePeriod& period : periods) {
+        uint32_t srcQueueIndex = deviceImpl->getQueueMap()->getQueueUniqueIndex(period.srcQueue);
+        if (queueExportLogs[srcQueueIndex]->hasExports(period.fromTimestamp, period.toTimestamp, dstQueueIndex))
+            return true;
     }
+    return false;
 }
 
 template void CrossQueueSync::broadcastResourceExport(
@@ -4,6 +4,7 @@
 #include "../job/accesses.hpp"
 #include "../job/barriers.hpp"
 #include "../common_impl.hpp"
+#include <deque>
 #include <variant>
 #include <vector>
 #include <unordered_map>
@@ -16,8 +17,10 @@ struct TimelinePeriod {
     uint64_t toTimestamp = 0; // Inclusive
 };
 
-// Handles synchronization of resource state across queues as well as queue family ownership transfers
-class CrossQueueSync {
+// Timestamp-ordered log of the resource exports broadcast by a single source queue. Querying a timeline period
+// binary searches the log instead of going over every exported resource. Each log has its own lock, so that queues
+// exporting to and querying from different timelines don't contend with each other
+class QueueExportLog {
 public:
     // An exported resource range
     struct ExportEntry {
@@ -27,7 +30,65 @@ public:
         uint32_t dstQueueFamilyIndex;
     };
 
-    explicit CrossQueueSync(DeviceContainer* deviceImpl) : deviceImpl(deviceImpl) {}
+    using VkResourceHandle = std::variant<VkBufferHandle, VkImageHandle>;
+
+    // Takes the queue family index of every queue of the device, indexed by the queue's unique index
+    explicit QueueExportLog(std::vector<uint32_t> queueFamilyIndices);
+
+    // Adds a new export, superseding older exports of the same resource whose ranges it fully contains
+    void addExport(const ExportEntry& exportEntry);
+
+    // Appends the exports within the (fromTimestamp, toTimestamp] period that are meant for the queue family of the
+    // given queue to incomingExports. Exports get dropped from the log once all queues of their destination family
+    // have queried them
+    void queryExports(
+        uint64_t fromTimestamp,
+        uint64_t toTimestamp,
+        uint32_t dstQueueIndex,
+        ScratchVector<ExportEntry>& incomingExports);
+
+    // Returns true if there are any live exports within the (fromTimestamp, toTimestamp] period that are meant for
+    // the queue family of the given queue, without marking them as queried
+    bool hasExports(uint64_t fromTimestamp, uint64_t toTimestamp, uint32_t dstQueueIndex);
+
+    // Removes all exports of the given resource
+    void forgetResource(const VkResourceHandle& vkResourceHandle);
+
+    TEPHRA_MAKE_NONCOPYABLE(QueueExportLog);
+    TEPHRA_MAKE_NONMOVABLE(QueueExportLog);
+    ~QueueExportLog() = default;
+
+private:
+    struct LoggedExport {
+        ExportEntry entry;
+        // Becomes false once the export gets superseded or its resource forgotten
+        bool isLive;
+    };
+
+    std::vector<uint32_t> queueFamilyIndices;
+    // The timestamp up to which each queue has queried this log
+    std::vector<uint64_t> queriedTimestamps;
+    std::deque<LoggedExport> exports;
+    std::size_t deadExportCount = 0;
+    // The number of live exports of each resource, so that resources without any can be skipped quickly
+    std::unordered_map<VkResourceHandle, uint32_t> liveExportCounts;
+    Mutex mutex;
+
+    // Drops exports from the front of the log that are no longer needed, compacting it if too many dead exports
+    // remain behind live ones
+    void trimExports();
+
+    bool isQueriedByAllDstQueues(const ExportEntry& exportEntry) const;
+
+    static VkResourceHandle getResourceHandle(const ExportEntry& exportEntry);
+};
+
+// Handles synchronization of resource state across queues as well as queue family ownership transfers
+class CrossQueueSync {
+public:
+    using ExportEntry = QueueExportLog::ExportEntry;
+
+    explicit CrossQueueSync(DeviceContainer* deviceImpl);
 
     // Export a resource access to a given queue family
     template <typename TResourceAccess>
@@ -40,29 +101,21 @@ public:
     template <typename TResourceHandle>
     void broadcastResourceForget(const TResourceHandle& vkResourceHandle);
 
-    // Gives incoming exports from given queue timelines. Entries that need a queue family ownership transfer
-    // are required to be transferred.
+    // Gives incoming exports to the given queue from the given queue timelines. Entries that need a queue family
+    // ownership transfer are required to be transferred.
     void queryIncomingExports(
         ArrayParameter<const TimelinePeriod> periods,
-        uint32_t dstQueueFamilyIndex,
+        uint32_t dstQueueIndex,
         ScratchVector<ExportEntry>& incomingExports);
 
-private:
-    using VkResourceHandle = std::variant<VkBufferHandle, VkImageHandle>;
-
-    struct ExportCacheEntry {
-        JobSemaphore semaphore;
-        uint32_t dstQueueFamilyIndex;
-        VkResourceHandle vkResourceHandle;
-    };
-    static constexpr std::size_t ExportCacheSize = 1024;
+    // Returns true if the given queue has any incoming exports from the given queue timelines that it hasn't queried
+    // yet, without querying them
+    bool hasIncomingExports(ArrayParameter<const TimelinePeriod> periods, uint32_t dstQueueIndex);
 
+private:
     DeviceContainer* deviceImpl;
-    std::unordered_map<VkResourceHandle, std::vector<ExportEntry>> exportedResources;
-    // Stores recent exports sorted by timestamp for fast access
-    std::deque<ExportCacheEntry> exportCache;
-    // TODO: May need to be lockless?
-    mutable Mutex mutex;
+    // The exports broadcast by each queue, indexed by its unique index
+    std::vector<std::unique_ptr<QueueExportLog>> queueExportLogs;
 };
 
 }
@@ -6,13 +6,16 @@
 #include "cross_queue_sync.hpp"
 #include "query_manager.hpp"
 #include "queue_state.hpp"
+#include "resource_id_allocator.hpp"
 #include "queue_map.hpp"
 #include "timeline_manager.hpp"
 #include "command_pool.hpp"
+#include "../utils/thread_pool.hpp"
 #include "../application/application_container.hpp"
 #include "../common_impl.hpp"
 #include <tephra/device.hpp>
 #include <tephra/physical_device.hpp>
+#include <algorithm>
 
 namespace tp {
 
@@ -31,11 +34,19 @@ public:
           timelineManager(this),
           queryManager(this) {
         // Initialize queue states
+        ArrayView<const DeviceQueue> compileQueues = deviceSetup.backgroundCompileQueues;
         for (uint32_t queueIndex = 0; queueIndex < queueMap.getQueueInfos().size(); queueIndex++) {
-            queueStates.push_back(std::make_unique<QueueState>(this, queueIndex));
+            const DeviceQueue& queue = queueMap.getQueueInfos()[queueIndex].identifier;
+            bool compileInBackground = std::find(compileQueues.begin(), compileQueues.end(), queue) !=
+                compileQueues.end();
+            queueStates.push_back(std::make_unique<QueueState>(this, queueIndex, compileInBackground));
         }
 
         timelineManager.initializeQueueSemaphores(static_cast<uint32_t>(queueStates.size()));
+
+        if (deviceSetup.recordingThreadCount > 0) {
+            recordingThreadPool = std::make_unique<ThreadPool>(deviceSetup.recordingThreadCount);
+        }
     }
 
     const DebugTarget* getDebugTarget() const {
@@ -102,6 +113,10 @@ public:
         return &crossQueueSync;
     }
 
+    ResourceIdAllocator* getResourceIdAllocator() {
+        return &resourceIdAllocator;
+    }
+
     const TimelineManager* getTimelineManager() const {
         return &timelineManager;
     }
@@ -114,6 +129,19 @@ public:
         return &queryManager;
     }
 
+    // Returns the pool of threads for recording jobs in parallel, or nullptr if parallel recording is disabled
+    ThreadPool* getRecordingThreadPool() {
+        return recordingThreadPool.get();
+    }
+
+    StatisticAggregator* getStatisticAggregator() {
+        return &statisticAggregator;
+    }
+
+    const StatisticAggregator* getStatisticAggregator() const {
+        return &statisticAggregator;
+    }
+
     const QueueState* getQueueState(uint32_t queueUniqueIndex) const {
         return queueStates[queueUniqueIndex].get();
     }
@@ -137,11 +165,14 @@ private:
     LogicalDevice logicalDevice;
     MemoryAllocator memoryAllocator;
     CommandPoolPool commandPoolPool;
+    ResourceIdAllocator resourceIdAllocator;
     CrossQueueSync crossQueueSync;
     std::vector<std::unique_ptr<QueueState>> queueStates;
     DeferredDestructor deferredDestructor;
     TimelineManager timelineManager;
     QueryManager queryManager;
+    std::unique_ptr<ThreadPool> recordingThreadPool;
+    StatisticAggregator statisticAggregator;
 };
 
 }
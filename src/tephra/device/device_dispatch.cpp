@@ -12,6 +12,7 @@
 #include "../common_impl.hpp"
 #include <tephra/device.hpp>
 #include <tephra/application.hpp>
+#include <algorithm>
 
 namespace tp {
 
@@ -37,13 +38,17 @@ DeviceSetup::DeviceSetup(
     ArrayView<const char* const> extensions,
     const VkFeatureMap* vkFeatureMap,
     MemoryAllocatorSetup memoryAllocatorSetup,
-    void* vkCreateInfoExtPtr)
+    void* vkCreateInfoExtPtr,
+    uint32_t recordingThreadCount,
+    ArrayView<const DeviceQueue> backgroundCompileQueues)
     : physicalDevice(physicalDevice),
       queues(queues),
       extensions(extensions),
       vkFeatureMap(vkFeatureMap),
       memoryAllocatorSetup(memoryAllocatorSetup),
-      vkCreateInfoExtPtr(vkCreateInfoExtPtr) {}
+      vkCreateInfoExtPtr(vkCreateInfoExtPtr),
+      recordingThreadCount(recordingThreadCount),
+      backgroundCompileQueues(backgroundCompileQueues) {}
 
 void validateRequestedDeviceQueues(const DeviceSetup& deviceSetup) {
     // Validate queue support
@@ -90,6 +95,15 @@ void validateRequestedDeviceQueues(const DeviceSetup& deviceSetup) {
         }
     }
 
+    for (DeviceQueue queue : deviceSetup.backgroundCompileQueues) {
+        if (std::find(deviceSetup.queues.begin(), deviceSetup.queues.end(), queue) == deviceSetup.queues.end()) {
+            reportDebugMessage(
+                DebugMessageSeverity::Error,
+                DebugMessageType::Validation,
+                "A queue requested for background compilation is not one of the requested queues.");
+        }
+    }
+
     // Extensions and features will be validated by Vulkan validation layers
 }
 
@@ -473,23 +487,13 @@ OwningPtr<AccelerationStructure> Device::allocateCompactedAccelerationStructureK
         deviceImpl, sizeQuery.getLastResult().value, std::move(asBuilder), debugName);
 }
 
-JobSemaphore Device::enqueueJob(
+JobSemaphore enqueueJobImpl(
+    DeviceContainer* deviceImpl,
     const DeviceQueue& queue,
     Job job,
     ArrayParameter<const JobSemaphore> waitJobSemaphores,
     ArrayParameter<const ExternalSemaphore> waitExternalSemaphores,
     ArrayParameter<const ExternalSemaphore> signalExternalSemaphores) {
-    auto deviceImpl = static_cast<DeviceContainer*>(this);
-
-#ifdef TEPHRA_ENABLE_DEBUG_CONTEXTS
-    const char* debugJobName = JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName();
-    // The job will get destroyed during this function, we need to extend the lifetime of the object name
-    std::string debugJobNameString;
-    if (debugJobName != nullptr)
-        debugJobNameString = debugJobName;
-    TEPHRA_DEBUG_SET_CONTEXT(deviceImpl->getDebugTarget(), "enqueueJob", debugJobNameString.c_str());
-#endif
-
     JobData* jobData = JobResourcePoolContainer::getJobData(job);
     uint32_t queueIndex = deviceImpl->getQueueMap()->getQueueUniqueIndex(queue);
 
@@ -511,6 +515,13 @@ JobSemaphore Device::enqueueJob(
                 ").");
         }
 
+        if (jobData->parentJob != nullptr) {
+            reportDebugMessage(
+                DebugMessageSeverity::Error,
+                DebugMessageType::Validation,
+                "Sub-jobs cannot be enqueued, they must be merged into their parent job with Job::mergeSubJobs.");
+        }
+
         for (const auto& semaphore : waitJobSemaphores) {
             uint32_t semaphoreQueueIndex = deviceImpl->getQueueMap()->getQueueUniqueIndex(semaphore.queue);
             if (queueIndex == ~0) {
@@ -571,6 +582,87 @@ JobSemaphore Device::enqueueJob(
     return signalSemaphore;
 }
 
+JobSemaphore Device::enqueueJob(
+    const DeviceQueue& queue,
+    Job job,
+    ArrayParameter<const JobSemaphore> waitJobSemaphores,
+    ArrayParameter<const ExternalSemaphore> waitExternalSemaphores,
+    ArrayParameter<const ExternalSemaphore> signalExternalSemaphores) {
+    auto deviceImpl = static_cast<DeviceContainer*>(this);
+
+#ifdef TEPHRA_ENABLE_DEBUG_CONTEXTS
+    const char* debugJobName = JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName();
+    // The job will get destroyed during this function, we need to extend the lifetime of the object name
+    std::string debugJobNameString;
+    if (debugJobName != nullptr)
+        debugJobNameString = debugJobName;
+    TEPHRA_DEBUG_SET_CONTEXT(deviceImpl->getDebugTarget(), "enqueueJob", debugJobNameString.c_str());
+#endif
+
+    if constexpr (TephraValidationEnabled) {
+        if (JobResourcePoolContainer::getJobData(job)->flags.contains(JobFlag::Reusable)) {
+            reportDebugMessage(
+                DebugMessageSeverity::Warning,
+                DebugMessageType::Performance,
+                "The Job was created with JobFlag::Reusable, but enqueued with enqueueJob. Use enqueueReusableJob "
+                "to take advantage of its reuse.");
+        }
+    }
+
+    return enqueueJobImpl(
+        deviceImpl,
+        queue,
+        std::move(job),
+        waitJobSemaphores,
+        waitExternalSemaphores,
+        signalExternalSemaphores);
+}
+
+JobSemaphore Device::enqueueReusableJob(
+    const DeviceQueue& queue,
+    Job& job,
+    ArrayParameter<const JobSemaphore> waitJobSemaphores,
+    ArrayParameter<const ExternalSemaphore> waitExternalSemaphores,
+    ArrayParameter<const ExternalSemaphore> signalExternalSemaphores) {
+    auto deviceImpl = static_cast<DeviceContainer*>(this);
+    TEPHRA_DEBUG_SET_CONTEXT(
+        deviceImpl->getDebugTarget(),
+        "enqueueReusableJob",
+        JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName());
+
+    JobData* jobData = JobResourcePoolContainer::getJobData(job);
+    if constexpr (TephraValidationEnabled) {
+        if (!jobData->flags.contains(JobFlag::Reusable)) {
+            reportDebugMessage(
+                DebugMessageSeverity::Error,
+                DebugMessageType::Validation,
+                "The Job was not created with JobFlag::Reusable.");
+        }
+    }
+
+    // The enqueued handle only gets released once it has been submitted. Enqueueing it again before then would
+    // overwrite the semaphores of the pending submission, so this can't be allowed in any build
+    if (jobData->handleCount > 1) {
+        throw UnsupportedOperationError(
+            "The Job is still enqueued from a previous call that hasn't been submitted yet. Call submitQueuedJobs "
+            "before enqueueing it again.");
+    }
+
+    // Semaphores only apply to a single submission of the job
+    jobData->semaphores.jobWaits.clear();
+    jobData->semaphores.externalWaits.clear();
+    jobData->semaphores.externalSignals.clear();
+
+    // Enqueue another handle to the same job, the user's handle keeps it alive for further submissions
+    return enqueueJobImpl(
+        deviceImpl,
+        queue,
+        JobResourcePoolContainer::acquireJobReference(job),
+        waitJobSemaphores,
+        waitExternalSemaphores,
+        signalExternalSemaphores);
+}
+
 void Device::submitQueuedJobs(
     const DeviceQueue& queue,
     const JobSemaphore& lastJobToSubmit,
@@ -792,6 +884,11 @@ MemoryHeapStatistics Device::getMemoryHeapStatistics(uint32_t memoryHeapIndex) c
     return stats;
 }
 
+StatisticCounters Device::getStatisticCounters() const {
+    auto deviceImpl = static_cast<const DeviceContainer*>(this);
+    return deviceImpl->getStatisticAggregator()->getSnapshot();
+}
+
 VkDeviceHandle Device::vkGetDeviceHandle() const {
     auto deviceImpl = static_cast<const DeviceContainer*>(this);
     return deviceImpl->getLogicalDevice()->vkGetDeviceHandle();
@@ -828,6 +925,11 @@ void DeviceContainer::updateDeviceProgress_() {
 
 DeviceContainer::~DeviceContainer() {
     TEPHRA_DEBUG_SET_CONTEXT_DESTRUCTOR(getDebugTarget());
+
+    // The compilation threads use the rest of the device, so they must be stopped first
+    for (std::unique_ptr<QueueState>& queueState : queueStates) {
+        queueState->stopBackgroundCompilation();
+    }
 }
 
 // Template declarations for vkMakeHandleLifeguard
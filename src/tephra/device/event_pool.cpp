@@ -0,0 +1,39 @@
+#include "event_pool.hpp"
+
+namespace tp {
+
+VkEventHandle EventPool::acquireEvent(uint64_t jobTimestamp) {
+    TEPHRA_ASSERT(usedEvents.empty() || usedEvents.back().first <= jobTimestamp);
+
+    VkEventHandle vkEventHandle;
+    if (!freeEvents.empty()) {
+        vkEventHandle = freeEvents.back();
+        freeEvents.pop_back();
+    } else {
+        vkEventHandle = logicalDevice->createEvent();
+    }
+
+    usedEvents.emplace_back(jobTimestamp, vkEventHandle);
+    return vkEventHandle;
+}
+
+void EventPool::recycleEvents(uint64_t reachedTimestamp) {
+    while (!usedEvents.empty() && usedEvents.front().first <= reachedTimestamp) {
+        // The events were left signaled by the finished job
+        VkEventHandle vkEventHandle = usedEvents.front().second;
+        logicalDevice->resetEvent(vkEventHandle);
+        freeEvents.push_back(vkEventHandle);
+        usedEvents.pop_front();
+    }
+}
+
+EventPool::~EventPool() {
+    for (VkEventHandle vkEventHandle : freeEvents) {
+        logicalDevice->destroyEvent(vkEventHandle);
+    }
+    for (auto& [jobTimestamp, vkEventHandle] : usedEvents) {
+        logicalDevice->destroyEvent(vkEventHandle);
+    }
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "logical_device.hpp"
+#include "../common_impl.hpp"
+#include <deque>
+#include <vector>
+
+namespace tp {
+
+// Recycles the events used for splitting barriers of jobs submitted to a single queue. Events are tagged with the
+// timestamp of the job that uses them and become available again once that timestamp is reached. Must only be used by
+// the thread submitting to the queue.
+class EventPool {
+public:
+    explicit EventPool(LogicalDevice* logicalDevice) : logicalDevice(logicalDevice) {}
+
+    // Returns an unsignaled event to be used by the job with the given timestamp
+    VkEventHandle acquireEvent(uint64_t jobTimestamp);
+
+    // Resets the events used by jobs up to the given reached timestamp, making them available for reuse
+    void recycleEvents(uint64_t reachedTimestamp);
+
+    TEPHRA_MAKE_NONCOPYABLE(EventPool);
+    TEPHRA_MAKE_NONMOVABLE(EventPool);
+    ~EventPool();
+
+private:
+    LogicalDevice* logicalDevice;
+    std::vector<VkEventHandle> freeEvents;
+    // Events in use along with the timestamp of the job using them, in increasing timestamp order
+    std::deque<std::pair<uint64_t, VkEventHandle>> usedEvents;
+};
+
+}
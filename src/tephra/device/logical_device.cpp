@@ -595,6 +595,26 @@ void LogicalDevice::signalSemaphore(VkSemaphoreHandle vkSemaphoreHandle, uint64_
     throwRetcodeErrors(vkiDevice.signalSemaphore(vkDeviceHandle, &signalInfo));
 }
 
+VkEventHandle LogicalDevice::createEvent() {
+    VkEventCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO;
+    createInfo.pNext = nullptr;
+    // Events get reset from the host before being reused, so they can't be device only
+    createInfo.flags = 0;
+
+    VkEvent vkEventHandle;
+    throwRetcodeErrors(vkiDevice.createEvent(vkDeviceHandle, &createInfo, nullptr, &vkEventHandle));
+    return VkEventHandle(vkEventHandle);
+}
+
+void LogicalDevice::destroyEvent(VkEventHandle vkEventHandle) noexcept {
+    vkiDevice.destroyEvent(vkDeviceHandle, vkEventHandle, nullptr);
+}
+
+void LogicalDevice::resetEvent(VkEventHandle vkEventHandle) {
+    throwRetcodeErrors(vkiDevice.resetEvent(vkDeviceHandle, vkEventHandle));
+}
+
 void LogicalDevice::queueSubmit(uint32_t queueIndex, const SubmitBatch& submitBatch) {
     ScratchVector<VkTimelineSemaphoreSubmitInfo> vkSemaphoreSubmitInfos;
     vkSemaphoreSubmitInfos.reserve(submitBatch.submitEntries.size());
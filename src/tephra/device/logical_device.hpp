@@ -162,6 +162,12 @@ public:
 
     void signalSemaphore(VkSemaphoreHandle vkSemaphoreHandle, uint64_t value);
 
+    VkEventHandle createEvent();
+
+    void destroyEvent(VkEventHandle vkEventHandle) noexcept;
+
+    void resetEvent(VkEventHandle vkEventHandle);
+
     void queueSubmit(uint32_t queueIndex, const SubmitBatch& submitBatch);
 
     VkQueryPoolHandle createQueryPool(
@@ -82,6 +82,14 @@ MemoryAllocator::MemoryAllocator(DeviceContainer* deviceImpl, Instance* instance
         MemoryLocationInfo locationInfo = physicalDevice->getMemoryLocationInfo(location);
         memoryLocationTypeIndices[static_cast<uint32_t>(location)] = locationInfo.memoryTypeIndex;
     }
+
+    // The memory type bits of a buffer only depend on its usage and flags, so a small buffer is enough to find out
+    // which memory types the buffers spanning image memory blocks can be bound to
+    VkBufferHandle vkProbeBufferHandle = device->createBuffer(makeImageMemoryBlockBufferCreateInfo(1));
+    VkMemoryRequirements probeMemoryReq;
+    vkiMemory.getBufferMemoryRequirements(vkDeviceHandle, vkProbeBufferHandle, &probeMemoryReq);
+    imageMemoryBlockBufferTypeBits = probeMemoryReq.memoryTypeBits;
+    device->destroyBuffer(vkProbeBufferHandle);
 }
 
 std::pair<Lifeguard<VkBufferHandle>, Lifeguard<VmaAllocationHandle>> MemoryAllocator::allocateBuffer(
@@ -197,6 +205,70 @@ std::pair<Lifeguard<VkImageHandle>, Lifeguard<VmaAllocationHandle>> MemoryAlloca
     return createImage(setup, true);
 }
 
+Lifeguard<VkImageHandle> MemoryAllocator::createUnboundImage(const ImageSetup& setup) const {
+    auto [imageHandleLifeguard, allocationHandleLifeguard] = createImage(setup, false);
+    return std::move(imageHandleLifeguard);
+}
+
+std::pair<Lifeguard<VkBufferHandle>, Lifeguard<VmaAllocationHandle>> MemoryAllocator::allocateImageMemoryBlock(
+    uint64_t size,
+    uint32_t memoryTypeIndex) {
+    TEPHRA_ASSERT(canTrackImageMemoryType(memoryTypeIndex));
+
+    // The buffer is only used to track accesses to the memory of the block, it never gets accessed itself
+    VkBufferHandle vkBufferHandle = deviceImpl->getLogicalDevice()->createBuffer(
+        makeImageMemoryBlockBufferCreateInfo(size));
+    auto bufferHandleLifeguard = deviceImpl->vkMakeHandleLifeguard(vkBufferHandle);
+
+    // The memory type comes from the requirements of the images that get placed in the block, the buffer only needs
+    // to be able to span it
+    VkMemoryRequirements memoryReq;
+    vkiMemory.getBufferMemoryRequirements(vkDeviceHandle, vkBufferHandle, &memoryReq);
+    memoryReq.size = tp::max(memoryReq.size, size);
+    memoryReq.memoryTypeBits = 1u << memoryTypeIndex;
+
+    // Use dedicated memory so that the block starts at offset zero, which keeps the offsets of the images placed
+    // within it aligned
+    VmaAllocationCreateInfo allocInfo;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    allocInfo.usage = VMA_MEMORY_USAGE_UNKNOWN;
+    allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocInfo.preferredFlags = 0;
+    allocInfo.memoryTypeBits = UINT32_MAX;
+    allocInfo.pool = VK_NULL_HANDLE;
+    allocInfo.pUserData = nullptr;
+
+    VmaAllocationHandle allocation;
+    while (true) {
+        VkResult retcode = vmaAllocateMemory(
+            vmaAllocator, &memoryReq, &allocInfo, vkCastTypedHandlePtr(&allocation), nullptr);
+        if (retcode >= 0) {
+            retcode = vmaBindBufferMemory(vmaAllocator, allocation, vkBufferHandle);
+        }
+
+        // Try to free up some memory, if there was some released, retry the allocation again
+        if (retcode == VK_ERROR_OUT_OF_DEVICE_MEMORY && outOfMemoryCallback &&
+            outOfMemoryCallback(MemoryLocation::DeviceLocal)) {
+            deviceImpl->waitForIdle();
+            continue;
+        }
+
+        throwRetcodeErrors(retcode);
+        break;
+    }
+
+    return { std::move(bufferHandleLifeguard), deviceImpl->vkMakeHandleLifeguard(allocation) };
+}
+
+bool MemoryAllocator::canTrackImageMemoryType(uint32_t memoryTypeIndex) const {
+    return (imageMemoryBlockBufferTypeBits & (1u << memoryTypeIndex)) != 0;
+}
+
+void MemoryAllocator::bindImageMemory(VkImageHandle vkImageHandle, VmaAllocationHandle allocation, uint64_t offset)
+    const {
+    throwRetcodeErrors(vmaBindImageMemory2(vmaAllocator, allocation, offset, vkImageHandle, nullptr));
+}
+
 VmaAllocationInfo MemoryAllocator::getAllocationInfo(VmaAllocationHandle allocation) const {
     VmaAllocationInfo allocInfo;
     vmaGetAllocationInfo(vmaAllocator, allocation, &allocInfo);
@@ -225,6 +297,29 @@ VkMemoryRequirements MemoryAllocator::getImageMemoryRequirements(const ImageSetu
     return memoryReq;
 }
 
+VkMemoryRequirements MemoryAllocator::getImageMemoryRequirements(VkImageHandle vkImageHandle) const {
+    VkMemoryRequirements memoryReq;
+    vkiMemory.getImageMemoryRequirements(vkDeviceHandle, vkImageHandle, &memoryReq);
+    return memoryReq;
+}
+
+uint32_t MemoryAllocator::getImageMemoryTypeIndex(const VkMemoryRequirements& memoryRequirements) const {
+    // Match the requirements used when allocating images in createImage
+    VmaAllocationCreateInfo allocInfo;
+    allocInfo.flags = 0;
+    allocInfo.usage = VMA_MEMORY_USAGE_UNKNOWN;
+    allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocInfo.preferredFlags = 0;
+    allocInfo.memoryTypeBits = UINT32_MAX;
+    allocInfo.pool = VK_NULL_HANDLE;
+    allocInfo.pUserData = nullptr;
+
+    uint32_t memoryTypeIndex;
+    throwRetcodeErrors(
+        vmaFindMemoryTypeIndex(vmaAllocator, memoryRequirements.memoryTypeBits, &allocInfo, &memoryTypeIndex));
+    return memoryTypeIndex;
+}
+
 VmaBudget MemoryAllocator::getMemoryHeapBudget(uint32_t heapIndex) const {
     VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
     vmaGetHeapBudgets(vmaAllocator, budgets);
@@ -370,6 +465,19 @@ std::pair<Lifeguard<VkImageHandle>, Lifeguard<VmaAllocationHandle>> MemoryAlloca
     return { deviceImpl->vkMakeHandleLifeguard(vkImageHandle), deviceImpl->vkMakeHandleLifeguard(vmaAllocationHandle) };
 }
 
+VkBufferCreateInfo MemoryAllocator::makeImageMemoryBlockBufferCreateInfo(uint64_t size) {
+    VkBufferCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.pNext = nullptr;
+    createInfo.flags = 0;
+    createInfo.size = size;
+    createInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.queueFamilyIndexCount = 0;
+    createInfo.pQueueFamilyIndices = nullptr;
+    return createInfo;
+}
+
 uint32_t MemoryAllocator::getMemoryLocationTypeIndex(MemoryLocation memoryLocation) const {
     return memoryLocationTypeIndices[static_cast<uint32_t>(memoryLocation)];
 }
@@ -19,6 +19,20 @@ public:
 
     std::pair<Lifeguard<VkImageHandle>, Lifeguard<VmaAllocationHandle>> allocateImage(const ImageSetup& setup);
 
+    // Creates an image without any memory bound to it, to be later placed with bindImageMemory
+    Lifeguard<VkImageHandle> createUnboundImage(const ImageSetup& setup) const;
+
+    // Allocates a device local memory block of the given memory type for placing images, along with a buffer that
+    // spans the entire block. The memory type must be supported by canTrackImageMemoryType
+    std::pair<Lifeguard<VkBufferHandle>, Lifeguard<VmaAllocationHandle>> allocateImageMemoryBlock(
+        uint64_t size,
+        uint32_t memoryTypeIndex);
+
+    // Returns true if a buffer spanning a memory block of the given image memory type can be bound to it
+    bool canTrackImageMemoryType(uint32_t memoryTypeIndex) const;
+
+    void bindImageMemory(VkImageHandle vkImageHandle, VmaAllocationHandle allocation, uint64_t offset) const;
+
     VmaAllocationInfo getAllocationInfo(VmaAllocationHandle allocation) const;
 
     MemoryLocation getAllocationLocation(VmaAllocationHandle allocation) const;
@@ -34,6 +48,11 @@ public:
 
     VkMemoryRequirements getImageMemoryRequirements(const ImageSetup& setup) const;
 
+    VkMemoryRequirements getImageMemoryRequirements(VkImageHandle vkImageHandle) const;
+
+    // Returns the index of the memory type that images with the given memory requirements get allocated from
+    uint32_t getImageMemoryTypeIndex(const VkMemoryRequirements& memoryRequirements) const;
+
     VmaBudget getMemoryHeapBudget(uint32_t heapIndex) const;
 
     void* mapMemory(VmaAllocationHandle allocation);
@@ -66,10 +85,13 @@ private:
     uint32_t memoryLocationTypeIndices[MemoryLocationEnumView::size()] = { ~0u };
     VkMemoryPropertyFlags memoryTypeFlags[VK_MAX_MEMORY_TYPES] = { 0 };
     bool allMemoryHostCoherent;
+    uint32_t imageMemoryBlockBufferTypeBits = 0;
 
     std::pair<Lifeguard<VkImageHandle>, Lifeguard<VmaAllocationHandle>> createImage(
         const ImageSetup& setup,
         bool doAllocate) const;
     uint32_t getMemoryLocationTypeIndex(MemoryLocation memoryLocation) const;
+
+    static VkBufferCreateInfo makeImageMemoryBlockBufferCreateInfo(uint64_t size);
 };
 }
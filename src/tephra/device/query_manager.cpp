@@ -339,6 +339,7 @@ void QueryRecorder::reset() {
     }
     usedBatches.clear();
     jobSemaphore = {};
+    isReusable = false;
 }
 
 QueryBatch* QueryRecorder::getBatch(const QueryHandle& query, uint32_t sampleCount) {
@@ -157,6 +157,16 @@ public:
     // Reset any used batches that may have been used, but not submitted
     void reset();
 
+    // Marks the recorder as recording command buffers that get submitted repeatedly, whose queries would only be
+    // tracked for the first submission. Lasts until reset
+    void markReusable() {
+        isReusable = true;
+    }
+
+    bool isRecordingReusable() const {
+        return isReusable;
+    }
+
     static QueryHandle getQueryHandle(const BaseQuery& query) {
         return query.handle;
     }
@@ -168,6 +178,7 @@ private:
     QueryManager* manager;
     std::vector<QueryBatch*> usedBatches;
     JobSemaphore jobSemaphore;
+    bool isReusable = false;
 };
 
 // Global manager for all queries
@@ -3,21 +3,61 @@
 #include "../job/resource_pool_container.hpp"
 #include "../job/job_compile.hpp"
 #include "../job/command_recording.hpp"
+#include "../utils/thread_pool.hpp"
 #include <algorithm>
 
 namespace tp {
 
-QueueState::QueueState(DeviceContainer* deviceImpl, uint32_t queueIndex)
+// Returns true if the job has command lists that the user may keep recording until the job gets submitted
+bool hasDeferredCommandLists(const JobData* jobData) {
+    for (std::size_t i = 0; i < jobData->record.computePassCount; i++) {
+        if (!jobData->record.computePassStorage[i].isRecordedInline())
+            return true;
+    }
+    for (std::size_t i = 0; i < jobData->record.renderPassCount; i++) {
+        if (!jobData->record.renderPassStorage[i].isRecordedInline())
+            return true;
+    }
+    for (const JobData* subJobData : jobData->subJobs) {
+        if (hasDeferredCommandLists(subJobData))
+            return true;
+    }
+    return false;
+}
+
+QueueState::QueueState(DeviceContainer* deviceImpl, uint32_t queueIndex, bool compileInBackground)
     : deviceImpl(deviceImpl), queueIndex(queueIndex), syncState(std::make_unique<QueueSyncState>()) {
     TEPHRA_ASSERT(queueIndex != ~0);
     queueLastQueriedTimestamps.resize(deviceImpl->getQueueMap()->getQueueInfos().size());
+
+    // Split barriers rely on events, which transfer queues may not support
+    QueueType queueType = deviceImpl->getQueueMap()->getQueueInfos()[queueIndex].identifier.type;
+    if (queueType == QueueType::Graphics || queueType == QueueType::Compute) {
+        splitBarrierEventPool = std::make_unique<EventPool>(deviceImpl->getLogicalDevice());
+    }
+
+    if (compileInBackground)
+        compileThread = std::thread(&QueueState::runBackgroundCompilation, this);
 }
 
 void QueueState::enqueueJob(Job job) {
+    StatisticTimer allocationTimer;
     JobResourcePoolContainer::allocateJobResources(job);
+    uint64_t allocationNanoseconds = allocationTimer.getElapsedNanoseconds();
 
     JobData* jobData = JobResourcePoolContainer::getJobData(job);
+    StatisticTimer broadcastTimer;
     broadcastResourceExports(jobData->record, jobData->semaphores.jobSignal);
+    uint64_t broadcastNanoseconds = broadcastTimer.getElapsedNanoseconds();
+
+    if constexpr (StatisticEventsEnabled) {
+        const char* jobName = JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName();
+        StatisticAggregator* aggregator = deviceImpl->getStatisticAggregator();
+        reportStatisticEvent(
+            aggregator, StatisticEventType::JobResourceAllocationNanoseconds, allocationNanoseconds, jobName);
+        reportStatisticEvent(
+            aggregator, StatisticEventType::JobExportBroadcastNanoseconds, broadcastNanoseconds, jobName);
+    }
 
     {
         std::lock_guard<Mutex> mutexLock(queuedJobsMutex);
@@ -26,24 +66,33 @@ void QueueState::enqueueJob(Job job) {
             jobData->semaphores.jobSignal.timestamp >
                 JobResourcePoolContainer::getJobData(queuedJobs.back())->semaphores.jobSignal.timestamp);
 
+        lastEnqueuedTimestamp = jobData->semaphores.jobSignal.timestamp;
         queuedJobs.push_back(std::move(job));
     }
+
+    if (compileThread.joinable())
+        compileWorkAvailable.notify_one();
 }
 
-void QueueState::forgetResource(VkBufferHandle vkBufferHandle) {
+void QueueState::forgetResource(VkBufferHandle vkBufferHandle, uint32_t resourceId) {
     std::lock_guard<Mutex> mutexLock(syncState->awaitingForgetsMutex);
-    syncState->awaitingBufferForgets.push_back(vkBufferHandle);
+    syncState->awaitingBufferForgets.emplace_back(vkBufferHandle, resourceId);
 }
 
-void QueueState::forgetResource(VkImageHandle vkImageHandle) {
+void QueueState::forgetResource(VkImageHandle vkImageHandle, uint32_t resourceId) {
     std::lock_guard<Mutex> mutexLock(syncState->awaitingForgetsMutex);
-    syncState->awaitingImageForgets.push_back(vkImageHandle);
+    syncState->awaitingImageForgets.emplace_back(vkImageHandle, resourceId);
 }
 
 void QueueState::submitQueuedJobs(
     const JobSemaphore& lastJobToSubmit,
     ArrayParameter<const JobSemaphore> waitJobSemaphores,
     ArrayParameter<const ExternalSemaphore> waitExternalSemaphores) {
+    if (compileThread.joinable()) {
+        submitCompiledJobs(lastJobToSubmit, waitJobSemaphores, waitExternalSemaphores);
+        return;
+    }
+
     // Gather jobs we want to submit, do the rest outside the lock
     ScratchVector<Job> jobsToSubmit;
     {
@@ -83,14 +132,309 @@ void QueueState::submitQueuedJobs(
     // TODO: Check as validation perf warning if any resource has too many distinct accesses
 }
 
+void QueueState::stopBackgroundCompilation() {
+    if (!compileThread.joinable())
+        return;
+
+    {
+        std::lock_guard<Mutex> mutexLock(queuedJobsMutex);
+        isStoppingCompilation = true;
+    }
+    compileWorkAvailable.notify_one();
+    compileThread.join();
+
+    // The jobs that never got submitted don't need their command buffers anymore
+    for (CompiledJob& compiledJob : compiledJobs) {
+        if (compiledJob.commandPool != nullptr)
+            deviceImpl->getCommandPoolPool()->releasePool(compiledJob.commandPool);
+    }
+    compiledJobs.clear();
+}
+
+QueueState::~QueueState() {
+    stopBackgroundCompilation();
+}
+
 void QueueState::submitJobs(ArrayView<Job> jobs) {
+    SubmitBatch submitBatch;
+    submitBatch.submitEntries.reserve(jobs.size());
+    std::vector<CommandPool*> usedCommandPools;
+
+    if (splitBarrierEventPool != nullptr) {
+        // Reuse the events of jobs that have already finished
+        splitBarrierEventPool->recycleEvents(deviceImpl->getTimelineManager()->getLastReachedTimestamp(queueIndex));
+    }
+
+    // Compile queued jobs into vulkan commands while building up submit information
+    ThreadPool* threadPool = deviceImpl->getRecordingThreadPool();
+    if (threadPool != nullptr && jobs.size() > 1) {
+        compileJobsInParallel(jobs, threadPool, submitBatch, usedCommandPools);
+    } else {
+        compileJobs(jobs, submitBatch, usedCommandPools);
+    }
+
+    submitToQueue(submitBatch, std::move(usedCommandPools));
+}
+
+void QueueState::submitCompiledJobs(
+    const JobSemaphore& lastJobToSubmit,
+    ArrayParameter<const JobSemaphore> waitJobSemaphores,
+    ArrayParameter<const ExternalSemaphore> waitExternalSemaphores) {
+    // Wait until the background thread compiles all the jobs we want to submit and take them
+    ScratchVector<CompiledJob> compiledJobsToSubmit;
+    {
+        std::unique_lock<Mutex> mutexLock(queuedJobsMutex);
+        uint64_t targetTimestamp = lastEnqueuedTimestamp;
+        if (!lastJobToSubmit.isNull())
+            targetTimestamp = tp::min(targetTimestamp, lastJobToSubmit.timestamp);
+
+        // Jobs with deferred command lists only get compiled once their submission is requested
+        submitRequestedTimestamp = tp::max(submitRequestedTimestamp, targetTimestamp);
+        compileWorkAvailable.notify_one();
+        compileWorkFinished.wait(mutexLock, [&]() { return lastCompiledTimestamp >= targetTimestamp; });
+
+        // The jobs were compiled without knowing about the submit wait semaphores, so they can't acquire the resources
+        // exported to this queue by the waited jobs. Reject the submit before taking any of the jobs
+        bool hasJobsToSubmit = !compiledJobs.empty() &&
+            JobResourcePoolContainer::getJobData(compiledJobs.front().job)->semaphores.jobSignal.timestamp <=
+                targetTimestamp;
+        if (hasJobsToSubmit &&
+            (hasUnacquiredExports(compiledJobs.front(), view(queuedSemaphoreStorage.jobWaits)) ||
+             hasUnacquiredExports(compiledJobs.front(), waitJobSemaphores))) {
+            throw UnsupportedOperationError(
+                "A job semaphore passed to submitQueuedJobs waits on resources exported to this queue, but the jobs "
+                "of queues with background compilation get compiled before the submit and can't acquire them. Pass "
+                "the semaphore to enqueueJob instead.");
+        }
+
+        while (!compiledJobs.empty()) {
+            CompiledJob& compiledJob = compiledJobs.front();
+            JobData* jobData = JobResourcePoolContainer::getJobData(compiledJob.job);
+            if (jobData->semaphores.jobSignal.timestamp > targetTimestamp)
+                break;
+
+            compiledJobsToSubmit.push_back(std::move(compiledJob));
+            compiledJobs.pop_front();
+        }
+    }
+
+    // The sync state of the queue assumes that all compiled jobs get submitted, so jobs that failed to compile still
+    // get submitted without any commands, signalling their semaphores. The first exception is rethrown afterwards
+    std::exception_ptr compileException;
+    const std::size_t queueCount = deviceImpl->getQueueMap()->getQueueInfos().size();
+    for (CompiledJob& compiledJob : compiledJobsToSubmit) {
+        if (compiledJob.exception == nullptr)
+            continue;
+
+        if (compileException == nullptr)
+            compileException = compiledJob.exception;
+        if (compiledJob.commandPool != nullptr) {
+            deviceImpl->getCommandPoolPool()->releasePool(compiledJob.commandPool);
+            compiledJob.commandPool = nullptr;
+        }
+        compiledJob.vkCommandBuffers.clear();
+        compiledJob.queueWaitStageMasks.assign(queueCount, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+    }
+
+    if (compiledJobsToSubmit.empty()) {
+        // Keep the submit wait semaphores around for the next submit
+        queuedSemaphoreStorage.insertWaits(waitJobSemaphores, waitExternalSemaphores);
+        return;
+    }
+
+    ScratchVector<Job> jobsToSubmit;
+    jobsToSubmit.reserve(compiledJobsToSubmit.size());
+    for (CompiledJob& compiledJob : compiledJobsToSubmit) {
+        jobsToSubmit.push_back(std::move(compiledJob.job));
+    }
+
+    // The jobs were compiled without knowing about the submit wait semaphores, so the stages waiting on them can't be
+    // narrowed down
+    bool hasSubmitJobWaits = !queuedSemaphoreStorage.jobWaits.empty() || !waitJobSemaphores.empty();
+    JobSemaphoreStorage& firstSemaphores = JobResourcePoolContainer::getJobData(jobsToSubmit[0])->semaphores;
+    firstSemaphores.insertWaits(view(queuedSemaphoreStorage.jobWaits), view(queuedSemaphoreStorage.externalWaits));
+    queuedSemaphoreStorage.clear();
+    firstSemaphores.insertWaits(waitJobSemaphores, waitExternalSemaphores);
+
+    SubmitBatch submitBatch;
+    submitBatch.submitEntries.reserve(jobsToSubmit.size());
+    std::vector<CommandPool*> usedCommandPools;
+    ScratchVector<VkPipelineStageFlags> queueWaitStageMasks;
+
+    std::size_t startJobIndex = 0;
+    while (startJobIndex < jobsToSubmit.size()) {
+        std::size_t endJobIndex = findSubmitEntryEnd(view(jobsToSubmit), startJobIndex);
+        ArrayView<Job> entryJobs = viewRange(jobsToSubmit, startJobIndex, endJobIndex - startJobIndex);
+
+        // The wait stages were found for each job on its own, which only holds for entries made of a single job
+        const std::vector<VkPipelineStageFlags>& jobWaitStageMasks =
+            compiledJobsToSubmit[startJobIndex].queueWaitStageMasks;
+        if (entryJobs.size() == 1 && !(startJobIndex == 0 && hasSubmitJobWaits)) {
+            queueWaitStageMasks.assign(jobWaitStageMasks.begin(), jobWaitStageMasks.end());
+        } else {
+            queueWaitStageMasks.assign(queueCount, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        }
+
+        addSubmitEntry(entryJobs, view(queueWaitStageMasks), submitBatch);
+        SubmitBatch::SubmitEntry& submitEntry = submitBatch.submitEntries.back();
+        submitEntry.commandBufferOffset = static_cast<uint32_t>(submitBatch.vkCommandBuffers.size());
+
+        for (std::size_t jobIndex = startJobIndex; jobIndex < endJobIndex; jobIndex++) {
+            const CompiledJob& compiledJob = compiledJobsToSubmit[jobIndex];
+            submitBatch.vkCommandBuffers.insert(
+                submitBatch.vkCommandBuffers.end(),
+                compiledJob.vkCommandBuffers.begin(),
+                compiledJob.vkCommandBuffers.end());
+            if (compiledJob.commandPool != nullptr)
+                usedCommandPools.push_back(compiledJob.commandPool);
+        }
+
+        submitEntry.commandBufferCount = static_cast<uint32_t>(
+            submitBatch.vkCommandBuffers.size() - submitEntry.commandBufferOffset);
+        startJobIndex = endJobIndex;
+    }
+
+    submitToQueue(submitBatch, std::move(usedCommandPools));
+
+    if (compileException != nullptr)
+        std::rethrow_exception(compileException);
+}
+
+bool QueueState::hasUnacquiredExports(
+    const CompiledJob& firstJob,
+    ArrayParameter<const JobSemaphore> waitJobSemaphores) const {
+    // A job that failed to compile before querying its exports gets rethrown on submit instead
+    if (firstJob.queueQueriedTimestamps.empty())
+        return false;
+
+    // Exports past what the job already queried would have been acquired had it known about the semaphores
+    for (const JobSemaphore& jobSemaphore : waitJobSemaphores) {
+        uint32_t srcQueueIndex = deviceImpl->getQueueMap()->getQueueUniqueIndex(jobSemaphore.queue);
+        uint64_t queriedTimestamp = firstJob.queueQueriedTimestamps[srcQueueIndex];
+        if (jobSemaphore.timestamp <= queriedTimestamp)
+            continue;
+
+        TimelinePeriod period;
+        period.srcQueue = jobSemaphore.queue;
+        period.fromTimestamp = queriedTimestamp;
+        period.toTimestamp = jobSemaphore.timestamp;
+        if (deviceImpl->getCrossQueueSync()->hasIncomingExports(viewOne(period), queueIndex))
+            return true;
+    }
+    return false;
+}
+
+void QueueState::submitToQueue(const SubmitBatch& submitBatch, std::vector<CommandPool*> usedCommandPools) {
+    StatisticTimer submitTimer;
+    deviceImpl->getLogicalDevice()->queueSubmit(queueIndex, submitBatch);
+
+    if constexpr (StatisticEventsEnabled) {
+        const char* queueName = deviceImpl->getQueueMap()->getQueueInfos()[queueIndex].name.c_str();
+        reportStatisticEvent(
+            deviceImpl->getStatisticAggregator(),
+            StatisticEventType::QueueSubmitNanoseconds,
+            submitTimer.getElapsedNanoseconds(),
+            queueName);
+    }
+
+    // Queue the release of the primary command pools once the jobs finish
+    deviceImpl->getTimelineManager()->addCleanupCallback([=]() {
+        for (CommandPool* commandPool : usedCommandPools) {
+            deviceImpl->getCommandPoolPool()->releasePool(commandPool);
+        }
+    });
+}
+
+void QueueState::runBackgroundCompilation() {
+    std::unique_lock<Mutex> mutexLock(queuedJobsMutex);
+    while (true) {
+        compileWorkAvailable.wait(mutexLock, [this]() { return isStoppingCompilation || canCompileNextJob(); });
+        if (isStoppingCompilation)
+            return;
+
+        Job job = std::move(queuedJobs.front());
+        queuedJobs.pop_front();
+        uint64_t jobTimestamp = JobResourcePoolContainer::getJobData(job)->semaphores.jobSignal.timestamp;
+
+        // Compile outside the lock so that more jobs can be enqueued in the meantime
+        mutexLock.unlock();
+        CompiledJob compiledJob = compileJobInBackground(std::move(job));
+        mutexLock.lock();
+
+        compiledJobs.push_back(std::move(compiledJob));
+        lastCompiledTimestamp = jobTimestamp;
+        compileWorkFinished.notify_all();
+    }
+}
+
+bool QueueState::canCompileNextJob() const {
+    if (queuedJobs.empty())
+        return false;
+
+    const JobData* jobData = JobResourcePoolContainer::getJobData(queuedJobs.front());
+    return jobData->semaphores.jobSignal.timestamp <= submitRequestedTimestamp || !hasDeferredCommandLists(jobData);
+}
+
+QueueState::CompiledJob QueueState::compileJobInBackground(Job job) {
+    CompiledJob compiledJob(std::move(job));
+    TEPHRA_DEBUG_SET_CONTEXT(
+        deviceImpl->getDebugTarget(),
+        "compileJobInBackground",
+        JobResourcePoolContainer::getJobDebugTarget(compiledJob.job)->getObjectName());
+
+    // Scratch memory is thread local, so everything allocated from it has to be released within this scope
+    try {
+        consumeAwaitingForgets();
+        if (splitBarrierEventPool != nullptr) {
+            splitBarrierEventPool->recycleEvents(deviceImpl->getTimelineManager()->getLastReachedTimestamp(queueIndex));
+        }
+
+        ArrayView<Job> jobs = view(&compiledJob.job, 1);
+        ScratchVector<CrossQueueSync::ExportEntry> incomingResourceExports;
+        ScratchVector<std::size_t> jobExportOffsets;
+        queryJobsIncomingExports(jobs, incomingResourceExports, jobExportOffsets);
+        compiledJob.queueQueriedTimestamps = queueLastQueriedTimestamps;
+
+        // The stages must be found before compilation consumes the job's commands
+        ScratchVector<VkPipelineStageFlags> queueWaitStageMasks;
+        findWaitStageMasks(jobs, view(incomingResourceExports), queueWaitStageMasks);
+        compiledJob.queueWaitStageMasks.assign(queueWaitStageMasks.begin(), queueWaitStageMasks.end());
+
+        // Each job gets its own command pool, as they get submitted in varying groups
+        const QueueInfo& queueInfo = deviceImpl->getQueueMap()->getQueueInfos()[queueIndex];
+        compiledJob.commandPool = deviceImpl->getCommandPoolPool()->acquirePool(
+            queueInfo.identifier.type, queueInfo.name.c_str());
+
+        const auto& vkiCommands = deviceImpl->getCommandPoolPool()->getVkiCommands();
+        ScratchVector<VkCommandBufferHandle> vkCommandBuffers;
+        PrimaryBufferRecorder recorder = PrimaryBufferRecorder(
+            compiledJob.commandPool, &vkiCommands, queueInfo.name.c_str(), &vkCommandBuffers);
+
+        JobCompilationContext compilationContext;
+        compilationContext.deviceImpl = deviceImpl;
+        compilationContext.queueSyncState = syncState.get();
+        compilationContext.splitBarrierEventPool = splitBarrierEventPool.get();
+        compilationContext.recorder = &recorder;
+        compileJob(compilationContext, compiledJob.job, view(incomingResourceExports));
+
+        recorder.endRecording();
+        compiledJob.vkCommandBuffers.assign(vkCommandBuffers.begin(), vkCommandBuffers.end());
+    } catch (...) {
+        compiledJob.exception = std::current_exception();
+    }
+
+    return compiledJob;
+}
+
+void QueueState::compileJobs(
+    ArrayView<Job> jobs,
+    SubmitBatch& submitBatch,
+    std::vector<CommandPool*>& usedCommandPools) {
     // Set up for job compilation
     const QueueInfo& queueInfo = deviceImpl->getQueueMap()->getQueueInfos()[queueIndex];
     CommandPool* commandPool = deviceImpl->getCommandPoolPool()->acquirePool(
         queueInfo.identifier.type, queueInfo.name.c_str());
-
-    SubmitBatch submitBatch;
-    submitBatch.submitEntries.reserve(jobs.size());
+    usedCommandPools.push_back(commandPool);
 
     const auto& vkiCommands = deviceImpl->getCommandPoolPool()->getVkiCommands();
     PrimaryBufferRecorder recorder = PrimaryBufferRecorder(
@@ -99,64 +443,202 @@ void QueueState::submitJobs(ArrayView<Job> jobs) {
     JobCompilationContext compilationContext;
     compilationContext.deviceImpl = deviceImpl;
     compilationContext.queueSyncState = syncState.get();
+    compilationContext.splitBarrierEventPool = splitBarrierEventPool.get();
     compilationContext.recorder = &recorder;
     ScratchVector<CrossQueueSync::ExportEntry> incomingResourceExports;
+    ScratchVector<std::size_t> jobExportOffsets;
+    ScratchVector<VkPipelineStageFlags> queueWaitStageMasks;
 
-    // Compile queued jobs into vulkan commands while building up submit information
     std::size_t startJobIndex = 0;
     while (startJobIndex < jobs.size()) {
         // Process as many jobs as we can in the same submit
-        std::size_t endJobIndex = startJobIndex + 1;
-        while (endJobIndex < jobs.size()) {
-            Job& job = jobs[endJobIndex];
-            JobData* jobData = JobResourcePoolContainer::getJobData(job);
+        std::size_t endJobIndex = findSubmitEntryEnd(jobs, startJobIndex);
+        ArrayView<Job> entryJobs = viewRange(jobs, startJobIndex, endJobIndex - startJobIndex);
 
-            // Putting this in the same submit would cause the previous jobs to wait, too
-            bool hasWaits = !jobData->semaphores.jobWaits.empty() || !jobData->semaphores.externalWaits.empty();
-            // Jobs always signal a semaphore, but if it's flagged as small, assume it won't significantly delay it
-            if (!jobData->flags.contains(tp::JobFlag::Small) || hasWaits)
-                break;
-        }
-
-        // Populate a new submit entry
-        submitBatch.submitEntries.emplace_back();
+        // The incoming exports are needed ahead of compilation to determine the stages that wait on other queues
+        queryJobsIncomingExports(entryJobs, incomingResourceExports, jobExportOffsets);
+        findWaitStageMasks(entryJobs, view(incomingResourceExports), queueWaitStageMasks);
+        addSubmitEntry(entryJobs, view(queueWaitStageMasks), submitBatch);
         SubmitBatch::SubmitEntry& submitEntry = submitBatch.submitEntries.back();
-        submitEntry.waitSemaphoreOffset = static_cast<uint32_t>(submitBatch.vkWaitSemaphores.size());
-        submitEntry.signalSemaphoreOffset = static_cast<uint32_t>(submitBatch.vkSignalSemaphores.size());
         submitEntry.commandBufferOffset = static_cast<uint32_t>(submitBatch.vkCommandBuffers.size());
 
-        for (std::size_t jobIndex = startJobIndex; jobIndex < endJobIndex; jobIndex++) {
-            Job& job = jobs[jobIndex];
-            JobData* jobData = JobResourcePoolContainer::getJobData(job);
-
-            // Set up semaphores
-            resolveSemaphores(jobData->semaphores, submitBatch);
-
-            incomingResourceExports.clear();
-            queryIncomingExports(view(jobData->semaphores.jobWaits), incomingResourceExports);
+        for (std::size_t entryJobIndex = 0; entryJobIndex < entryJobs.size(); entryJobIndex++) {
+            std::size_t exportCount = jobExportOffsets[entryJobIndex + 1] - jobExportOffsets[entryJobIndex];
+            auto jobIncomingExports = viewRange(incomingResourceExports, jobExportOffsets[entryJobIndex], exportCount);
 
             // Compile the job to Vulkan command buffers
-            compileJob(compilationContext, job, view(incomingResourceExports));
+            compileJob(compilationContext, entryJobs[entryJobIndex], jobIncomingExports);
         }
 
         // Finalize the entry
         recorder.endRecording();
-        submitEntry.waitSemaphoreCount = static_cast<uint32_t>(
-            submitBatch.vkWaitSemaphores.size() - submitEntry.waitSemaphoreOffset);
-        submitEntry.signalSemaphoreCount = static_cast<uint32_t>(
-            submitBatch.vkSignalSemaphores.size() - submitEntry.signalSemaphoreOffset);
         submitEntry.commandBufferCount = static_cast<uint32_t>(
             submitBatch.vkCommandBuffers.size() - submitEntry.commandBufferOffset);
 
         startJobIndex = endJobIndex;
     }
+}
 
-    // Finally submit the batch
-    deviceImpl->getLogicalDevice()->queueSubmit(queueIndex, submitBatch);
+void QueueState::compileJobsInParallel(
+    ArrayView<Job> jobs,
+    ThreadPool* threadPool,
+    SubmitBatch& submitBatch,
+    std::vector<CommandPool*>& usedCommandPools) {
+    // Analysis of the jobs updates the sync state of the queue, so it has to happen sequentially in submission order
+    ScratchDeque<BarrierList> jobBarriers;
+    ScratchVector<std::size_t> entryEndJobIndices;
+    ScratchVector<CrossQueueSync::ExportEntry> incomingResourceExports;
+    ScratchVector<std::size_t> jobExportOffsets;
+    ScratchVector<VkPipelineStageFlags> queueWaitStageMasks;
+
+    std::size_t startJobIndex = 0;
+    while (startJobIndex < jobs.size()) {
+        std::size_t endJobIndex = findSubmitEntryEnd(jobs, startJobIndex);
+        ArrayView<Job> entryJobs = viewRange(jobs, startJobIndex, endJobIndex - startJobIndex);
 
-    // Queue the release of the primary command pool once the jobs finish
-    deviceImpl->getTimelineManager()->addCleanupCallback(
-        [=]() { deviceImpl->getCommandPoolPool()->releasePool(commandPool); });
+        queryJobsIncomingExports(entryJobs, incomingResourceExports, jobExportOffsets);
+        findWaitStageMasks(entryJobs, view(incomingResourceExports), queueWaitStageMasks);
+        addSubmitEntry(entryJobs, view(queueWaitStageMasks), submitBatch);
+        entryEndJobIndices.push_back(endJobIndex);
+
+        for (std::size_t entryJobIndex = 0; entryJobIndex < entryJobs.size(); entryJobIndex++) {
+            Job& job = entryJobs[entryJobIndex];
+            JobData* jobData = JobResourcePoolContainer::getJobData(job);
+            std::size_t exportCount = jobExportOffsets[entryJobIndex + 1] - jobExportOffsets[entryJobIndex];
+            auto jobIncomingExports = viewRange(incomingResourceExports, jobExportOffsets[entryJobIndex], exportCount);
+
+            TEPHRA_ASSERT(!jobData->semaphores.jobSignal.isNull());
+            jobBarriers.emplace_back(jobData->semaphores.jobSignal.timestamp);
+            StatisticTimer barrierTimer;
+            prepareJobBarriers(
+                syncState.get(),
+                splitBarrierEventPool.get(),
+                job,
+                jobIncomingExports,
+                jobBarriers.back());
+
+            if constexpr (StatisticEventsEnabled) {
+                reportStatisticEvent(
+                    deviceImpl->getStatisticAggregator(),
+                    StatisticEventType::JobBarrierPreparationNanoseconds,
+                    barrierTimer.getElapsedNanoseconds(),
+                    JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName());
+            }
+        }
+
+        startJobIndex = endJobIndex;
+    }
+
+    // Each job gets its own command pool, so that they can be recorded independently
+    const QueueInfo& queueInfo = deviceImpl->getQueueMap()->getQueueInfos()[queueIndex];
+    std::size_t firstPoolIndex = usedCommandPools.size();
+    for (std::size_t jobIndex = 0; jobIndex < jobs.size(); jobIndex++) {
+        usedCommandPools.push_back(
+            deviceImpl->getCommandPoolPool()->acquirePool(queueInfo.identifier.type, queueInfo.name.c_str()));
+    }
+
+    // Record the jobs in parallel. Scratch memory is thread local, so the workers need to return the recorded
+    // buffers through regular vectors
+    const auto& vkiCommands = deviceImpl->getCommandPoolPool()->getVkiCommands();
+    std::vector<std::vector<VkCommandBufferHandle>> jobCommandBuffers(jobs.size());
+    // The debug context is thread local, so the recording times get reported from this thread afterwards
+    std::vector<uint64_t> jobRecordingNanoseconds(jobs.size());
+    threadPool->parallelFor(static_cast<uint32_t>(jobs.size()), [&](uint32_t jobIndex) {
+        ScratchVector<VkCommandBufferHandle> vkCommandBuffers;
+        PrimaryBufferRecorder recorder = PrimaryBufferRecorder(
+            usedCommandPools[firstPoolIndex + jobIndex], &vkiCommands, queueInfo.name.c_str(), &vkCommandBuffers);
+
+        StatisticTimer recordingTimer;
+        recordJob(deviceImpl, recorder, jobs[jobIndex], jobBarriers[jobIndex]);
+        recorder.endRecording();
+        jobRecordingNanoseconds[jobIndex] = recordingTimer.getElapsedNanoseconds();
+        jobCommandBuffers[jobIndex].assign(vkCommandBuffers.begin(), vkCommandBuffers.end());
+    });
+
+    // Stitch the recorded buffers together in submission order
+    startJobIndex = 0;
+    for (std::size_t entryIndex = 0; entryIndex < submitBatch.submitEntries.size(); entryIndex++) {
+        SubmitBatch::SubmitEntry& submitEntry = submitBatch.submitEntries[entryIndex];
+        submitEntry.commandBufferOffset = static_cast<uint32_t>(submitBatch.vkCommandBuffers.size());
+
+        std::size_t endJobIndex = entryEndJobIndices[entryIndex];
+        for (std::size_t jobIndex = startJobIndex; jobIndex < endJobIndex; jobIndex++) {
+            const std::vector<VkCommandBufferHandle>& vkCommandBuffers = jobCommandBuffers[jobIndex];
+            submitBatch.vkCommandBuffers.insert(
+                submitBatch.vkCommandBuffers.end(), vkCommandBuffers.begin(), vkCommandBuffers.end());
+
+            if constexpr (StatisticEventsEnabled) {
+                reportStatisticEvent(
+                    deviceImpl->getStatisticAggregator(),
+                    StatisticEventType::JobCommandRecordingNanoseconds,
+                    jobRecordingNanoseconds[jobIndex],
+                    JobResourcePoolContainer::getJobDebugTarget(jobs[jobIndex])->getObjectName());
+            }
+
+            CommandPool* commandPool = usedCommandPools[firstPoolIndex + jobIndex];
+            finalizeJob(
+                deviceImpl,
+                commandPool->getQueryRecorder(),
+                jobs[jobIndex],
+                jobBarriers[jobIndex],
+                vkCommandBuffers.size());
+        }
+
+        submitEntry.commandBufferCount = static_cast<uint32_t>(
+            submitBatch.vkCommandBuffers.size() - submitEntry.commandBufferOffset);
+        startJobIndex = endJobIndex;
+    }
+}
+
+std::size_t QueueState::findSubmitEntryEnd(ArrayView<Job> jobs, std::size_t startJobIndex) const {
+    std::size_t endJobIndex = startJobIndex + 1;
+    while (endJobIndex < jobs.size()) {
+        Job& job = jobs[endJobIndex];
+        JobData* jobData = JobResourcePoolContainer::getJobData(job);
+
+        // Putting this in the same submit would cause the previous jobs to wait, too
+        bool hasWaits = !jobData->semaphores.jobWaits.empty() || !jobData->semaphores.externalWaits.empty();
+        // Jobs always signal a semaphore, but if it's flagged as small, assume it won't significantly delay it
+        if (!jobData->flags.contains(tp::JobFlag::Small) || hasWaits)
+            break;
+        endJobIndex++;
+    }
+    return endJobIndex;
+}
+
+void QueueState::queryJobsIncomingExports(
+    ArrayView<Job> jobs,
+    ScratchVector<CrossQueueSync::ExportEntry>& incomingExports,
+    ScratchVector<std::size_t>& jobExportOffsets) {
+    incomingExports.clear();
+    jobExportOffsets.clear();
+
+    for (Job& job : jobs) {
+        jobExportOffsets.push_back(incomingExports.size());
+        queryIncomingExports(view(JobResourcePoolContainer::getJobData(job)->semaphores.jobWaits), incomingExports);
+    }
+    jobExportOffsets.push_back(incomingExports.size());
+}
+
+void QueueState::addSubmitEntry(
+    ArrayView<Job> jobs,
+    ArrayView<const VkPipelineStageFlags> queueWaitStageMasks,
+    SubmitBatch& submitBatch) const {
+    submitBatch.submitEntries.emplace_back();
+    SubmitBatch::SubmitEntry& submitEntry = submitBatch.submitEntries.back();
+    submitEntry.waitSemaphoreOffset = static_cast<uint32_t>(submitBatch.vkWaitSemaphores.size());
+    submitEntry.signalSemaphoreOffset = static_cast<uint32_t>(submitBatch.vkSignalSemaphores.size());
+
+    for (Job& job : jobs) {
+        resolveSemaphores(JobResourcePoolContainer::getJobData(job)->semaphores, queueWaitStageMasks, submitBatch);
+    }
+
+    submitEntry.waitSemaphoreCount = static_cast<uint32_t>(
+        submitBatch.vkWaitSemaphores.size() - submitEntry.waitSemaphoreOffset);
+    submitEntry.signalSemaphoreCount = static_cast<uint32_t>(
+        submitBatch.vkSignalSemaphores.size() - submitEntry.signalSemaphoreOffset);
+    submitEntry.commandBufferOffset = 0;
+    submitEntry.commandBufferCount = 0;
 }
 
 void QueueState::broadcastResourceExports(const JobRecordStorage& jobRecord, const JobSemaphore& srcSemaphore) {
@@ -170,10 +652,12 @@ void QueueState::broadcastResourceExports(const JobRecordStorage& jobRecord, con
                 data->dstQueueFamilyIndex == VK_QUEUE_FAMILY_EXTERNAL)
                 break;
 
-            auto [vkBufferHandle, range] = resolveBufferAccess(data->buffer);
+            auto [vkBufferHandle, resourceId, range] = resolveBufferAccess(data->buffer);
 
             deviceImpl->getCrossQueueSync()->broadcastResourceExport(
-                srcSemaphore, NewBufferAccess(vkBufferHandle, range, data->access), data->dstQueueFamilyIndex);
+                srcSemaphore,
+                NewBufferAccess(vkBufferHandle, resourceId, range, data->access),
+                data->dstQueueFamilyIndex);
             break;
         }
         case JobCommandTypes::ExportImage: {
@@ -183,11 +667,12 @@ void QueueState::broadcastResourceExports(const JobRecordStorage& jobRecord, con
                 break;
 
             ImageAccessRange range = data->range;
-            VkImageHandle vkImageHandle = resolveImageAccess(data->image, &range);
+            uint32_t resourceId;
+            VkImageHandle vkImageHandle = resolveImageAccess(data->image, &range, &resourceId);
 
             deviceImpl->getCrossQueueSync()->broadcastResourceExport(
                 srcSemaphore,
-                NewImageAccess(vkImageHandle, range, data->access, data->vkImageLayout),
+                NewImageAccess(vkImageHandle, resourceId, range, data->access, data->vkImageLayout),
                 data->dstQueueFamilyIndex);
             break;
         }
@@ -229,11 +714,143 @@ void QueueState::queryIncomingExports(
         }
     }
 
-    uint32_t dstQueueFamilyIndex = deviceImpl->getQueueMap()->getQueueInfos()[queueIndex].queueFamilyIndex;
-    deviceImpl->getCrossQueueSync()->queryIncomingExports(view(periods), dstQueueFamilyIndex, incomingExports);
+    deviceImpl->getCrossQueueSync()->queryIncomingExports(view(periods), queueIndex, incomingExports);
 }
 
-void QueueState::resolveSemaphores(const JobSemaphoreStorage& semaphores, SubmitBatch& submitBatch) const {
+void QueueState::findWaitStageMasks(
+    ArrayView<Job> jobs,
+    ArrayView<const CrossQueueSync::ExportEntry> incomingExports,
+    ScratchVector<VkPipelineStageFlags>& queueWaitStageMasks) const {
+    queueWaitStageMasks.assign(deviceImpl->getQueueMap()->getQueueInfos().size(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+    // Waits are only ever on the first job of an entry, but they apply to all of its jobs. They also order all the
+    // later submissions to this queue after the waited work, so they can only be narrowed down to the accesses of
+    // this entry when the waiting job opts into it
+    bool hasJobWaits = false;
+    bool narrowsJobWaits = true;
+    for (Job& job : jobs) {
+        const JobData* jobData = JobResourcePoolContainer::getJobData(job);
+        if (!jobData->semaphores.jobWaits.empty()) {
+            hasJobWaits = true;
+            narrowsJobWaits &= jobData->flags.contains(JobFlag::NarrowSemaphoreWaits);
+        }
+    }
+    if (!hasJobWaits || !narrowsJobWaits)
+        return;
+
+    // The exported resources get acquired at the stages of their exported accesses, or at the top of the pipe when
+    // only their ownership gets transferred
+    auto getAcquireStageMask = [](const ResourceAccess& exportedAccess) -> VkPipelineStageFlags {
+        return exportedAccess.stageMask != 0 ? exportedAccess.stageMask : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    };
+    // The exported resources are indexed by their handles, so that each access can look up its source queues
+    ScratchVector<VkPipelineStageFlags> queueExportStageMasks(queueWaitStageMasks.size(), 0);
+    ScratchUnorderedMultimap<VkBufferHandle, uint32_t> exportedBuffers;
+    ScratchUnorderedMultimap<VkImageHandle, uint32_t> exportedImages;
+    for (const CrossQueueSync::ExportEntry& exportEntry : incomingExports) {
+        uint32_t srcQueueIndex = deviceImpl->getQueueMap()->getQueueUniqueIndex(exportEntry.semaphore.queue);
+        if (std::holds_alternative<NewBufferAccess>(exportEntry.access)) {
+            const NewBufferAccess& access = std::get<NewBufferAccess>(exportEntry.access);
+            queueExportStageMasks[srcQueueIndex] |= getAcquireStageMask(access);
+            exportedBuffers.emplace(access.vkResourceHandle, srcQueueIndex);
+        } else {
+            const NewImageAccess& access = std::get<NewImageAccess>(exportEntry.access);
+            queueExportStageMasks[srcQueueIndex] |= getAcquireStageMask(access);
+            exportedImages.emplace(access.vkResourceHandle, srcQueueIndex);
+        }
+    }
+
+    // A layout transition writes to the image, so a read that needs one counts as a write. The first access of an
+    // image within the jobs transitions from the layout the queue left it in, the rest from the previous access
+    ScratchUnorderedMap<VkImageHandle, VkImageLayout> imageLayouts;
+    auto needsLayoutTransition = [&](const NewImageAccess& access) -> bool {
+        auto [layoutIt, isFirstAccess] = imageLayouts.try_emplace(access.vkResourceHandle, access.layout);
+        if (!isFirstAccess) {
+            bool isTransition = layoutIt->second != access.layout;
+            layoutIt->second = access.layout;
+            return isTransition;
+        }
+        ImageAccessMap* accessMap = syncState->findAccessMap(access.vkResourceHandle, access.resourceId);
+        return accessMap == nullptr || !accessMap->isInLayout(access.range, access.layout);
+    };
+
+    // Reads of resources that weren't exported from another queue can't depend on its work, but any write might
+    // overwrite data that the other queue is still reading
+    VkPipelineStageFlags writeStageMask = 0;
+    ScratchVector<NewBufferAccess> newBufferAccesses;
+    ScratchVector<NewImageAccess> newImageAccesses;
+    for (Job& job : jobs) {
+        auto* cmd = JobResourcePoolContainer::getJobData(job)->record.firstCommandPtr;
+        while (cmd != nullptr) {
+            if (cmd->commandType == JobCommandTypes::ExportBuffer ||
+                cmd->commandType == JobCommandTypes::ExportImage ||
+                cmd->commandType == JobCommandTypes::DiscardImageContents ||
+                cmd->commandType == JobCommandTypes::ImportExternalBuffer ||
+                cmd->commandType == JobCommandTypes::ImportExternalImage) {
+                // The ownership transfers and layout transitions these result in may be placed at any stage
+                writeStageMask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                cmd = cmd->nextCommand;
+                continue;
+            }
+            identifyCommandResourceAccesses(cmd, newBufferAccesses, newImageAccesses);
+
+            for (const NewBufferAccess& access : newBufferAccesses) {
+                if (!access.isReadOnly())
+                    writeStageMask |= access.stageMask;
+                auto [exportBeginIt, exportEndIt] = exportedBuffers.equal_range(access.vkResourceHandle);
+                for (auto exportIt = exportBeginIt; exportIt != exportEndIt; ++exportIt) {
+                    queueExportStageMasks[exportIt->second] |= access.stageMask;
+                }
+            }
+            for (const NewImageAccess& access : newImageAccesses) {
+                bool isTransition = needsLayoutTransition(access);
+                if (!access.isReadOnly() || isTransition)
+                    writeStageMask |= access.stageMask;
+                auto [exportBeginIt, exportEndIt] = exportedImages.equal_range(access.vkResourceHandle);
+                for (auto exportIt = exportBeginIt; exportIt != exportEndIt; ++exportIt) {
+                    queueExportStageMasks[exportIt->second] |= access.stageMask;
+                }
+            }
+
+            cmd = cmd->nextCommand;
+        }
+    }
+
+    for (std::size_t srcQueueIndex = 0; srcQueueIndex < queueWaitStageMasks.size(); srcQueueIndex++) {
+        // Host accesses can't be waited on by the device
+        VkPipelineStageFlags stageMask = (queueExportStageMasks[srcQueueIndex] | writeStageMask) &
+            ~VK_PIPELINE_STAGE_HOST_BIT;
+        // Jobs without any dependent accesses keep waiting at the top of the pipe, so that signalling their
+        // semaphore still implies that the waited work has finished
+        if (stageMask != 0)
+            queueWaitStageMasks[srcQueueIndex] = stageMask;
+    }
+
+    if constexpr (StatisticEventsEnabled) {
+        ScratchVector<uint32_t> waitedQueueIndices;
+        for (Job& job : jobs) {
+            for (const JobSemaphore& jobWait : JobResourcePoolContainer::getJobData(job)->semaphores.jobWaits) {
+                uint32_t waitedQueueIndex = deviceImpl->getQueueMap()->getQueueUniqueIndex(jobWait.queue);
+                if (std::find(waitedQueueIndices.begin(), waitedQueueIndices.end(), waitedQueueIndex) !=
+                    waitedQueueIndices.end())
+                    continue;
+                waitedQueueIndices.push_back(waitedQueueIndex);
+
+                const char* queueName = deviceImpl->getQueueMap()->getQueueInfos()[waitedQueueIndex].name.c_str();
+                reportStatisticEvent(
+                    deviceImpl->getStatisticAggregator(),
+                    StatisticEventType::JobSemaphoreWaitStageMask,
+                    queueWaitStageMasks[waitedQueueIndex],
+                    queueName);
+            }
+        }
+    }
+}
+
+void QueueState::resolveSemaphores(
+    const JobSemaphoreStorage& semaphores,
+    ArrayView<const VkPipelineStageFlags> queueWaitStageMasks,
+    SubmitBatch& submitBatch) const {
     // Reduce to one job semaphore per queue
     ScratchVector<uint32_t> queueIndices;
     queueIndices.reserve(semaphores.jobWaits.size());
@@ -265,8 +882,7 @@ void QueueState::resolveSemaphores(const JobSemaphoreStorage& semaphores, Submit
             queueIndices[i]);
         submitBatch.vkWaitSemaphores.push_back(vkTimelineSemaphore);
         submitBatch.waitSemaphoreValues.push_back(queueTimestamps[i]);
-        // TODO: Determine the latest stage to wait on from job accesses somehow
-        submitBatch.vkWaitStageFlags.push_back(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        submitBatch.vkWaitStageFlags.push_back(queueWaitStageMasks[queueIndices[i]]);
     }
 
     for (const ExternalSemaphore& externalSemaphore : semaphores.externalWaits) {
@@ -291,12 +907,15 @@ void QueueState::resolveSemaphores(const JobSemaphoreStorage& semaphores, Submit
 void QueueState::consumeAwaitingForgets() {
     std::lock_guard<Mutex> mutexLock(syncState->awaitingForgetsMutex);
 
-    for (VkBufferHandle vkBufferHandle : syncState->awaitingBufferForgets) {
-        syncState->bufferResourceMap.erase(vkBufferHandle);
+    // Only free the slots that still belong to the forgotten resources, the ids may have been reused since
+    for (const auto& [vkBufferHandle, resourceId] : syncState->awaitingBufferForgets) {
+        if (syncState->findAccessMap(vkBufferHandle, resourceId) != nullptr)
+            syncState->bufferResourceSlots[resourceId].reset();
     }
     syncState->awaitingBufferForgets.clear();
-    for (VkImageHandle vkImageHandle : syncState->awaitingImageForgets) {
-        syncState->imageResourceMap.erase(vkImageHandle);
+    for (const auto& [vkImageHandle, resourceId] : syncState->awaitingImageForgets) {
+        if (syncState->findAccessMap(vkImageHandle, resourceId) != nullptr)
+            syncState->imageResourceSlots[resourceId].reset();
     }
     syncState->awaitingImageForgets.clear();
 }
@@ -2,60 +2,219 @@
 
 #include "logical_device.hpp"
 #include "cross_queue_sync.hpp"
+#include "event_pool.hpp"
 #include "queue_map.hpp"
+#include "resource_id_allocator.hpp"
 #include "../job/accesses.hpp"
+#include "../job/barrier_plan_cache.hpp"
 #include "../job/job_data.hpp"
 #include "../common_impl.hpp"
 #include <tephra/device.hpp>
+#include <condition_variable>
+#include <exception>
+#include <thread>
 
 namespace tp {
 
+class CommandPool;
+class ThreadPool;
+
 struct QueueSyncState {
-    // TODO: Implement value-cached maps to save allocations
-    std::unordered_map<VkBufferHandle, BufferAccessMap> bufferResourceMap;
-    std::unordered_map<VkImageHandle, ImageAccessMap> imageResourceMap;
+    // Access maps of resources used in this queue, indexed by their device-wide resource ids
+    std::vector<std::unique_ptr<BufferAccessMap>> bufferResourceSlots;
+    std::vector<std::unique_ptr<ImageAccessMap>> imageResourceSlots;
 
-    // Storage of awaiting forgets of deleted resources
+    // Storage of awaiting forgets of deleted resources along with their resource ids
     Mutex awaitingForgetsMutex;
-    std::deque<VkBufferHandle> awaitingBufferForgets;
-    std::deque<VkImageHandle> awaitingImageForgets;
+    std::deque<std::pair<VkBufferHandle, uint32_t>> awaitingBufferForgets;
+    std::deque<std::pair<VkImageHandle, uint32_t>> awaitingImageForgets;
+
+    // Barriers prepared for previous jobs with tp::JobFlag::CachedBarriers, to be reused by jobs of the same structure
+    BarrierPlanCache barrierPlanCache;
+
+    // Returns the access map of the given buffer, or nullptr if it hasn't been used in this queue
+    BufferAccessMap* findAccessMap(VkBufferHandle vkBufferHandle, uint32_t resourceId) {
+        return findAccessMap(bufferResourceSlots, vkBufferHandle, resourceId);
+    }
+
+    ImageAccessMap* findAccessMap(VkImageHandle vkImageHandle, uint32_t resourceId) {
+        return findAccessMap(imageResourceSlots, vkImageHandle, resourceId);
+    }
+
+    // Returns the access map of the given buffer, creating it if it hasn't been used in this queue yet
+    BufferAccessMap& getAccessMap(VkBufferHandle vkBufferHandle, uint32_t resourceId) {
+        return getAccessMap(bufferResourceSlots, vkBufferHandle, resourceId);
+    }
+
+    ImageAccessMap& getAccessMap(VkImageHandle vkImageHandle, uint32_t resourceId) {
+        return getAccessMap(imageResourceSlots, vkImageHandle, resourceId);
+    }
+
+private:
+    template <typename TAccessMap, typename TResourceHandle>
+    static TAccessMap* findAccessMap(
+        std::vector<std::unique_ptr<TAccessMap>>& slots,
+        TResourceHandle vkResourceHandle,
+        uint32_t resourceId) {
+        TEPHRA_ASSERT(resourceId != ResourceIdAllocator::InvalidId);
+        if (resourceId >= slots.size() || slots[resourceId] == nullptr)
+            return nullptr;
+
+        // The id may have been recycled before the forget of its previous resource got processed
+        TAccessMap* accessMap = slots[resourceId].get();
+        if (getResourceHandle(*accessMap) != vkResourceHandle)
+            return nullptr;
+        return accessMap;
+    }
+
+    template <typename TAccessMap, typename TResourceHandle>
+    static TAccessMap& getAccessMap(
+        std::vector<std::unique_ptr<TAccessMap>>& slots,
+        TResourceHandle vkResourceHandle,
+        uint32_t resourceId) {
+        TEPHRA_ASSERT(resourceId != ResourceIdAllocator::InvalidId);
+        if (resourceId >= slots.size())
+            slots.resize(resourceId + 1);
+
+        std::unique_ptr<TAccessMap>& slot = slots[resourceId];
+        if (slot == nullptr || getResourceHandle(*slot) != vkResourceHandle)
+            slot = std::make_unique<TAccessMap>(vkResourceHandle);
+        return *slot;
+    }
+
+    static VkBufferHandle getResourceHandle(const BufferAccessMap& accessMap) {
+        return accessMap.vkGetBufferHandle();
+    }
+
+    static VkImageHandle getResourceHandle(const ImageAccessMap& accessMap) {
+        return accessMap.vkGetImageHandle();
+    }
 };
 
 class QueueState {
 public:
-    QueueState(DeviceContainer* deviceImpl, uint32_t queueIndex);
+    QueueState(DeviceContainer* deviceImpl, uint32_t queueIndex, bool compileInBackground);
 
     void enqueueJob(Job job);
 
     // Removes a resource from synchronization state when it's being deleted
-    void forgetResource(VkBufferHandle vkBufferHandle);
-    void forgetResource(VkImageHandle vkImageHandle);
+    void forgetResource(VkBufferHandle vkBufferHandle, uint32_t resourceId);
+    void forgetResource(VkImageHandle vkImageHandle, uint32_t resourceId);
 
     void submitQueuedJobs(
         const JobSemaphore& lastJobToSubmit,
         ArrayParameter<const JobSemaphore> waitJobSemaphores,
         ArrayParameter<const ExternalSemaphore> waitExternalSemaphores);
 
+    // Joins the background compilation thread, if there is one, and releases the command pools of jobs that were
+    // compiled, but never submitted. Must be called before the rest of the device gets destroyed
+    void stopBackgroundCompilation();
+
     TEPHRA_MAKE_NONCOPYABLE(QueueState);
     TEPHRA_MAKE_NONMOVABLE(QueueState);
-    ~QueueState() = default;
+    ~QueueState();
 
 private:
+    // A job compiled on the background thread, ready to be submitted
+    struct CompiledJob {
+        Job job;
+        CommandPool* commandPool = nullptr;
+        std::vector<VkCommandBufferHandle> vkCommandBuffers;
+        // The stages that wait on the work of each queue, derived from the job's own waits
+        std::vector<VkPipelineStageFlags> queueWaitStageMasks;
+        // The timestamp of each queue up to which the job acquired the resources exported to this queue
+        std::vector<uint64_t> queueQueriedTimestamps;
+        // The exception thrown during compilation, to be rethrown on submit
+        std::exception_ptr exception;
+
+        explicit CompiledJob(Job job) : job(std::move(job)) {}
+    };
+
     DeviceContainer* deviceImpl;
     uint32_t queueIndex;
 
     std::deque<Job> queuedJobs;
-    // Mutex guarding against simulateneous enqueue and submit
+    // Mutex guarding against simulateneous enqueue and submit, as well as the background compilation state
     Mutex queuedJobsMutex;
     std::unique_ptr<QueueSyncState> syncState;
     // For each (other) queue, stores the last timestamp that has been waited on
     std::vector<uint64_t> queueLastQueriedTimestamps;
     // Submit semaphores we queued up for the next job
     JobSemaphoreStorage queuedSemaphoreStorage;
+    // Events for splitting barriers, null if the queue doesn't support them
+    std::unique_ptr<EventPool> splitBarrierEventPool;
+
+    // Background compilation state, the thread is only running if it was requested in tp::DeviceSetup
+    std::thread compileThread;
+    std::condition_variable_any compileWorkAvailable;
+    std::condition_variable_any compileWorkFinished;
+    std::deque<CompiledJob> compiledJobs;
+    // The timestamp of the last job enqueued, compiled and requested to be submitted, respectively
+    uint64_t lastEnqueuedTimestamp = 0;
+    uint64_t lastCompiledTimestamp = 0;
+    uint64_t submitRequestedTimestamp = 0;
+    bool isStoppingCompilation = false;
 
     // Compiles and submits the given jobs
     void submitJobs(ArrayView<Job> jobs);
 
+    // Submits the jobs compiled in the background up to the given one
+    void submitCompiledJobs(
+        const JobSemaphore& lastJobToSubmit,
+        ArrayParameter<const JobSemaphore> waitJobSemaphores,
+        ArrayParameter<const ExternalSemaphore> waitExternalSemaphores);
+
+    // Returns true if any of the submit wait semaphores would have made the given job compiled in the background
+    // acquire more incoming resource exports
+    bool hasUnacquiredExports(const CompiledJob& firstJob, ArrayParameter<const JobSemaphore> waitJobSemaphores)
+        const;
+
+    // Submits the batch and queues up the release of the used command pools once it finishes
+    void submitToQueue(const SubmitBatch& submitBatch, std::vector<CommandPool*> usedCommandPools);
+
+    // The loop of the background compilation thread, compiling queued jobs in timestamp order
+    void runBackgroundCompilation();
+
+    // Returns true if the job at the front of the queue can be compiled in the background, assuming queuedJobsMutex
+    // is locked
+    bool canCompileNextJob() const;
+
+    // Compiles a single job into its own command pool on the background thread
+    CompiledJob compileJobInBackground(Job job);
+
+    // Compiles the jobs into the submit batch, recording all of them on the calling thread
+    void compileJobs(ArrayView<Job> jobs, SubmitBatch& submitBatch, std::vector<CommandPool*>& usedCommandPools);
+
+    // Compiles the jobs into the submit batch, analyzing them sequentially and then recording each job into its own
+    // command pool on the given thread pool
+    void compileJobsInParallel(
+        ArrayView<Job> jobs,
+        ThreadPool* threadPool,
+        SubmitBatch& submitBatch,
+        std::vector<CommandPool*>& usedCommandPools);
+
+    // Returns the end of the range of jobs starting at startJobIndex that can be part of the same submit entry
+    std::size_t findSubmitEntryEnd(ArrayView<Job> jobs, std::size_t startJobIndex) const;
+
+    // Finds incoming resource exports for each of the given jobs, storing their ranges within incomingExports through
+    // the offsets of each job, with one extra offset at the end
+    void queryJobsIncomingExports(
+        ArrayView<Job> jobs,
+        ScratchVector<CrossQueueSync::ExportEntry>& incomingExports,
+        ScratchVector<std::size_t>& jobExportOffsets);
+
+    // Starts a new submit entry, filling in the semaphores of the given jobs
+    void addSubmitEntry(
+        ArrayView<Job> jobs,
+        ArrayView<const VkPipelineStageFlags> queueWaitStageMasks,
+        SubmitBatch& submitBatch) const;
+
+    // Finds the stages of the given jobs that need to wait on the work of each queue, indexed by the queue index
+    void findWaitStageMasks(
+        ArrayView<Job> jobs,
+        ArrayView<const CrossQueueSync::ExportEntry> incomingExports,
+        ScratchVector<VkPipelineStageFlags>& queueWaitStageMasks) const;
+
     // Analyze cross-queue export commands in the job and broadcast them
     void broadcastResourceExports(const JobRecordStorage& jobRecord, const JobSemaphore& srcSemaphore);
 
@@ -65,7 +224,10 @@ private:
         ScratchVector<CrossQueueSync::ExportEntry>& incomingExports);
 
     // Translates semaphores to a Vulkan submit batch
-    void resolveSemaphores(const JobSemaphoreStorage& semaphores, SubmitBatch& submitBatch) const;
+    void resolveSemaphores(
+        const JobSemaphoreStorage& semaphores,
+        ArrayView<const VkPipelineStageFlags> queueWaitStageMasks,
+        SubmitBatch& submitBatch) const;
 
     // Handles forgotten resources
     void consumeAwaitingForgets();
@@ -0,0 +1,53 @@
+#include "resource_id_allocator.hpp"
+
+namespace tp {
+
+template <>
+ResourceIdAllocator::IdSpace<VkBufferHandle>& ResourceIdAllocator::getIdSpace() {
+    return bufferIds;
+}
+
+template <>
+ResourceIdAllocator::IdSpace<VkImageHandle>& ResourceIdAllocator::getIdSpace() {
+    return imageIds;
+}
+
+template <typename TResourceHandle>
+uint32_t ResourceIdAllocator::allocateId(const TResourceHandle& vkResourceHandle) {
+    TEPHRA_ASSERT(!vkResourceHandle.isNull());
+    std::lock_guard<Mutex> mutexLock(mutex);
+    IdSpace<TResourceHandle>& idSpace = getIdSpace<TResourceHandle>();
+
+    uint32_t id;
+    if (!idSpace.freeIds.empty()) {
+        id = idSpace.freeIds.back();
+        idSpace.freeIds.pop_back();
+    } else {
+        id = idSpace.nextId++;
+    }
+
+    idSpace.assignedIds[vkResourceHandle] = id;
+    return id;
+}
+
+template <typename TResourceHandle>
+uint32_t ResourceIdAllocator::freeId(const TResourceHandle& vkResourceHandle) {
+    std::lock_guard<Mutex> mutexLock(mutex);
+    IdSpace<TResourceHandle>& idSpace = getIdSpace<TResourceHandle>();
+
+    auto assignedIt = idSpace.assignedIds.find(vkResourceHandle);
+    if (assignedIt == idSpace.assignedIds.end())
+        return InvalidId;
+
+    uint32_t id = assignedIt->second;
+    idSpace.assignedIds.erase(assignedIt);
+    idSpace.freeIds.push_back(id);
+    return id;
+}
+
+template uint32_t ResourceIdAllocator::allocateId(const VkBufferHandle& vkResourceHandle);
+template uint32_t ResourceIdAllocator::allocateId(const VkImageHandle& vkResourceHandle);
+template uint32_t ResourceIdAllocator::freeId(const VkBufferHandle& vkResourceHandle);
+template uint32_t ResourceIdAllocator::freeId(const VkImageHandle& vkResourceHandle);
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../common_impl.hpp"
+#include <unordered_map>
+#include <vector>
+
+namespace tp {
+
+// Assigns compact, device-wide ids to buffer and image resources, so that their per-queue synchronization state can be
+// kept in dense arrays rather than in hash maps. Ids of destroyed resources get recycled.
+class ResourceIdAllocator {
+public:
+    static constexpr uint32_t InvalidId = ~0u;
+
+    // Assigns a new id to the given resource handle
+    template <typename TResourceHandle>
+    uint32_t allocateId(const TResourceHandle& vkResourceHandle);
+
+    // Frees the id assigned to the given resource handle for reuse and returns it, or InvalidId if it has none
+    template <typename TResourceHandle>
+    uint32_t freeId(const TResourceHandle& vkResourceHandle);
+
+private:
+    template <typename TResourceHandle>
+    struct IdSpace {
+        std::unordered_map<TResourceHandle, uint32_t> assignedIds;
+        std::vector<uint32_t> freeIds;
+        uint32_t nextId = 0;
+    };
+
+    IdSpace<VkBufferHandle> bufferIds;
+    IdSpace<VkImageHandle> imageIds;
+    Mutex mutex;
+
+    template <typename TResourceHandle>
+    IdSpace<TResourceHandle>& getIdSpace();
+};
+
+}
@@ -1,6 +1,7 @@
 
 #include "image_impl.hpp"
 #include "device/device_container.hpp"
+#include "job/local_images.hpp"
 
 namespace tp {
 
@@ -25,6 +26,8 @@ ImageImpl::ImageImpl(
 
     createView_(defaultView.setup);
     vkDefaultViewHandle = viewHandleMap[defaultView.setup];
+
+    resourceId = deviceImpl->getResourceIdAllocator()->allocateId(this->imageHandle.vkGetHandle());
 }
 
 Extent3D ImageImpl::getExtent_(uint32_t mipLevel) const {
@@ -79,6 +82,10 @@ void ImageImpl::destroyHandles(bool immediately) {
     }
     viewHandleMap.clear();
 
+    // Non-owned handles don't go through the deferred destructor, which would otherwise recycle the resource id
+    if (imageHandle.isNonOwning())
+        deviceImpl->getResourceIdAllocator()->freeId(imageHandle.vkGetHandle());
+
     imageHandle.destroyHandle(immediately);
     memoryAllocationHandle.destroyHandle(immediately);
 }
@@ -99,6 +106,14 @@ ImageImpl& ImageImpl::getImageImpl(const ImageView& imageView) {
     return *std::get<ImageImpl*>(imageView.image);
 }
 
+uint32_t ImageImpl::resolveResourceId(const ImageView& imageView) {
+    if (imageView.viewsJobLocalImage()) {
+        return getImageImpl(JobLocalImageImpl::getViewToUnderlyingImage(imageView)).getResourceId();
+    } else {
+        return getImageImpl(imageView).getResourceId();
+    }
+}
+
 ImageViewSetup ImageImpl::getDefaultViewSetup(const ImageSetup& imageSetup) {
     bool isArray = imageSetup.arrayLayerCount > 1;
 
@@ -86,12 +86,20 @@ public:
         return imageHandle.vkGetHandle();
     }
 
+    // Returns the compact device-wide id used to index the image's synchronization state
+    uint32_t getResourceId() const {
+        return resourceId;
+    }
+
     void destroyHandles(bool immediately);
 
     static VkImageViewHandle vkGetImageViewHandle(const ImageView& imageView);
 
     static ImageImpl& getImageImpl(const ImageView& imageView);
 
+    // Returns the resource id of the image the view ultimately refers to, resolving job-local images
+    static uint32_t resolveResourceId(const ImageView& imageView);
+
     static ImageViewSetup getDefaultViewSetup(const ImageSetup& imageSetup);
 
     TEPHRA_MAKE_NONCOPYABLE(ImageImpl);
@@ -111,6 +119,7 @@ private:
     ImageType type;
     Extent3D extent;
     MultisampleLevel sampleLevel;
+    uint32_t resourceId;
 
     ImageView defaultView;
     bool canHaveVulkanViews;
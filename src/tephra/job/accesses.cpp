@@ -378,23 +378,29 @@ ResourceAccess operator|(const ResourceAccess& a, const ResourceAccess& b) {
     return ResourceAccess(a.stageMask | b.stageMask, a.accessMask | b.accessMask);
 }
 
-std::pair<VkBufferHandle, BufferAccessRange> resolveBufferAccess(StoredBufferView& bufferView) {
+uint64_t packSignatureWord(uint32_t low, uint32_t high) {
+    return static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+}
+
+std::tuple<VkBufferHandle, uint32_t, BufferAccessRange> resolveBufferAccess(StoredBufferView& bufferView) {
     BufferAccessRange range = { 0, bufferView.getSize() };
-    VkBufferHandle vkBufferHandle = resolveBufferAccess(bufferView, &range);
-    return { vkBufferHandle, range };
+    uint32_t resourceId;
+    VkBufferHandle vkBufferHandle = resolveBufferAccess(bufferView, &range, &resourceId);
+    return { vkBufferHandle, resourceId, range };
 }
 
-VkBufferHandle resolveBufferAccess(StoredBufferView& bufferView, BufferAccessRange* range) {
+VkBufferHandle resolveBufferAccess(StoredBufferView& bufferView, BufferAccessRange* range, uint32_t* resourceId) {
     uint64_t viewOffset;
     VkBufferHandle vkBufferHandle = bufferView.vkResolveBufferHandle(&viewOffset);
     TEPHRA_ASSERT(!vkBufferHandle.isNull());
     TEPHRA_ASSERT(range->offset + range->size <= bufferView.getSize());
 
     range->offset += viewOffset;
+    *resourceId = bufferView.getResourceId();
     return vkBufferHandle;
 }
 
-VkImageHandle resolveImageAccess(StoredImageView& imageView, ImageAccessRange* range) {
+VkImageHandle resolveImageAccess(StoredImageView& imageView, ImageAccessRange* range, uint32_t* resourceId) {
     uint32_t viewBaseMipLevel;
     uint32_t viewBaseArrayLevel;
     VkImageHandle vkImageHandle = imageView.vkResolveImageHandle(&viewBaseMipLevel, &viewBaseArrayLevel);
@@ -404,6 +410,7 @@ VkImageHandle resolveImageAccess(StoredImageView& imageView, ImageAccessRange* r
 
     range->baseArrayLayer += viewBaseArrayLevel;
     range->mipLevelMask <<= viewBaseMipLevel;
+    *resourceId = imageView.getResourceId();
     return vkImageHandle;
 }
 
@@ -432,11 +439,11 @@ void BufferAccessMap::synchronizeNewAccess(
     }
 
     // Iterate over all overlapping ranges
-    auto rangeIts = accessMap.equal_range(newAccess.range);
+    auto [firstIt, lastIt] = accessMap.findOverlapping(newAccess.range);
 
-    for (auto& it = rangeIts.first; it != rangeIts.second; ++it) {
-        const BufferAccessRange& entryRange = it->first;
-        BufferRangeEntry& entry = it->second;
+    for (auto it = firstIt; it != lastIt; ++it) {
+        const BufferAccessRange& entryRange = it->range;
+        BufferRangeEntry& entry = it->value;
         TEPHRA_ASSERT(areAccessRangesOverlapping(entryRange, newAccess.range));
 
         if (newAccess.isReadOnly()) {
@@ -457,7 +464,11 @@ void BufferAccessMap::synchronizeNewAccess(
                         readAfterWriteDependency, entry.barrierAfterWriteAccess);
                 } else {
                     entry.barrierAfterWriteAccess = barriers.synchronizeDependency(
-                        readAfterWriteDependency, commandIndex, entry.barrierIndexAfterWriteAccess, entry.wasExported);
+                        readAfterWriteDependency,
+                        commandIndex,
+                        entry.barrierIndexAfterWriteAccess,
+                        entry.wasExported,
+                        entry.commandIndexAfterAccesses);
                 }
             }
         } else {
@@ -470,7 +481,11 @@ void BufferAccessMap::synchronizeNewAccess(
                 auto writeAfterReadDependency = BufferDependency(
                     vkBufferHandle, intersectionRange, entry.lastReadAccesses, newAccess);
                 lastBarrier = barriers.synchronizeDependency(
-                    writeAfterReadDependency, commandIndex, entry.barrierIndexAfterReadAccesses, entry.wasExported);
+                    writeAfterReadDependency,
+                    commandIndex,
+                    entry.barrierIndexAfterReadAccesses,
+                    entry.wasExported,
+                    entry.commandIndexAfterAccesses);
             }
 
             if (!entry.lastWriteAccess.isNull()) {
@@ -484,15 +499,77 @@ void BufferAccessMap::synchronizeNewAccess(
                     barriers.synchronizeDependency(writeAfterWriteDependency, lastBarrier);
                 } else {
                     barriers.synchronizeDependency(
-                        writeAfterWriteDependency, commandIndex, entry.barrierIndexAfterWriteAccess, entry.wasExported);
+                        writeAfterWriteDependency,
+                        commandIndex,
+                        entry.barrierIndexAfterWriteAccess,
+                        entry.wasExported,
+                        entry.commandIndexAfterAccesses);
                 }
             }
         }
     }
 }
 
+void BufferAccessMap::synchronizeOwnershipRelease(
+    const NewBufferAccess& releaseAccess,
+    uint32_t srcQueueFamilyIndex,
+    uint32_t dstQueueFamilyIndex,
+    BarrierList& barriers) {
+    if (lastJobId != barriers.getJobId()) {
+        // Lazy barrier reset
+        resetBarriers();
+        lastJobId = barriers.getJobId();
+    }
+
+    // The release must cover the exact range that the destination queue acquires, so instead of synchronizing each
+    // overlapping entry separately, merge all of their accesses into one dependency placed after all of them
+    PastAccesses pastAccesses = getPastAccesses(releaseAccess.range, barriers);
+    if (pastAccesses.access.isNull())
+        pastAccesses.access = ResourceAccess(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+
+    auto releaseDependency = BufferDependency(
+        vkBufferHandle,
+        releaseAccess.range,
+        pastAccesses.access,
+        releaseAccess,
+        srcQueueFamilyIndex,
+        dstQueueFamilyIndex);
+    barriers.synchronizeDependency(
+        releaseDependency,
+        ~0,
+        pastAccesses.barrierIndexAfterAccesses,
+        pastAccesses.wasExported,
+        pastAccesses.commandIndexAfterAccesses);
+}
+
+PastAccesses BufferAccessMap::getPastAccesses(const BufferAccessRange& range, BarrierList& barriers) {
+    if (lastJobId != barriers.getJobId()) {
+        // Lazy barrier reset
+        resetBarriers();
+        lastJobId = barriers.getJobId();
+    }
+
+    PastAccesses pastAccesses;
+    auto [firstIt, lastIt] = accessMap.findOverlapping(range);
+    for (auto it = firstIt; it != lastIt; ++it) {
+        const BufferRangeEntry& entry = it->value;
+        // Only the write access needs to be made available, the reads just need to finish
+        pastAccesses.access.stageMask |= entry.lastWriteAccess.stageMask | entry.lastReadAccesses.stageMask;
+        pastAccesses.access.accessMask |= entry.lastWriteAccess.accessMask;
+        uint32_t barrierIndexAfterAccesses = tp::max(
+            entry.barrierIndexAfterWriteAccess, entry.barrierIndexAfterReadAccesses);
+        pastAccesses.barrierIndexAfterAccesses = tp::max(
+            pastAccesses.barrierIndexAfterAccesses, barrierIndexAfterAccesses);
+        pastAccesses.commandIndexAfterAccesses = tp::max(
+            pastAccesses.commandIndexAfterAccesses, entry.commandIndexAfterAccesses);
+        pastAccesses.wasExported = pastAccesses.wasExported || entry.wasExported;
+    }
+    return pastAccesses;
+}
+
 void BufferAccessMap::insertNewAccess(
     const NewBufferAccess& newAccess,
+    uint32_t commandIndexAfterAccess,
     uint32_t nextBarrierIndex,
     bool forceOverwrite,
     bool isExport) {
@@ -500,37 +577,118 @@ void BufferAccessMap::insertNewAccess(
     TEPHRA_ASSERT(!newAccess.range.isNull());
     TEPHRA_ASSERT(!isExport || newAccess.isReadOnly());
 
-    // Iterate over all overlapping ranges
-    auto rangeIts = accessMap.equal_range(newAccess.range);
     if (newAccess.isReadOnly() && !forceOverwrite) {
         // Read accesses don't subdivide previous accesses, just extend them
-        for (auto& it = rangeIts.first; it != rangeIts.second; ++it) {
-            BufferRangeEntry& entry = it->second;
+        auto [firstIt, lastIt] = accessMap.findOverlapping(newAccess.range);
+        for (auto it = firstIt; it != lastIt; ++it) {
+            BufferRangeEntry& entry = it->value;
 
             entry.lastReadAccesses = entry.lastReadAccesses | newAccess;
             entry.barrierIndexAfterReadAccesses = nextBarrierIndex;
             entry.wasExported = entry.wasExported || isExport;
+            entry.commandIndexAfterAccesses = commandIndexAfterAccess;
         }
+
+        // The extended entries may now be identical to each other or their neighbors
+        std::size_t firstIndex = firstIt - accessMap.begin();
+        std::size_t lastIndex = lastIt - accessMap.begin();
+        accessMap.coalesce(firstIndex > 0 ? firstIndex - 1 : 0, tp::min(lastIndex + 1, accessMap.size()));
     } else {
-        // Erase all overlapping ranges
-        auto& it = rangeIts.first;
-        while (it != rangeIts.second) {
-            it = removeOverlappingRange(it, newAccess.range);
+        // Overwrite all overlapping ranges with the new access
+        accessMap.assign(
+            newAccess.range, BufferRangeEntry(newAccess, commandIndexAfterAccess, nextBarrierIndex, isExport));
+    }
+}
+
+void BufferAccessMap::getAccessStates(uint32_t resourceId, std::vector<BufferAccessState>& states) const {
+    for (const auto& mapEntry : accessMap) {
+        const BufferRangeEntry& entry = mapEntry.value;
+        if (entry.lastWriteAccess.isNull() && entry.lastReadAccesses.isNull())
+            continue;
+
+        states.push_back(
+            { vkBufferHandle,
+              resourceId,
+              mapEntry.range,
+              entry.lastWriteAccess,
+              entry.lastReadAccesses,
+              entry.wasExported });
+    }
+}
+
+bool BufferAccessMap::isInAccessState(const BufferAccessState& state) {
+    auto [firstIt, lastIt] = accessMap.findOverlapping(state.range);
+    for (auto it = firstIt; it != lastIt; ++it) {
+        const BufferRangeEntry& entry = it->value;
+
+        if (state.lastWriteAccess.isNull()) {
+            // Without a write access in the state, the range only needs to have been synchronized for its reads
+            if (containsAllBits(entry.lastReadAccesses.stageMask, state.lastReadAccesses.stageMask) &&
+                containsAllBits(entry.lastReadAccesses.accessMask, state.lastReadAccesses.accessMask))
+                continue;
+        } else if (entry.lastWriteAccess == state.lastWriteAccess && entry.lastReadAccesses == state.lastReadAccesses) {
+            continue;
         }
+        return false;
+    }
+    return true;
+}
 
-        // With the space for the new access free, add its entry
-        accessMap.emplace_hint(
-            rangeIts.second, newAccess.range, BufferRangeEntry(newAccess, nextBarrierIndex, isExport));
+void BufferAccessMap::insertAccessState(const BufferAccessState& state, uint32_t nextBarrierIndex) {
+    // Overwrite the range with the last write access, if any, then extend it with the reads that followed
+    if (!state.lastWriteAccess.isNull()) {
+        insertNewAccess(
+            NewBufferAccess(state.vkResourceHandle, state.resourceId, state.range, state.lastWriteAccess),
+            ~0,
+            nextBarrierIndex,
+            true);
     }
+    if (!state.lastReadAccesses.isNull()) {
+        insertNewAccess(
+            NewBufferAccess(state.vkResourceHandle, state.resourceId, state.range, state.lastReadAccesses),
+            ~0,
+            nextBarrierIndex,
+            false,
+            state.wasExported);
+    }
+}
+
+void BufferAccessMap::appendSignature(uint64_t jobId, std::vector<uint64_t>& signature) {
+    if (lastJobId != jobId) {
+        resetBarriers();
+        lastJobId = jobId;
+    }
+
+    signature.push_back(accessMap.size());
+    for (const auto& mapEntry : accessMap) {
+        const BufferRangeEntry& entry = mapEntry.value;
+        signature.push_back(mapEntry.range.offset);
+        signature.push_back(mapEntry.range.size);
+        signature.push_back(packSignatureWord(entry.lastWriteAccess.stageMask, entry.lastWriteAccess.accessMask));
+        signature.push_back(packSignatureWord(entry.lastReadAccesses.stageMask, entry.lastReadAccesses.accessMask));
+        signature.push_back(
+            packSignatureWord(entry.barrierIndexAfterWriteAccess, entry.barrierIndexAfterReadAccesses));
+        signature.push_back(packSignatureWord(
+            entry.barrierAfterWriteAccess.pipelineBarrierIndex, entry.barrierAfterWriteAccess.memoryBarrierIndex));
+        signature.push_back(packSignatureWord(entry.commandIndexAfterAccesses, entry.wasExported));
+    }
+}
+
+void BufferAccessMap::assignAccesses(const BufferAccessMap& other, uint64_t jobId) {
+    TEPHRA_ASSERT(other.vkBufferHandle == vkBufferHandle);
+    accessMap = other.accessMap;
+    lastJobId = jobId;
 }
 
 void BufferAccessMap::resetBarriers() {
-    for (auto& mapPair : accessMap) {
-        BufferRangeEntry& entry = mapPair.second;
+    for (auto& mapEntry : accessMap) {
+        BufferRangeEntry& entry = mapEntry.value;
         entry.barrierIndexAfterReadAccesses = 0;
         entry.barrierIndexAfterWriteAccess = 0;
         entry.barrierAfterWriteAccess = BarrierReference();
+        entry.commandIndexAfterAccesses = 0;
     }
+    accessMap.coalesce();
 }
 
 void BufferAccessMap::clear() {
@@ -539,30 +697,8 @@ void BufferAccessMap::clear() {
     // Initialize the access map to the given access
     // We don't know the actual size of the buffer, so improvise
     auto wholeRange = BufferAccessRange(0, ~0ull);
-    auto defaultEntry = BufferRangeEntry({}, 0, false);
-    accessMap.emplace(wholeRange, defaultEntry);
-}
-
-BufferAccessMap::AccessMapType::iterator BufferAccessMap::removeOverlappingRange(
-    const BufferAccessMap::AccessMapType::iterator& entryIt,
-    const BufferAccessRange& overlappingRange) {
-    BufferAccessRange entryRange = entryIt->first;
-    BufferRangeEntry entry = entryIt->second;
-
-    // Erase the overlapping range
-    AccessMapType::iterator it = accessMap.erase(entryIt);
-
-    // But keep the non-overlapping parts, splitting the range if necessary
-    BufferAccessRange leftRange = getAccessRangeDifferenceLeft(entryRange, overlappingRange);
-    if (!leftRange.isNull()) {
-        accessMap.emplace_hint(it, leftRange, entry);
-    }
-    BufferAccessRange rightRange = getAccessRangeDifferenceRight(entryRange, overlappingRange);
-    if (!rightRange.isNull()) {
-        accessMap.emplace_hint(it, rightRange, entry);
-    }
-
-    return it;
+    auto defaultEntry = BufferRangeEntry({}, 0, 0, false);
+    accessMap.assign(wholeRange, defaultEntry);
 }
 
 ImageAccessMap::ImageAccessMap(VkImageHandle vkImageHandle) : vkImageHandle(vkImageHandle) {
@@ -573,21 +709,22 @@ uint64_t ImageAccessMap::getAccessCount() const {
     return accessMap.size();
 }
 
-void ImageAccessMap::synchronizeNewAccess(const NewImageAccess& newAccess, uint32_t commandIndex, BarrierList& barriers) {
+void ImageAccessMap::synchronizeNewAccess(
+    const NewImageAccess& newAccess,
+    uint32_t commandIndex,
+    BarrierList& barriers,
+    const PastAccesses* aliasedMemoryAccesses) {
     if (lastJobId != barriers.getJobId()) {
         // Lazy compact and barrier reset
         compactAndResetBarriers();
         lastJobId = barriers.getJobId();
     }
 
-    // Iterate over all ranges, besides the ones we add
-    std::size_t origSize = accessMap.size();
-    for (std::size_t i = 0; i < origSize; i++) {
+    // Iterate over all overlapping ranges, besides the ones we add
+    findOverlappingEntries(newAccess.range);
+    for (uint32_t i : overlappingEntries) {
         ImageAccessRange& entryRange = accessMap[i].first;
         ImageRangeEntry& entry = accessMap[i].second;
-        if (!areAccessRangesOverlapping(newAccess.range, entryRange)) {
-            continue;
-        }
 
         // Treat layout transition accesses as write accesses
         bool needsLayoutTransition = newAccess.layout != entry.layout && newAccess.layout != VK_IMAGE_LAYOUT_UNDEFINED;
@@ -609,7 +746,11 @@ void ImageAccessMap::synchronizeNewAccess(const NewImageAccess& newAccess, uint3
                         readAfterWriteDependency, entry.barrierAfterWriteAccess);
                 } else {
                     entry.barrierAfterWriteAccess = barriers.synchronizeDependency(
-                        readAfterWriteDependency, commandIndex, entry.barrierIndexAfterWriteAccess, entry.wasExported);
+                        readAfterWriteDependency,
+                        commandIndex,
+                        entry.barrierIndexAfterWriteAccess,
+                        entry.wasExported,
+                        entry.commandIndexAfterAccesses);
                 }
             }
         } else {
@@ -622,7 +763,11 @@ void ImageAccessMap::synchronizeNewAccess(const NewImageAccess& newAccess, uint3
                 auto writeAfterReadDependency = ImageDependency(
                     vkImageHandle, intersectionRange, entry.lastReadAccesses, newAccess, entry.layout, newAccess.layout);
                 lastBarrier = barriers.synchronizeDependency(
-                    writeAfterReadDependency, commandIndex, entry.barrierIndexAfterReadAccesses, entry.wasExported);
+                    writeAfterReadDependency,
+                    commandIndex,
+                    entry.barrierIndexAfterReadAccesses,
+                    entry.wasExported,
+                    entry.commandIndexAfterAccesses);
             }
 
             if (!entry.lastWriteAccess.isNull()) {
@@ -637,18 +782,37 @@ void ImageAccessMap::synchronizeNewAccess(const NewImageAccess& newAccess, uint3
                     barriers.synchronizeDependency(writeAfterWriteDependency, lastBarrier);
                 } else {
                     lastBarrier = barriers.synchronizeDependency(
-                        writeAfterWriteDependency, commandIndex, entry.barrierIndexAfterWriteAccess, entry.wasExported);
+                        writeAfterWriteDependency,
+                        commandIndex,
+                        entry.barrierIndexAfterWriteAccess,
+                        entry.wasExported,
+                        entry.commandIndexAfterAccesses);
                 }
             }
 
             if (needsLayoutTransition) {
                 if (lastBarrier.isNull()) {
-                    // Layout transition but no previous access to sync against - just transition
-                    ResourceAccess noneAccess = ResourceAccess(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+                    // Layout transition but no previous access of the image to sync against. The transition writes
+                    // to the image's memory, so it still has to follow the accesses of any resources it aliases
+                    PastAccesses srcAccesses;
+                    if (aliasedMemoryAccesses != nullptr)
+                        srcAccesses = *aliasedMemoryAccesses;
+                    if (srcAccesses.access.isNull())
+                        srcAccesses.access = ResourceAccess(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+
                     auto transitionDependency = ImageDependency(
-                        vkImageHandle, intersectionRange, noneAccess, newAccess, entry.layout, newAccess.layout);
+                        vkImageHandle,
+                        intersectionRange,
+                        srcAccesses.access,
+                        newAccess,
+                        entry.layout,
+                        newAccess.layout);
                     lastBarrier = barriers.synchronizeDependency(
-                        transitionDependency, commandIndex, entry.barrierIndexAfterWriteAccess, entry.wasExported);
+                        transitionDependency,
+                        commandIndex,
+                        tp::max(entry.barrierIndexAfterWriteAccess, srcAccesses.barrierIndexAfterAccesses),
+                        entry.wasExported || srcAccesses.wasExported,
+                        tp::max(entry.commandIndexAfterAccesses, srcAccesses.commandIndexAfterAccesses));
                 }
 
                 if (newAccess.isReadOnly()) {
@@ -665,8 +829,61 @@ void ImageAccessMap::synchronizeNewAccess(const NewImageAccess& newAccess, uint3
     }
 }
 
+bool ImageAccessMap::synchronizeOwnershipRelease(
+    const NewImageAccess& releaseAccess,
+    uint32_t srcQueueFamilyIndex,
+    uint32_t dstQueueFamilyIndex,
+    BarrierList& barriers) {
+    if (lastJobId != barriers.getJobId()) {
+        // Lazy compact and barrier reset
+        compactAndResetBarriers();
+        lastJobId = barriers.getJobId();
+    }
+
+    // The release must match the acquire barrier of the destination queue, which doesn't know the previous layouts
+    findOverlappingEntries(releaseAccess.range);
+    for (uint32_t i : overlappingEntries) {
+        if (accessMap[i].second.layout != releaseAccess.layout)
+            return false;
+    }
+
+    // Merge the accesses of all overlapping entries into one dependency placed after all of them
+    ResourceAccess srcAccess;
+    uint32_t firstReusableBarrierIndex = 0;
+    uint32_t srcCommandIndex = 0;
+    bool wasExported = false;
+
+    for (uint32_t i : overlappingEntries) {
+        const ImageRangeEntry& entry = accessMap[i].second;
+        // Only the write access needs to be made available, the reads just need to finish
+        srcAccess.stageMask |= entry.lastWriteAccess.stageMask | entry.lastReadAccesses.stageMask;
+        srcAccess.accessMask |= entry.lastWriteAccess.accessMask;
+        uint32_t barrierIndexAfterAccesses = tp::max(
+            entry.barrierIndexAfterWriteAccess, entry.barrierIndexAfterReadAccesses);
+        firstReusableBarrierIndex = tp::max(firstReusableBarrierIndex, barrierIndexAfterAccesses);
+        srcCommandIndex = tp::max(srcCommandIndex, entry.commandIndexAfterAccesses);
+        wasExported = wasExported || entry.wasExported;
+    }
+
+    if (srcAccess.isNull())
+        srcAccess = ResourceAccess(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+
+    auto releaseDependency = ImageDependency(
+        vkImageHandle,
+        releaseAccess.range,
+        srcAccess,
+        releaseAccess,
+        releaseAccess.layout,
+        releaseAccess.layout,
+        srcQueueFamilyIndex,
+        dstQueueFamilyIndex);
+    barriers.synchronizeDependency(releaseDependency, ~0, firstReusableBarrierIndex, wasExported, srcCommandIndex);
+    return true;
+}
+
 void ImageAccessMap::insertNewAccess(
     const NewImageAccess& newAccess,
+    uint32_t commandIndexAfterAccess,
     uint32_t nextBarrierIndex,
     bool forceOverwrite,
     bool isExport) {
@@ -677,11 +894,9 @@ void ImageAccessMap::insertNewAccess(
     if (newAccess.isReadOnly() && !forceOverwrite) {
         // Read accesses don't subdivide previous accesses, just extend them, except when they need
         // an image layout transition, then they partly act like write accesses
-        for (auto& entryPair : accessMap) {
-            const ImageAccessRange& entryRange = entryPair.first;
-            ImageRangeEntry& entry = entryPair.second;
-            if (!areAccessRangesOverlapping(newAccess.range, entryRange))
-                continue;
+        findOverlappingEntries(newAccess.range);
+        for (uint32_t i : overlappingEntries) {
+            ImageRangeEntry& entry = accessMap[i].second;
 
             bool hadLayoutTransition = newAccess.layout != entry.layout &&
                 newAccess.layout != VK_IMAGE_LAYOUT_UNDEFINED;
@@ -689,6 +904,7 @@ void ImageAccessMap::insertNewAccess(
                 entry.lastReadAccesses = entry.lastReadAccesses | newAccess;
                 entry.barrierIndexAfterReadAccesses = nextBarrierIndex;
                 entry.wasExported = entry.wasExported || isExport;
+                entry.commandIndexAfterAccesses = commandIndexAfterAccess;
             } else {
                 // Read access with layout transition. Treat the transition as a new write access, but keep the
                 // references to the original transition barrier (if it exists), so we can potentially reuse it later.
@@ -696,24 +912,24 @@ void ImageAccessMap::insertNewAccess(
                 entry.lastReadAccesses = static_cast<tp::ResourceAccess>(newAccess);
                 entry.barrierIndexAfterReadAccesses = nextBarrierIndex;
                 entry.wasExported = isExport;
+                entry.commandIndexAfterAccesses = commandIndexAfterAccess;
                 entry.layout = newAccess.layout;
             }
         }
     } else {
         // Erase all overlapping ranges and insert the entry
         bool hasAddedEntry = false;
-        std::size_t origSize = accessMap.size();
-        for (std::size_t i = 0; i < origSize; i++) {
-            if (areAccessRangesOverlapping(newAccess.range, accessMap[i].first)) {
-                splitOverlappingRange(i, newAccess.range);
-
-                if (!hasAddedEntry) {
-                    accessMap[i] = { newAccess.range,
-                                     ImageRangeEntry(newAccess, nextBarrierIndex, newAccess.layout, isExport) };
-                    hasAddedEntry = true;
-                } else {
-                    accessMap[i].first = {};
-                }
+        findOverlappingEntries(newAccess.range);
+        for (uint32_t i : overlappingEntries) {
+            splitOverlappingRange(i, newAccess.range);
+
+            if (!hasAddedEntry) {
+                setEntryRange(i, newAccess.range);
+                accessMap[i].second = ImageRangeEntry(
+                    newAccess, commandIndexAfterAccess, nextBarrierIndex, newAccess.layout, isExport);
+                hasAddedEntry = true;
+            } else {
+                setEntryRange(i, {});
             }
         }
         TEPHRA_ASSERT(hasAddedEntry);
@@ -721,10 +937,9 @@ void ImageAccessMap::insertNewAccess(
 }
 
 void ImageAccessMap::discardContents(const ImageAccessRange& range) {
-    std::size_t origSize = accessMap.size();
-    for (std::size_t i = 0; i < origSize; i++) {
-        if (areAccessRangesOverlapping(range, accessMap[i].first) &&
-            accessMap[i].second.layout != VK_IMAGE_LAYOUT_UNDEFINED) {
+    findOverlappingEntries(range);
+    for (uint32_t i : overlappingEntries) {
+        if (accessMap[i].second.layout != VK_IMAGE_LAYOUT_UNDEFINED) {
             // Split the overlapping range and reset its layout
             splitOverlappingRange(i, range);
             accessMap[i].second.layout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -732,15 +947,134 @@ void ImageAccessMap::discardContents(const ImageAccessRange& range) {
     }
 }
 
+void ImageAccessMap::getAccessStates(uint32_t resourceId, std::vector<ImageAccessState>& states) const {
+    for (const auto& [entryRange, entry] : accessMap) {
+        if (entryRange.isNull() || (entry.lastWriteAccess.isNull() && entry.lastReadAccesses.isNull()))
+            continue;
+
+        states.push_back(
+            { vkImageHandle,
+              resourceId,
+              entryRange,
+              entry.lastWriteAccess,
+              entry.lastReadAccesses,
+              entry.wasExported,
+              entry.layout });
+    }
+}
+
+bool ImageAccessMap::isInAccessState(const ImageAccessState& state) {
+    findOverlappingEntries(state.range);
+    for (uint32_t i : overlappingEntries) {
+        const ImageRangeEntry& entry = accessMap[i].second;
+        if (entry.layout != state.layout)
+            return false;
+
+        if (state.lastWriteAccess.isNull()) {
+            // Without a write access in the state, the range only needs to have been synchronized for its reads
+            if (containsAllBits(entry.lastReadAccesses.stageMask, state.lastReadAccesses.stageMask) &&
+                containsAllBits(entry.lastReadAccesses.accessMask, state.lastReadAccesses.accessMask))
+                continue;
+        } else if (entry.lastWriteAccess == state.lastWriteAccess && entry.lastReadAccesses == state.lastReadAccesses) {
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+void ImageAccessMap::insertAccessState(const ImageAccessState& state, uint32_t nextBarrierIndex) {
+    // Overwrite the range with the last write access, if any, then extend it with the reads that followed. The reads
+    // share the layout of the write, so they won't be mistaken for a layout transition
+    if (!state.lastWriteAccess.isNull()) {
+        insertNewAccess(
+            NewImageAccess(state.vkResourceHandle, state.resourceId, state.range, state.lastWriteAccess, state.layout),
+            ~0,
+            nextBarrierIndex,
+            true);
+    }
+    if (!state.lastReadAccesses.isNull()) {
+        insertNewAccess(
+            NewImageAccess(state.vkResourceHandle, state.resourceId, state.range, state.lastReadAccesses, state.layout),
+            ~0,
+            nextBarrierIndex,
+            false,
+            state.wasExported);
+    }
+}
+
+bool ImageAccessMap::isInLayout(const ImageAccessRange& range, VkImageLayout layout) {
+    auto getSubresourceCount = [](const ImageAccessRange& subresourceRange) -> uint64_t {
+        uint32_t aspectBits = static_cast<uint32_t>(
+            static_cast<ImageAspectMask::EnumValueType>(subresourceRange.aspectMask));
+        return static_cast<uint64_t>(subresourceRange.arrayLayerCount) * countBitsSet(subresourceRange.mipLevelMask) *
+            countBitsSet(aspectBits);
+    };
+
+    // The entries don't overlap each other, so the range is fully covered when the sizes of their intersections with
+    // it add up to its own size
+    uint64_t coveredSubresourceCount = 0;
+    findOverlappingEntries(range);
+    for (uint32_t i : overlappingEntries) {
+        const auto& [entryRange, entry] = accessMap[i];
+        if (entry.layout != layout)
+            return false;
+
+        uint32_t baseArrayLayer = tp::max(entryRange.baseArrayLayer, range.baseArrayLayer);
+        uint32_t endArrayLayer = tp::min(entryRange.getEndPoint(), range.getEndPoint());
+        coveredSubresourceCount += getSubresourceCount(ImageAccessRange(
+            entryRange.aspectMask & range.aspectMask,
+            baseArrayLayer,
+            endArrayLayer - baseArrayLayer,
+            entryRange.mipLevelMask & range.mipLevelMask));
+    }
+    return coveredSubresourceCount == getSubresourceCount(range);
+}
+
+void ImageAccessMap::appendSignature(uint64_t jobId, std::vector<uint64_t>& signature) {
+    if (lastJobId != jobId) {
+        compactAndResetBarriers();
+        lastJobId = jobId;
+    }
+
+    // Deleted entries don't take part in synchronization, but the order of the others does
+    auto entryCount = std::count_if(
+        accessMap.begin(), accessMap.end(), [](const auto& el) { return !el.first.isNull(); });
+    signature.push_back(static_cast<uint64_t>(entryCount));
+    for (const auto& [entryRange, entry] : accessMap) {
+        if (entryRange.isNull())
+            continue;
+
+        signature.push_back(packSignatureWord(static_cast<uint32_t>(entryRange.aspectMask), entryRange.mipLevelMask));
+        signature.push_back(packSignatureWord(entryRange.baseArrayLayer, entryRange.arrayLayerCount));
+        signature.push_back(packSignatureWord(entry.lastWriteAccess.stageMask, entry.lastWriteAccess.accessMask));
+        signature.push_back(packSignatureWord(entry.lastReadAccesses.stageMask, entry.lastReadAccesses.accessMask));
+        signature.push_back(
+            packSignatureWord(entry.barrierIndexAfterWriteAccess, entry.barrierIndexAfterReadAccesses));
+        signature.push_back(packSignatureWord(
+            entry.barrierAfterWriteAccess.pipelineBarrierIndex, entry.barrierAfterWriteAccess.memoryBarrierIndex));
+        signature.push_back(packSignatureWord(entry.commandIndexAfterAccesses, entry.wasExported));
+        signature.push_back(static_cast<uint64_t>(entry.layout));
+    }
+}
+
+void ImageAccessMap::assignAccesses(const ImageAccessMap& other, uint64_t jobId) {
+    TEPHRA_ASSERT(other.vkImageHandle == vkImageHandle);
+    accessMap = other.accessMap;
+    accessIndex = other.accessIndex;
+    lastJobId = jobId;
+}
+
 void ImageAccessMap::clear() {
     accessMap.clear();
+    accessIndex.clear();
 
     // Initialize the access map to set the layout of the entire image to undefined
-    auto defaultEntry = ImageRangeEntry({}, 0, VK_IMAGE_LAYOUT_UNDEFINED, false);
+    auto defaultEntry = ImageRangeEntry({}, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED, false);
     // We don't know the actual range of the whole image, so improvise
     ImageAccessRange wholeRange = ImageAccessRange(
         ImageAspect::Color | ImageAspect::Depth | ImageAspect::Stencil, 0, ~0u, ~0u);
-    accessMap.emplace_back(wholeRange, defaultEntry);
+    addEntry(wholeRange, defaultEntry);
 }
 
 void ImageAccessMap::compactAndResetBarriers() {
@@ -749,11 +1083,48 @@ void ImageAccessMap::compactAndResetBarriers() {
         entry.barrierIndexAfterReadAccesses = 0;
         entry.barrierIndexAfterWriteAccess = 0;
         entry.barrierAfterWriteAccess = BarrierReference();
+        entry.commandIndexAfterAccesses = 0;
 
         return entryRange.isNull();
     });
 
     accessMap.erase(removeIt, accessMap.end());
+
+    // Entry indices have changed, so the index needs to be rebuilt
+    accessIndex.clear();
+    for (std::size_t i = 0; i < accessMap.size(); i++) {
+        const ImageAccessRange& entryRange = accessMap[i].first;
+        accessIndex.insert(
+            static_cast<uint32_t>(i), entryRange.getStartPoint(), entryRange.getEndPoint(), entryRange.mipLevelMask);
+    }
+}
+
+void ImageAccessMap::findOverlappingEntries(const ImageAccessRange& range) {
+    overlappingEntries.clear();
+    accessIndex.findOverlapping(range.getStartPoint(), range.getEndPoint(), range.mipLevelMask, overlappingEntries);
+
+    // The index only considers layers and mip levels
+    auto removeIt = std::remove_if(overlappingEntries.begin(), overlappingEntries.end(), [&](uint32_t i) {
+        return !areAccessRangesOverlapping(range, accessMap[i].first);
+    });
+    overlappingEntries.erase(removeIt, overlappingEntries.end());
+
+    // Keep the order of processing the same as the order of the entries
+    std::sort(overlappingEntries.begin(), overlappingEntries.end());
+}
+
+void ImageAccessMap::addEntry(const ImageAccessRange& range, const ImageRangeEntry& entry) {
+    uint32_t entryIndex = static_cast<uint32_t>(accessMap.size());
+    accessMap.emplace_back(range, entry);
+    accessIndex.insert(entryIndex, range.getStartPoint(), range.getEndPoint(), range.mipLevelMask);
+}
+
+void ImageAccessMap::setEntryRange(std::size_t entryIndex, const ImageAccessRange& range) {
+    uint32_t index = static_cast<uint32_t>(entryIndex);
+    accessIndex.erase(index);
+    accessMap[entryIndex].first = range;
+    if (!range.isNull())
+        accessIndex.insert(index, range.getStartPoint(), range.getEndPoint(), range.mipLevelMask);
 }
 
 void ImageAccessMap::splitOverlappingRange(std::size_t entryIndex, const ImageAccessRange& overlappingRange) {
@@ -763,29 +1134,29 @@ void ImageAccessMap::splitOverlappingRange(std::size_t entryIndex, const ImageAc
     // Replace the entry's range with the intersecting one
     ImageAccessRange intersectionRange = getAccessRangeIntersection(entryRange, overlappingRange);
     TEPHRA_ASSERT(!intersectionRange.isNull());
-    accessMap[entryIndex].first = intersectionRange;
+    setEntryRange(entryIndex, intersectionRange);
 
     // But keep the non-overlapping parts, splitting the range if necessary
     if (entryRange.aspectMask != overlappingRange.aspectMask) {
         ImageAccessRange middleAspectRange = intersectionRange;
         middleAspectRange.aspectMask = entryRange.aspectMask & (~overlappingRange.aspectMask);
-        accessMap.emplace_back(middleAspectRange, entry);
+        addEntry(middleAspectRange, entry);
     }
 
     if (entryRange.mipLevelMask != overlappingRange.mipLevelMask) {
         ImageAccessRange middleMipRange = intersectionRange;
         middleMipRange.mipLevelMask = entryRange.mipLevelMask & (~overlappingRange.mipLevelMask);
-        accessMap.emplace_back(middleMipRange, entry);
+        addEntry(middleMipRange, entry);
     }
 
     ImageAccessRange leftRange = getAccessRangeDifferenceLeft(entryRange, overlappingRange);
     if (!leftRange.isNull()) {
-        accessMap.emplace_back(leftRange, entry);
+        addEntry(leftRange, entry);
     }
 
     ImageAccessRange rightRange = getAccessRangeDifferenceRight(entryRange, overlappingRange);
     if (!rightRange.isNull()) {
-        accessMap.emplace_back(rightRange, entry);
+        addEntry(rightRange, entry);
     }
 }
 
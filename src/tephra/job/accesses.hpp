@@ -4,7 +4,9 @@
 #include "../common_impl.hpp"
 #include "local_buffers.hpp"
 #include "local_images.hpp"
-#include <map>
+#include "../utils/flat_interval_map.hpp"
+#include "../utils/interval_tree.hpp"
+#include <tuple>
 
 namespace tp {
 
@@ -31,6 +33,10 @@ struct ResourceAccess {
         return stageMask == 0;
     }
 
+    bool operator==(const ResourceAccess& other) const {
+        return stageMask == other.stageMask && accessMask == other.accessMask;
+    }
+
     ResourceAccess& operator|=(const ResourceAccess& other);
 };
 
@@ -100,8 +106,8 @@ struct BufferAccessRange {
     }
 };
 
-VkBufferHandle resolveBufferAccess(StoredBufferView& bufferView, BufferAccessRange* range);
-std::pair<VkBufferHandle, BufferAccessRange> resolveBufferAccess(StoredBufferView& bufferView);
+VkBufferHandle resolveBufferAccess(StoredBufferView& bufferView, BufferAccessRange* range, uint32_t* resourceId);
+std::tuple<VkBufferHandle, uint32_t, BufferAccessRange> resolveBufferAccess(StoredBufferView& bufferView);
 
 // Structure representing the extent of an access to an image resource
 // For reduced storage requirements and complexity, mip levels accessed is stored as a mask rather than a range
@@ -139,7 +145,10 @@ struct ImageAccessRange {
     }
 };
 
-VkImageHandle resolveImageAccess(StoredImageView& imageView, ImageAccessRange* range);
+VkImageHandle resolveImageAccess(StoredImageView& imageView, ImageAccessRange* range, uint32_t* resourceId);
+
+// Packs two 32-bit values into a single word of a signature describing resource accesses
+uint64_t packSignatureWord(uint32_t low, uint32_t high);
 
 // Returns true when any part of the access ranges is overlapping
 inline bool areAccessRangesOverlapping(const BufferAccessRange& a, const BufferAccessRange& b) {
@@ -164,21 +173,86 @@ inline bool doesAccessRangeContainAnother(const ImageAccessRange& a, const Image
 // Structure for a new, identified buffer access
 struct NewBufferAccess : ResourceAccess {
     VkBufferHandle vkResourceHandle;
+    // The device-wide id of the buffer, see ResourceIdAllocator
+    uint32_t resourceId;
     BufferAccessRange range;
 
-    NewBufferAccess(VkBufferHandle vkBufferHandle, BufferAccessRange range, ResourceAccess access)
-        : ResourceAccess(std::move(access)), vkResourceHandle(vkBufferHandle), range(std::move(range)) {}
+    NewBufferAccess(VkBufferHandle vkBufferHandle, uint32_t resourceId, BufferAccessRange range, ResourceAccess access)
+        : ResourceAccess(std::move(access)),
+          vkResourceHandle(vkBufferHandle),
+          resourceId(resourceId),
+          range(std::move(range)) {}
 };
 
 // Structure for a new, identified image access
 struct NewImageAccess : ResourceAccess {
     VkImageHandle vkResourceHandle;
+    // The device-wide id of the image, see ResourceIdAllocator
+    uint32_t resourceId;
     ImageAccessRange range;
     // The layout the image range needs to be in for this access
     VkImageLayout layout;
+    // For images placed into shared memory blocks, the index of the buffer access of the same command to the memory
+    // the image aliases, ~0 otherwise
+    uint32_t memoryAliasAccessIndex;
+
+    NewImageAccess(
+        VkImageHandle vkImageHandle,
+        uint32_t resourceId,
+        ImageAccessRange range,
+        ResourceAccess access,
+        VkImageLayout layout,
+        uint32_t memoryAliasAccessIndex = ~0)
+        : ResourceAccess(std::move(access)),
+          vkResourceHandle(vkImageHandle),
+          resourceId(resourceId),
+          range(std::move(range)),
+          layout(layout),
+          memoryAliasAccessIndex(memoryAliasAccessIndex) {}
+};
+
+// Describes the state that past accesses left a range of a buffer in
+struct BufferAccessState {
+    VkBufferHandle vkResourceHandle;
+    uint32_t resourceId;
+    BufferAccessRange range;
+    ResourceAccess lastWriteAccess;
+    ResourceAccess lastReadAccesses;
+    bool wasExported;
 
-    NewImageAccess(VkImageHandle vkImageHandle, ImageAccessRange range, ResourceAccess access, VkImageLayout layout)
-        : ResourceAccess(std::move(access)), vkResourceHandle(vkImageHandle), range(std::move(range)), layout(layout) {}
+    // Returns an access that future accesses can synchronize against in place of the ones in this state
+    NewBufferAccess toNewAccess() const {
+        return NewBufferAccess(vkResourceHandle, resourceId, range, lastWriteAccess | lastReadAccesses);
+    }
+};
+
+// Describes the state that past accesses left a range of an image in
+struct ImageAccessState {
+    VkImageHandle vkResourceHandle;
+    uint32_t resourceId;
+    ImageAccessRange range;
+    ResourceAccess lastWriteAccess;
+    ResourceAccess lastReadAccesses;
+    bool wasExported;
+    VkImageLayout layout;
+
+    // Returns an access that future accesses can synchronize against in place of the ones in this state
+    NewImageAccess toNewAccess() const {
+        return NewImageAccess(vkResourceHandle, resourceId, range, lastWriteAccess | lastReadAccesses, layout);
+    }
+};
+
+// Summarizes the past accesses of a range that a new dependency needs to be placed after
+struct PastAccesses {
+    // The stages of all the accesses, but only the access mask of the write access that needs to be made available
+    ResourceAccess access;
+    // The index of the first barrier that can be reused to synchronize against all of the accesses
+    uint32_t barrierIndexAfterAccesses;
+    // The index of the first command following all of the accesses
+    uint32_t commandIndexAfterAccesses;
+    bool wasExported;
+
+    PastAccesses() : barrierIndexAfterAccesses(0), commandIndexAfterAccesses(0), wasExported(false) {}
 };
 
 // Specifies a nullable reference to a particular pipeline and memory dependency within a BarrierList
@@ -198,6 +272,10 @@ struct BarrierReference {
     bool hasMemoryBarrier() {
         return memoryBarrierIndex != ~0;
     }
+
+    bool operator==(const BarrierReference& other) const {
+        return pipelineBarrierIndex == other.pipelineBarrierIndex && memoryBarrierIndex == other.memoryBarrierIndex;
+    }
 };
 
 class BarrierList;
@@ -207,6 +285,10 @@ class BufferAccessMap {
 public:
     explicit BufferAccessMap(VkBufferHandle vkBufferHandle);
 
+    VkBufferHandle vkGetBufferHandle() const {
+        return vkBufferHandle;
+    }
+
     // Returns the number of currently tracked access ranges
     uint64_t getAccessCount() const;
 
@@ -214,13 +296,44 @@ public:
     // Does not modify the access map in a way that would affect any future accesses
     void synchronizeNewAccess(const NewBufferAccess& newAccess, uint32_t commandIndex, BarrierList& barriers);
 
-    // Updates the access map by inserting the new access, to be synchronized against others in the future
+    // Synchronizes the previous accesses of the release access' range with a single memory dependency that also
+    // releases the ownership of the whole range to the destination queue family
+    void synchronizeOwnershipRelease(
+        const NewBufferAccess& releaseAccess,
+        uint32_t srcQueueFamilyIndex,
+        uint32_t dstQueueFamilyIndex,
+        BarrierList& barriers);
+
+    // Merges the previous accesses of the given range, so that a single dependency can be synchronized against them
+    PastAccesses getPastAccesses(const BufferAccessRange& range, BarrierList& barriers);
+
+    // Updates the access map by inserting the new access, to be synchronized against others in the future.
+    // The commandIndexAfterAccess is the index of the first command that follows the access within the job.
     void insertNewAccess(
         const NewBufferAccess& newAccess,
+        uint32_t commandIndexAfterAccess,
         uint32_t nextBarrierIndex,
         bool forceOverwrite = false,
         bool isExport = false);
 
+    // Appends the states of all ranges that have been accessed so far
+    void getAccessStates(uint32_t resourceId, std::vector<BufferAccessState>& states) const;
+
+    // Returns true if the accesses of the state's range are already synchronized with any future access that the
+    // given state would be synchronized with
+    bool isInAccessState(const BufferAccessState& state);
+
+    // Updates the access map as if the accesses of the given state happened before nextBarrierIndex
+    void insertAccessState(const BufferAccessState& state, uint32_t nextBarrierIndex);
+
+    // Appends a description of the tracked accesses that fully determines how new accesses of the given job get
+    // synchronized against them. Resets the barrier information left over from previous jobs beforehand
+    void appendSignature(uint64_t jobId, std::vector<uint64_t>& signature);
+
+    // Replaces the tracked accesses with the ones of another map of the same buffer, as if they happened in the job
+    // with the given id
+    void assignAccesses(const BufferAccessMap& other, uint64_t jobId);
+
     // Clears all previous accesses and barriers
     void clear();
 
@@ -245,17 +358,36 @@ private:
         // The barrier that was used to synchronize read accesses with the preceding write access
         BarrierReference barrierAfterWriteAccess;
 
+        // The index of the first command following the last access of either kind, 0 if it happened before the job
+        uint32_t commandIndexAfterAccesses;
+
         // Constructs a new entry, initialized to some access - it is treated like write access
-        BufferRangeEntry(ResourceAccess access, uint32_t barrierIndexAfterAccess, bool isExport)
+        BufferRangeEntry(
+            ResourceAccess access,
+            uint32_t commandIndexAfterAccess,
+            uint32_t barrierIndexAfterAccess,
+            bool isExport)
             : lastWriteAccess(std::move(access)),
               barrierIndexAfterWriteAccess(barrierIndexAfterAccess),
               lastReadAccesses(0, 0),
               barrierIndexAfterReadAccesses(0),
               wasExported(isExport),
-              barrierAfterWriteAccess() {}
+              barrierAfterWriteAccess(),
+              commandIndexAfterAccesses(commandIndexAfterAccess) {}
+
+        // Adjacent ranges with equal entries get merged together
+        bool operator==(const BufferRangeEntry& other) const {
+            return lastWriteAccess == other.lastWriteAccess &&
+                barrierIndexAfterWriteAccess == other.barrierIndexAfterWriteAccess &&
+                lastReadAccesses == other.lastReadAccesses &&
+                barrierIndexAfterReadAccesses == other.barrierIndexAfterReadAccesses &&
+                wasExported == other.wasExported && barrierAfterWriteAccess == other.barrierAfterWriteAccess &&
+                commandIndexAfterAccesses == other.commandIndexAfterAccesses;
+        }
     };
 
-    using AccessMapType = std::map<BufferAccessRange, BufferRangeEntry>;
+    // Most buffers are accessed as a whole or in just a few ranges, so keep a few of them inline
+    using AccessMapType = FlatIntervalMap<BufferAccessRange, BufferRangeEntry, 4>;
 
     // The buffer being tracked
     VkBufferHandle vkBufferHandle;
@@ -264,13 +396,8 @@ private:
     // Contains a unique entry for each access range
     AccessMapType accessMap;
 
-    // Resets the recorded barrier information of the past accesses.
+    // Resets the recorded barrier information of the past accesses, merging ranges that become identical.
     void resetBarriers();
-
-    // Helper function to remove the parts of the given entry from the access map that overlap with the range
-    AccessMapType::iterator removeOverlappingRange(
-        const AccessMapType::iterator& entryIt,
-        const BufferAccessRange& overlappingRange);
 };
 
 // Maintains a map of past accesses of a single image resource, using them to synchronize against new accesses
@@ -278,16 +405,36 @@ class ImageAccessMap {
 public:
     explicit ImageAccessMap(VkImageHandle vkImageHandle);
 
+    VkImageHandle vkGetImageHandle() const {
+        return vkImageHandle;
+    }
+
     // Returns the number of currently tracked access ranges
     uint64_t getAccessCount() const;
 
     // Synchronizes the new access with the previous ones through the provided barrier list
-    // Does not modify the access map in a way that would affect any future accesses
-    void synchronizeNewAccess(const NewImageAccess& newAccess, uint32_t commandIndex, BarrierList& barriers);
-
-    // Updates the access map by inserting the new access, to be synchronized against others in the future
+    // Does not modify the access map in a way that would affect any future accesses. For images placed into shared
+    // memory, aliasedMemoryAccesses are the past accesses of the memory that its first layout transition must follow
+    void synchronizeNewAccess(
+        const NewImageAccess& newAccess,
+        uint32_t commandIndex,
+        BarrierList& barriers,
+        const PastAccesses* aliasedMemoryAccesses = nullptr);
+
+    // Synchronizes the previous accesses of the release access' range with a single memory dependency that also
+    // releases the ownership of the whole range to the destination queue family. This is only possible when the
+    // range is already in the layout of the release access, otherwise returns false without synchronizing anything
+    bool synchronizeOwnershipRelease(
+        const NewImageAccess& releaseAccess,
+        uint32_t srcQueueFamilyIndex,
+        uint32_t dstQueueFamilyIndex,
+        BarrierList& barriers);
+
+    // Updates the access map by inserting the new access, to be synchronized against others in the future.
+    // The commandIndexAfterAccess is the index of the first command that follows the access within the job.
     void insertNewAccess(
         const NewImageAccess& newAccess,
+        uint32_t commandIndexAfterAccess,
         uint32_t nextBarrierIndex,
         bool forceOverwrite = false,
         bool isExport = false);
@@ -295,6 +442,28 @@ public:
     // Marks the range as not needing to preserve contents for future accesses
     void discardContents(const ImageAccessRange& range);
 
+    // Appends the states of all ranges that have been accessed so far
+    void getAccessStates(uint32_t resourceId, std::vector<ImageAccessState>& states) const;
+
+    // Returns true if the accesses of the state's range are already synchronized with any future access that the
+    // given state would be synchronized with, including its layout
+    bool isInAccessState(const ImageAccessState& state);
+
+    // Updates the access map as if the accesses of the given state happened before nextBarrierIndex
+    void insertAccessState(const ImageAccessState& state, uint32_t nextBarrierIndex);
+
+    // Returns true if the whole range is known to already be in the given layout, so that accessing it in that layout
+    // won't need a layout transition
+    bool isInLayout(const ImageAccessRange& range, VkImageLayout layout);
+
+    // Appends a description of the tracked accesses that fully determines how new accesses of the given job get
+    // synchronized against them. Compacts the map and resets the barrier information of previous jobs beforehand
+    void appendSignature(uint64_t jobId, std::vector<uint64_t>& signature);
+
+    // Replaces the tracked accesses with the ones of another map of the same image, as if they happened in the job
+    // with the given id
+    void assignAccesses(const ImageAccessMap& other, uint64_t jobId);
+
     // Clears all previous accesses and barriers
     void clear();
 
@@ -319,22 +488,33 @@ private:
         // The barrier that was used to synchronize read accesses with the preceding write access
         BarrierReference barrierAfterWriteAccess;
 
+        // The index of the first command following the last access of either kind, 0 if it happened before the job
+        uint32_t commandIndexAfterAccesses;
+
         // The current layout the image subresource range is in
         VkImageLayout layout;
 
         // Constructs a new entry, initialized to some access - it is treated like write access
-        ImageRangeEntry(ResourceAccess access, uint32_t barrierIndexAfterAccess, VkImageLayout layout, bool isExport)
+        ImageRangeEntry(
+            ResourceAccess access,
+            uint32_t commandIndexAfterAccess,
+            uint32_t barrierIndexAfterAccess,
+            VkImageLayout layout,
+            bool isExport)
             : lastWriteAccess(std::move(access)),
               barrierIndexAfterWriteAccess(barrierIndexAfterAccess),
               lastReadAccesses(0, 0),
               barrierIndexAfterReadAccesses(0),
               wasExported(isExport),
               barrierAfterWriteAccess(),
+              commandIndexAfterAccesses(commandIndexAfterAccess),
               layout(layout) {}
     };
     // We cannot use map here because there is no way to order overlapping image ranges
     // Instead, we use a vector where null ranges represent deleted elements
     using AccessMapType = std::vector<std::pair<ImageAccessRange, ImageRangeEntry>>;
+    // Indexes the entries of the access map by their array layer intervals and mip level masks
+    using AccessIndexType = IntervalTree<uint32_t, uint32_t>;
 
     // The image being tracked
     VkImageHandle vkImageHandle;
@@ -342,6 +522,19 @@ private:
     uint64_t lastJobId;
     // Contains a unique entry for each access range
     AccessMapType accessMap;
+    // Allows finding the entries overlapping a range without going through the whole access map
+    AccessIndexType accessIndex;
+    // Reused storage for the indices of overlapping entries
+    std::vector<uint32_t> overlappingEntries;
+
+    // Fills overlappingEntries with the indices of all entries overlapping the given range, in increasing order
+    void findOverlappingEntries(const ImageAccessRange& range);
+
+    // Appends a new entry to the access map
+    void addEntry(const ImageAccessRange& range, const ImageRangeEntry& entry);
+
+    // Changes the range of an existing entry, null range marks it as deleted
+    void setEntryRange(std::size_t entryIndex, const ImageAccessRange& range);
 
     // Compacts the access map and resets the recorded barrier information of the past accesses.
     void compactAndResetBarriers();
@@ -1,4 +1,5 @@
 #include "aliasing_suballocator.hpp"
+#include <algorithm>
 
 namespace tp {
 
@@ -14,18 +15,20 @@ void ResourceUsageRange::update(uint64_t usage) {
     }
 }
 
+// Returns the exclusive end of the usage range. Resources used until the end of the job have a last usage of ~0, which
+// must not wrap around
+static uint64_t getUsageEnd(const ResourceUsageRange& usageRange) {
+    return usageRange.lastUsage == ~0ull ? ~0ull : usageRange.lastUsage + 1;
+}
+
 AliasingSuballocator::AliasingSuballocator(ArrayParameter<const uint64_t> backingSizes) {
     // To extend the algorithm to consider multiple backing buffers, we just need to make sure that no allocation
-    // spans the buffer boundaries if they were put right after each other in a virtual address space. To do that,
-    // we add dummy allocations of size 0 at those boundaries.
-
-    allocations.reserve(backingSizes.size());
+    // spans the buffer boundaries if they were put right after each other in a virtual address space.
+    backingEnds.reserve(backingSizes.size());
     uint64_t offset = 0;
     for (uint64_t backingSize : backingSizes) {
         offset += backingSize;
-
-        ResourceUsageRange fullRange = { 0ull, ~0ull };
-        allocations.emplace_back(fullRange, offset, 0);
+        backingEnds.push_back(offset);
     }
 }
 
@@ -34,42 +37,70 @@ std::pair<uint32_t, uint64_t> AliasingSuballocator::allocate(
     ResourceUsageRange usageRange,
     uint64_t requiredAlignment) {
     TEPHRA_ASSERT(requiredSize > 0);
+    TEPHRA_ASSERT(!usageRange.isEmpty());
+
+    // Only the allocations with overlapping usage restrict where the new one can go. Sort them by their offset so we
+    // can walk the free space between them.
+    overlappingIds.clear();
+    usageTree.findOverlapping(usageRange.firstUsage, getUsageEnd(usageRange), 1u, overlappingIds);
+    std::sort(overlappingIds.begin(), overlappingIds.end(), [this](uint32_t left, uint32_t right) {
+        return allocations[left].offset < allocations[right].offset;
+    });
+
+    bool foundGap = false;
     uint32_t allocIndex = 0; // Index of the backing allocation used
     uint64_t allocOffset = 0; // Offset of the backing allocation used
     uint64_t offset = 0; // The virtual offset across the space of all backing allocations
-    int sortedIndex = 0; // The index where the allocation should be inserted wrt its virtual offset
+    uint64_t bestGapSize = 0;
 
-    // Walk over already assigned allocations for ones with overlapping usage in the order they are assigned
-    // in memory and find an empty space for this one.
-    for (int i = 0; i < allocations.size(); i++) {
-        const Allocation& otherAllocation = allocations[i];
-
-        if (!usageRange.isOverlapping(otherAllocation)) {
-            // Non-overlapping usage
-            continue;
+    // Considers the free space [gapStart, gapEnd) in the given backing allocation, keeping the smallest one that fits
+    auto considerGap = [&](uint32_t backingIndex, uint64_t backingOffset, uint64_t gapStart, uint64_t gapEnd) {
+        uint64_t alignedStart = backingOffset + roundUpToPoTMultiple(gapStart - backingOffset, requiredAlignment);
+        if (alignedStart >= gapEnd || gapEnd - alignedStart < requiredSize)
+            return;
+        uint64_t gapSize = gapEnd - alignedStart;
+        if (!foundGap || gapSize < bestGapSize) {
+            foundGap = true;
+            allocIndex = backingIndex;
+            allocOffset = backingOffset;
+            offset = alignedStart;
+            bestGapSize = gapSize;
         }
+    };
 
-        if (offset + requiredSize <= otherAllocation.offset) {
-            // Allocation fits to the left. Since the current allocations are sorted, we know all the space between
-            // offset and otherAllocation.offset is free to use
-            break;
-        } else {
-            // Have to allocate to the right of the allocation
-            if (otherAllocation.isBackingAllocBoundary()) {
-                // We have crossed to another backing allocation
-                allocIndex++;
-                allocOffset = otherAllocation.offset;
-            }
+    int overlappingIndex = 0;
+    uint64_t backingOffset = 0;
+    for (uint32_t backingIndex = 0; backingIndex < backingEnds.size(); backingIndex++) {
+        uint64_t backingEnd = backingEnds[backingIndex];
+        uint64_t gapStart = backingOffset;
+        for (; overlappingIndex < overlappingIds.size(); overlappingIndex++) {
+            const Allocation& otherAllocation = allocations[overlappingIds[overlappingIndex]];
+            if (otherAllocation.offset >= backingEnd)
+                break;
+            considerGap(backingIndex, backingOffset, gapStart, otherAllocation.offset);
+            gapStart = tp::max(gapStart, otherAllocation.offset + otherAllocation.size);
+        }
+        considerGap(backingIndex, backingOffset, gapStart, backingEnd);
+        backingOffset = backingEnd;
+    }
 
-            uint64_t unalignedOffset = otherAllocation.offset + otherAllocation.size;
-            offset = allocOffset + roundUpToPoTMultiple(unalignedOffset - allocOffset, requiredAlignment);
-            // This new allocation would go right after this one
-            sortedIndex = i + 1;
+    if (!foundGap) {
+        // Doesn't fit in any of the backing allocations, so it goes to the unbounded leftover one
+        uint32_t leftoverIndex = static_cast<uint32_t>(backingEnds.size());
+        uint64_t gapStart = backingOffset;
+        for (; overlappingIndex < overlappingIds.size(); overlappingIndex++) {
+            const Allocation& otherAllocation = allocations[overlappingIds[overlappingIndex]];
+            considerGap(leftoverIndex, backingOffset, gapStart, otherAllocation.offset);
+            gapStart = tp::max(gapStart, otherAllocation.offset + otherAllocation.size);
         }
+        considerGap(leftoverIndex, backingOffset, gapStart, ~0ull);
+        TEPHRA_ASSERT(foundGap);
     }
 
-    // Insert the new allocation to consider it for the next one
-    allocations.emplace(allocations.begin() + sortedIndex, usageRange, offset, requiredSize);
+    // Record the new allocation to consider it for the next one
+    uint32_t allocationId = static_cast<uint32_t>(allocations.size());
+    allocations.push_back({ offset, requiredSize });
+    usageTree.insert(allocationId, usageRange.firstUsage, getUsageEnd(usageRange), 1u);
     usedSize = tp::max(usedSize, offset + requiredSize);
 
     // Convert virtual offset to actual offset
@@ -77,4 +108,18 @@ std::pair<uint32_t, uint64_t> AliasingSuballocator::allocate(
     return { allocIndex, offset - allocOffset };
 }
 
+bool AliasingSuballocator::isAllocatedBefore(
+    uint64_t leftSize,
+    const ResourceUsageRange& leftUsage,
+    uint64_t rightSize,
+    const ResourceUsageRange& rightUsage) {
+    if (leftSize != rightSize)
+        return leftSize > rightSize;
+    uint64_t leftLength = leftUsage.lastUsage - leftUsage.firstUsage;
+    uint64_t rightLength = rightUsage.lastUsage - rightUsage.firstUsage;
+    if (leftLength != rightLength)
+        return leftLength > rightLength;
+    return leftUsage.firstUsage < rightUsage.firstUsage;
+}
+
 }
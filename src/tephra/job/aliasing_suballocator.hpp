@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../common_impl.hpp"
+#include "../utils/interval_tree.hpp"
 
 namespace tp {
 
@@ -22,7 +23,9 @@ struct ResourceUsageRange {
 
 // Defines a suballocation algorithm that greedily aliases resources whose usage range doesn't overlap. It will
 // progressively use up space in the backing allocations of the given sizes.
-// Takes O(N) space and O(N^2) time for N allocations.
+// Each allocation only considers the allocations whose usage overlaps with it, found through an interval tree, and
+// picks the smallest free gap between them that fits. Takes O(N) space and O(N (log N + K log K)) time for
+// N allocations, where K is the number of allocations overlapping in usage.
 class AliasingSuballocator {
 public:
     // Assigns a new set of backing allocations. After the ones provided, an unbounded backing allocation is assumed
@@ -40,21 +43,27 @@ public:
         return usedSize;
     }
 
+    // Defines the order in which resources should be allocated for tight packing and a result that doesn't depend on
+    // the order of the requests: larger resources first, then the ones used for longer, then by their first usage
+    static bool isAllocatedBefore(
+        uint64_t leftSize,
+        const ResourceUsageRange& leftUsage,
+        uint64_t rightSize,
+        const ResourceUsageRange& rightUsage);
+
 private:
-    struct Allocation : ResourceUsageRange {
+    struct Allocation {
         uint64_t offset;
         uint64_t size;
-
-        Allocation(const ResourceUsageRange& usageRange, uint64_t offset, uint64_t size)
-            : ResourceUsageRange(usageRange), offset(offset), size(size) {}
-
-        bool isBackingAllocBoundary() const {
-            return size == 0;
-        }
     };
 
-    // List of current allocations sorted by offset
+    // Virtual offsets of the ends of the backing allocations, as if they were put right after each other
+    ScratchVector<uint64_t> backingEnds;
+    // List of current allocations in the order they were made, indexed by their usage ranges in the tree
     ScratchVector<Allocation> allocations;
+    IntervalTree<uint64_t> usageTree;
+    // Temporary list of allocations overlapping in usage with the one being made
+    ScratchVector<uint32_t> overlappingIds;
     // Total used size
     uint64_t usedSize = 0;
 };
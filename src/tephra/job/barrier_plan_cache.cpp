@@ -0,0 +1,232 @@
+#include "barrier_plan_cache.hpp"
+#include "command_recording.hpp"
+#include "../device/queue_state.hpp"
+#include <algorithm>
+
+namespace tp {
+
+// Appends the words describing a new access to the job signature
+void appendAccessSignature(std::vector<uint64_t>& signature, const NewBufferAccess& access) {
+    signature.push_back(reinterpret_cast<uint64_t>(access.vkResourceHandle.vkRawHandle));
+    signature.push_back(access.resourceId);
+    signature.push_back(access.range.offset);
+    signature.push_back(access.range.size);
+    signature.push_back(packSignatureWord(access.stageMask, access.accessMask));
+}
+
+void appendAccessSignature(std::vector<uint64_t>& signature, const NewImageAccess& access) {
+    signature.push_back(reinterpret_cast<uint64_t>(access.vkResourceHandle.vkRawHandle));
+    signature.push_back(access.resourceId);
+    signature.push_back(packSignatureWord(static_cast<uint32_t>(access.range.aspectMask), access.range.mipLevelMask));
+    signature.push_back(packSignatureWord(access.range.baseArrayLayer, access.range.arrayLayerCount));
+    signature.push_back(packSignatureWord(access.stageMask, access.accessMask));
+    signature.push_back(static_cast<uint64_t>(access.layout));
+}
+
+bool BarrierPlanCache::applyCachedPlan(const JobData* job, QueueSyncState* queueSyncState, BarrierList& barriers) {
+    TEPHRA_ASSERT(barriers.getBarrierCount() == 0);
+    buildSignature(job, queueSyncState, barriers.getJobId());
+
+    auto planIt = plans.find(pendingSignatureHash);
+    if (planIt == plans.end() || planIt->second.signature != pendingSignature) {
+        missCount++;
+        return false;
+    }
+    hitCount++;
+
+    CachedPlan& plan = planIt->second;
+    plan.lastUsedJobId = barriers.getJobId();
+
+    for (const CachedBarrier& cachedBarrier : plan.barriers) {
+        Barrier& barrier = barriers.appendBarrier(cachedBarrier.commandIndex);
+        barrier.srcCommandIndex = cachedBarrier.srcCommandIndex;
+        barrier.srcStageMask = cachedBarrier.srcStageMask;
+        barrier.dstStageMask = cachedBarrier.dstStageMask;
+        barrier.extSrcStageMask = cachedBarrier.extSrcStageMask;
+        barrier.extDstStageMask = cachedBarrier.extDstStageMask;
+        barrier.bufferDependencies.assign(
+            cachedBarrier.bufferDependencies.begin(), cachedBarrier.bufferDependencies.end());
+        barrier.imageDependencies.assign(
+            cachedBarrier.imageDependencies.begin(), cachedBarrier.imageDependencies.end());
+        barrier.executionDependencies.assign(
+            cachedBarrier.executionDependencies.begin(), cachedBarrier.executionDependencies.end());
+    }
+
+    // Leave the resources in the same states as the job the plan was prepared for
+    for (const auto& [resourceId, accessMapState] : plan.bufferStates) {
+        if (accessMapState != nullptr) {
+            queueSyncState->getAccessMap(accessMapState->vkGetBufferHandle(), resourceId)
+                .assignAccesses(*accessMapState, barriers.getJobId());
+        }
+    }
+    for (const auto& [resourceId, accessMapState] : plan.imageStates) {
+        if (accessMapState != nullptr) {
+            queueSyncState->getAccessMap(accessMapState->vkGetImageHandle(), resourceId)
+                .assignAccesses(*accessMapState, barriers.getJobId());
+        }
+    }
+
+    return true;
+}
+
+void BarrierPlanCache::storePlan(QueueSyncState* queueSyncState, const BarrierList& barriers) {
+    if (plans.find(pendingSignatureHash) == plans.end() && plans.size() >= MaxPlanCount) {
+        auto evictedIt = std::min_element(plans.begin(), plans.end(), [](const auto& a, const auto& b) {
+            return a.second.lastUsedJobId < b.second.lastUsedJobId;
+        });
+        plans.erase(evictedIt);
+    }
+
+    // Overwrites any plan with a colliding hash
+    CachedPlan& plan = plans[pendingSignatureHash];
+    plan.signature = pendingSignature;
+    plan.lastUsedJobId = barriers.getJobId();
+
+    plan.barriers.clear();
+    plan.barriers.reserve(barriers.getBarrierCount());
+    for (uint32_t barrierIndex = 0; barrierIndex < barriers.getBarrierCount(); barrierIndex++) {
+        const Barrier& barrier = barriers.getBarrier(barrierIndex);
+        TEPHRA_ASSERT(barrier.vkSplitEvent.isNull());
+
+        CachedBarrier& cachedBarrier = plan.barriers.emplace_back();
+        cachedBarrier.commandIndex = barrier.commandIndex;
+        cachedBarrier.srcCommandIndex = barrier.srcCommandIndex;
+        cachedBarrier.srcStageMask = barrier.srcStageMask;
+        cachedBarrier.dstStageMask = barrier.dstStageMask;
+        cachedBarrier.extSrcStageMask = barrier.extSrcStageMask;
+        cachedBarrier.extDstStageMask = barrier.extDstStageMask;
+        cachedBarrier.bufferDependencies.assign(barrier.bufferDependencies.begin(), barrier.bufferDependencies.end());
+        cachedBarrier.imageDependencies.assign(barrier.imageDependencies.begin(), barrier.imageDependencies.end());
+        cachedBarrier.executionDependencies.assign(
+            barrier.executionDependencies.begin(), barrier.executionDependencies.end());
+    }
+
+    plan.bufferStates.clear();
+    for (const auto& [resourceId, vkBufferHandle] : touchedBuffers) {
+        BufferAccessMap* accessMap = queueSyncState->findAccessMap(vkBufferHandle, resourceId);
+        plan.bufferStates.emplace_back(
+            resourceId, accessMap != nullptr ? std::make_unique<BufferAccessMap>(*accessMap) : nullptr);
+    }
+    plan.imageStates.clear();
+    for (const auto& [resourceId, vkImageHandle] : touchedImages) {
+        ImageAccessMap* accessMap = queueSyncState->findAccessMap(vkImageHandle, resourceId);
+        plan.imageStates.emplace_back(
+            resourceId, accessMap != nullptr ? std::make_unique<ImageAccessMap>(*accessMap) : nullptr);
+    }
+}
+
+void BarrierPlanCache::buildSignature(const JobData* job, QueueSyncState* queueSyncState, uint64_t jobId) {
+    pendingSignature.clear();
+    touchedBuffers.clear();
+    touchedImages.clear();
+
+    ScratchVector<NewBufferAccess> newBufferAccesses;
+    ScratchVector<NewImageAccess> newImageAccesses;
+
+    // Describe the commands by the parts that prepareBarriers cares about
+    auto* cmd = job->record.firstCommandPtr;
+    while (cmd != nullptr) {
+        pendingSignature.push_back(static_cast<uint64_t>(cmd->commandType));
+        newBufferAccesses.clear();
+        newImageAccesses.clear();
+
+        switch (cmd->commandType) {
+        case JobCommandTypes::ExportBuffer: {
+            auto* data = getCommandData<JobRecordStorage::ExportBufferData>(cmd);
+            auto [vkBufferHandle, resourceId, range] = resolveBufferAccess(data->buffer);
+            newBufferAccesses.emplace_back(vkBufferHandle, resourceId, range, data->access);
+            pendingSignature.push_back(data->dstQueueFamilyIndex);
+            break;
+        }
+        case JobCommandTypes::ExportImage: {
+            auto* data = getCommandData<JobRecordStorage::ExportImageData>(cmd);
+            ImageAccessRange range = data->range;
+            uint32_t resourceId;
+            VkImageHandle vkImageHandle = resolveImageAccess(data->image, &range, &resourceId);
+            newImageAccesses.emplace_back(vkImageHandle, resourceId, range, data->access, data->vkImageLayout);
+            pendingSignature.push_back(data->dstQueueFamilyIndex);
+            break;
+        }
+        case JobCommandTypes::DiscardImageContents: {
+            auto* data = getCommandData<JobRecordStorage::DiscardImageContentsData>(cmd);
+            ImageAccessRange range = data->range;
+            uint32_t resourceId;
+            VkImageHandle vkImageHandle = resolveImageAccess(data->image, &range, &resourceId);
+            newImageAccesses.emplace_back(
+                vkImageHandle, resourceId, range, ResourceAccess(), VK_IMAGE_LAYOUT_UNDEFINED);
+            break;
+        }
+        case JobCommandTypes::ImportExternalBuffer: {
+            auto* data = getCommandData<JobRecordStorage::ImportExternalBufferData>(cmd);
+            auto [vkBufferHandle, resourceId, range] = resolveBufferAccess(data->buffer);
+            newBufferAccesses.emplace_back(vkBufferHandle, resourceId, range, data->access);
+            break;
+        }
+        case JobCommandTypes::ImportExternalImage: {
+            auto* data = getCommandData<JobRecordStorage::ImportExternalImageData>(cmd);
+            ImageAccessRange range = data->range;
+            uint32_t resourceId;
+            VkImageHandle vkImageHandle = resolveImageAccess(data->image, &range, &resourceId);
+            newImageAccesses.emplace_back(vkImageHandle, resourceId, range, data->access, data->vkImageLayout);
+            break;
+        }
+        case JobCommandTypes::BuildAccelerationStructures:
+        case JobCommandTypes::BuildAccelerationStructuresIndirect: {
+            auto* data = getCommandData<JobRecordStorage::BuildAccelerationStructuresData>(cmd);
+            pendingSignature.push_back(data->hasTopLevelBuilds);
+            identifyCommandResourceAccesses(cmd, newBufferAccesses, newImageAccesses);
+            break;
+        }
+        default: {
+            identifyCommandResourceAccesses(cmd, newBufferAccesses, newImageAccesses);
+        }
+        }
+
+        pendingSignature.push_back(newBufferAccesses.size());
+        for (const NewBufferAccess& access : newBufferAccesses) {
+            appendAccessSignature(pendingSignature, access);
+            touchedBuffers.emplace_back(access.resourceId, access.vkResourceHandle);
+        }
+        pendingSignature.push_back(newImageAccesses.size());
+        for (const NewImageAccess& access : newImageAccesses) {
+            appendAccessSignature(pendingSignature, access);
+            touchedImages.emplace_back(access.resourceId, access.vkResourceHandle);
+        }
+
+        cmd = cmd->nextCommand;
+    }
+
+    // Describe the initial states of the touched resources, each only once
+    auto compareTouched = [](const auto& a, const auto& b) {
+        return a.first < b.first ||
+            (a.first == b.first &&
+             reinterpret_cast<uint64_t>(a.second.vkRawHandle) < reinterpret_cast<uint64_t>(b.second.vkRawHandle));
+    };
+    std::sort(touchedBuffers.begin(), touchedBuffers.end(), compareTouched);
+    touchedBuffers.erase(std::unique(touchedBuffers.begin(), touchedBuffers.end()), touchedBuffers.end());
+    std::sort(touchedImages.begin(), touchedImages.end(), compareTouched);
+    touchedImages.erase(std::unique(touchedImages.begin(), touchedImages.end()), touchedImages.end());
+
+    // Resources not tracked yet are distinguished from ones tracked in their default state, since imports and discards
+    // have no effect on them
+    for (const auto& [resourceId, vkBufferHandle] : touchedBuffers) {
+        BufferAccessMap* accessMap = queueSyncState->findAccessMap(vkBufferHandle, resourceId);
+        pendingSignature.push_back(accessMap != nullptr);
+        if (accessMap != nullptr)
+            accessMap->appendSignature(jobId, pendingSignature);
+    }
+    for (const auto& [resourceId, vkImageHandle] : touchedImages) {
+        ImageAccessMap* accessMap = queueSyncState->findAccessMap(vkImageHandle, resourceId);
+        pendingSignature.push_back(accessMap != nullptr);
+        if (accessMap != nullptr)
+            accessMap->appendSignature(jobId, pendingSignature);
+    }
+
+    const uint64_t fibMul = 11400714819323198485ull; // 2^64 / phi
+    pendingSignatureHash = pendingSignature.size();
+    for (uint64_t word : pendingSignature) {
+        pendingSignatureHash = pendingSignatureHash * fibMul ^ word;
+    }
+}
+
+}
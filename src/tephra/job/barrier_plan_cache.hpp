@@ -0,0 +1,83 @@
+#pragma once
+
+#include "barriers.hpp"
+#include "accesses.hpp"
+#include "job_data.hpp"
+#include "../common_impl.hpp"
+#include <unordered_map>
+#include <memory>
+#include <vector>
+
+namespace tp {
+
+struct QueueSyncState;
+
+// Caches the barriers prepared for jobs of a queue along with the updates of the access maps they caused, so that
+// they can be replayed for later jobs with the same structure. Jobs share the structure when they consist of the same
+// commands accessing the same resource ranges and the accessed resources start out in the same states. The plan is
+// looked up by a hash of the job's signature, but the whole signature is compared to rule out collisions.
+class BarrierPlanCache {
+public:
+    // Looks up the plan for the job. On a hit, fills the empty barrier list with the cached barriers and applies the
+    // plan's access map updates to the sync state, returning true. Otherwise, keeps the signature of the job for
+    // a following call to storePlan.
+    bool applyCachedPlan(const JobData* job, QueueSyncState* queueSyncState, BarrierList& barriers);
+
+    // Stores the barriers prepared for the job that missed the cache in the last call to applyCachedPlan, together
+    // with the states it left its resources in
+    void storePlan(QueueSyncState* queueSyncState, const BarrierList& barriers);
+
+    // Returns the total number of lookups that found a plan
+    uint64_t getHitCount() const {
+        return hitCount;
+    }
+
+    // Returns the total number of lookups that did not find a plan
+    uint64_t getMissCount() const {
+        return missCount;
+    }
+
+private:
+    // Copy of a prepared barrier that doesn't rely on scratch memory
+    struct CachedBarrier {
+        uint32_t commandIndex;
+        uint32_t srcCommandIndex;
+        VkPipelineStageFlags srcStageMask;
+        VkPipelineStageFlags dstStageMask;
+        VkPipelineStageFlags extSrcStageMask;
+        VkPipelineStageFlags extDstStageMask;
+        std::vector<BufferDependency> bufferDependencies;
+        std::vector<ImageDependency> imageDependencies;
+        std::vector<ExecutionDependency> executionDependencies;
+    };
+
+    struct CachedPlan {
+        std::vector<uint64_t> signature;
+        std::vector<CachedBarrier> barriers;
+        // Copies of the access maps of the resources touched by the job as it left them, indexed by their resource
+        // ids. Null if the resource wasn't tracked by the queue before nor after the job
+        std::vector<std::pair<uint32_t, std::unique_ptr<BufferAccessMap>>> bufferStates;
+        std::vector<std::pair<uint32_t, std::unique_ptr<ImageAccessMap>>> imageStates;
+        // The id of the last job that used the plan, for evicting the least recently used ones
+        uint64_t lastUsedJobId;
+    };
+
+    // Plans of jobs that stop being submitted get evicted once the cache reaches this size
+    static constexpr std::size_t MaxPlanCount = 64;
+
+    std::unordered_map<uint64_t, CachedPlan> plans;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+
+    // The signature of the last job that missed the cache and the resources it touches, sorted by their ids
+    std::vector<uint64_t> pendingSignature;
+    uint64_t pendingSignatureHash = 0;
+    std::vector<std::pair<uint32_t, VkBufferHandle>> touchedBuffers;
+    std::vector<std::pair<uint32_t, VkImageHandle>> touchedImages;
+
+    // Builds the signature of the job from the accesses of its commands and the initial states of the resources it
+    // touches
+    void buildSignature(const JobData* job, QueueSyncState* queueSyncState, uint64_t jobId);
+};
+
+}
@@ -1,4 +1,6 @@
 #include "barriers.hpp"
+#include <algorithm>
+#include <tuple>
 
 namespace tp {
 
@@ -45,14 +47,17 @@ VkPipelineStageFlags getComputePipelineStageMask() {
     return ComputePipelineStagesMask;
 }
 
-VkBufferMemoryBarrier BufferDependency::toMemoryBarrier() const {
+VkBufferMemoryBarrier2 BufferDependency::toMemoryBarrier2() const {
     TEPHRA_ASSERT((srcQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED) == (srcQueueFamilyIndex == dstQueueFamilyIndex));
 
-    VkBufferMemoryBarrier memoryBarrier;
-    memoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    VkBufferMemoryBarrier2 memoryBarrier;
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
     memoryBarrier.pNext = nullptr;
-    memoryBarrier.srcAccessMask = srcAccess.accessMask;
-    memoryBarrier.dstAccessMask = dstAccess.accessMask;
+    // The stage and access flag bits map directly to their synchronization2 counterparts
+    memoryBarrier.srcStageMask = static_cast<VkPipelineStageFlags2>(srcAccess.stageMask);
+    memoryBarrier.srcAccessMask = static_cast<VkAccessFlags2>(srcAccess.accessMask);
+    memoryBarrier.dstStageMask = static_cast<VkPipelineStageFlags2>(dstAccess.stageMask);
+    memoryBarrier.dstAccessMask = static_cast<VkAccessFlags2>(dstAccess.accessMask);
     memoryBarrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
     memoryBarrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
     memoryBarrier.buffer = vkBufferHandle;
@@ -61,14 +66,17 @@ VkBufferMemoryBarrier BufferDependency::toMemoryBarrier() const {
     return memoryBarrier;
 }
 
-void ImageDependency::toImageBarriers(ScratchVector<VkImageMemoryBarrier>& barriers) const {
+void ImageDependency::toImageBarriers2(ScratchVector<VkImageMemoryBarrier2>& barriers) const {
     TEPHRA_ASSERT((srcQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED) == (srcQueueFamilyIndex == dstQueueFamilyIndex));
 
-    VkImageMemoryBarrier memoryBarrier;
-    memoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    VkImageMemoryBarrier2 memoryBarrier;
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
     memoryBarrier.pNext = nullptr;
-    memoryBarrier.srcAccessMask = srcAccess.accessMask;
-    memoryBarrier.dstAccessMask = dstAccess.accessMask;
+    // The stage and access flag bits map directly to their synchronization2 counterparts
+    memoryBarrier.srcStageMask = static_cast<VkPipelineStageFlags2>(srcAccess.stageMask);
+    memoryBarrier.srcAccessMask = static_cast<VkAccessFlags2>(srcAccess.accessMask);
+    memoryBarrier.dstStageMask = static_cast<VkPipelineStageFlags2>(dstAccess.stageMask);
+    memoryBarrier.dstAccessMask = static_cast<VkAccessFlags2>(dstAccess.accessMask);
     memoryBarrier.oldLayout = srcLayout;
     // Transition image layout only when needed - Undefined layout means reuse previous layout
     memoryBarrier.newLayout = dstLayout != VK_IMAGE_LAYOUT_UNDEFINED ? dstLayout : srcLayout;
@@ -106,6 +114,17 @@ void ImageDependency::toImageBarriers(ScratchVector<VkImageMemoryBarrier>& barri
     TEPHRA_ASSERT(barrierCount >= 1);
 }
 
+VkMemoryBarrier2 ExecutionDependency::toMemoryBarrier2() const {
+    VkMemoryBarrier2 memoryBarrier;
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    memoryBarrier.pNext = nullptr;
+    memoryBarrier.srcStageMask = static_cast<VkPipelineStageFlags2>(srcStageMask);
+    memoryBarrier.srcAccessMask = 0;
+    memoryBarrier.dstStageMask = static_cast<VkPipelineStageFlags2>(dstStageMask);
+    memoryBarrier.dstAccessMask = 0;
+    return memoryBarrier;
+}
+
 uint32_t Barrier::addDependency(const BufferDependency& dependency) {
     TEPHRA_ASSERT(!dependency.range.isNull());
     TEPHRA_ASSERT(dependency.srcAccess.stageMask != 0 && dependency.dstAccess.stageMask != 0);
@@ -123,6 +142,7 @@ uint32_t Barrier::addDependency(const BufferDependency& dependency) {
         bufferDependencies.push_back(dependency);
         return static_cast<uint32_t>(bufferDependencies.size() - 1);
     }
+    addExecutionDependency(dependency.srcAccess.stageMask, dependency.dstAccess.stageMask);
     return ~0;
 }
 
@@ -145,6 +165,7 @@ uint32_t Barrier::addDependency(const ImageDependency& dependency) {
         imageDependencies.push_back(dependency);
         return static_cast<uint32_t>(imageDependencies.size() - 1);
     }
+    addExecutionDependency(dependency.srcAccess.stageMask, dependency.dstAccess.stageMask);
     return ~0;
 }
 
@@ -207,6 +228,143 @@ void Barrier::extendMemoryDependency(const ImageDependency& dependency, uint32_t
     extendedDependency.dstAccess |= dependency.dstAccess;
 }
 
+bool Barrier::isSplittable() const {
+    // Barriers at the end of the job have no commands to overlap with
+    if (commandIndex == ~0u || srcCommandIndex >= commandIndex)
+        return false;
+
+    // Event dependencies can't include host accesses or queue family ownership transfers
+    if (containsAllBits(srcStageMask, VK_PIPELINE_STAGE_HOST_BIT))
+        return false;
+    for (const BufferDependency& dependency : bufferDependencies) {
+        if (dependency.srcQueueFamilyIndex != dependency.dstQueueFamilyIndex)
+            return false;
+    }
+    for (const ImageDependency& dependency : imageDependencies) {
+        if (dependency.srcQueueFamilyIndex != dependency.dstQueueFamilyIndex)
+            return false;
+    }
+    return true;
+}
+
+uint32_t Barrier::foldBufferDependencies(uint32_t threshold) {
+    // Ownership transfers need to name the buffer, so only queue-local dependencies can be folded
+    auto isQueueLocal = [](const BufferDependency& dependency) {
+        return dependency.srcQueueFamilyIndex == dependency.dstQueueFamilyIndex;
+    };
+
+    auto foldedCount = static_cast<uint32_t>(
+        std::count_if(bufferDependencies.begin(), bufferDependencies.end(), isQueueLocal));
+    if (foldedCount <= threshold)
+        return 0;
+
+    for (const BufferDependency& dependency : bufferDependencies) {
+        if (isQueueLocal(dependency)) {
+            globalSrcAccess |= dependency.srcAccess;
+            globalDstAccess |= dependency.dstAccess;
+        }
+    }
+
+    auto removeIt = std::remove_if(bufferDependencies.begin(), bufferDependencies.end(), isQueueLocal);
+    bufferDependencies.erase(removeIt, bufferDependencies.end());
+    return foldedCount;
+}
+
+// Sorts the image dependencies so that the ones that may be merged together are next to each other, then merges each
+// one into the previous one if possible. Returns true if any dependencies were merged
+template <typename TRangeKeyFn, typename TMergeRangesFn>
+bool mergeImageDependencyRanges(
+    ScratchVector<ImageDependency>& dependencies,
+    TRangeKeyFn getRangeKey,
+    TMergeRangesFn tryMergeRanges) {
+    // Dependencies can only be merged if they only differ in their ranges
+    auto getDependencyKey = [](const ImageDependency& dependency) {
+        return std::make_tuple(
+            dependency.vkImageHandle.vkRawHandle,
+            dependency.srcLayout,
+            dependency.dstLayout,
+            dependency.srcAccess.stageMask,
+            dependency.srcAccess.accessMask,
+            dependency.dstAccess.stageMask,
+            dependency.dstAccess.accessMask,
+            dependency.srcQueueFamilyIndex,
+            dependency.dstQueueFamilyIndex);
+    };
+
+    std::sort(dependencies.begin(), dependencies.end(), [&](const ImageDependency& a, const ImageDependency& b) {
+        auto keyA = getDependencyKey(a);
+        auto keyB = getDependencyKey(b);
+        return keyA < keyB || (keyA == keyB && getRangeKey(a.range) < getRangeKey(b.range));
+    });
+
+    std::size_t mergedCount = 0;
+    for (std::size_t i = 0; i < dependencies.size(); i++) {
+        if (mergedCount > 0) {
+            ImageDependency& previous = dependencies[mergedCount - 1];
+            if (getDependencyKey(previous) == getDependencyKey(dependencies[i]) &&
+                tryMergeRanges(previous.range, dependencies[i].range))
+                continue;
+        }
+        dependencies[mergedCount++] = dependencies[i];
+    }
+
+    bool anyMerged = mergedCount < dependencies.size();
+    dependencies.erase(dependencies.begin() + mergedCount, dependencies.end());
+    return anyMerged;
+}
+
+void Barrier::mergeImageDependencies() {
+    // Each pass merges the ranges along one dimension, which may in turn allow merging along the other ones
+    bool anyMerged = imageDependencies.size() > 1;
+    while (anyMerged) {
+        // Ranges of the same mip levels and aspects with contiguous or overlapping array layers
+        anyMerged = mergeImageDependencyRanges(
+            imageDependencies,
+            [](const ImageAccessRange& range) {
+                return std::make_tuple(range.aspectMask.value, range.mipLevelMask, range.baseArrayLayer);
+            },
+            [](ImageAccessRange& range, const ImageAccessRange& other) {
+                if (range.aspectMask != other.aspectMask || range.mipLevelMask != other.mipLevelMask ||
+                    other.getStartPoint() > range.getEndPoint())
+                    return false;
+                range.arrayLayerCount = tp::max(range.getEndPoint(), other.getEndPoint()) - range.baseArrayLayer;
+                return true;
+            });
+
+        // Ranges of the same array layers and aspects, the mip level mask can express any set of levels
+        anyMerged |= mergeImageDependencyRanges(
+            imageDependencies,
+            [](const ImageAccessRange& range) {
+                return std::make_tuple(
+                    range.aspectMask.value, range.baseArrayLayer, range.arrayLayerCount, range.mipLevelMask);
+            },
+            [](ImageAccessRange& range, const ImageAccessRange& other) {
+                if (range.aspectMask != other.aspectMask || range.baseArrayLayer != other.baseArrayLayer ||
+                    range.arrayLayerCount != other.arrayLayerCount)
+                    return false;
+                range.mipLevelMask |= other.mipLevelMask;
+                return true;
+            });
+
+        // Ranges of the same array layers and mip levels, but different aspects
+        anyMerged |= mergeImageDependencyRanges(
+            imageDependencies,
+            [](const ImageAccessRange& range) {
+                return std::make_tuple(
+                    range.baseArrayLayer, range.arrayLayerCount, range.mipLevelMask, range.aspectMask.value);
+            },
+            [](ImageAccessRange& range, const ImageAccessRange& other) {
+                if (range.baseArrayLayer != other.baseArrayLayer || range.arrayLayerCount != other.arrayLayerCount ||
+                    range.mipLevelMask != other.mipLevelMask)
+                    return false;
+                range.aspectMask |= other.aspectMask;
+                return true;
+            });
+
+        anyMerged = anyMerged && imageDependencies.size() > 1;
+    }
+}
+
 void Barrier::clear() {
     srcStageMask = 0;
     dstStageMask = 0;
@@ -214,6 +372,9 @@ void Barrier::clear() {
     extDstStageMask = 0;
     bufferDependencies.clear();
     imageDependencies.clear();
+    executionDependencies.clear();
+    globalSrcAccess = {};
+    globalDstAccess = {};
 }
 
 void Barrier::updateExtendedStageMasks() {
@@ -254,12 +415,27 @@ void Barrier::updateExtendedStageMasks() {
     }
 }
 
+void Barrier::addExecutionDependency(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask) {
+    // Dependencies sharing either side can be merged without making the other side wait on anything new
+    for (ExecutionDependency& existingDependency : executionDependencies) {
+        if (existingDependency.srcStageMask == srcStageMask) {
+            existingDependency.dstStageMask |= dstStageMask;
+            return;
+        } else if (existingDependency.dstStageMask == dstStageMask) {
+            existingDependency.srcStageMask |= srcStageMask;
+            return;
+        }
+    }
+    executionDependencies.emplace_back(srcStageMask, dstStageMask);
+}
+
 template <typename TResourceDependency>
 BarrierReference BarrierList::synchronizeDependency(
     const TResourceDependency& dependency,
     uint32_t commandIndex,
     uint32_t firstReusableBarrierIndex,
-    bool wasExported) {
+    bool wasExported,
+    uint32_t srcCommandIndex) {
     if (wasExported)
         firstReusableBarrierIndex = tp::max(firstReusableBarrierIndex, exportReusableBarrierIndex);
 
@@ -269,19 +445,23 @@ BarrierReference BarrierList::synchronizeDependency(
         if (containsAllBits(barrier.extSrcStageMask, dependency.srcAccess.stageMask) &&
             containsAllBits(barrier.extDstStageMask, dependency.dstAccess.stageMask)) {
             uint32_t memoryBarrierIndex = barrier.addDependency(dependency);
+            barrier.srcCommandIndex = tp::max(barrier.srcCommandIndex, srcCommandIndex);
             return BarrierReference(barrierIndex, memoryBarrierIndex);
         }
     }
 
     // Failing that, go for the last existing barrier
     if (firstReusableBarrierIndex < getBarrierCount()) {
-        uint32_t memoryBarrierIndex = barriers[firstReusableBarrierIndex].addDependency(dependency);
+        Barrier& barrier = barriers[firstReusableBarrierIndex];
+        uint32_t memoryBarrierIndex = barrier.addDependency(dependency);
+        barrier.srcCommandIndex = tp::max(barrier.srcCommandIndex, srcCommandIndex);
         return BarrierReference(firstReusableBarrierIndex, memoryBarrierIndex);
     }
 
     // Failing that too, create a new barrier
     uint32_t barrierIndex = getBarrierCount();
     barriers.emplace_back(commandIndex);
+    barriers[barrierIndex].srcCommandIndex = srcCommandIndex;
     uint32_t memoryBarrierIndex = barriers[barrierIndex].addDependency(dependency);
     return BarrierReference(barrierIndex, memoryBarrierIndex);
 }
@@ -302,16 +482,32 @@ BarrierReference BarrierList::synchronizeDependency(
     }
 }
 
+uint32_t BarrierList::foldBufferDependencies(uint32_t threshold) {
+    uint32_t foldedCount = 0;
+    for (Barrier& barrier : barriers) {
+        foldedCount += barrier.foldBufferDependencies(threshold);
+    }
+    return foldedCount;
+}
+
+void BarrierList::mergeImageDependencies() {
+    for (Barrier& barrier : barriers) {
+        barrier.mergeImageDependencies();
+    }
+}
+
 template BarrierReference BarrierList::synchronizeDependency<BufferDependency>(
     const BufferDependency&,
     uint32_t,
     uint32_t,
-    bool);
+    bool,
+    uint32_t);
 template BarrierReference BarrierList::synchronizeDependency<ImageDependency>(
     const ImageDependency&,
     uint32_t,
     uint32_t,
-    bool);
+    bool,
+    uint32_t);
 
 template BarrierReference BarrierList::synchronizeDependency<BufferDependency>(
     const BufferDependency&,
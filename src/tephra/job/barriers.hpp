@@ -34,8 +34,8 @@ struct BufferDependency {
           srcQueueFamilyIndex(srcQueueFamilyIndex),
           dstQueueFamilyIndex(dstQueueFamilyIndex) {}
 
-    // Translates the dependency to a Vulkan memory barrier
-    VkBufferMemoryBarrier toMemoryBarrier() const;
+    // Translates the dependency to a synchronization2 memory barrier with its own stage masks
+    VkBufferMemoryBarrier2 toMemoryBarrier2() const;
 };
 
 // Specifies a memory dependency on an image subresource range between two accesses and optionally defines a layout
@@ -68,8 +68,21 @@ struct ImageDependency {
           srcQueueFamilyIndex(srcQueueFamilyIndex),
           dstQueueFamilyIndex(dstQueueFamilyIndex) {}
 
-    // Translates the dependency to Vulkan memory barriers (mip mask can be disjoint)
-    void toImageBarriers(ScratchVector<VkImageMemoryBarrier>& barriers) const;
+    // Translates the dependency to synchronization2 memory barriers with their own stage masks (mip mask can be
+    // disjoint)
+    void toImageBarriers2(ScratchVector<VkImageMemoryBarrier2>& barriers) const;
+};
+
+// Specifies an execution dependency between two sets of stages that doesn't need a memory barrier (e.g. R->W)
+struct ExecutionDependency {
+    VkPipelineStageFlags srcStageMask;
+    VkPipelineStageFlags dstStageMask;
+
+    ExecutionDependency(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
+        : srcStageMask(srcStageMask), dstStageMask(dstStageMask) {}
+
+    // Translates the dependency to a synchronization2 global barrier without any access masks
+    VkMemoryBarrier2 toMemoryBarrier2() const;
 };
 
 // Represents a Vulkan barrier for synchronizing accesses
@@ -77,6 +90,14 @@ struct Barrier {
     // The index of the first command that depends on this barrier
     uint32_t commandIndex;
 
+    // The index of the first command following all of the source accesses of this barrier. When there are other
+    // commands between it and commandIndex, the barrier can be split around them
+    uint32_t srcCommandIndex;
+
+    // The event used to split the barrier into a signal before srcCommandIndex and a wait before commandIndex, or null
+    // if the barrier is recorded as a regular pipeline barrier
+    VkEventHandle vkSplitEvent;
+
     // The source and destination stage masks forming the execution dependency
     VkPipelineStageFlags srcStageMask;
     VkPipelineStageFlags dstStageMask;
@@ -89,8 +110,21 @@ struct Barrier {
     ScratchVector<BufferDependency> bufferDependencies;
     ScratchVector<ImageDependency> imageDependencies;
 
+    // Execution-only dependencies that are otherwise only represented by the stage masks above. Needed to express
+    // the barrier with synchronization2, where each dependency carries its own stage masks
+    ScratchVector<ExecutionDependency> executionDependencies;
+
+    // Queue-local buffer dependencies that were folded together into a single global memory dependency, null if none
+    ResourceAccess globalSrcAccess;
+    ResourceAccess globalDstAccess;
+
     explicit Barrier(uint32_t commandIndex)
-        : commandIndex(commandIndex), srcStageMask(0), dstStageMask(0), extSrcStageMask(0), extDstStageMask(0) {}
+        : commandIndex(commandIndex),
+          srcCommandIndex(0),
+          srcStageMask(0),
+          dstStageMask(0),
+          extSrcStageMask(0),
+          extDstStageMask(0) {}
 
     // Extends the barrier by the given buffer dependency, returning its index if one was added, ~0 otherwise.
     uint32_t addDependency(const BufferDependency& dependency);
@@ -104,11 +138,25 @@ struct Barrier {
     // Extends an existing image memory dependency by the given dependency
     void extendMemoryDependency(const ImageDependency& dependency, uint32_t memoryDependencyIndex);
 
+    // Returns true if the barrier can be split into an event signal and wait with other commands in between
+    bool isSplittable() const;
+
+    // Replaces the queue-local buffer dependencies with a single global memory dependency if there are more of them
+    // than the given threshold. Returns the number of dependencies folded that way
+    uint32_t foldBufferDependencies(uint32_t threshold);
+
+    // Merges image dependencies that only differ in their subresource ranges, wherever the union of the ranges can be
+    // expressed as a single range
+    void mergeImageDependencies();
+
     void clear();
 
 private:
     // Update extended stage masks to reflect changes made to the actual stage masks
     void updateExtendedStageMasks();
+
+    // Adds an execution-only dependency, merging it with an existing one where that doesn't add any new dependencies
+    void addExecutionDependency(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask);
 };
 
 // Translates known dependencies into barriers to be inserted into the command buffer
@@ -132,6 +180,12 @@ public:
         return barriers[barrierIndex];
     }
 
+    // Appends an empty barrier before the given command, to be filled in directly. Used for replaying barriers that
+    // were prepared for another job
+    Barrier& appendBarrier(uint32_t commandIndex) {
+        return barriers.emplace_back(commandIndex);
+    }
+
     // Marks all previous barriers as non-reusable for export accesses. This is done after compute / render passes
     // that may use previously exported resources
     void markExportedResourceUsage() {
@@ -139,18 +193,29 @@ public:
     }
 
     // Synchronize a dependency with a barrier, attempting to reuse any with index greater than
-    // firstReusableBarrierIndex, with some special handling for exports
+    // firstReusableBarrierIndex, with some special handling for exports. The srcCommandIndex is the index of the first
+    // command following the source access of the dependency
     template <typename TResourceDependency>
     BarrierReference synchronizeDependency(
         const TResourceDependency& dependency,
         uint32_t commandIndex,
         uint32_t firstReusableBarrierIndex,
-        bool wasExported);
+        bool wasExported,
+        uint32_t srcCommandIndex);
 
     // Synchronize a dependency with a barrier, reusing a specific barrier
     template <typename TResourceDependency>
     BarrierReference synchronizeDependency(const TResourceDependency& dependency, BarrierReference reusedBarrier);
 
+    // Folds the buffer dependencies of barriers exceeding the threshold into global memory dependencies. Must only be
+    // called once all dependencies have been synchronized, as it invalidates references to buffer dependencies.
+    // Returns the total number of dependencies folded
+    uint32_t foldBufferDependencies(uint32_t threshold);
+
+    // Merges the image dependencies of each barrier into the fewest subresource ranges. Like folding, it invalidates
+    // references to image dependencies
+    void mergeImageDependencies();
+
 private:
     uint64_t jobId = 0;
     uint32_t exportReusableBarrierIndex = 0;
@@ -26,11 +26,11 @@ QueryRecorder& PrimaryBufferRecorder::getQueryRecorder() {
 
 VkCommandBufferHandle PrimaryBufferRecorder::requestBuffer() {
     if (vkCurrentBuffer.isNull()) {
-        // Setup of a primary one time use command buffer
+        // Setup of a primary command buffer, one time use unless the pool says otherwise
         VkCommandBufferBeginInfo beginInfo;
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.pNext = nullptr;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.flags = commandPool->getCommandBufferUsage();
         beginInfo.pInheritanceInfo = nullptr;
 
         vkCurrentBuffer = commandPool->acquirePrimaryCommandBuffer(debugName);
@@ -64,31 +64,84 @@ void PrimaryBufferRecorder::endRecording() {
     }
 }
 
-inline void addBufferAccess(
-    ScratchVector<NewBufferAccess>& bufferAccesses,
-    StoredBufferView& bufferView,
-    ResourceAccess access) {
-    auto [vkBufferHandle, range] = resolveBufferAccess(bufferView);
-    bufferAccesses.emplace_back(vkBufferHandle, std::move(range), std::move(access));
+// Collects the accesses of a command resolved to the underlying resources
+class ResolvedAccessList {
+public:
+    ResolvedAccessList(ScratchVector<NewBufferAccess>& bufferAccesses, ScratchVector<NewImageAccess>& imageAccesses)
+        : bufferAccesses(bufferAccesses), imageAccesses(imageAccesses) {}
+
+    void addBufferAccess(StoredBufferView& bufferView, BufferAccessRange range, ResourceAccess access) {
+        uint32_t resourceId;
+        VkBufferHandle vkBufferHandle = resolveBufferAccess(bufferView, &range, &resourceId);
+        bufferAccesses.emplace_back(vkBufferHandle, resourceId, std::move(range), std::move(access));
+    }
+
+    void addImageAccess(
+        StoredImageView& imageView,
+        ImageAccessRange range,
+        ResourceAccess access,
+        VkImageLayout layout) {
+        // Images placed into shared memory blocks also access the memory they alias through the block's buffer
+        uint32_t memoryAliasAccessIndex = ~0;
+        const BufferView* memoryAliasView = imageView.getMemoryAliasView();
+        if (memoryAliasView != nullptr) {
+            memoryAliasAccessIndex = static_cast<uint32_t>(bufferAccesses.size());
+            StoredBufferView storedAliasView = *memoryAliasView;
+            addBufferAccess(storedAliasView, { 0, memoryAliasView->getSize() }, access);
+        }
+
+        uint32_t resourceId;
+        VkImageHandle vkImageHandle = resolveImageAccess(imageView, &range, &resourceId);
+        imageAccesses.emplace_back(
+            vkImageHandle, resourceId, std::move(range), std::move(access), layout, memoryAliasAccessIndex);
+    }
+
+private:
+    ScratchVector<NewBufferAccess>& bufferAccesses;
+    ScratchVector<NewImageAccess>& imageAccesses;
+};
+
+// Collects the accesses of a command to the views themselves, so that they can be resolved later
+class RecordedAccessList {
+public:
+    void addBufferAccess(StoredBufferView& bufferView, BufferAccessRange range, ResourceAccess access) {
+        bufferAccesses.push_back({ &bufferView, range, access });
+    }
+
+    void addImageAccess(
+        StoredImageView& imageView,
+        ImageAccessRange range,
+        ResourceAccess access,
+        VkImageLayout layout) {
+        imageAccesses.push_back({ &imageView, range, access, layout });
+    }
+
+    ScratchVector<JobRecordStorage::RecordedBufferAccess> bufferAccesses;
+    ScratchVector<JobRecordStorage::RecordedImageAccess> imageAccesses;
+};
+
+template <typename TAccessList>
+inline void addBufferAccess(TAccessList& accesses, StoredBufferView& bufferView, ResourceAccess access) {
+    accesses.addBufferAccess(bufferView, { 0, bufferView.getSize() }, std::move(access));
 }
 
+template <typename TAccessList>
 inline void addBufferAccess(
-    ScratchVector<NewBufferAccess>& bufferAccesses,
+    TAccessList& accesses,
     StoredBufferView& bufferView,
     BufferAccessRange range,
     ResourceAccess access) {
-    VkBufferHandle vkBufferHandle = resolveBufferAccess(bufferView, &range);
-    bufferAccesses.emplace_back(vkBufferHandle, std::move(range), std::move(access));
+    accesses.addBufferAccess(bufferView, std::move(range), std::move(access));
 }
 
+template <typename TAccessList>
 inline void addImageAccess(
-    ScratchVector<NewImageAccess>& imageAccesses,
+    TAccessList& accesses,
     StoredImageView& imageView,
     ImageAccessRange range,
     ResourceAccess access,
     VkImageLayout layout) {
-    VkImageHandle vkImageHandle = resolveImageAccess(imageView, &range);
-    imageAccesses.emplace_back(vkImageHandle, std::move(range), std::move(access), layout);
+    accesses.addImageAccess(imageView, std::move(range), std::move(access), layout);
 }
 
 uint64_t getImageCopySizeBytes(const BufferImageCopyRegion& copyInfo, const FormatClassProperties& formatProperties) {
@@ -111,36 +164,29 @@ uint64_t getImageCopySizeBytes(const BufferImageCopyRegion& copyInfo, const Form
     return imageSize * slices;
 }
 
-void identifyCommandResourceAccesses(
-    JobRecordStorage::CommandMetadata* command,
-    ScratchVector<NewBufferAccess>& bufferAccesses,
-    ScratchVector<NewImageAccess>& imageAccesses) {
-    bufferAccesses.clear();
-    imageAccesses.clear();
-
+template <typename TAccessList>
+void identifyCommandAccesses(JobRecordStorage::CommandMetadata* command, TAccessList& accesses) {
     switch (command->commandType) {
     case JobCommandTypes::FillBuffer: {
         auto* data = getCommandData<JobRecordStorage::FillBufferData>(command);
-        addBufferAccess(
-            bufferAccesses, data->dstBuffer, { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT });
+        addBufferAccess(accesses, data->dstBuffer, { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT });
         break;
     }
     case JobCommandTypes::UpdateBuffer: {
         auto* data = getCommandData<JobRecordStorage::UpdateBufferData>(command);
-        addBufferAccess(
-            bufferAccesses, data->dstBuffer, { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT });
+        addBufferAccess(accesses, data->dstBuffer, { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT });
         break;
     }
     case JobCommandTypes::CopyBuffer: {
         auto* data = getCommandData<JobRecordStorage::CopyBufferData>(command);
         for (const auto& copyRegion : data->copyRegions) {
             addBufferAccess(
-                bufferAccesses,
+                accesses,
                 data->srcBuffer,
                 { copyRegion.srcOffset, copyRegion.size },
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT });
             addBufferAccess(
-                bufferAccesses,
+                accesses,
                 data->dstBuffer,
                 { copyRegion.dstOffset, copyRegion.size },
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT });
@@ -153,12 +199,12 @@ void identifyCommandResourceAccesses(
 
         for (const auto& copyRegion : data->copyRegions) {
             addBufferAccess(
-                bufferAccesses,
+                accesses,
                 data->buffer,
                 { copyRegion.bufferOffset, getImageCopySizeBytes(copyRegion, formatProperties) },
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT });
             addImageAccess(
-                imageAccesses,
+                accesses,
                 data->image,
                 ImageSubresourceRange(copyRegion.imageSubresource),
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT },
@@ -172,13 +218,13 @@ void identifyCommandResourceAccesses(
 
         for (const auto& copyRegion : data->copyRegions) {
             addImageAccess(
-                imageAccesses,
+                accesses,
                 data->image,
                 ImageSubresourceRange(copyRegion.imageSubresource),
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT },
                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
             addBufferAccess(
-                bufferAccesses,
+                accesses,
                 data->buffer,
                 { copyRegion.bufferOffset, getImageCopySizeBytes(copyRegion, formatProperties) },
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT });
@@ -190,13 +236,13 @@ void identifyCommandResourceAccesses(
         auto* data = getCommandData<JobRecordStorage::CopyImageData>(command);
         for (const auto& copyRegion : data->copyRegions) {
             addImageAccess(
-                imageAccesses,
+                accesses,
                 data->srcImage,
                 ImageSubresourceRange(copyRegion.srcSubresource),
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT },
                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
             addImageAccess(
-                imageAccesses,
+                accesses,
                 data->dstImage,
                 ImageSubresourceRange(copyRegion.dstSubresource),
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT },
@@ -208,13 +254,13 @@ void identifyCommandResourceAccesses(
         auto* data = getCommandData<JobRecordStorage::BlitImageData>(command);
         for (const auto& blitRegion : data->blitRegions) {
             addImageAccess(
-                imageAccesses,
+                accesses,
                 data->srcImage,
                 ImageSubresourceRange(blitRegion.srcSubresource),
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT },
                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
             addImageAccess(
-                imageAccesses,
+                accesses,
                 data->dstImage,
                 ImageSubresourceRange(blitRegion.dstSubresource),
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT },
@@ -226,7 +272,7 @@ void identifyCommandResourceAccesses(
         auto* data = getCommandData<JobRecordStorage::ClearImageData>(command);
         for (const auto& range : data->ranges) {
             addImageAccess(
-                imageAccesses,
+                accesses,
                 data->dstImage,
                 range,
                 { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT },
@@ -241,7 +287,7 @@ void identifyCommandResourceAccesses(
             VkAccessFlags accessMask;
             bool isAtomic;
             convertComputeAccessToVkAccess(entry.accessMask, &stageMask, &accessMask, &isAtomic);
-            addBufferAccess(bufferAccesses, entry.buffer, { stageMask, accessMask });
+            addBufferAccess(accesses, entry.buffer, { stageMask, accessMask });
         }
         for (StoredImageComputeAccess& entry : data->pass->getImageAccesses()) {
             VkPipelineStageFlags stageMask;
@@ -249,7 +295,7 @@ void identifyCommandResourceAccesses(
             bool isAtomic;
             convertComputeAccessToVkAccess(entry.accessMask, &stageMask, &accessMask, &isAtomic);
             VkImageLayout layout = vkGetImageLayoutFromComputeAccess(entry.accessMask);
-            addImageAccess(imageAccesses, entry.image, entry.range, { stageMask, accessMask }, layout);
+            addImageAccess(accesses, entry.image, entry.range, { stageMask, accessMask }, layout);
         }
         break;
     }
@@ -260,7 +306,7 @@ void identifyCommandResourceAccesses(
             VkAccessFlags accessMask;
             bool isAtomic;
             convertRenderAccessToVkAccess(entry.accessMask, &stageMask, &accessMask, &isAtomic);
-            addBufferAccess(bufferAccesses, entry.buffer, { stageMask, accessMask });
+            addBufferAccess(accesses, entry.buffer, { stageMask, accessMask });
         }
         for (StoredImageRenderAccess& entry : data->pass->getImageAccesses()) {
             VkPipelineStageFlags stageMask;
@@ -268,7 +314,7 @@ void identifyCommandResourceAccesses(
             bool isAtomic;
             convertRenderAccessToVkAccess(entry.accessMask, &stageMask, &accessMask, &isAtomic);
             VkImageLayout layout = vkGetImageLayoutFromRenderAccess(entry.accessMask);
-            addImageAccess(imageAccesses, entry.image, entry.range, { stageMask, accessMask }, layout);
+            addImageAccess(accesses, entry.image, entry.range, { stageMask, accessMask }, layout);
         }
         for (AttachmentAccess& entry : data->pass->getAttachmentAccesses()) {
             ImageAccessRange range;
@@ -276,7 +322,7 @@ void identifyCommandResourceAccesses(
             VkImageLayout layout;
             if (!entry.imageView.isNull()) {
                 entry.convertToVkAccess(&range, &access, &layout);
-                addImageAccess(imageAccesses, entry.imageView, range, access, layout);
+                addImageAccess(accesses, entry.imageView, range, access, layout);
             }
         }
         break;
@@ -299,56 +345,54 @@ void identifyCommandResourceAccesses(
             // Destination structure could also be read from in case of an in-place update
             if (inPlaceUpdate)
                 dstAccess |= VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
-            addBufferAccess(bufferAccesses, dstBuffer, { asBuildStage, dstAccess });
+            addBufferAccess(accesses, dstBuffer, { asBuildStage, dstAccess });
 
             if (!buildInfo.srcView.isNull() && !inPlaceUpdate) {
                 StoredBufferView& srcBuffer = buildInfo.srcView.getBackingBufferView();
-                addBufferAccess(
-                    bufferAccesses, srcBuffer, { asBuildStage, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR });
+                addBufferAccess(accesses, srcBuffer, { asBuildStage, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR });
             }
 
             if (!buildInfo.instanceGeometry.instanceBuffer.isNull())
-                addBufferAccess(bufferAccesses, buildInfo.instanceGeometry.instanceBuffer, asBuildInput);
+                addBufferAccess(accesses, buildInfo.instanceGeometry.instanceBuffer, asBuildInput);
 
             for (StoredAccelerationStructureView& accessedView : buildInfo.instanceGeometry.accessedViews) {
                 StoredBufferView& srcBuffer = accessedView.getBackingBufferView();
-                addBufferAccess(
-                    bufferAccesses, srcBuffer, { asBuildStage, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR });
+                addBufferAccess(accesses, srcBuffer, { asBuildStage, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR });
             }
 
             for (StoredTriangleGeometryBuildInfo& triangles : buildInfo.triangleGeometries) {
-                addBufferAccess(bufferAccesses, triangles.vertexBuffer, asBuildInput);
+                addBufferAccess(accesses, triangles.vertexBuffer, asBuildInput);
                 if (!triangles.indexBuffer.isNull())
-                    addBufferAccess(bufferAccesses, triangles.indexBuffer, asBuildInput);
+                    addBufferAccess(accesses, triangles.indexBuffer, asBuildInput);
                 if (!triangles.transformBuffer.isNull())
-                    addBufferAccess(bufferAccesses, triangles.transformBuffer, asBuildInput);
+                    addBufferAccess(accesses, triangles.transformBuffer, asBuildInput);
             }
 
             for (StoredAABBGeometryBuildInfo& aabbs : buildInfo.aabbGeometries) {
-                addBufferAccess(bufferAccesses, aabbs.aabbBuffer, asBuildInput);
+                addBufferAccess(accesses, aabbs.aabbBuffer, asBuildInput);
             }
 
             StoredBufferView& indirectBuffer = buildData.indirectInfo.buildRangeBuffer;
             if (!indirectBuffer.isNull())
-                addBufferAccess(bufferAccesses, indirectBuffer, { asBuildStage, VK_ACCESS_INDIRECT_COMMAND_READ_BIT });
+                addBufferAccess(accesses, indirectBuffer, { asBuildStage, VK_ACCESS_INDIRECT_COMMAND_READ_BIT });
         }
 
         if (!data->scratchBuffer.isNull()) {
             const auto scratchAccess = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR |
                 VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
-            addBufferAccess(bufferAccesses, data->scratchBuffer, { asBuildStage, scratchAccess });
+            addBufferAccess(accesses, data->scratchBuffer, { asBuildStage, scratchAccess });
         }
         break;
     }
     case JobCommandTypes::CopyAccelerationStructure: {
         auto* data = getCommandData<JobRecordStorage::CopyAccelerationStructureData>(command);
         addBufferAccess(
-            bufferAccesses,
+            accesses,
             data->srcView.getBackingBufferView(),
             { VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR });
 
         addBufferAccess(
-            bufferAccesses,
+            accesses,
             data->dstView.getBackingBufferView(),
             { VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR });
         break;
@@ -357,7 +401,7 @@ void identifyCommandResourceAccesses(
         auto* data = getCommandData<JobRecordStorage::WriteAccelerationStructureSizesData>(command);
         for (StoredAccelerationStructureView& view : data->views) {
             addBufferAccess(
-                bufferAccesses,
+                accesses,
                 view.getBackingBufferView(),
                 { VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
                   VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR });
@@ -375,6 +419,60 @@ void identifyCommandResourceAccesses(
     }
 }
 
+void identifyCommandResourceAccesses(
+    JobRecordStorage::CommandMetadata* command,
+    ScratchVector<NewBufferAccess>& bufferAccesses,
+    ScratchVector<NewImageAccess>& imageAccesses) {
+    bufferAccesses.clear();
+    imageAccesses.clear();
+
+    ResolvedAccessList accesses(bufferAccesses, imageAccesses);
+    if (command->recordedAccesses != nullptr) {
+        // Only the views of the accesses identified at record time need to be resolved
+        for (const JobRecordStorage::RecordedBufferAccess& recorded : command->recordedAccesses->bufferAccesses) {
+            accesses.addBufferAccess(*recorded.buffer, recorded.range, recorded.access);
+        }
+        for (const JobRecordStorage::RecordedImageAccess& recorded : command->recordedAccesses->imageAccesses) {
+            accesses.addImageAccess(*recorded.image, recorded.range, recorded.access, recorded.layout);
+        }
+    } else {
+        identifyCommandAccesses(command, accesses);
+    }
+}
+
+void recordCommandResourceAccesses(JobRecordStorage& storage, JobRecordStorage::CommandMetadata* command) {
+    switch (command->commandType) {
+    case JobCommandTypes::ExportBuffer:
+    case JobCommandTypes::ExportImage:
+    case JobCommandTypes::DiscardImageContents:
+    case JobCommandTypes::ImportExternalBuffer:
+    case JobCommandTypes::ImportExternalImage:
+        // Handled separately during compilation
+        return;
+    case JobCommandTypes::BuildAccelerationStructures:
+    case JobCommandTypes::BuildAccelerationStructuresIndirect:
+        // Whether a build updates a structure in place depends on the handles of job-local acceleration structures,
+        // which are only known after the job gets enqueued
+        return;
+    default:
+        break;
+    }
+
+    RecordedAccessList accesses;
+    identifyCommandAccesses(command, accesses);
+    if (accesses.bufferAccesses.empty() && accesses.imageAccesses.empty())
+        return;
+
+    // Store the accesses along with the command data, so they stay valid for as long as the views they refer to
+    auto bufferAccesses = storage.cmdBuffer.allocate<JobRecordStorage::RecordedBufferAccess>(
+        view(accesses.bufferAccesses));
+    auto imageAccesses = storage.cmdBuffer.allocate<JobRecordStorage::RecordedImageAccess>(
+        view(accesses.imageAccesses));
+    auto recordedAccessesBytes = storage.cmdBuffer.allocate(sizeof(JobRecordStorage::RecordedAccesses));
+    command->recordedAccesses = new (recordedAccessesBytes.data())
+        JobRecordStorage::RecordedAccesses{ bufferAccesses, imageAccesses };
+}
+
 void recordCommand(const JobData* job, PrimaryBufferRecorder& recorder, JobRecordStorage::CommandMetadata* command) {
     const VulkanCommandInterface& vkiCommands = recorder.getVkiCommands();
 
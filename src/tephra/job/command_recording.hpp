@@ -55,11 +55,17 @@ const T* getCommandData(const JobRecordStorage::CommandMetadata* command) {
     return reinterpret_cast<const T*>(command + 1);
 }
 
+// Identifies the resource accesses of the command, resolved to the underlying resources. Uses the accesses identified
+// at record time, if available
 void identifyCommandResourceAccesses(
     JobRecordStorage::CommandMetadata* command,
     ScratchVector<NewBufferAccess>& bufferAccesses,
     ScratchVector<NewImageAccess>& imageAccesses);
 
+// Identifies the resource accesses of a just recorded command and stores them alongside it, leaving only the resolution
+// of the accessed views to the underlying resources for compilation
+void recordCommandResourceAccesses(JobRecordStorage& storage, JobRecordStorage::CommandMetadata* command);
+
 // Records a Tephra command to primary Vulkan command buffers. The command data may be consumed by this operation
 void recordCommand(const JobData* job, PrimaryBufferRecorder& recorder, JobRecordStorage::CommandMetadata* command);
 
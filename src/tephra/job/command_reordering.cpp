@@ -0,0 +1,210 @@
+#include "command_reordering.hpp"
+#include "command_recording.hpp"
+#include "accesses.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace tp {
+
+// Returns true for commands that can be moved within the job as long as the order of their dependencies is kept
+bool isReorderableCommand(JobCommandTypes commandType) {
+    switch (commandType) {
+    case JobCommandTypes::FillBuffer:
+    case JobCommandTypes::UpdateBuffer:
+    case JobCommandTypes::CopyBuffer:
+    case JobCommandTypes::CopyBufferToImage:
+    case JobCommandTypes::CopyImageToBuffer:
+    case JobCommandTypes::CopyImage:
+    case JobCommandTypes::BlitImage:
+    case JobCommandTypes::ClearImage:
+    case JobCommandTypes::ResolveImage:
+    case JobCommandTypes::ExecuteComputePass:
+    case JobCommandTypes::ExecuteRenderPass:
+        return true;
+    default:
+        // Exports, imports, discards, debug labels, queries and acceleration structure operations stay in place
+        return false;
+    }
+}
+
+bool areAccessesDependent(const NewBufferAccess& a, const NewBufferAccess& b) {
+    return a.vkResourceHandle == b.vkResourceHandle && areAccessRangesOverlapping(a.range, b.range) &&
+        (!a.isReadOnly() || !b.isReadOnly());
+}
+
+bool areAccessesDependent(const NewImageAccess& a, const NewImageAccess& b) {
+    // Layout transitions count as writes
+    return a.vkResourceHandle == b.vkResourceHandle && areAccessRangesOverlapping(a.range, b.range) &&
+        (!a.isReadOnly() || !b.isReadOnly() || a.layout != b.layout);
+}
+
+// Keeps track of the accesses of the commands in a segment, chained by the resource they access
+template <typename TNewAccess>
+class SegmentAccessTracker {
+public:
+    // Finds the accesses of previous commands that the given access depends on, raising the level of the accessing
+    // command above theirs and extending dependencyEnd past the offset of the last of those commands
+    void findDependencies(
+        const TNewAccess& newAccess,
+        ArrayView<const uint32_t> commandLevels,
+        uint32_t* level,
+        uint32_t* dependencyEnd) const {
+        if (newAccess.resourceId >= lastAccessIndices.size())
+            return;
+
+        for (uint32_t accessIndex = lastAccessIndices[newAccess.resourceId]; accessIndex != ~0u;
+             accessIndex = accesses[accessIndex].previousAccessIndex) {
+            const SegmentAccess& access = accesses[accessIndex];
+            if (areAccessesDependent(access.access, newAccess)) {
+                *level = tp::max(*level, commandLevels[access.commandOffset] + 1);
+                *dependencyEnd = tp::max(*dependencyEnd, access.commandOffset + 1);
+            }
+        }
+    }
+
+    void addAccess(const TNewAccess& newAccess, uint32_t commandOffset) {
+        if (newAccess.resourceId >= lastAccessIndices.size())
+            lastAccessIndices.resize(newAccess.resourceId + 1, ~0u);
+
+        uint32_t& lastAccessIndex = lastAccessIndices[newAccess.resourceId];
+        accesses.push_back({ newAccess, commandOffset, lastAccessIndex });
+        lastAccessIndex = static_cast<uint32_t>(accesses.size() - 1);
+    }
+
+    void clear() {
+        for (const SegmentAccess& access : accesses) {
+            lastAccessIndices[access.access.resourceId] = ~0u;
+        }
+        accesses.clear();
+    }
+
+private:
+    struct SegmentAccess {
+        TNewAccess access;
+        uint32_t commandOffset;
+        // The index of the previous access to the same resource, ~0 if none
+        uint32_t previousAccessIndex;
+    };
+
+    ScratchVector<SegmentAccess> accesses;
+    // The index of the last access of each resource, indexed by its resource id
+    ScratchVector<uint32_t> lastAccessIndices;
+};
+
+class CommandReorderer {
+public:
+    explicit CommandReorderer(JobRecordStorage* record) : record(record) {}
+
+    // Reorders the given run of reorderable commands placed between commandBefore and commandAfter, either of which
+    // may be null. Returns the estimated number of barriers saved
+    uint32_t reorderSegment(
+        JobRecordStorage::CommandMetadata* commandBefore,
+        ArrayView<JobRecordStorage::CommandMetadata* const> segment,
+        JobRecordStorage::CommandMetadata* commandAfter) {
+        uint32_t commandCount = static_cast<uint32_t>(segment.size());
+        commandLevels.assign(commandCount, 0);
+
+        // Estimate the barriers needed in the recorded order the same way they get placed during compilation,
+        // inserting a new one whenever a command depends on another one that follows the last barrier
+        uint32_t recordedBarrierCount = 0;
+        uint32_t lastBarrierOffset = 0;
+        uint32_t levelCount = 1;
+
+        for (uint32_t commandOffset = 0; commandOffset < commandCount; commandOffset++) {
+            identifyCommandResourceAccesses(segment[commandOffset], newBufferAccesses, newImageAccesses);
+
+            uint32_t level = 0;
+            uint32_t dependencyEnd = 0;
+            for (const NewBufferAccess& newAccess : newBufferAccesses) {
+                bufferTracker.findDependencies(newAccess, view(commandLevels), &level, &dependencyEnd);
+            }
+            for (const NewImageAccess& newAccess : newImageAccesses) {
+                imageTracker.findDependencies(newAccess, view(commandLevels), &level, &dependencyEnd);
+            }
+
+            for (const NewBufferAccess& newAccess : newBufferAccesses) {
+                bufferTracker.addAccess(newAccess, commandOffset);
+            }
+            for (const NewImageAccess& newAccess : newImageAccesses) {
+                imageTracker.addAccess(newAccess, commandOffset);
+            }
+
+            commandLevels[commandOffset] = level;
+            levelCount = tp::max(levelCount, level + 1);
+            if (dependencyEnd > lastBarrierOffset) {
+                recordedBarrierCount++;
+                lastBarrierOffset = commandOffset;
+            }
+        }
+
+        bufferTracker.clear();
+        imageTracker.clear();
+
+        // Every level after the first depends on the previous one, needing exactly one barrier each
+        uint32_t reorderedBarrierCount = levelCount - 1;
+        if (reorderedBarrierCount >= recordedBarrierCount)
+            return 0;
+
+        // Order the commands by their levels, keeping the recorded order within each of them
+        commandOrder.resize(commandCount);
+        std::iota(commandOrder.begin(), commandOrder.end(), 0);
+        std::stable_sort(commandOrder.begin(), commandOrder.end(), [&](uint32_t a, uint32_t b) {
+            return commandLevels[a] < commandLevels[b];
+        });
+
+        // Relink the segment in the new order
+        JobRecordStorage::CommandMetadata* previousCommand = commandBefore;
+        for (uint32_t commandOffset : commandOrder) {
+            JobRecordStorage::CommandMetadata* command = segment[commandOffset];
+            if (previousCommand != nullptr)
+                previousCommand->nextCommand = command;
+            else
+                record->firstCommandPtr = command;
+            previousCommand = command;
+        }
+        previousCommand->nextCommand = commandAfter;
+        if (commandAfter == nullptr)
+            record->lastCommandPtr = previousCommand;
+
+        return recordedBarrierCount - reorderedBarrierCount;
+    }
+
+private:
+    JobRecordStorage* record;
+    SegmentAccessTracker<NewBufferAccess> bufferTracker;
+    SegmentAccessTracker<NewImageAccess> imageTracker;
+    ScratchVector<NewBufferAccess> newBufferAccesses;
+    ScratchVector<NewImageAccess> newImageAccesses;
+    ScratchVector<uint32_t> commandLevels;
+    ScratchVector<uint32_t> commandOrder;
+};
+
+uint32_t reorderJobCommands(JobData* job) {
+    CommandReorderer reorderer(&job->record);
+    ScratchVector<JobRecordStorage::CommandMetadata*> segment;
+    JobRecordStorage::CommandMetadata* commandBeforeSegment = nullptr;
+    uint32_t barriersSaved = 0;
+
+    auto* cmd = job->record.firstCommandPtr;
+    while (true) {
+        if (cmd != nullptr && isReorderableCommand(cmd->commandType)) {
+            segment.push_back(cmd);
+            cmd = cmd->nextCommand;
+            continue;
+        }
+
+        // Reached the end of a segment, the command stays in place
+        if (segment.size() > 1)
+            barriersSaved += reorderer.reorderSegment(commandBeforeSegment, view(segment), cmd);
+        segment.clear();
+
+        if (cmd == nullptr)
+            break;
+        commandBeforeSegment = cmd;
+        cmd = cmd->nextCommand;
+    }
+
+    return barriersSaved;
+}
+
+}
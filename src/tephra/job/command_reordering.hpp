@@ -0,0 +1,16 @@
+#pragma once
+
+#include "job_data.hpp"
+#include "../common_impl.hpp"
+
+namespace tp {
+
+// Reorders the commands of the job to batch independent commands together, so that fewer barriers are needed between
+// them. Only runs of transfer commands and compute and render passes get reordered, any other command stays in place
+// and no command moves across it. Commands get grouped by the length of the longest chain of dependent commands leading
+// to them, keeping their recorded order within each group. Must be called after the job's resources have been
+// allocated, so that accesses of aliased job-local resources are seen as dependencies. Returns the estimated number of
+// barriers saved.
+uint32_t reorderJobCommands(JobData* job);
+
+}
@@ -55,6 +55,11 @@ public:
 
     void recordPass(PrimaryBufferRecorder& recorder);
 
+    // Inline passes get recorded during compilation, deferred ones may still be recorded by the user after enqueue
+    bool isRecordedInline() const {
+        return isInline;
+    }
+
     TEPHRA_MAKE_NONCOPYABLE(ComputePass);
     TEPHRA_MAKE_NONMOVABLE(ComputePass);
     ~ComputePass() = default;
@@ -3,10 +3,12 @@
 #include "compute_pass.hpp"
 #include "render_pass.hpp"
 #include "accesses.hpp"
+#include "command_recording.hpp"
 #include "../device/device_container.hpp"
 #include "../swapchain_impl.hpp"
 #include "../acceleration_structure_impl.hpp"
 #include <tephra/job.hpp>
+#include <algorithm>
 
 namespace tp {
 
@@ -15,6 +17,8 @@ constexpr const char* RenderListTypeName = "RenderList";
 constexpr const char* JobLocalBufferTypeName = "JobLocalBuffer";
 constexpr const char* JobLocalImageTypeName = "JobLocalImage";
 constexpr const char* JobLocalAccelerationStructureTypeName = "JobLocalAccelerationStructure";
+// The minimum size of the preinitialized buffers that large buffer updates get staged in
+constexpr uint64_t UpdateStagingBufferSize = 256 * 1024;
 
 template <typename T, typename... TArgs>
 std::pair<JobRecordStorage::CommandMetadata*, T*> allocateCommand(
@@ -27,9 +31,12 @@ std::pair<JobRecordStorage::CommandMetadata*, T*> allocateCommand(
     auto metadataPtr = new (bytes.data()) JobRecordStorage::CommandMetadata;
     metadataPtr->commandType = type;
     metadataPtr->nextCommand = nullptr;
+    metadataPtr->recordedAccesses = nullptr;
 
-    auto cmdDataPtr = bytes.data() + sizeof(JobRecordStorage::CommandMetadata);
-    return { metadataPtr, new (cmdDataPtr) T(std::forward<TArgs>(args)...) };
+    auto cmdDataPtr = new (bytes.data() + sizeof(JobRecordStorage::CommandMetadata)) T(std::forward<TArgs>(args)...);
+    if (storage.identifiesAccesses)
+        recordCommandResourceAccesses(storage, metadataPtr);
+    return { metadataPtr, cmdDataPtr };
 }
 
 template <typename T, typename... TArgs>
@@ -46,9 +53,42 @@ T* recordDelayedCommand(JobRecordStorage& storage, JobCommandTypes type, TArgs&&
     return cmdDataPtr;
 }
 
+// Reports the use of functionality that can't be compiled once for repeated submissions of the job
+inline void validateReusableJobSupport(const JobData* jobData, const char* functionality) {
+    if constexpr (TephraValidationEnabled) {
+        if (jobData->flags.contains(JobFlag::Reusable)) {
+            reportDebugMessage(
+                DebugMessageSeverity::Error,
+                DebugMessageType::Validation,
+                functionality,
+                " cannot be used in a Job created with JobFlag::Reusable.");
+        }
+    }
+}
+
+// Reports the use of functionality that sub-jobs can't support, because it isn't safe to access the parent job or
+// its pool while recording
+inline void validateSubJobSupport(const JobData* jobData, const char* functionality) {
+    if constexpr (TephraValidationEnabled) {
+        if (jobData->parentJob != nullptr) {
+            reportDebugMessage(
+                DebugMessageSeverity::Error,
+                DebugMessageType::Validation,
+                functionality,
+                " cannot be used in a sub-job created with Job::createSubJob.");
+        }
+    }
+}
+
 inline void markResourceUsage(JobData* jobData, const BufferView& buffer, bool usedUntilEnd = false) {
     TEPHRA_ASSERT(!buffer.isNull());
-    if (buffer.viewsJobLocalBuffer()) {
+    if (buffer.viewsJobLocalBuffer() && jobData->parentJob != nullptr) {
+        // The local resources belong to the parent job, which may be recorded on another thread
+        jobData->record.subJobBufferUsages.emplace_back(buffer, jobData->record.nextCommandIndex);
+        if (usedUntilEnd) {
+            jobData->record.subJobBufferUsages.emplace_back(buffer, ~0);
+        }
+    } else if (buffer.viewsJobLocalBuffer()) {
         jobData->resources.localBuffers.markBufferUsage(buffer, jobData->record.nextCommandIndex);
         if (usedUntilEnd) {
             jobData->resources.localBuffers.markBufferUsage(buffer, ~0);
@@ -58,7 +98,12 @@ inline void markResourceUsage(JobData* jobData, const BufferView& buffer, bool u
 
 inline void markResourceUsage(JobData* jobData, const ImageView& image, bool usedUntilEnd = false) {
     TEPHRA_ASSERT(!image.isNull());
-    if (image.viewsJobLocalImage()) {
+    if (image.viewsJobLocalImage() && jobData->parentJob != nullptr) {
+        jobData->record.subJobImageUsages.emplace_back(image, jobData->record.nextCommandIndex);
+        if (usedUntilEnd) {
+            jobData->record.subJobImageUsages.emplace_back(image, ~0);
+        }
+    } else if (image.viewsJobLocalImage()) {
         jobData->resources.localImages.markImageUsage(image, jobData->record.nextCommandIndex);
         if (usedUntilEnd) {
             jobData->resources.localImages.markImageUsage(image, ~0);
@@ -76,8 +121,6 @@ inline void markResourceUsage(JobData* jobData, const StoredImageView& image, bo
 Job::Job(JobData* jobData, DebugTarget debugTarget) : debugTarget(std::move(debugTarget)), jobData(jobData) {
     TEPHRA_ASSERT(jobData != nullptr);
     TEPHRA_ASSERT(jobData->resourcePoolImpl != nullptr);
-    if (this->debugTarget->getObjectName() != nullptr)
-        cmdBeginDebugLabel(this->debugTarget->getObjectName());
 }
 
 void Job::finalize() {
@@ -94,6 +137,8 @@ void Job::finalize() {
 
 BufferView Job::allocateLocalBuffer(const BufferSetup& setup, const char* debugName) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "allocateLocalBuffer", debugName);
+    validateReusableJobSupport(jobData, "Job-local buffers");
+    validateSubJobSupport(jobData, "Job-local buffers");
 
     DebugTarget debugTarget = DebugTarget(
         jobData->resourcePoolImpl->getDebugTarget(), JobLocalBufferTypeName, debugName);
@@ -102,6 +147,8 @@ BufferView Job::allocateLocalBuffer(const BufferSetup& setup, const char* debugN
 
 ImageView Job::allocateLocalImage(const ImageSetup& setup, const char* debugName) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "allocateLocalImage", debugName);
+    validateReusableJobSupport(jobData, "Job-local images");
+    validateSubJobSupport(jobData, "Job-local images");
 
     DebugTarget debugTarget = DebugTarget(
         jobData->resourcePoolImpl->getDebugTarget(), JobLocalImageTypeName, debugName);
@@ -113,6 +160,7 @@ BufferView Job::allocatePreinitializedBuffer(
     const MemoryPreference& memoryPreference,
     const char* debugName) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "allocatePreinitializedBuffer", debugName);
+    validateSubJobSupport(jobData, "Preinitialized buffers");
 
     return jobData->resourcePoolImpl->getPreinitializedBufferPool()->allocateJobBuffer(
         jobData->jobIdInPool, setup, memoryPreference, debugName);
@@ -123,6 +171,7 @@ DescriptorSetView Job::allocateLocalDescriptorSet(
     ArrayParameter<const FutureDescriptor> descriptors,
     const char* debugName) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "allocateLocalDescriptorSet", debugName);
+    validateSubJobSupport(jobData, "Job-local descriptor sets");
     return jobData->resources.localDescriptorSets.prepareNewDescriptorSet(descriptorSetLayout, descriptors, debugName);
 }
 
@@ -130,6 +179,8 @@ AccelerationStructureView Job::allocateLocalAccelerationStructureKHR(
     const AccelerationStructureSetup& setup,
     const char* debugName) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "allocateLocalAccelerationStructureKHR", debugName);
+    validateReusableJobSupport(jobData, "Job-local acceleration structures");
+    validateSubJobSupport(jobData, "Job-local acceleration structures");
 
     DeviceContainer* deviceImpl = jobData->resourcePoolImpl->getParentDeviceImpl();
     AccelerationStructureBuilder* asBuilder = jobData->resourcePoolImpl->getAccelerationStructurePool()->acquireBuilder(
@@ -152,6 +203,7 @@ AccelerationStructureView Job::allocateLocalAccelerationStructureKHR(
 
 CommandPool* Job::createCommandPool(const char* debugName) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "createCommandPool", debugName);
+    validateSubJobSupport(jobData, "Command pools");
 
     DeviceContainer* deviceImpl = jobData->resourcePoolImpl->getParentDeviceImpl();
 
@@ -160,10 +212,54 @@ CommandPool* Job::createCommandPool(const char* debugName) {
 
     CommandPool* commandPool = deviceImpl->getCommandPoolPool()->acquirePool(baseQueueType, debugName);
     jobData->resources.commandPools.push_back(commandPool);
+    // The command lists of reusable jobs get executed by each of their submissions
+    if (jobData->flags.contains(JobFlag::Reusable))
+        commandPool->makeCommandBuffersReusable();
 
     return commandPool;
 }
 
+Job Job::createSubJob() {
+    TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "createSubJob", nullptr);
+    validateSubJobSupport(jobData, "Sub-jobs");
+
+    return jobData->resourcePoolImpl->acquireSubJob(jobData);
+}
+
+void Job::mergeSubJobs(ArrayView<Job> subJobs) {
+    TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "mergeSubJobs", nullptr);
+
+    for (Job& subJob : subJobs) {
+        if constexpr (TephraValidationEnabled) {
+            if (subJob.jobData == nullptr || subJob.jobData->parentJob != jobData) {
+                reportDebugMessage(
+                    DebugMessageSeverity::Error,
+                    DebugMessageType::Validation,
+                    "'subJobs' must only contain sub-jobs created from this job that haven't been merged yet.");
+                continue;
+            }
+        }
+
+        subJob.finalize();
+        JobRecordStorage& subJobRecord = subJob.jobData->record;
+
+        // Mark the usages of local resources now that their command indices within this job are known
+        uint64_t baseCommandIndex = jobData->record.nextCommandIndex;
+        for (const auto& [buffer, commandIndex] : subJobRecord.subJobBufferUsages) {
+            uint64_t usageNumber = commandIndex == ~0 ? commandIndex : baseCommandIndex + commandIndex;
+            jobData->resources.localBuffers.markBufferUsage(buffer, usageNumber);
+        }
+        for (const auto& [image, commandIndex] : subJobRecord.subJobImageUsages) {
+            uint64_t usageNumber = commandIndex == ~0 ? commandIndex : baseCommandIndex + commandIndex;
+            jobData->resources.localImages.markImageUsage(image, usageNumber);
+        }
+
+        jobData->record.appendSubJobCommands(subJobRecord);
+        jobData->subJobs.push_back(subJob.jobData);
+        subJob.jobData = nullptr;
+    }
+}
+
 void Job::cmdExportResource(const BufferView& buffer, ReadAccessMask readAccessMask, QueueType targetQueueType) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "cmdExportResource", nullptr);
 
@@ -255,11 +351,81 @@ void Job::cmdFillBuffer(const BufferView& dstBuffer, uint32_t value) {
     recordCommand<JobRecordStorage::FillBufferData>(jobData->record, JobCommandTypes::FillBuffer, dstBuffer, value);
 }
 
+// Writes the data of a buffer update to a preinitialized buffer and records a copy from it, adding the copy as another
+// region of the previous staged update if possible
+void recordStagedUpdate(JobData* jobData, const BufferView& dstBuffer, ArrayParameter<const std::byte> data) {
+    JobRecordStorage& record = jobData->record;
+    uint64_t dataSize = data.size();
+
+    if (record.updateStagingBuffer.isNull() ||
+        record.updateStagingOffset + dataSize > record.updateStagingBuffer.getSize()) {
+        auto stagingSetup = BufferSetup(tp::max(dataSize, UpdateStagingBufferSize), BufferUsage::HostMapped);
+        record.updateStagingBuffer = jobData->resourcePoolImpl->getPreinitializedBufferPool()->allocateJobBuffer(
+            jobData->jobIdInPool, stagingSetup, MemoryPreference::UploadStream, nullptr);
+        record.updateStagingOffset = 0;
+        record.lastStagedUpdateCommand = nullptr;
+    }
+
+    uint64_t srcOffset = record.updateStagingOffset;
+    record.updateStagingBuffer.getView(srcOffset, dataSize).mapForHostWrite().write(0, data.data(), dataSize);
+    // Keep the offset aligned so that the next update can view the staging buffer from there
+    record.updateStagingOffset = roundUpToMultiple(
+        srcOffset + dataSize, record.updateStagingBuffer.getRequiredViewAlignment());
+
+    uint64_t dstOffset;
+    BufferView wholeDstBuffer = BufferImpl::getWholeBufferView(dstBuffer, &dstOffset);
+    auto copyRegion = BufferCopyRegion(srcOffset, dstOffset, dataSize);
+
+    // Regions of a single copy must not overlap, so only updates that follow the previous one in the buffer can be
+    // added to its copy. No other command may have been recorded since then either
+    if (record.lastStagedUpdateCommand != nullptr && record.lastStagedUpdateCommand == record.lastCommandPtr &&
+        record.lastStagedUpdateDstBuffer == wholeDstBuffer) {
+        auto* copyData = getCommandData<JobRecordStorage::CopyBufferData>(record.lastStagedUpdateCommand);
+        std::size_t regionCount = copyData->copyRegions.size();
+        const BufferCopyRegion& lastRegion = copyData->copyRegions[regionCount - 1];
+
+        if (dstOffset >= lastRegion.dstOffset + lastRegion.size) {
+            BufferCopyRegion* regionsPtr = copyData->copyRegions.data();
+            if (regionCount == record.lastStagedUpdateRegionCapacity) {
+                record.lastStagedUpdateRegionCapacity *= 2;
+                auto newRegions = record.cmdBuffer.allocate<BufferCopyRegion>(record.lastStagedUpdateRegionCapacity);
+                std::copy(regionsPtr, regionsPtr + regionCount, newRegions.data());
+                regionsPtr = newRegions.data();
+            }
+            regionsPtr[regionCount] = copyRegion;
+            copyData->copyRegions = ArrayView<BufferCopyRegion>(regionsPtr, regionCount + 1);
+            // The accesses identified when recording the copy no longer cover all of its regions
+            record.lastStagedUpdateCommand->recordedAccesses = nullptr;
+            return;
+        }
+    }
+
+    static constexpr std::size_t InitialRegionCapacity = 4;
+    auto regions = record.cmdBuffer.allocate<BufferCopyRegion>(InitialRegionCapacity);
+    regions[0] = copyRegion;
+    recordCommand<JobRecordStorage::CopyBufferData>(
+        record,
+        JobCommandTypes::CopyBuffer,
+        record.updateStagingBuffer,
+        wholeDstBuffer,
+        ArrayView<BufferCopyRegion>(regions.data(), 1));
+
+    record.lastStagedUpdateCommand = record.lastCommandPtr;
+    record.lastStagedUpdateDstBuffer = wholeDstBuffer;
+    record.lastStagedUpdateRegionCapacity = InitialRegionCapacity;
+}
+
 void Job::cmdUpdateBuffer(const BufferView& dstBuffer, ArrayParameter<const std::byte> data) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "cmdUpdateBuffer", nullptr);
 
     markResourceUsage(jobData, dstBuffer);
 
+    // Sub-jobs can't allocate the preinitialized buffers needed for staging
+    if (data.size() > jobData->resourcePoolImpl->getStagedUpdateThreshold() && jobData->parentJob == nullptr) {
+        recordStagedUpdate(jobData, dstBuffer, data);
+        return;
+    }
+
     auto cmdBufData = jobData->record.cmdBuffer.allocate(data.size());
     memcpy(cmdBufData.data(), data.data(), data.size());
 
@@ -504,6 +670,7 @@ void Job::cmdEndDebugLabel() {
 
 void Job::cmdWriteTimestamp(const TimestampQuery& query, PipelineStage stage) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "cmdWriteTimestamp", nullptr);
+    validateReusableJobSupport(jobData, "Timestamp queries");
     recordCommand<JobRecordStorage::WriteTimestampData>(
         jobData->record, JobCommandTypes::WriteTimestamp, QueryRecorder::getQueryHandle(query), stage);
 }
@@ -634,6 +801,8 @@ inline AccelerationStructureBuildData prepareASBuild(
 
 void Job::cmdBuildAccelerationStructuresKHR(ArrayParameter<const AccelerationStructureBuildInfo> buildInfos) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "cmdBuildAccelerationStructuresKHR", nullptr);
+    validateReusableJobSupport(jobData, "Acceleration structure builds");
+    validateSubJobSupport(jobData, "Acceleration structure builds");
 
     if constexpr (TephraValidationEnabled) {
         for (std::size_t i = 0; i < buildInfos.size(); i++) {
@@ -687,6 +856,8 @@ void Job::cmdBuildAccelerationStructuresIndirectKHR(
     ArrayParameter<const AccelerationStructureBuildInfo> buildInfos,
     ArrayParameter<const AccelerationStructureBuildIndirectInfo> indirectInfos) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "cmdBuildAccelerationStructuresIndirectKHR", nullptr);
+    validateReusableJobSupport(jobData, "Acceleration structure builds");
+    validateSubJobSupport(jobData, "Acceleration structure builds");
 
     if constexpr (TephraValidationEnabled) {
         if (buildInfos.size() != indirectInfos.size()) {
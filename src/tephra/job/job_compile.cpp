@@ -2,8 +2,11 @@
 #include "job_compile.hpp"
 #include "job_data.hpp"
 #include "command_recording.hpp"
+#include "command_reordering.hpp"
 #include "accesses.hpp"
 #include "barriers.hpp"
+#include "../utils/thread_pool.hpp"
+#include <algorithm>
 #include <unordered_map>
 #include <deque>
 
@@ -16,28 +19,30 @@ public:
         : barriers(barriers), queueSyncState(queueSyncState), currentQueueFamilyIndex(currentQueueFamilyIndex) {}
 
     void addExport(JobRecordStorage::ExportBufferData& exportData) {
-        auto [vkBufferHandle, range] = resolveBufferAccess(exportData.buffer);
+        auto [vkBufferHandle, resourceId, range] = resolveBufferAccess(exportData.buffer);
 
         if (exportData.dstQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED &&
             exportData.dstQueueFamilyIndex != currentQueueFamilyIndex) {
             qfotBufferExports.emplace_back(
-                NewBufferAccess(vkBufferHandle, range, exportData.access), exportData.dstQueueFamilyIndex);
+                NewBufferAccess(vkBufferHandle, resourceId, range, exportData.access), exportData.dstQueueFamilyIndex);
         } else {
-            queuedBufferExports.emplace_back(vkBufferHandle, range, exportData.access);
+            queuedBufferExports.emplace_back(vkBufferHandle, resourceId, range, exportData.access);
         }
     }
 
     void addExport(JobRecordStorage::ExportImageData& exportData) {
         ImageAccessRange range = exportData.range;
-        VkImageHandle vkImageHandle = resolveImageAccess(exportData.image, &range);
+        uint32_t resourceId;
+        VkImageHandle vkImageHandle = resolveImageAccess(exportData.image, &range, &resourceId);
 
         if (exportData.dstQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED &&
             exportData.dstQueueFamilyIndex != currentQueueFamilyIndex) {
             qfotImageExports.emplace_back(
-                NewImageAccess(vkImageHandle, range, exportData.access, exportData.vkImageLayout),
+                NewImageAccess(vkImageHandle, resourceId, range, exportData.access, exportData.vkImageLayout),
                 exportData.dstQueueFamilyIndex);
         } else {
-            queuedImageExports.emplace_back(vkImageHandle, range, exportData.access, exportData.vkImageLayout);
+            queuedImageExports.emplace_back(
+                vkImageHandle, resourceId, range, exportData.access, exportData.vkImageLayout);
         }
     }
 
@@ -49,14 +54,11 @@ public:
                 return false;
             }
 
-            VkBufferHandle handle = access.vkResourceHandle;
-            auto mapHit = queueSyncState->bufferResourceMap.find(handle);
-            if (mapHit == queueSyncState->bufferResourceMap.end())
-                mapHit = queueSyncState->bufferResourceMap.emplace(handle, BufferAccessMap(handle)).first;
+            BufferAccessMap& accessMap = queueSyncState->getAccessMap(access.vkResourceHandle, access.resourceId);
 
             // The exports are treated like a special access
-            mapHit->second.synchronizeNewAccess(access, cmdIndex, *barriers);
-            mapHit->second.insertNewAccess(access, barriers->getBarrierCount(), false, true);
+            accessMap.synchronizeNewAccess(access, cmdIndex, *barriers);
+            accessMap.insertNewAccess(access, cmdIndex, barriers->getBarrierCount(), false, true);
             return true;
         };
 
@@ -66,14 +68,11 @@ public:
                 return false;
             }
 
-            VkImageHandle handle = access.vkResourceHandle;
-            auto mapHit = queueSyncState->imageResourceMap.find(handle);
-            if (mapHit == queueSyncState->imageResourceMap.end())
-                mapHit = queueSyncState->imageResourceMap.emplace(handle, ImageAccessMap(handle)).first;
+            ImageAccessMap& accessMap = queueSyncState->getAccessMap(access.vkResourceHandle, access.resourceId);
 
             // The exports are treated like a special access
-            mapHit->second.synchronizeNewAccess(access, cmdIndex, *barriers);
-            mapHit->second.insertNewAccess(access, barriers->getBarrierCount(), false, true);
+            accessMap.synchronizeNewAccess(access, cmdIndex, *barriers);
+            accessMap.insertNewAccess(access, cmdIndex, barriers->getBarrierCount(), false, true);
             return true;
         };
 
@@ -89,49 +88,44 @@ public:
         // Flush all remaining exports
         flushExports(~0, ~0);
 
-        // Split the cross-queue exports into two barriers. The first transitions the resources to a known state, while
-        // the second only does the queue family ownership transfer. This is a bit wasteful as sometimes we could have
-        // combined these barriers together, but for imports in the destination queue (which may have already happened)
-        // we need to know the exact range and layout of exported resources to insert a matching barrier.
+        // Where possible, synchronize the cross-queue exports with a single barrier that also releases the ownership
+        // of the resource. The acquire barrier in the destination queue (which may have already been recorded) must
+        // match it exactly, but it only knows the exported range and layout. That is always enough for buffers, but
+        // images that need a layout transition first get split into two barriers. The first transitions the range to
+        // the exported layout, while the second only does the queue family ownership transfer.
         for (const auto& [access, dstQueueFamilyIndex] : qfotBufferExports) {
-            VkBufferHandle handle = access.vkResourceHandle;
-            auto mapHit = queueSyncState->bufferResourceMap.find(access.vkResourceHandle);
-            if (mapHit == queueSyncState->bufferResourceMap.end())
-                mapHit = queueSyncState->bufferResourceMap.emplace(handle, BufferAccessMap(handle)).first;
+            BufferAccessMap& accessMap = queueSyncState->getAccessMap(access.vkResourceHandle, access.resourceId);
 
             // Use bottom of pipe access as it can be used in all queues
-            auto exportAccess = NewBufferAccess(access.vkResourceHandle, access.range, bottomOfPipeAccess);
-            mapHit->second.synchronizeNewAccess(exportAccess, ~0, *barriers);
-            mapHit->second.insertNewAccess(exportAccess, barriers->getBarrierCount());
+            auto exportAccess = NewBufferAccess(
+                access.vkResourceHandle, access.resourceId, access.range, bottomOfPipeAccess);
+            accessMap.synchronizeOwnershipRelease(
+                exportAccess, currentQueueFamilyIndex, dstQueueFamilyIndex, *barriers);
+            accessMap.insertNewAccess(exportAccess, ~0, barriers->getBarrierCount());
         }
 
-        for (const auto& [access, dstQueueFamilyIndex] : qfotImageExports) {
-            VkImageHandle handle = access.vkResourceHandle;
-            auto mapHit = queueSyncState->imageResourceMap.find(access.vkResourceHandle);
-            if (mapHit == queueSyncState->imageResourceMap.end())
-                mapHit = queueSyncState->imageResourceMap.emplace(handle, ImageAccessMap(handle)).first;
+        auto releaseImageExport = [this, &bottomOfPipeAccess](const std::pair<NewImageAccess, uint32_t>& qfotExport) {
+            const auto& [access, dstQueueFamilyIndex] = qfotExport;
+            ImageAccessMap& accessMap = queueSyncState->getAccessMap(access.vkResourceHandle, access.resourceId);
 
             // Use bottom of pipe access as it can be used in all queues
             auto exportAccess = NewImageAccess(
-                access.vkResourceHandle, access.range, bottomOfPipeAccess, access.layout);
-            mapHit->second.synchronizeNewAccess(exportAccess, ~0, *barriers);
+                access.vkResourceHandle, access.resourceId, access.range, bottomOfPipeAccess, access.layout);
+            bool isReleased = accessMap.synchronizeOwnershipRelease(
+                exportAccess, currentQueueFamilyIndex, dstQueueFamilyIndex, *barriers);
+            if (!isReleased)
+                accessMap.synchronizeNewAccess(exportAccess, ~0, *barriers);
+
             // The image can now only be accessed from this queue by discarding its contents, so set undefined layout
             exportAccess.layout = VK_IMAGE_LAYOUT_UNDEFINED;
-            mapHit->second.insertNewAccess(exportAccess, barriers->getBarrierCount());
-        }
+            accessMap.insertNewAccess(exportAccess, ~0, barriers->getBarrierCount());
+            return isReleased;
+        };
 
-        // Add pure QFOT release barriers
-        for (const auto& [access, dstQueueFamilyIndex] : qfotBufferExports) {
-            auto qfotDependency = BufferDependency(
-                access.vkResourceHandle,
-                access.range,
-                bottomOfPipeAccess,
-                bottomOfPipeAccess,
-                currentQueueFamilyIndex,
-                dstQueueFamilyIndex);
-            barriers->synchronizeDependency(qfotDependency, ~0, barriers->getBarrierCount(), false);
-        }
+        auto removeItImage = std::remove_if(qfotImageExports.begin(), qfotImageExports.end(), releaseImageExport);
+        qfotImageExports.erase(removeItImage, qfotImageExports.end());
 
+        // Add pure QFOT release barriers for the remaining image exports
         for (const auto& [access, dstQueueFamilyIndex] : qfotImageExports) {
             auto qfotDependency = ImageDependency(
                 access.vkResourceHandle,
@@ -142,7 +136,7 @@ public:
                 access.layout,
                 currentQueueFamilyIndex,
                 dstQueueFamilyIndex);
-            barriers->synchronizeDependency(qfotDependency, ~0, barriers->getBarrierCount(), false);
+            barriers->synchronizeDependency(qfotDependency, ~0, barriers->getBarrierCount(), false, ~0);
         }
 
         qfotBufferExports.clear();
@@ -151,7 +145,15 @@ public:
 
     void processIncomingExports(ArrayParameter<const CrossQueueSync::ExportEntry> incomingExports) {
         TEPHRA_ASSERT(barriers->getBarrierCount() == 0);
-        ResourceAccess topOfPipeAccess = { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0 };
+        // The QFOT acquire barriers wait on the same stages that the submit waits on the exporting queue at, so that
+        // they form a dependency chain with the semaphore wait. The exporting queue releases the exact exported range
+        // without any layout transition, either together with synchronizing its own accesses or in a separate barrier
+        // after them, so the acquire barriers match the release regardless of how it was done
+        auto getAcquireSrcAccess = [](const ResourceAccess& exportedAccess) {
+            if (exportedAccess.stageMask == 0)
+                return ResourceAccess(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+            return ResourceAccess(exportedAccess.stageMask, 0);
+        };
         uint32_t nextBarrierIndex = 1; // First barrier will be the QFOT acquire barrier
 
         for (auto& exportEntry : incomingExports) {
@@ -159,45 +161,39 @@ public:
 
             if (std::holds_alternative<NewBufferAccess>(exportEntry.access)) {
                 const NewBufferAccess& access = std::get<NewBufferAccess>(exportEntry.access);
-                VkBufferHandle handle = access.vkResourceHandle;
 
                 // Add the exported access
-                auto mapHit = queueSyncState->bufferResourceMap.find(handle);
-                if (mapHit == queueSyncState->bufferResourceMap.end())
-                    mapHit = queueSyncState->bufferResourceMap.emplace(handle, BufferAccessMap(handle)).first;
-                mapHit->second.insertNewAccess(access, nextBarrierIndex, true, true);
+                BufferAccessMap& accessMap = queueSyncState->getAccessMap(access.vkResourceHandle, access.resourceId);
+                accessMap.insertNewAccess(access, 0, nextBarrierIndex, true, true);
 
                 // Add the QFOT acquire barrier
                 auto qfotDependency = BufferDependency(
                     access.vkResourceHandle,
                     access.range,
-                    topOfPipeAccess,
+                    getAcquireSrcAccess(access),
                     access,
                     exportEntry.currentQueueFamilyIndex,
                     exportEntry.dstQueueFamilyIndex);
-                barriers->synchronizeDependency(qfotDependency, 0, 0, false);
+                barriers->synchronizeDependency(qfotDependency, 0, 0, false, 0);
 
             } else {
                 const NewImageAccess& access = std::get<NewImageAccess>(exportEntry.access);
-                VkImageHandle handle = access.vkResourceHandle;
 
                 // Add the exported access
-                auto mapHit = queueSyncState->imageResourceMap.find(handle);
-                if (mapHit == queueSyncState->imageResourceMap.end())
-                    mapHit = queueSyncState->imageResourceMap.emplace(handle, ImageAccessMap(handle)).first;
-                mapHit->second.insertNewAccess(access, nextBarrierIndex, true, true);
+                ImageAccessMap& accessMap = queueSyncState->getAccessMap(access.vkResourceHandle, access.resourceId);
+                accessMap.insertNewAccess(access, 0, nextBarrierIndex, true, true);
 
                 // Add the QFOT acquire barrier
                 auto qfotDependency = ImageDependency(
                     access.vkResourceHandle,
                     access.range,
-                    topOfPipeAccess,
+                    getAcquireSrcAccess(access),
                     access,
                     access.layout,
                     access.layout,
                     exportEntry.currentQueueFamilyIndex,
                     exportEntry.dstQueueFamilyIndex);
-                barriers->synchronizeDependency(qfotDependency, 0, 0, false);
+                barriers->synchronizeDependency(qfotDependency, 0, 0, false, 0);
             }
         }
     }
@@ -222,30 +218,39 @@ void processAccesses(
     ArrayView<const NewImageAccess> newImageAccesses,
     BarrierList& barriers,
     QueueSyncState* queueSyncState) {
+    // Look up the access maps only once. They are heap allocated, so the pointers stay valid when slots get added
+    ScratchVector<BufferAccessMap*> bufferAccessMaps;
+    bufferAccessMaps.reserve(newBufferAccesses.size());
+    ScratchVector<ImageAccessMap*> imageAccessMaps;
+    imageAccessMaps.reserve(newImageAccesses.size());
+
     // Update barriers pass
     for (const NewBufferAccess& newAccess : newBufferAccesses) {
-        VkBufferHandle handle = newAccess.vkResourceHandle;
-        auto mapHit = queueSyncState->bufferResourceMap.find(handle);
-        if (mapHit == queueSyncState->bufferResourceMap.end())
-            mapHit = queueSyncState->bufferResourceMap.emplace(handle, BufferAccessMap(handle)).first;
-        mapHit->second.synchronizeNewAccess(newAccess, cmdIndex, barriers);
+        BufferAccessMap& accessMap = queueSyncState->getAccessMap(newAccess.vkResourceHandle, newAccess.resourceId);
+        accessMap.synchronizeNewAccess(newAccess, cmdIndex, barriers);
+        bufferAccessMaps.push_back(&accessMap);
     }
     for (const NewImageAccess& newAccess : newImageAccesses) {
-        VkImageHandle handle = newAccess.vkResourceHandle;
-        auto mapHit = queueSyncState->imageResourceMap.find(handle);
-        if (mapHit == queueSyncState->imageResourceMap.end())
-            mapHit = queueSyncState->imageResourceMap.emplace(handle, ImageAccessMap(handle)).first;
-        mapHit->second.synchronizeNewAccess(newAccess, cmdIndex, barriers);
+        // A placed image's first layout transition must follow the previous accesses of the memory it aliases, which
+        // the access map of the memory block's buffer still holds until the update pass below
+        PastAccesses aliasedMemoryAccesses;
+        if (newAccess.memoryAliasAccessIndex != ~0) {
+            const NewBufferAccess& aliasAccess = newBufferAccesses[newAccess.memoryAliasAccessIndex];
+            aliasedMemoryAccesses = bufferAccessMaps[newAccess.memoryAliasAccessIndex]->getPastAccesses(
+                aliasAccess.range, barriers);
+        }
+
+        ImageAccessMap& accessMap = queueSyncState->getAccessMap(newAccess.vkResourceHandle, newAccess.resourceId);
+        accessMap.synchronizeNewAccess(newAccess, cmdIndex, barriers, &aliasedMemoryAccesses);
+        imageAccessMaps.push_back(&accessMap);
     }
 
     // Update accesses pass
-    for (const NewBufferAccess& newAccess : newBufferAccesses) {
-        auto mapHit = queueSyncState->bufferResourceMap.find(newAccess.vkResourceHandle);
-        mapHit->second.insertNewAccess(newAccess, barriers.getBarrierCount());
+    for (std::size_t i = 0; i < newBufferAccesses.size(); i++) {
+        bufferAccessMaps[i]->insertNewAccess(newBufferAccesses[i], cmdIndex + 1, barriers.getBarrierCount());
     }
-    for (const NewImageAccess& newAccess : newImageAccesses) {
-        auto mapHit = queueSyncState->imageResourceMap.find(newAccess.vkResourceHandle);
-        mapHit->second.insertNewAccess(newAccess, barriers.getBarrierCount());
+    for (std::size_t i = 0; i < newImageAccesses.size(); i++) {
+        imageAccessMaps[i]->insertNewAccess(newImageAccesses[i], cmdIndex + 1, barriers.getBarrierCount());
     }
 }
 
@@ -281,23 +286,28 @@ void prepareBarriers(
             // Discard image subresource range - mark the range with VK_IMAGE_LAYOUT_UNDEFINED layout
             auto* data = getCommandData<JobRecordStorage::DiscardImageContentsData>(cmd);
             ImageAccessRange range = data->range;
-            VkImageHandle vkImageHandle = resolveImageAccess(data->image, &range);
+            uint32_t resourceId;
+            VkImageHandle vkImageHandle = resolveImageAccess(data->image, &range, &resourceId);
 
-            auto mapHit = queueSyncState->imageResourceMap.find(vkImageHandle);
-            if (mapHit != queueSyncState->imageResourceMap.end()) {
-                mapHit->second.discardContents(range);
+            ImageAccessMap* accessMap = queueSyncState->findAccessMap(vkImageHandle, resourceId);
+            if (accessMap != nullptr) {
+                accessMap->discardContents(range);
             }
             break;
         }
         case JobCommandTypes::ImportExternalBuffer: {
             // Overwrite subresource range with the given access
             auto* data = getCommandData<JobRecordStorage::ImportExternalBufferData>(cmd);
-            auto [vkBufferHandle, range] = resolveBufferAccess(data->buffer);
-
-            auto mapHit = queueSyncState->bufferResourceMap.find(vkBufferHandle);
-            if (mapHit != queueSyncState->bufferResourceMap.end()) {
-                mapHit->second.insertNewAccess(
-                    { vkBufferHandle, range, data->access }, barriers.getBarrierCount(), true, true);
+            auto [vkBufferHandle, resourceId, range] = resolveBufferAccess(data->buffer);
+
+            BufferAccessMap* accessMap = queueSyncState->findAccessMap(vkBufferHandle, resourceId);
+            if (accessMap != nullptr) {
+                accessMap->insertNewAccess(
+                    { vkBufferHandle, resourceId, range, data->access },
+                    cmdIndex + 1,
+                    barriers.getBarrierCount(),
+                    true,
+                    true);
             }
             break;
         }
@@ -305,12 +315,17 @@ void prepareBarriers(
             // Overwrite subresource range with the given access
             auto* data = getCommandData<JobRecordStorage::ImportExternalImageData>(cmd);
             ImageAccessRange range = data->range;
-            VkImageHandle vkImageHandle = resolveImageAccess(data->image, &range);
-
-            auto mapHit = queueSyncState->imageResourceMap.find(vkImageHandle);
-            if (mapHit != queueSyncState->imageResourceMap.end()) {
-                mapHit->second.insertNewAccess(
-                    { vkImageHandle, range, data->access, data->vkImageLayout }, barriers.getBarrierCount(), true, true);
+            uint32_t resourceId;
+            VkImageHandle vkImageHandle = resolveImageAccess(data->image, &range, &resourceId);
+
+            ImageAccessMap* accessMap = queueSyncState->findAccessMap(vkImageHandle, resourceId);
+            if (accessMap != nullptr) {
+                accessMap->insertNewAccess(
+                    { vkImageHandle, resourceId, range, data->access, data->vkImageLayout },
+                    cmdIndex + 1,
+                    barriers.getBarrierCount(),
+                    true,
+                    true);
             }
             break;
         }
@@ -360,133 +375,539 @@ void prepareBarriers(
     resourceExportHandler.finishSubmit();
 }
 
+// Translates the barrier to a synchronization2 dependency info, keeping the stage masks of each dependency separate
+// instead of merging them into a single execution dependency
+struct BarrierDependencyInfo {
+    ScratchVector<VkMemoryBarrier2> memoryBarriers;
+    ScratchVector<VkBufferMemoryBarrier2> bufferBarriers;
+    ScratchVector<VkImageMemoryBarrier2> imageBarriers;
+    VkDependencyInfo vkDependencyInfo;
+
+    explicit BarrierDependencyInfo(const Barrier& barrier) {
+        memoryBarriers.reserve(barrier.executionDependencies.size() + 1);
+        bufferBarriers.reserve(barrier.bufferDependencies.size());
+        // Reserve slight excess for image barriers with disjoint mip levels
+        imageBarriers.reserve(barrier.imageDependencies.size() + (barrier.imageDependencies.size() >> 2));
+
+        // Execution-only dependencies have no resource to attach to, so they become global barriers with no accesses
+        for (const ExecutionDependency& dependency : barrier.executionDependencies) {
+            memoryBarriers.push_back(dependency.toMemoryBarrier2());
+        }
+
+        // Buffer dependencies folded together become a single global barrier with the union of their stages
+        if (!barrier.globalSrcAccess.isNull()) {
+            VkMemoryBarrier2& memoryBarrier = memoryBarriers.emplace_back();
+            memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+            memoryBarrier.pNext = nullptr;
+            memoryBarrier.srcStageMask = static_cast<VkPipelineStageFlags2>(barrier.globalSrcAccess.stageMask);
+            memoryBarrier.srcAccessMask = static_cast<VkAccessFlags2>(barrier.globalSrcAccess.accessMask);
+            memoryBarrier.dstStageMask = static_cast<VkPipelineStageFlags2>(barrier.globalDstAccess.stageMask);
+            memoryBarrier.dstAccessMask = static_cast<VkAccessFlags2>(barrier.globalDstAccess.accessMask);
+        }
+
+        for (const BufferDependency& dependency : barrier.bufferDependencies) {
+            bufferBarriers.push_back(dependency.toMemoryBarrier2());
+        }
+
+        for (const ImageDependency& dependency : barrier.imageDependencies) {
+            dependency.toImageBarriers2(imageBarriers);
+        }
+
+        vkDependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        vkDependencyInfo.pNext = nullptr;
+        vkDependencyInfo.dependencyFlags = 0;
+        vkDependencyInfo.memoryBarrierCount = static_cast<uint32_t>(memoryBarriers.size());
+        vkDependencyInfo.pMemoryBarriers = memoryBarriers.data();
+        vkDependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+        vkDependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+        vkDependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+        vkDependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+    }
+
+    TEPHRA_MAKE_NONCOPYABLE(BarrierDependencyInfo);
+    TEPHRA_MAKE_NONMOVABLE(BarrierDependencyInfo);
+};
+
+// Records the barrier with synchronization2. Split barriers only wait here for the event signaled after their source
+// commands
 void recordBarrier(PrimaryBufferRecorder& recorder, const Barrier& barrier) {
-    ScratchVector<VkBufferMemoryBarrier> bufferBarriers;
-    bufferBarriers.reserve(barrier.bufferDependencies.size());
-    ScratchVector<VkImageMemoryBarrier> imageBarriers;
-    // Reserve slight excess for image barriers with disjoint mip levels
-    imageBarriers.reserve(barrier.imageDependencies.size() + (barrier.imageDependencies.size() >> 2));
-
-    // Translate resource dependencies to memory barriers
-    for (const BufferDependency& dependency : barrier.bufferDependencies) {
-        bufferBarriers.push_back(dependency.toMemoryBarrier());
-    }
-
-    for (const ImageDependency& dependency : barrier.imageDependencies) {
-        dependency.toImageBarriers(imageBarriers);
-    }
-
-    recorder.getVkiCommands().cmdPipelineBarrier(
-        recorder.requestBuffer(),
-        barrier.srcStageMask,
-        barrier.dstStageMask,
-        0,
-        0,
-        nullptr,
-        static_cast<uint32_t>(bufferBarriers.size()),
-        bufferBarriers.data(),
-        static_cast<uint32_t>(imageBarriers.size()),
-        imageBarriers.data());
+    BarrierDependencyInfo dependencyInfo(barrier);
+
+    if (barrier.vkSplitEvent.isNull()) {
+        recorder.getVkiCommands().cmdPipelineBarrier2(recorder.requestBuffer(), &dependencyInfo.vkDependencyInfo);
+    } else {
+        VkEvent vkEvent = barrier.vkSplitEvent;
+        recorder.getVkiCommands().cmdWaitEvents2(
+            recorder.requestBuffer(), 1, &vkEvent, &dependencyInfo.vkDependencyInfo);
+    }
 }
 
-void recordCommandBuffers(
-    DeviceContainer* deviceImpl,
+// Records the first half of a split barrier. The dependency info must match the one used for the wait
+void recordSplitBarrierSignal(PrimaryBufferRecorder& recorder, const Barrier& barrier) {
+    TEPHRA_ASSERT(!barrier.vkSplitEvent.isNull());
+    BarrierDependencyInfo dependencyInfo(barrier);
+
+    recorder.getVkiCommands().cmdSetEvent2(
+        recorder.requestBuffer(), barrier.vkSplitEvent, &dependencyInfo.vkDependencyInfo);
+}
+
+// A contiguous range of commands of a job along with the barriers that precede them
+struct CommandSegment {
+    JobRecordStorage::CommandMetadata* firstCommand;
+    uint32_t firstCommandIndex;
+    uint32_t endCommandIndex;
+    uint32_t firstBarrierIndex;
+    uint32_t endBarrierIndex;
+};
+
+// Records the commands of the segment along with its barriers and the signals of split barriers whose source commands
+// belong to the segment. The split barrier indices are expected to be ordered by their source command indices.
+void recordCommandSegment(
     PrimaryBufferRecorder& recorder,
     const JobData* job,
-    const BarrierList& barriers) {
-    // Prepare query recording
-    recorder.getQueryRecorder().setJobSemaphore(job->semaphores.jobSignal);
+    const BarrierList& barriers,
+    ArrayView<const uint32_t> splitBarrierIndices,
+    const CommandSegment& segment) {
+    auto* cmd = segment.firstCommand;
+    uint32_t cmdIndex = segment.firstCommandIndex;
+    uint32_t barrierIndex = segment.firstBarrierIndex;
+
+    // Skip the signals that belong to previous segments
+    std::size_t splitIndex = 0;
+    while (splitIndex < splitBarrierIndices.size() &&
+           barriers.getBarrier(splitBarrierIndices[splitIndex]).srcCommandIndex < cmdIndex) {
+        splitIndex++;
+    }
 
-    auto* cmd = job->record.firstCommandPtr;
-    uint32_t cmdIndex = 0;
-    uint32_t barrierIndex = 0;
+    while (cmd != nullptr && cmdIndex < segment.endCommandIndex) {
+        // Signal the split barriers whose source commands have all been recorded
+        while (splitIndex < splitBarrierIndices.size() &&
+               barriers.getBarrier(splitBarrierIndices[splitIndex]).srcCommandIndex <= cmdIndex) {
+            recordSplitBarrierSignal(recorder, barriers.getBarrier(splitBarrierIndices[splitIndex]));
+            splitIndex++;
+        }
 
-    while (true) {
         // Record the next barriers
-        while (barrierIndex < barriers.getBarrierCount() &&
-               barriers.getBarrier(barrierIndex).commandIndex <= cmdIndex) {
+        while (barrierIndex < segment.endBarrierIndex && barriers.getBarrier(barrierIndex).commandIndex <= cmdIndex) {
             recordBarrier(recorder, barriers.getBarrier(barrierIndex));
             barrierIndex++;
         }
 
         // Record the next command
-        if (cmd != nullptr) {
-            recordCommand(job, recorder, cmd);
-            cmd = cmd->nextCommand;
-            cmdIndex++;
-        } else {
-            // End of job, record remaining barriers
-            for (; barrierIndex < barriers.getBarrierCount(); barrierIndex++) {
-                recordBarrier(recorder, barriers.getBarrier(barrierIndex));
-            }
+        recordCommand(job, recorder, cmd);
+        cmd = cmd->nextCommand;
+        cmdIndex++;
+    }
+
+    // End of segment, record remaining barriers
+    for (; barrierIndex < segment.endBarrierIndex; barrierIndex++) {
+        recordBarrier(recorder, barriers.getBarrier(barrierIndex));
+    }
+}
+
+// Cuts the commands of the job at barrier boundaries into at most maxSegmentCount segments of similar size
+void splitIntoCommandSegments(
+    const JobData* job,
+    const BarrierList& barriers,
+    uint32_t maxSegmentCount,
+    ScratchVector<CommandSegment>& segments) {
+    // Don't bother splitting off segments that are too small to offset the cost of an extra command buffer
+    constexpr uint32_t MinCommandsPerSegment = 8;
+
+    ScratchVector<JobRecordStorage::CommandMetadata*> commands;
+    for (auto* cmd = job->record.firstCommandPtr; cmd != nullptr; cmd = cmd->nextCommand) {
+        commands.push_back(cmd);
+    }
+    uint32_t commandCount = static_cast<uint32_t>(commands.size());
+    uint32_t commandsPerSegment = (commandCount + maxSegmentCount - 1) / maxSegmentCount;
+    commandsPerSegment = tp::max(commandsPerSegment, MinCommandsPerSegment);
+
+    // Barriers are ordered by the index of the command they precede, so each one is a potential cut point
+    uint32_t segmentStart = 0;
+    uint32_t segmentBarrierStart = 0;
+    for (uint32_t barrierIndex = 0; barrierIndex < barriers.getBarrierCount(); barrierIndex++) {
+        uint32_t cutIndex = barriers.getBarrier(barrierIndex).commandIndex;
+        if (cutIndex >= commandCount || segments.size() + 1 >= maxSegmentCount)
             break;
+
+        if (cutIndex - segmentStart >= commandsPerSegment) {
+            segments.push_back({ commands[segmentStart], segmentStart, cutIndex, segmentBarrierStart, barrierIndex });
+            segmentStart = cutIndex;
+            segmentBarrierStart = barrierIndex;
         }
     }
 
-    // Compile query batches from primary and secondary buffers and notify the manager about them
-    ScratchVector<QueryBatch*> queryBatches;
-    recorder.getQueryRecorder().retrieveBatchesAndReset(queryBatches);
-    for (CommandPool* secondaryPool : job->resources.commandPools) {
-        secondaryPool->getQueryRecorder().retrieveBatchesAndReset(queryBatches);
+    JobRecordStorage::CommandMetadata* firstCommand = segmentStart < commandCount ? commands[segmentStart] : nullptr;
+    segments.push_back({ firstCommand, segmentStart, ~0u, segmentBarrierStart, barriers.getBarrierCount() });
+}
+
+// Records each segment on the thread pool into separate primary command buffers from their own command pools, then
+// appends them to the recorder in order
+void recordCommandSegmentsInParallel(
+    DeviceContainer* deviceImpl,
+    ThreadPool* threadPool,
+    PrimaryBufferRecorder& recorder,
+    JobData* job,
+    const BarrierList& barriers,
+    ArrayView<const uint32_t> splitBarrierIndices,
+    ArrayView<const CommandSegment> segments) {
+    // The pools get released along with the rest of the job's resources, which also takes care of their queries
+    const QueueInfo& queueInfo = deviceImpl->getQueueMap()->getQueueInfos()[job->resourcePoolImpl->getBaseQueueIndex()];
+    std::size_t firstPoolIndex = job->resources.commandPools.size();
+    for (std::size_t i = 0; i < segments.size(); i++) {
+        CommandPool* commandPool = deviceImpl->getCommandPoolPool()->acquirePool(
+            queueInfo.identifier.type, queueInfo.name.c_str());
+        commandPool->getQueryRecorder().setJobSemaphore(job->semaphores.jobSignal);
+        if (job->flags.contains(JobFlag::Reusable))
+            commandPool->makeCommandBuffersReusable();
+        job->resources.commandPools.push_back(commandPool);
+    }
+
+    const VulkanCommandInterface* vkiCommands = &recorder.getVkiCommands();
+    std::vector<std::vector<VkCommandBufferHandle>> segmentCommandBuffers(segments.size());
+    threadPool->parallelFor(static_cast<uint32_t>(segments.size()), [&](uint32_t segmentIndex) {
+        ScratchVector<VkCommandBufferHandle> vkCommandBuffers;
+        PrimaryBufferRecorder segmentRecorder = PrimaryBufferRecorder(
+            job->resources.commandPools[firstPoolIndex + segmentIndex],
+            vkiCommands,
+            queueInfo.name.c_str(),
+            &vkCommandBuffers);
+
+        recordCommandSegment(segmentRecorder, job, barriers, splitBarrierIndices, segments[segmentIndex]);
+        segmentRecorder.endRecording();
+        segmentCommandBuffers[segmentIndex].assign(vkCommandBuffers.begin(), vkCommandBuffers.end());
+    });
+
+    for (const std::vector<VkCommandBufferHandle>& vkCommandBuffers : segmentCommandBuffers) {
+        for (VkCommandBufferHandle vkCommandBuffer : vkCommandBuffers) {
+            recorder.appendBuffer(vkCommandBuffer);
+        }
     }
-    deviceImpl->getQueryManager()->registerBatches(view(queryBatches), job->semaphores.jobSignal);
 }
 
-void compileJob(
-    JobCompilationContext& context,
-    const Job& job,
-    ArrayParameter<const CrossQueueSync::ExportEntry> incomingExports) {
-    const JobData* jobData = JobResourcePoolContainer::getJobData(job);
-    const char* jobName = JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName();
+void recordCommandBuffers(
+    DeviceContainer* deviceImpl,
+    PrimaryBufferRecorder& recorder,
+    JobData* job,
+    const BarrierList& barriers) {
+    // Prepare query recording
+    recorder.getQueryRecorder().setJobSemaphore(job->semaphores.jobSignal);
+
+    // The events of split barriers get signaled in the order of their source commands
+    ScratchVector<uint32_t> splitBarrierIndices;
+    for (uint32_t barrierIndex = 0; barrierIndex < barriers.getBarrierCount(); barrierIndex++) {
+        if (!barriers.getBarrier(barrierIndex).vkSplitEvent.isNull())
+            splitBarrierIndices.push_back(barrierIndex);
+    }
+    std::stable_sort(splitBarrierIndices.begin(), splitBarrierIndices.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return barriers.getBarrier(lhs).srcCommandIndex < barriers.getBarrier(rhs).srcCommandIndex;
+    });
+
+    // Split large jobs into segments that can be recorded in parallel if requested
+    ThreadPool* threadPool = deviceImpl->getRecordingThreadPool();
+    if (job->flags.contains(JobFlag::ParallelRecording) && threadPool != nullptr) {
+        // Allow a few segments per thread to balance out differences in recording costs
+        constexpr uint32_t SegmentsPerThread = 2;
+        uint32_t maxSegmentCount = (threadPool->getThreadCount() + 1) * SegmentsPerThread;
+
+        ScratchVector<CommandSegment> segments;
+        splitIntoCommandSegments(job, barriers, maxSegmentCount, segments);
+        if (segments.size() > 1) {
+            recordCommandSegmentsInParallel(
+                deviceImpl,
+                threadPool,
+                recorder,
+                job,
+                barriers,
+                view(splitBarrierIndices),
+                view(segments));
+            return;
+        }
+    }
+
+    CommandSegment wholeJob = { job->record.firstCommandPtr, 0, ~0u, 0, barriers.getBarrierCount() };
+    recordCommandSegment(recorder, job, barriers, view(splitBarrierIndices), wholeJob);
+}
+
+// Compiles the commands of a reusable job to command buffers that can be submitted repeatedly. The barriers between
+// them get prepared against the states the job itself leaves its resources in, found by analyzing the job twice on
+// an empty synchronization state.
+void compileReusableJob(JobData* job) {
+    DeviceContainer* deviceImpl = job->resourcePoolImpl->getParentDeviceImpl();
+    const QueueInfo& queueInfo = deviceImpl->getQueueMap()->getQueueInfos()[job->resourcePoolImpl->getBaseQueueIndex()];
+
+    QueueSyncState assumedSyncState;
+    BarrierList firstPassBarriers(1);
+    ResourceExportHandler firstPassExportHandler(&firstPassBarriers, &assumedSyncState, queueInfo.queueFamilyIndex);
+    prepareBarriers(job, &assumedSyncState, firstPassExportHandler, firstPassBarriers);
+
+    BarrierList barriers(2);
+    ResourceExportHandler resourceExportHandler(&barriers, &assumedSyncState, queueInfo.queueFamilyIndex);
+    prepareBarriers(job, &assumedSyncState, resourceExportHandler, barriers);
+
+    for (uint32_t resourceId = 0; resourceId < assumedSyncState.bufferResourceSlots.size(); resourceId++) {
+        if (assumedSyncState.bufferResourceSlots[resourceId] != nullptr)
+            assumedSyncState.bufferResourceSlots[resourceId]->getAccessStates(
+                resourceId, job->reusable.bufferExitStates);
+    }
+    for (uint32_t resourceId = 0; resourceId < assumedSyncState.imageResourceSlots.size(); resourceId++) {
+        if (assumedSyncState.imageResourceSlots[resourceId] != nullptr)
+            assumedSyncState.imageResourceSlots[resourceId]->getAccessStates(
+                resourceId, job->reusable.imageExitStates);
+    }
+
+    // Record to a command pool owned by the job, so that the command buffers live as long as the job does
+    CommandPool* commandPool = deviceImpl->getCommandPoolPool()->acquirePool(
+        queueInfo.identifier.type, queueInfo.name.c_str());
+    commandPool->makeCommandBuffersReusable();
+    job->resources.commandPools.push_back(commandPool);
+
+    barriers.mergeImageDependencies();
+    barriers.foldBufferDependencies(job->resourcePoolImpl->getGlobalBufferBarrierThreshold());
+
+    const auto& vkiCommands = deviceImpl->getCommandPoolPool()->getVkiCommands();
+    ScratchVector<VkCommandBufferHandle> vkCommandBuffers;
+    PrimaryBufferRecorder recorder = PrimaryBufferRecorder(
+        commandPool, &vkiCommands, queueInfo.name.c_str(), &vkCommandBuffers);
+    recordCommandBuffers(deviceImpl, recorder, job, barriers);
+    recorder.endRecording();
+
+    job->reusable.vkCommandBuffers.assign(vkCommandBuffers.begin(), vkCommandBuffers.end());
+    job->reusable.isCompiled = true;
+}
+
+// Prepares the barrier that brings the resources of a reusable job from their current states to the ones its compiled
+// commands assume, then updates the states to what the commands leave behind
+void prepareReusableJobBarriers(
+    QueueSyncState* queueSyncState,
+    JobData* job,
+    ArrayParameter<const CrossQueueSync::ExportEntry> incomingExports,
+    BarrierList& barriers) {
+    if (!job->reusable.isCompiled)
+        compileReusableJob(job);
+
+    auto queueInfos = job->resourcePoolImpl->getParentDeviceImpl()->getQueueMap()->getQueueInfos();
+    uint32_t currentQueueFamilyIndex = queueInfos[job->resourcePoolImpl->getBaseQueueIndex()].queueFamilyIndex;
+
+    // Incoming exports may concern any resource, so they need to be handled here all the same
+    ResourceExportHandler resourceExportHandler(&barriers, queueSyncState, currentQueueFamilyIndex);
+    resourceExportHandler.processIncomingExports(incomingExports);
+
+    // Only synchronize the resources whose states differ, usually none when the job gets submitted repeatedly
+    for (const BufferAccessState& state : job->reusable.bufferExitStates) {
+        BufferAccessMap& accessMap = queueSyncState->getAccessMap(state.vkResourceHandle, state.resourceId);
+        if (!accessMap.isInAccessState(state))
+            accessMap.synchronizeNewAccess(state.toNewAccess(), 0, barriers);
+    }
+    for (const ImageAccessState& state : job->reusable.imageExitStates) {
+        ImageAccessMap& accessMap = queueSyncState->getAccessMap(state.vkResourceHandle, state.resourceId);
+        if (!accessMap.isInAccessState(state))
+            accessMap.synchronizeNewAccess(state.toNewAccess(), 0, barriers);
+    }
+
+    for (const BufferAccessState& state : job->reusable.bufferExitStates) {
+        queueSyncState->getAccessMap(state.vkResourceHandle, state.resourceId)
+            .insertAccessState(state, barriers.getBarrierCount());
+    }
+    for (const ImageAccessState& state : job->reusable.imageExitStates) {
+        queueSyncState->getAccessMap(state.vkResourceHandle, state.resourceId)
+            .insertAccessState(state, barriers.getBarrierCount());
+    }
+}
+
+void prepareJobBarriers(
+    QueueSyncState* queueSyncState,
+    EventPool* splitBarrierEventPool,
+    Job& job,
+    ArrayParameter<const CrossQueueSync::ExportEntry> incomingExports,
+    BarrierList& barriers) {
+    JobData* jobData = JobResourcePoolContainer::getJobData(job);
+
+    // Reusable jobs only need their commands reordered once, before they get compiled
+    if (jobData->flags.contains(JobFlag::ReorderCommands) && !jobData->reusable.isCompiled) {
+        uint32_t barriersSaved = reorderJobCommands(jobData);
+
+        if constexpr (StatisticEventsEnabled) {
+            const char* jobName = JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName();
+            reportStatisticEvent(
+                jobData->resourcePoolImpl->getParentDeviceImpl()->getStatisticAggregator(),
+                StatisticEventType::JobPipelineBarriersSavedByReordering,
+                barriersSaved,
+                jobName);
+        }
+    }
+
+    if (jobData->flags.contains(JobFlag::Reusable)) {
+        prepareReusableJobBarriers(queueSyncState, jobData, incomingExports, barriers);
+        return;
+    }
 
     // Discard contents of local images
     for (const auto& localImage : jobData->resources.localImages.getImages()) {
         if (!localImage.hasUnderlyingImage())
             continue;
 
-        const Image* underlyingImage = localImage.getUnderlyingImage();
-        auto mapHit = context.queueSyncState->imageResourceMap.find(underlyingImage->vkGetImageHandle());
-        if (mapHit != context.queueSyncState->imageResourceMap.end()) {
-            mapHit->second.discardContents(underlyingImage->getWholeRange());
+        auto underlyingImage = static_cast<const ImageImpl*>(localImage.getUnderlyingImage());
+        ImageAccessMap* accessMap = queueSyncState->findAccessMap(
+            underlyingImage->vkGetImageHandle_(), underlyingImage->getResourceId());
+        if (accessMap != nullptr) {
+            accessMap->discardContents(underlyingImage->getWholeRange_());
         }
     }
 
-    TEPHRA_ASSERT(!jobData->semaphores.jobSignal.isNull());
-    BarrierList barriers(jobData->semaphores.jobSignal.timestamp);
-    {
+    // Incoming exports modify the sync state ahead of the job's own commands, so such jobs don't take part in caching
+    bool useBarrierPlanCache = jobData->flags.contains(JobFlag::CachedBarriers) && incomingExports.empty();
+    bool isCachedPlanApplied = useBarrierPlanCache &&
+        queueSyncState->barrierPlanCache.applyCachedPlan(jobData, queueSyncState, barriers);
+
+    if (!isCachedPlanApplied) {
         // Setup barriers and handle incoming exports
         auto queueInfos = jobData->resourcePoolImpl->getParentDeviceImpl()->getQueueMap()->getQueueInfos();
-        uint32_t currentQueueFamilyIndex = queueInfos[jobData->resourcePoolImpl->getBaseQueueIndex()].queueFamilyIndex;
+        uint32_t currentQueueFamilyIndex =
+            queueInfos[jobData->resourcePoolImpl->getBaseQueueIndex()].queueFamilyIndex;
 
-        ResourceExportHandler resourceExportHandler(&barriers, context.queueSyncState, currentQueueFamilyIndex);
+        ResourceExportHandler resourceExportHandler(&barriers, queueSyncState, currentQueueFamilyIndex);
         resourceExportHandler.processIncomingExports(incomingExports);
 
         // Insert barriers based on previous accesses and local accesses from commands within the job
-        prepareBarriers(jobData, context.queueSyncState, resourceExportHandler, barriers);
+        prepareBarriers(jobData, queueSyncState, resourceExportHandler, barriers);
+
+        if (useBarrierPlanCache)
+            queueSyncState->barrierPlanCache.storePlan(queueSyncState, barriers);
     }
 
-    // Record the vulkan command buffers, inserting the prepared barriers
-    std::size_t commandBuffersBefore = context.recorder->getCommandBufferCount();
-    recordCommandBuffers(context.deviceImpl, *context.recorder, jobData, barriers);
+    if constexpr (StatisticEventsEnabled) {
+        if (useBarrierPlanCache) {
+            const char* jobName = JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName();
+            DeviceContainer* deviceImpl = jobData->resourcePoolImpl->getParentDeviceImpl();
+            StatisticAggregator* aggregator = deviceImpl->getStatisticAggregator();
+            reportStatisticEvent(
+                aggregator,
+                StatisticEventType::JobBarrierCacheHits,
+                queueSyncState->barrierPlanCache.getHitCount(),
+                jobName);
+            reportStatisticEvent(
+                aggregator,
+                StatisticEventType::JobBarrierCacheMisses,
+                queueSyncState->barrierPlanCache.getMissCount(),
+                jobName);
+        }
+    }
 
+    // Cached plans hold the individual dependencies, so only merge and fold them after the plan has been stored
+    barriers.mergeImageDependencies();
+    uint32_t foldedCount = barriers.foldBufferDependencies(
+        jobData->resourcePoolImpl->getGlobalBufferBarrierThreshold());
     if constexpr (StatisticEventsEnabled) {
-        // Report statistics
+        const char* jobName = JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName();
         reportStatisticEvent(
-            StatisticEventType::JobPrimaryCommandBuffersUsed,
-            context.recorder->getCommandBufferCount() - commandBuffersBefore,
+            jobData->resourcePoolImpl->getParentDeviceImpl()->getStatisticAggregator(),
+            StatisticEventType::JobBufferMemoryBarriersFolded,
+            foldedCount,
             jobName);
-        reportStatisticEvent(StatisticEventType::JobPipelineBarriersInserted, barriers.getBarrierCount(), jobName);
+    }
+
+    // Split the barriers that have enough independent commands between their source accesses and the first dependent
+    // command, so that the tail of the source work can overlap with them
+    if (splitBarrierEventPool != nullptr) {
+        uint32_t minCommandDistance = tp::max(jobData->resourcePoolImpl->getSplitBarrierCommandDistance(), 1u);
+        for (uint32_t barrierIndex = 0; barrierIndex < barriers.getBarrierCount(); barrierIndex++) {
+            Barrier& barrier = barriers.getBarrier(barrierIndex);
+            if (barrier.isSplittable() && barrier.commandIndex - barrier.srcCommandIndex >= minCommandDistance)
+                barrier.vkSplitEvent = splitBarrierEventPool->acquireEvent(barriers.getJobId());
+        }
+    }
+}
+
+void recordJob(DeviceContainer* deviceImpl, PrimaryBufferRecorder& recorder, Job& job, const BarrierList& barriers) {
+    JobData* jobData = JobResourcePoolContainer::getJobData(job);
+    if (!jobData->flags.contains(JobFlag::Reusable)) {
+        recordCommandBuffers(deviceImpl, recorder, jobData, barriers);
+        return;
+    }
+
+    // Reusable jobs only need their fix-up barriers recorded before the precompiled commands
+    for (uint32_t barrierIndex = 0; barrierIndex < barriers.getBarrierCount(); barrierIndex++) {
+        recordBarrier(recorder, barriers.getBarrier(barrierIndex));
+    }
+    for (VkCommandBufferHandle vkCommandBuffer : jobData->reusable.vkCommandBuffers) {
+        recorder.appendBuffer(vkCommandBuffer);
+    }
+}
+
+void finalizeJob(
+    DeviceContainer* deviceImpl,
+    QueryRecorder& primaryQueryRecorder,
+    const Job& job,
+    const BarrierList& barriers,
+    std::size_t primaryBufferCount) {
+    const JobData* jobData = JobResourcePoolContainer::getJobData(job);
+
+    // Compile query batches from primary and secondary buffers and notify the manager about them
+    ScratchVector<QueryBatch*> queryBatches;
+    primaryQueryRecorder.retrieveBatchesAndReset(queryBatches);
+    for (CommandPool* secondaryPool : jobData->resources.commandPools) {
+        secondaryPool->getQueryRecorder().retrieveBatchesAndReset(queryBatches);
+    }
+    deviceImpl->getQueryManager()->registerBatches(view(queryBatches), jobData->semaphores.jobSignal);
+
+    if constexpr (StatisticEventsEnabled) {
+        // Report statistics
+        const char* jobName = JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName();
+        StatisticAggregator* aggregator = deviceImpl->getStatisticAggregator();
+        reportStatisticEvent(aggregator, StatisticEventType::JobPrimaryCommandBuffersUsed, primaryBufferCount, jobName);
+        reportStatisticEvent(
+            aggregator, StatisticEventType::JobPipelineBarriersInserted, barriers.getBarrierCount(), jobName);
 
         uint64_t bufferBarriers = 0;
         uint64_t imageBarriers = 0;
+        uint64_t splitBarriers = 0;
         for (uint32_t i = 0; i < barriers.getBarrierCount(); i++) {
             bufferBarriers += barriers.getBarrier(i).bufferDependencies.size();
             // In general, a single image dependency can result in multiple memory barriers, but let's simplify
             imageBarriers += barriers.getBarrier(i).imageDependencies.size();
+            if (!barriers.getBarrier(i).vkSplitEvent.isNull())
+                splitBarriers++;
         }
-        reportStatisticEvent(StatisticEventType::JobBufferMemoryBarriersInserted, bufferBarriers, jobName);
-        reportStatisticEvent(StatisticEventType::JobImageMemoryBarriersInserted, imageBarriers, jobName);
+        reportStatisticEvent(aggregator, StatisticEventType::JobBufferMemoryBarriersInserted, bufferBarriers, jobName);
+        reportStatisticEvent(aggregator, StatisticEventType::JobImageMemoryBarriersInserted, imageBarriers, jobName);
+        reportStatisticEvent(aggregator, StatisticEventType::JobPipelineBarriersSplit, splitBarriers, jobName);
+    }
+}
+
+void compileJob(
+    JobCompilationContext& context,
+    Job& job,
+    ArrayParameter<const CrossQueueSync::ExportEntry> incomingExports) {
+    const JobData* jobData = JobResourcePoolContainer::getJobData(job);
+    TEPHRA_ASSERT(!jobData->semaphores.jobSignal.isNull());
+
+    BarrierList barriers(jobData->semaphores.jobSignal.timestamp);
+    StatisticTimer barrierTimer;
+    prepareJobBarriers(context.queueSyncState, context.splitBarrierEventPool, job, incomingExports, barriers);
+    uint64_t barrierNanoseconds = barrierTimer.getElapsedNanoseconds();
+
+    // Record the vulkan command buffers, inserting the prepared barriers
+    std::size_t commandBuffersBefore = context.recorder->getCommandBufferCount();
+    StatisticTimer recordingTimer;
+    recordJob(context.deviceImpl, *context.recorder, job, barriers);
+    uint64_t recordingNanoseconds = recordingTimer.getElapsedNanoseconds();
+
+    if constexpr (StatisticEventsEnabled) {
+        const char* jobName = JobResourcePoolContainer::getJobDebugTarget(job)->getObjectName();
+        StatisticAggregator* aggregator = context.deviceImpl->getStatisticAggregator();
+        reportStatisticEvent(
+            aggregator, StatisticEventType::JobBarrierPreparationNanoseconds, barrierNanoseconds, jobName);
+        reportStatisticEvent(
+            aggregator, StatisticEventType::JobCommandRecordingNanoseconds, recordingNanoseconds, jobName);
     }
+
+    finalizeJob(
+        context.deviceImpl,
+        context.recorder->getQueryRecorder(),
+        job,
+        barriers,
+        context.recorder->getCommandBufferCount() - commandBuffersBefore);
 }
 
 }
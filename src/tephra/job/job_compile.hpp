@@ -1,7 +1,9 @@
 #pragma once
 
 #include "command_recording.hpp"
+#include "barriers.hpp"
 #include "../device/cross_queue_sync.hpp"
+#include "../device/event_pool.hpp"
 #include "../device/device_container.hpp"
 #include "../common_impl.hpp"
 
@@ -10,12 +12,41 @@ namespace tp {
 struct JobCompilationContext {
     DeviceContainer* deviceImpl;
     QueueSyncState* queueSyncState;
+    // The pool of events for split barriers, or nullptr if barriers shouldn't be split
+    EventPool* splitBarrierEventPool;
     PrimaryBufferRecorder* recorder;
 };
 
+// Job compilation is split into the following phases, so that the recording of multiple jobs can be parallelized
+
+// Analyzes the accesses of the job, updating the queue's synchronization state and preparing the barriers that need to
+// be inserted. Barriers get split with events from the given pool, if provided. Must be called for all jobs of a queue
+// sequentially in submission order. Reusable jobs get their commands compiled on the first call, after which only
+// the barrier preceding them gets prepared.
+void prepareJobBarriers(
+    QueueSyncState* queueSyncState,
+    EventPool* splitBarrierEventPool,
+    Job& job,
+    ArrayParameter<const CrossQueueSync::ExportEntry> incomingExports,
+    BarrierList& barriers);
+
+// Records the commands of the job along with the prepared barriers. Doesn't touch any state shared with other jobs, so
+// different jobs can be recorded concurrently, as long as they use different recorders. Jobs with
+// JobFlag::ParallelRecording may additionally get split into segments recorded on the device's recording threads.
+void recordJob(DeviceContainer* deviceImpl, PrimaryBufferRecorder& recorder, Job& job, const BarrierList& barriers);
+
+// Registers the queries used by the recorded job and reports its statistics. Must be called in submission order.
+void finalizeJob(
+    DeviceContainer* deviceImpl,
+    QueryRecorder& primaryQueryRecorder,
+    const Job& job,
+    const BarrierList& barriers,
+    std::size_t primaryBufferCount);
+
+// Performs all three phases of compilation of a single job
 void compileJob(
     JobCompilationContext& context,
-    const Job& job,
+    Job& job,
     ArrayParameter<const CrossQueueSync::ExportEntry> incomingExports);
 
 }
@@ -43,27 +43,64 @@ void JobRecordStorage::addDelayedCommand(JobRecordStorage::CommandMetadata* comm
     }
 }
 
+void JobRecordStorage::appendSubJobCommands(const JobRecordStorage& subJobRecord) {
+    if (subJobRecord.firstCommandPtr != nullptr) {
+        if (lastCommandPtr != nullptr) {
+            lastCommandPtr->nextCommand = subJobRecord.firstCommandPtr;
+        } else {
+            firstCommandPtr = subJobRecord.firstCommandPtr;
+        }
+        lastCommandPtr = subJobRecord.lastCommandPtr;
+    }
+    nextCommandIndex += subJobRecord.nextCommandIndex;
+}
+
 void JobRecordStorage::clear() {
     nextCommandIndex = 0;
+    identifiesAccesses = false;
     cmdBuffer.clear();
     firstCommandPtr = nullptr;
     lastCommandPtr = nullptr;
     firstDelayedCommandPtr = nullptr;
     lastDelayedCommandPtr = nullptr;
     debugStringStorage.clear();
+    subJobBufferUsages.clear();
+    subJobImageUsages.clear();
+    updateStagingBuffer = {};
+    updateStagingOffset = 0;
+    lastStagedUpdateCommand = nullptr;
+    lastStagedUpdateDstBuffer = {};
+    lastStagedUpdateRegionCapacity = 0;
 
     computePassCount = 0;
     renderPassCount = 0;
 }
 
 JobData::JobData(JobResourcePoolContainer* resourcePoolImpl)
-    : jobIdInPool(~0), resourcePoolImpl(resourcePoolImpl), resources(resourcePoolImpl) {}
+    : jobIdInPool(~0),
+      resourcePoolImpl(resourcePoolImpl),
+      handleCount(0),
+      resources(resourcePoolImpl),
+      parentJob(nullptr) {}
 
 void JobData::clear() {
     jobIdInPool = ~0;
     record.clear();
     resources.clear();
     semaphores.clear();
+    reusable.clear();
+    parentJob = nullptr;
+    // Merged sub-jobs must be released explicitly back to the pool as well
+    TEPHRA_ASSERT(subJobs.empty());
+}
+
+void ReusableJobStorage::clear() {
+    isAllocated = false;
+    isCompiled = false;
+    // The command buffers get freed along with the job's command pools
+    vkCommandBuffers.clear();
+    bufferExitStates.clear();
+    imageExitStates.clear();
 }
 
 void JobSemaphoreStorage::clear() {
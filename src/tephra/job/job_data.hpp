@@ -11,6 +11,7 @@
 #include "../utils/data_block_allocator.hpp"
 #include "../common_impl.hpp"
 #include <tephra/job.hpp>
+#include <atomic>
 
 namespace tp {
 
@@ -57,9 +58,35 @@ struct JobResourceStorage {
 };
 
 struct JobRecordStorage {
+    // An access of a command to a buffer view identified at record time. The view only gets resolved to the underlying
+    // buffer during compilation, because job-local buffers don't have one assigned until the job is enqueued
+    struct RecordedBufferAccess {
+        StoredBufferView* buffer;
+        // The accessed range, relative to the view
+        BufferAccessRange range;
+        ResourceAccess access;
+    };
+
+    // An access of a command to an image view identified at record time, see RecordedBufferAccess
+    struct RecordedImageAccess {
+        StoredImageView* image;
+        // The accessed range, relative to the view
+        ImageAccessRange range;
+        ResourceAccess access;
+        VkImageLayout layout;
+    };
+
+    struct RecordedAccesses {
+        ArrayView<RecordedBufferAccess> bufferAccesses;
+        ArrayView<RecordedImageAccess> imageAccesses;
+    };
+
     struct CommandMetadata {
         JobCommandTypes commandType;
         CommandMetadata* nextCommand;
+        // The resource accesses of the command identified at record time, see JobFlag::PrecomputedAccesses. Null if
+        // they need to be identified from the command data instead
+        const RecordedAccesses* recordedAccesses;
     };
 
     struct ExportBufferData {
@@ -273,10 +300,14 @@ struct JobRecordStorage {
 
     void addCommand(JobRecordStorage::CommandMetadata* commandPtr);
     void addDelayedCommand(JobRecordStorage::CommandMetadata* commandPtr);
+    // Appends the commands of a finalized sub-job, continuing its command indices from this one's
+    void appendSubJobCommands(const JobRecordStorage& subJobRecord);
 
     void clear();
 
     uint64_t nextCommandIndex = 0;
+    // Whether the resource accesses of commands get identified as they are recorded
+    bool identifiesAccesses = false;
     DataBlockAllocator<> cmdBuffer;
     CommandMetadata* firstCommandPtr = nullptr;
     CommandMetadata* lastCommandPtr = nullptr;
@@ -288,6 +319,20 @@ struct JobRecordStorage {
     std::size_t renderPassCount = 0;
     std::deque<RenderPass> renderPassStorage;
     std::deque<std::string> debugStringStorage;
+
+    // The usages of job-local resources recorded in a sub-job, along with the command index within the sub-job. They
+    // are marked in the parent job only once the sub-job gets merged into it
+    std::vector<std::pair<BufferView, uint64_t>> subJobBufferUsages;
+    std::vector<std::pair<ImageView, uint64_t>> subJobImageUsages;
+
+    // The preinitialized buffer that the data of large buffer updates currently gets staged in and its used size
+    BufferView updateStagingBuffer;
+    uint64_t updateStagingOffset = 0;
+    // The copy command of the last staged update along with the whole buffer it updates and the number of copy
+    // regions it has space for. Further updates of the same buffer can add their regions to it
+    CommandMetadata* lastStagedUpdateCommand = nullptr;
+    BufferView lastStagedUpdateDstBuffer;
+    std::size_t lastStagedUpdateRegionCapacity = 0;
 };
 
 struct JobSemaphoreStorage {
@@ -306,6 +351,22 @@ struct JobSemaphoreStorage {
     void clear();
 };
 
+// State of a job created with JobFlag::Reusable that persists between its submissions
+struct ReusableJobStorage {
+    // Set once the resources of the job have been allocated by its first enqueue
+    bool isAllocated = false;
+    // Set once the commands of the job have been compiled by its first submission
+    bool isCompiled = false;
+    // The primary command buffers the commands of the job were compiled to
+    std::vector<VkCommandBufferHandle> vkCommandBuffers;
+    // The states the compiled commands leave the job's resources in. The barriers within the compiled commands assume
+    // the resources to be in the same states when the job starts
+    std::vector<BufferAccessState> bufferExitStates;
+    std::vector<ImageAccessState> imageExitStates;
+
+    void clear();
+};
+
 class JobResourcePoolContainer;
 
 struct JobData {
@@ -317,9 +378,17 @@ struct JobData {
 
     uint64_t jobIdInPool;
     JobFlagMask flags;
+    // The number of Job handles referencing this data, more than one only for enqueued reusable jobs
+    std::atomic<uint32_t> handleCount;
     JobRecordStorage record;
     JobResourceStorage resources;
     JobSemaphoreStorage semaphores;
+    ReusableJobStorage reusable;
+    // The job that a sub-job was created from, null for regular jobs
+    JobData* parentJob;
+    // The sub-jobs merged into this job. Their recorded commands are linked into this job's command list, so they
+    // get released together with it
+    std::vector<JobData*> subJobs;
 };
 
 }
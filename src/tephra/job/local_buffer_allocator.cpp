@@ -10,7 +10,10 @@ JobLocalBufferAllocator::JobLocalBufferAllocator(
     DeviceContainer* deviceImpl,
     const OverallocationBehavior& overallocationBehavior,
     JobResourcePoolFlagMask poolFlags)
-    : deviceImpl(deviceImpl), overallocationBehavior(overallocationBehavior), poolFlags(poolFlags) {}
+    : deviceImpl(deviceImpl),
+      overallocationBehavior(overallocationBehavior),
+      poolFlags(poolFlags),
+      demandWindow(overallocationBehavior.demandWindowSize) {}
 
 void JobLocalBufferAllocator::allocateJobBuffers(
     JobLocalBuffers* bufferResources,
@@ -50,10 +53,14 @@ void JobLocalBufferAllocator::allocateJobBuffers(
         else
             bufferBytesCommitted = allocateJobBufferGroupNoAlias(view(assignInfos), currentTimestamp);
     }
+    demandWindow.record(bufferBytesCommitted);
 
     if constexpr (StatisticEventsEnabled) {
-        reportStatisticEvent(StatisticEventType::JobLocalBufferRequestedBytes, bufferBytesRequested, jobName);
-        reportStatisticEvent(StatisticEventType::JobLocalBufferCommittedBytes, bufferBytesCommitted, jobName);
+        StatisticAggregator* aggregator = deviceImpl->getStatisticAggregator();
+        reportStatisticEvent(
+            aggregator, StatisticEventType::JobLocalBufferRequestedBytes, bufferBytesRequested, jobName);
+        reportStatisticEvent(
+            aggregator, StatisticEventType::JobLocalBufferCommittedBytes, bufferBytesCommitted, jobName);
     }
 
     bufferResources->createPendingBufferViews();
@@ -123,9 +130,9 @@ uint64_t JobLocalBufferAllocator::allocateJobBufferGroup(
 
     AliasingSuballocator suballocator(view(backingBufferSizes));
 
-    // Sort buffers in descending order by their size for more efficient memory allocations
+    // Sort buffers in descending order by their size and usage length for more efficient memory allocations
     std::sort(buffersToAlloc.begin(), buffersToAlloc.end(), [](const AssignInfo& left, const AssignInfo& right) {
-        return left.size > right.size;
+        return AliasingSuballocator::isAllocatedBefore(left.size, left, right.size, right);
     });
 
     // Index and offset of leftover buffers that didn't fit
@@ -158,12 +165,14 @@ uint64_t JobLocalBufferAllocator::allocateJobBufferGroup(
     }
 
     // TODO: Handle out of memory exception, fallback to allocating a smaller buffer
-    uint64_t sizeToAlloc = overallocationBehavior.apply(leftoverSize, currentBackingGroupSize);
+    uint64_t peakDemand = tp::max(demandWindow.getPeakDemand(), leftoverSize);
+    uint64_t sizeToAlloc = overallocationBehavior.apply(leftoverSize, currentBackingGroupSize, peakDemand);
     std::pair<std::unique_ptr<Buffer>, uint64_t> newEntry = std::make_pair(
         allocateBackingBuffer(deviceImpl, sizeToAlloc, MemoryPreference::Device), currentTimestamp);
     Buffer* newBackingBuffer = newEntry.first.get();
     totalAllocationSize += newBackingBuffer->getSize();
     totalAllocationCount++;
+    lastAllocationSize = newBackingBuffer->getSize();
 
     // Insert the new backing buffer to the list so that the largest buffer appears first
     auto pos = std::find_if(backingBuffers.begin(), backingBuffers.end(), [sizeToAlloc](const auto& entry) {
@@ -208,6 +217,7 @@ uint64_t JobLocalBufferAllocator::allocateJobBufferGroupNoAlias(
 
             totalAllocationCount++;
             totalAllocationSize += backingBuffer->getSize();
+            lastAllocationSize = backingBuffer->getSize();
         }
 
         deviceImpl->getLogicalDevice()->setObjectDebugName(
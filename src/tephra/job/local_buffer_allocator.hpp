@@ -1,6 +1,7 @@
 #pragma once
 
 #include "local_buffers.hpp"
+#include "../utils/demand_window.hpp"
 #include "../common_impl.hpp"
 
 namespace tp {
@@ -28,6 +29,15 @@ public:
         return totalAllocationSize;
     }
 
+    // Returns the largest number of bytes committed by a single job within the demand window
+    uint64_t getPeakDemand() const {
+        return demandWindow.getPeakDemand();
+    }
+
+    uint64_t getLastAllocationSize() const {
+        return lastAllocationSize;
+    }
+
     // Helper function to allocate an internal backing buffer
     static std::unique_ptr<Buffer> allocateBackingBuffer(
         DeviceContainer* deviceImpl,
@@ -48,6 +58,8 @@ private:
     std::vector<std::pair<std::unique_ptr<Buffer>, uint64_t>> backingBuffers;
     uint64_t totalAllocationSize = 0;
     uint32_t totalAllocationCount = 0;
+    uint64_t lastAllocationSize = 0;
+    DemandWindow demandWindow;
 
     // Allocate requested buffers, returns the number of bytes used
     uint64_t allocateJobBufferGroup(ArrayView<AssignInfo> buffersToAlloc, uint64_t currentTimestamp);
@@ -106,18 +106,25 @@ public:
         return std::get<ResolvedView>(storedView).vkBufferHandle;
     }
 
+    uint32_t getResourceId() {
+        resolve();
+        return std::get<ResolvedView>(storedView).resourceId;
+    }
+
 private:
     struct ResolvedView {
         uint64_t size;
         uint64_t offset;
         DeviceAddress deviceAddress;
         VkBufferHandle vkBufferHandle;
+        uint32_t resourceId;
 
         explicit ResolvedView(const BufferView& view) {
             size = view.getSize();
             offset = 0;
             deviceAddress = view.getDeviceAddress();
             vkBufferHandle = view.vkResolveBufferHandle(&offset);
+            resourceId = !vkBufferHandle.isNull() ? BufferImpl::resolveResourceId(view) : ~0u;
         }
     };
 
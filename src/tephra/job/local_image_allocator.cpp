@@ -88,15 +88,45 @@ void JobLocalImageAllocator::allocateJobImages(
     JobLocalImages* imageResources,
     uint64_t currentTimestamp,
     const char* jobName) {
+    if (poolFlags.contains(JobResourcePoolFlag::AliasImageMemory) &&
+        !poolFlags.contains(JobResourcePoolFlag::DisableSuballocation)) {
+        allocateJobImagesPlaced(imageResources, currentTimestamp, jobName);
+        return;
+    }
+
+    ScratchVector<int> imageIndices;
+    imageIndices.reserve(imageResources->images.size());
+    for (int i = 0; i < imageResources->images.size(); i++) {
+        imageIndices.push_back(i);
+    }
+
     uint64_t imageBytesRequested = 0;
+    uint64_t imageBytesCommitted = allocateJobImageClasses(
+        imageResources, view(imageIndices), currentTimestamp, &imageBytesRequested);
+
+    if constexpr (StatisticEventsEnabled) {
+        StatisticAggregator* aggregator = deviceImpl->getStatisticAggregator();
+        reportStatisticEvent(aggregator, StatisticEventType::JobLocalImageRequestedBytes, imageBytesRequested, jobName);
+        reportStatisticEvent(aggregator, StatisticEventType::JobLocalImageCommittedBytes, imageBytesCommitted, jobName);
+    }
+
+    imageResources->createPendingImageViews();
+}
+
+uint64_t JobLocalImageAllocator::allocateJobImageClasses(
+    JobLocalImages* imageResources,
+    ArrayView<const int> imageIndices,
+    uint64_t currentTimestamp,
+    uint64_t* imageBytesRequested) {
     uint64_t imageBytesCommitted = 0;
 
     // Group requests by their image class by sorting
     ScratchVector<std::pair<ImageClass, int>> assignList;
-    for (int i = 0; i < imageResources->images.size(); i++) {
+    for (int imageIndex : imageIndices) {
         ImageClass imageClass = ImageClass(
-            imageResources->images[i].getImageSetup(), poolFlags.contains(JobResourcePoolFlag::AliasCompatibleFormats));
-        assignList.emplace_back(imageClass, i);
+            imageResources->images[imageIndex].getImageSetup(),
+            poolFlags.contains(JobResourcePoolFlag::AliasCompatibleFormats));
+        assignList.emplace_back(imageClass, imageIndex);
     }
     std::sort(assignList.begin(), assignList.end());
 
@@ -113,7 +143,7 @@ void JobLocalImageAllocator::allocateJobImages(
 
             if constexpr (StatisticEventsEnabled) {
                 const ImageSetup& setup = localImage.getImageSetup();
-                imageBytesRequested += deviceImpl->getMemoryAllocator()->getImageMemoryRequirements(setup).size;
+                *imageBytesRequested += deviceImpl->getMemoryAllocator()->getImageMemoryRequirements(setup).size;
             }
 
             const ResourceUsageRange& localUsage = imageResources->usageRanges[imageIndex]; 
@@ -156,12 +186,7 @@ void JobLocalImageAllocator::allocateJobImages(
         assignInfos.clear();
     }
 
-    if constexpr (StatisticEventsEnabled) {
-        reportStatisticEvent(StatisticEventType::JobLocalImageRequestedBytes, imageBytesRequested, jobName);
-        reportStatisticEvent(StatisticEventType::JobLocalImageCommittedBytes, imageBytesCommitted, jobName);
-    }
-
-    imageResources->createPendingImageViews();
+    return imageBytesCommitted;
 }
 
 void JobLocalImageAllocator::trim(uint64_t upToTimestamp) {
@@ -191,6 +216,190 @@ void JobLocalImageAllocator::trim(uint64_t upToTimestamp) {
             });
         backingImages.erase(removeIt, backingImages.end());
     }
+
+    for (auto& [memoryTypeIndex, memoryBlocks] : memoryBlockMap) {
+        auto removeIt = std::remove_if(
+            memoryBlocks.begin(),
+            memoryBlocks.end(),
+            [deviceImpl = this->deviceImpl,
+             &totalAllocationSize = this->totalAllocationSize,
+             &totalAllocationCount = this->totalAllocationCount,
+             upToTimestamp](const auto& el) {
+                const auto& [memoryBlock, lastUseTimestamp] = el;
+                bool trimmable = lastUseTimestamp <= upToTimestamp;
+
+                if (trimmable) {
+                    VmaAllocationHandle vmaAllocationHandle = memoryBlock->vmaGetMemoryAllocationHandle_();
+                    uint64_t memoryBlockSize =
+                        deviceImpl->getMemoryAllocator()->getAllocationInfo(vmaAllocationHandle).size;
+                    TEPHRA_ASSERT(totalAllocationSize >= memoryBlockSize);
+                    TEPHRA_ASSERT(totalAllocationCount >= 1);
+                    totalAllocationSize -= memoryBlockSize;
+                    totalAllocationCount--;
+                    // The images placed in the block may still exist, but we know that they aren't being used
+                    memoryBlock->destroyHandles(true);
+                }
+                return trimmable;
+            });
+        memoryBlocks.erase(removeIt, memoryBlocks.end());
+    }
+}
+
+void JobLocalImageAllocator::allocateJobImagesPlaced(
+    JobLocalImages* imageResources,
+    uint64_t currentTimestamp,
+    const char* jobName) {
+    MemoryAllocator* memoryAllocator = deviceImpl->getMemoryAllocator();
+    uint64_t imageBytesRequested = 0;
+    uint64_t imageBytesCommitted = 0;
+
+    // Create the used images up front without memory to find out their memory requirements
+    ScratchVector<PlaceInfo> placeInfos;
+    placeInfos.reserve(imageResources->images.size());
+    // Images whose memory can't be tracked through a buffer get allocated by their image class instead
+    ScratchVector<int> classImageIndices;
+    for (int i = 0; i < imageResources->images.size(); i++) {
+        JobLocalImageImpl& localImage = imageResources->images[i];
+        const ResourceUsageRange& localUsage = imageResources->usageRanges[i];
+        if (localUsage.isEmpty()) {
+            if constexpr (StatisticEventsEnabled) {
+                imageBytesRequested += memoryAllocator->getImageMemoryRequirements(localImage.getImageSetup()).size;
+            }
+            continue;
+        }
+
+        Lifeguard<VkImageHandle> imageHandle = memoryAllocator->createUnboundImage(localImage.getImageSetup());
+        VkMemoryRequirements memoryRequirements = memoryAllocator->getImageMemoryRequirements(
+            imageHandle.vkGetHandle());
+        uint32_t memoryTypeIndex = memoryAllocator->getImageMemoryTypeIndex(memoryRequirements);
+        if (!memoryAllocator->canTrackImageMemoryType(memoryTypeIndex)) {
+            classImageIndices.push_back(i);
+            continue;
+        }
+
+        PlaceInfo& placeInfo = placeInfos.emplace_back();
+        placeInfo.firstUsage = localUsage.firstUsage;
+        placeInfo.lastUsage = localUsage.lastUsage;
+        placeInfo.imageHandle = std::move(imageHandle);
+        placeInfo.memoryRequirements = memoryRequirements;
+        placeInfo.memoryTypeIndex = memoryTypeIndex;
+        placeInfo.resourcePtr = &localImage;
+        imageBytesRequested += placeInfo.memoryRequirements.size;
+    }
+
+    // Group the images by their memory type and sort them by size - wouldn't want a large image to have to be
+    // allocated fresh because a small one stole its original place
+    ScratchVector<PlaceInfo*> imagesToPlace;
+    imagesToPlace.reserve(placeInfos.size());
+    for (PlaceInfo& placeInfo : placeInfos) {
+        imagesToPlace.push_back(&placeInfo);
+    }
+    std::sort(imagesToPlace.begin(), imagesToPlace.end(), [](const PlaceInfo* left, const PlaceInfo* right) {
+        if (left->memoryTypeIndex != right->memoryTypeIndex)
+            return left->memoryTypeIndex < right->memoryTypeIndex;
+        return AliasingSuballocator::isAllocatedBefore(
+            left->memoryRequirements.size, *left, right->memoryRequirements.size, *right);
+    });
+
+    // Process each memory type individually
+    int i = 0;
+    while (i < imagesToPlace.size()) {
+        uint32_t memoryTypeIndex = imagesToPlace[i]->memoryTypeIndex;
+        int groupStart = i;
+        do {
+            i++;
+        } while (i < imagesToPlace.size() && imagesToPlace[i]->memoryTypeIndex == memoryTypeIndex);
+
+        imageBytesCommitted += allocateJobImageMemoryType(
+            memoryBlockMap[memoryTypeIndex],
+            viewRange(imagesToPlace, groupStart, i - groupStart),
+            memoryTypeIndex,
+            currentTimestamp,
+            imageResources->placedImages);
+    }
+
+    if (!classImageIndices.empty()) {
+        imageBytesCommitted += allocateJobImageClasses(
+            imageResources, view(classImageIndices), currentTimestamp, &imageBytesRequested);
+    }
+
+    if constexpr (StatisticEventsEnabled) {
+        StatisticAggregator* aggregator = deviceImpl->getStatisticAggregator();
+        reportStatisticEvent(aggregator, StatisticEventType::JobLocalImageRequestedBytes, imageBytesRequested, jobName);
+        reportStatisticEvent(aggregator, StatisticEventType::JobLocalImageCommittedBytes, imageBytesCommitted, jobName);
+    }
+
+    imageResources->createPendingImageViews();
+}
+
+uint64_t JobLocalImageAllocator::allocateJobImageMemoryType(
+    std::vector<MemoryBlock>& memoryBlocks,
+    ArrayView<PlaceInfo*> imagesToPlace,
+    uint32_t memoryTypeIndex,
+    uint64_t currentTimestamp,
+    std::vector<std::unique_ptr<ImageImpl>>& placedImages) {
+    // Suballocate the images from the memory blocks with aliasing
+    ScratchVector<uint64_t> memoryBlockSizes;
+    memoryBlockSizes.reserve(memoryBlocks.size());
+    for (const auto& [memoryBlock, lastUseTimestamp] : memoryBlocks) {
+        memoryBlockSizes.push_back(memoryBlock->getSize_());
+    }
+
+    AliasingSuballocator suballocator(view(memoryBlockSizes));
+
+    // Index and offset of the memory block assigned to each image
+    ScratchVector<std::pair<uint32_t, uint64_t>> placements;
+    placements.reserve(imagesToPlace.size());
+    uint64_t leftoverSize = 0;
+
+    for (const PlaceInfo* imageToPlace : imagesToPlace) {
+        const VkMemoryRequirements& memoryReq = imageToPlace->memoryRequirements;
+        auto [memoryBlockIndex, memoryBlockOffset] = suballocator.allocate(
+            memoryReq.size, ResourceUsageRange(*imageToPlace), memoryReq.alignment);
+        placements.emplace_back(memoryBlockIndex, memoryBlockOffset);
+
+        if (memoryBlockIndex >= memoryBlocks.size()) {
+            // It doesn't fit, remember the size so we can allocate a new memory block for it
+            leftoverSize = tp::max(leftoverSize, memoryBlockOffset + memoryReq.size);
+        }
+    }
+
+    if (leftoverSize > 0) {
+        // Some of the images still haven't been assigned. Create a new memory block to host them. It has to go last
+        // to preserve the block indices assigned by the suballocator.
+        memoryBlocks.emplace_back(allocateMemoryBlock(deviceImpl, leftoverSize, memoryTypeIndex), currentTimestamp);
+        VmaAllocationHandle vmaAllocationHandle = memoryBlocks.back().first->vmaGetMemoryAllocationHandle_();
+        totalAllocationCount++;
+        totalAllocationSize += deviceImpl->getMemoryAllocator()->getAllocationInfo(vmaAllocationHandle).size;
+    }
+
+    // Bind the images to their assigned memory and hand them over to the job
+    for (int i = 0; i < imagesToPlace.size(); i++) {
+        PlaceInfo* imageToPlace = imagesToPlace[i];
+        auto [memoryBlockIndex, memoryBlockOffset] = placements[i];
+        auto& [memoryBlock, lastUseTimestamp] = memoryBlocks[memoryBlockIndex];
+        lastUseTimestamp = currentTimestamp;
+
+        VkImageHandle vkImageHandle = imageToPlace->imageHandle.vkGetHandle();
+        deviceImpl->getMemoryAllocator()->bindImageMemory(
+            vkImageHandle, memoryBlock->vmaGetMemoryAllocationHandle_(), memoryBlockOffset);
+        deviceImpl->getLogicalDevice()->setObjectDebugName(
+            vkImageHandle, imageToPlace->resourcePtr->getDebugTarget()->getObjectName());
+
+        // The image doesn't own the memory, it gets freed along with the memory block
+        placedImages.push_back(std::make_unique<ImageImpl>(
+            deviceImpl,
+            imageToPlace->resourcePtr->getImageSetup(),
+            std::move(imageToPlace->imageHandle),
+            Lifeguard<VmaAllocationHandle>(),
+            DebugTarget::makeSilent()));
+
+        imageToPlace->resourcePtr->assignUnderlyingImage(placedImages.back().get(), 0);
+        imageToPlace->resourcePtr->assignMemoryAliasView(
+            memoryBlock->getDefaultView_().getView(memoryBlockOffset, imageToPlace->memoryRequirements.size));
+    }
+
+    return suballocator.getUsedSize();
 }
 
 uint64_t JobLocalImageAllocator::allocateJobImageClass(
@@ -209,7 +418,7 @@ uint64_t JobLocalImageAllocator::allocateJobImageClass(
     // Sort images by the number of array layers - wouldn't want a large array to have to be allocated fresh
     // because a single image stole its original allocation
     std::sort(imagesToAlloc.begin(), imagesToAlloc.end(), [](const AssignInfo& left, const AssignInfo& right) {
-        return left.arrayLayerCount > right.arrayLayerCount;
+        return AliasingSuballocator::isAllocatedBefore(left.arrayLayerCount, left, right.arrayLayerCount, right);
     });
 
     // Index and offset of leftover images that didn't fit
@@ -330,4 +539,19 @@ std::unique_ptr<ImageImpl> JobLocalImageAllocator::allocateBackingImage(
         std::move(allocationHandleLifeguard),
         DebugTarget::makeSilent());
 }
+
+std::unique_ptr<BufferImpl> JobLocalImageAllocator::allocateMemoryBlock(
+    DeviceContainer* deviceImpl,
+    uint64_t size,
+    uint32_t memoryTypeIndex) {
+    auto [bufferHandleLifeguard, allocationHandleLifeguard] =
+        deviceImpl->getMemoryAllocator()->allocateImageMemoryBlock(size, memoryTypeIndex);
+
+    return std::make_unique<BufferImpl>(
+        deviceImpl,
+        BufferSetup(size, BufferUsageMask::None()),
+        std::move(bufferHandleLifeguard),
+        std::move(allocationHandleLifeguard),
+        DebugTarget::makeSilent());
+}
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "local_images.hpp"
+#include "../buffer_impl.hpp"
 
 namespace tp {
 
@@ -71,12 +72,36 @@ private:
         uint32_t arrayLayerCount;
         JobLocalImageImpl* resourcePtr;
     };
+
+    // Block of device memory that images get placed into, represented by a buffer spanning the whole block, along
+    // with its last used timestamp
+    using MemoryBlock = std::pair<std::unique_ptr<BufferImpl>, uint64_t>;
+
+    // Memory blocks for each memory type index
+    using MemoryBlockMap = std::unordered_map<uint32_t, std::vector<MemoryBlock>>;
+
+    struct PlaceInfo : ResourceUsageRange {
+        Lifeguard<VkImageHandle> imageHandle;
+        VkMemoryRequirements memoryRequirements;
+        uint32_t memoryTypeIndex;
+        JobLocalImageImpl* resourcePtr;
+    };
+
     DeviceContainer* deviceImpl;
     JobResourcePoolFlagMask poolFlags;
     ImageClassMap backingImageMap;
+    MemoryBlockMap memoryBlockMap;
     uint64_t totalAllocationSize = 0;
     uint32_t totalAllocationCount = 0;
 
+    // Allocates the requested images with the given indices grouped by their image class, returns the committed size
+    // and accumulates the requested size
+    uint64_t allocateJobImageClasses(
+        JobLocalImages* imageResources,
+        ArrayView<const int> imageIndices,
+        uint64_t currentTimestamp,
+        uint64_t* imageBytesRequested);
+
     // Allocate requested images from the given backing group, returns the number of layers used
     uint64_t allocateJobImageClass(
         std::vector<BackingImage>& backingImages,
@@ -89,8 +114,26 @@ private:
         ScratchVector<AssignInfo>& imagesToAlloc,
         uint64_t currentTimestamp);
 
+    // Allocates requested images as individual images placed into shared memory blocks, aliasing them regardless
+    // of their image class. Images of memory types that can't be tracked get allocated by their class instead
+    void allocateJobImagesPlaced(JobLocalImages* imageResources, uint64_t currentTimestamp, const char* jobName);
+
+    // Places the requested images of the same memory type into the given memory blocks, returns the used size
+    uint64_t allocateJobImageMemoryType(
+        std::vector<MemoryBlock>& memoryBlocks,
+        ArrayView<PlaceInfo*> imagesToPlace,
+        uint32_t memoryTypeIndex,
+        uint64_t currentTimestamp,
+        std::vector<std::unique_ptr<ImageImpl>>& placedImages);
+
     // Helper function to allocate an internal backing image
     static std::unique_ptr<ImageImpl> allocateBackingImage(DeviceContainer* deviceImpl, const ImageSetup& setup);
+
+    // Helper function to allocate an internal memory block for placing images
+    static std::unique_ptr<BufferImpl> allocateMemoryBlock(
+        DeviceContainer* deviceImpl,
+        uint64_t size,
+        uint32_t memoryTypeIndex);
 };
 
 }
@@ -115,6 +115,7 @@ void JobLocalImages::clear() {
     images.clear();
     pendingImageViews.clear();
     usageRanges.clear();
+    placedImages.clear();
 }
 
 }
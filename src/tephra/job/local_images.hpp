@@ -35,6 +35,16 @@ public:
         underlyingImageLayerOffset = layerOffset;
     }
 
+    // Images placed into a shared memory block also record their accesses through a view of a buffer spanning that
+    // block, so that the accesses get synchronized with any other images aliasing the same memory
+    void assignMemoryAliasView(BufferView view) {
+        memoryAliasView = view;
+    }
+
+    const BufferView* getMemoryAliasView() const {
+        return memoryAliasView.isNull() ? nullptr : &memoryAliasView;
+    }
+
     bool hasUnderlyingImage() const {
         return underlyingImage != nullptr;
     }
@@ -73,6 +83,7 @@ private:
 
     Image* underlyingImage = nullptr;
     uint32_t underlyingImageLayerOffset = 0;
+    BufferView memoryAliasView;
     std::deque<ImageView>* jobPendingImageViews;
 };
 
@@ -126,18 +137,34 @@ public:
         return std::get<ResolvedView>(storedView).vkImageHandle;
     }
 
+    uint32_t getResourceId() {
+        resolve();
+        return std::get<ResolvedView>(storedView).resourceId;
+    }
+
+    const BufferView* getMemoryAliasView() {
+        resolve();
+        return std::get<ResolvedView>(storedView).memoryAliasView;
+    }
+
 private:
     struct ResolvedView {
         ImageSubresourceRange subresourceRange;
         Format format;
         VkImageHandle vkImageHandle;
         VkImageViewHandle vkImageViewHandle;
+        uint32_t resourceId;
+        const BufferView* memoryAliasView;
 
         explicit ResolvedView(const ImageView& view) {
             subresourceRange = view.getWholeRange();
             format = view.getFormat();
             vkImageHandle = view.vkResolveImageHandle(&subresourceRange.baseMipLevel, &subresourceRange.baseArrayLayer);
             vkImageViewHandle = view.vkGetImageViewHandle();
+            resourceId = !vkImageHandle.isNull() ? ImageImpl::resolveResourceId(view) : ~0u;
+            memoryAliasView = nullptr;
+            if (view.viewsJobLocalImage())
+                memoryAliasView = JobLocalImageImpl::getImageImpl(view).getMemoryAliasView();
         }
     };
 
@@ -187,6 +214,7 @@ private:
     std::deque<JobLocalImageImpl> images; // The local images implementing access through views
     std::deque<ImageView> pendingImageViews; // Image views that need vkImageViews assigned
     std::deque<ResourceUsageRange> usageRanges; // The usages of the local images within the job
+    std::vector<std::unique_ptr<ImageImpl>> placedImages; // Images placed into shared memory blocks for this job
 };
 
 }
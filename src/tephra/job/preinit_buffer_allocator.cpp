@@ -38,6 +38,7 @@ BufferView PreinitializedBufferAllocator::allocateJobBuffer(
         backingBufferGroups.emplace_back();
         BackingBufferGroup& backingGroup = backingBufferGroups.back();
         backingGroup.memoryPreference = memoryPreference;
+        backingGroup.demandWindow = DemandWindow(overallocationBehavior.demandWindowSize);
 
         // Create one ring buffer for each memory location, by order of progression
         int locationIndex = 0;
@@ -91,6 +92,9 @@ void PreinitializedBufferAllocator::finalizeJobAllocations(uint64_t jobId, const
     // The job has been enqueued and no more allocations will be made for it,
     // so we can reuse the ring buffers for other jobs.
     for (auto& group : backingBufferGroups) {
+        // The ring buffers only get popped once jobs finish, so this is the peak of what is in flight up to this job
+        group.demandWindow.record(getGroupAllocatedSize(group));
+
         if (group.recordingJobId == jobId) {
             group.recordingJobId = NoJobRecordingId;
 
@@ -102,7 +106,9 @@ void PreinitializedBufferAllocator::finalizeJobAllocations(uint64_t jobId, const
     }
 
     if constexpr (StatisticEventsEnabled) {
-        reportStatisticEvent(StatisticEventType::JobPreinitBufferRequestedBytes, bufferBytesRequested, jobName);
+        StatisticAggregator* aggregator = deviceImpl->getStatisticAggregator();
+        reportStatisticEvent(
+            aggregator, StatisticEventType::JobPreinitBufferRequestedBytes, bufferBytesRequested, jobName);
     }
 }
 
@@ -122,6 +128,14 @@ void PreinitializedBufferAllocator::freeJobAllocations(uint64_t jobId) {
     }
 }
 
+uint64_t PreinitializedBufferAllocator::getPeakDemand() const {
+    uint64_t peakDemand = 0;
+    for (const BackingBufferGroup& backingGroup : backingBufferGroups) {
+        peakDemand += backingGroup.demandWindow.getPeakDemand();
+    }
+    return peakDemand;
+}
+
 void PreinitializedBufferAllocator::trim() {
     for (BackingBufferGroup& backingGroup : backingBufferGroups) {
         // Don't free buffers for jobs that we're still recording
@@ -179,14 +193,18 @@ std::pair<BufferView, uint32_t> PreinitializedBufferAllocator::allocateBufferFro
         currentBackingGroupSize += ringBackingBuffer.getTotalSize();
     }
 
+    uint64_t peakDemand = tp::max(
+        backingGroup.demandWindow.getPeakDemand(), getGroupAllocatedSize(backingGroup) + bufferSetup.size);
+
     // TODO: Handle out of memory exception, fallback to allocating a smaller buffer
-    uint64_t sizeToAlloc = overallocationBehavior.apply(bufferSetup.size, currentBackingGroupSize);
+    uint64_t sizeToAlloc = overallocationBehavior.apply(bufferSetup.size, currentBackingGroupSize, peakDemand);
     uint64_t backingBufferIndex = backingGroup.backingBuffers.size();
     backingGroup.backingBuffers.push_back(
         JobLocalBufferAllocator::allocateBackingBuffer(deviceImpl, sizeToAlloc, backingGroup.memoryPreference));
     Buffer* backingBuffer = backingGroup.backingBuffers[backingBufferIndex].get();
     totalAllocationCount++;
     totalAllocationSize += backingBuffer->getSize();
+    lastAllocationSize = backingBuffer->getSize();
 
     // Find the memory location index in the memory preference progression and assign the new backing buffer for
     // this location
@@ -208,4 +226,12 @@ std::pair<BufferView, uint32_t> PreinitializedBufferAllocator::allocateBufferFro
 
     return std::make_pair(view, locationIndex);
 }
+
+uint64_t PreinitializedBufferAllocator::getGroupAllocatedSize(const BackingBufferGroup& backingGroup) {
+    uint64_t allocatedSize = 0;
+    for (const utils::GrowableRingBuffer& ringBuffer : backingGroup.ringBuffers) {
+        allocatedSize += ringBuffer.getAllocationSize();
+    }
+    return allocatedSize;
+}
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../utils/demand_window.hpp"
 #include "../common_impl.hpp"
 #include <tephra/utils/growable_ring_buffer.hpp>
 
@@ -39,6 +40,13 @@ public:
         return totalAllocationSize;
     }
 
+    // Returns the sum of the largest number of bytes in flight in each backing group within its demand window
+    uint64_t getPeakDemand() const;
+
+    uint64_t getLastAllocationSize() const {
+        return lastAllocationSize;
+    }
+
 private:
     // Specifies that no recording job is making use of that group
     static constexpr uint64_t NoJobRecordingId = ~0ull;
@@ -49,6 +57,7 @@ private:
         std::vector<utils::GrowableRingBuffer> ringBuffers;
         std::vector<std::unique_ptr<Buffer>> backingBuffers;
         uint64_t recordingJobRequestedBytes = 0;
+        DemandWindow demandWindow;
     };
 
     struct BufferAllocation {
@@ -63,6 +72,7 @@ private:
     std::vector<std::pair<uint64_t, std::vector<BufferAllocation>>> jobAllocationsList;
     uint64_t totalAllocationSize = 0;
     uint32_t totalAllocationCount = 0;
+    uint64_t lastAllocationSize = 0;
 
     // Satisfy a buffer allocation request from a specific backing group, returns also the index of the ring buffer
     // used
@@ -71,6 +81,9 @@ private:
         uint64_t jobId,
         const BufferSetup& bufferSetup,
         bool dontSuballocate);
+
+    // Returns the number of bytes currently allocated from the ring buffers of the group by all jobs in flight
+    static uint64_t getGroupAllocatedSize(const BackingBufferGroup& backingGroup);
 };
 
 }
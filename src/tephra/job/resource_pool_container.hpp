@@ -36,6 +36,18 @@ public:
         return deviceImpl;
     }
 
+    uint32_t getGlobalBufferBarrierThreshold() const {
+        return globalBufferBarrierThreshold;
+    }
+
+    uint64_t getStagedUpdateThreshold() const {
+        return stagedUpdateThreshold;
+    }
+
+    uint32_t getSplitBarrierCommandDistance() const {
+        return splitBarrierCommandDistance;
+    }
+
     PreinitializedBufferAllocator* getPreinitializedBufferPool() {
         return &preinitBufferPool;
     }
@@ -54,6 +66,13 @@ public:
 
     Job acquireJob(JobFlagMask flags, const char* jobName);
 
+    // Creates a sub-job of the given job that shares its flags, but records into its own storage
+    Job acquireSubJob(JobData* parentJobData);
+
+    // Creates another handle to the given job, used for enqueueing reusable jobs. The job only gets released once all
+    // of its handles are destroyed
+    static Job acquireJobReference(Job& job);
+
     static JobData* getJobData(Job& job) {
         return job.jobData;
     }
@@ -76,6 +95,15 @@ private:
     DeviceContainer* deviceImpl;
     uint32_t baseQueueIndex;
     uint64_t jobsAcquiredCount;
+    uint32_t globalBufferBarrierThreshold;
+    uint64_t stagedUpdateThreshold;
+    uint32_t splitBarrierCommandDistance;
+
+    JobResourcePoolTrimPolicy trimPolicy;
+    uint32_t trimPolicyHeapIndex;
+    // Timestamps of the most recently enqueued jobs, up to the unused job count of the trim policy
+    std::deque<uint64_t> recentJobTimestamps;
+    bool isHeapUsageTrimArmed;
 
     JobLocalBufferAllocator localBufferPool;
     JobLocalImageAllocator localImagePool;
@@ -90,6 +118,10 @@ private:
     std::deque<JobData*> jobReleaseQueue;
 
     void tryFreeSubmittedJobs();
+
+    // Trims the pool according to its trim policy after allocating the resources of the job with the given timestamp
+    // and reports the number of bytes freed
+    void applyTrimPolicy(uint64_t jobTimestamp, const char* jobName);
 };
 
 }
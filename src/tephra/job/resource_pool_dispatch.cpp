@@ -6,17 +6,37 @@ namespace tp {
 
 constexpr const char* JobTypeName = "Job";
 
+JobResourcePoolTrimPolicy::JobResourcePoolTrimPolicy(
+    uint32_t unusedJobCount,
+    float heapUsageHighWatermark,
+    float heapUsageLowWatermark)
+    : unusedJobCount(unusedJobCount),
+      heapUsageHighWatermark(heapUsageHighWatermark),
+      heapUsageLowWatermark(heapUsageLowWatermark) {}
+
+JobResourcePoolTrimPolicy JobResourcePoolTrimPolicy::Manual() {
+    return JobResourcePoolTrimPolicy(0, 0.0f, 0.0f);
+}
+
 JobResourcePoolSetup::JobResourcePoolSetup(
     DeviceQueue queue,
     JobResourcePoolFlagMask flags,
     OverallocationBehavior bufferOverallocationBehavior,
     OverallocationBehavior preinitBufferOverallocationBehavior,
-    OverallocationBehavior descriptorOverallocationBehavior)
+    OverallocationBehavior descriptorOverallocationBehavior,
+    uint32_t globalBufferBarrierThreshold,
+    uint64_t stagedUpdateThreshold,
+    JobResourcePoolTrimPolicy trimPolicy,
+    uint32_t splitBarrierCommandDistance)
     : queue(queue),
       flags(flags),
       bufferOverallocationBehavior(bufferOverallocationBehavior),
       preinitBufferOverallocationBehavior(preinitBufferOverallocationBehavior),
-      descriptorOverallocationBehavior(descriptorOverallocationBehavior) {}
+      descriptorOverallocationBehavior(descriptorOverallocationBehavior),
+      globalBufferBarrierThreshold(globalBufferBarrierThreshold),
+      stagedUpdateThreshold(stagedUpdateThreshold),
+      trimPolicy(trimPolicy),
+      splitBarrierCommandDistance(splitBarrierCommandDistance) {}
 
 Job JobResourcePool::createJob(JobFlagMask flags, const char* debugName) {
     auto poolImpl = static_cast<JobResourcePoolContainer*>(this);
@@ -47,6 +67,13 @@ JobResourcePoolContainer::JobResourcePoolContainer(
       deviceImpl(deviceImpl),
       baseQueueIndex(deviceImpl->getQueueMap()->getQueueUniqueIndex(setup.queue)),
       jobsAcquiredCount(0),
+      globalBufferBarrierThreshold(setup.globalBufferBarrierThreshold),
+      stagedUpdateThreshold(setup.stagedUpdateThreshold),
+      splitBarrierCommandDistance(setup.splitBarrierCommandDistance),
+      trimPolicy(setup.trimPolicy),
+      trimPolicyHeapIndex(
+          deviceImpl->getPhysicalDevice()->getMemoryLocationInfo(MemoryLocation::DeviceLocal).memoryHeapIndex),
+      isHeapUsageTrimArmed(true),
       localBufferPool(deviceImpl, setup.bufferOverallocationBehavior, setup.flags),
       localImagePool(deviceImpl, setup.flags),
       localAccelerationStructurePool(deviceImpl),
@@ -55,7 +82,20 @@ JobResourcePoolContainer::JobResourcePoolContainer(
           deviceImpl,
           DescriptorPoolSetup(setup.descriptorOverallocationBehavior),
           baseQueueIndex,
-          DebugTarget::makeSilent()) {}
+          DebugTarget::makeSilent()) {
+    if constexpr (TephraValidationEnabled) {
+        if (trimPolicy.heapUsageLowWatermark > trimPolicy.heapUsageHighWatermark) {
+            reportDebugMessage(
+                DebugMessageSeverity::Error,
+                DebugMessageType::Validation,
+                "'setup.trimPolicy.heapUsageLowWatermark' (",
+                trimPolicy.heapUsageLowWatermark,
+                ") is greater than 'setup.trimPolicy.heapUsageHighWatermark' (",
+                trimPolicy.heapUsageHighWatermark,
+                ").");
+        }
+    }
+}
 
 uint64_t JobResourcePoolContainer::trim_(const JobSemaphore& latestTrimmed) {
     uint64_t upToTimestamp = deviceImpl->getTimelineManager()->getLastReachedTimestamp(baseQueueIndex);
@@ -86,6 +126,10 @@ JobResourcePoolStatistics JobResourcePoolContainer::getStatistics_() const {
     stats.imageAllocationBytes = localImagePool.getTotalSize();
     stats.preinitBufferAllocationCount = preinitBufferPool.getAllocationCount();
     stats.preinitBufferAllocationBytes = preinitBufferPool.getTotalSize();
+    stats.bufferDemandBytes = localBufferPool.getPeakDemand();
+    stats.bufferLastAllocationBytes = localBufferPool.getLastAllocationSize();
+    stats.preinitBufferDemandBytes = preinitBufferPool.getPeakDemand();
+    stats.preinitBufferLastAllocationBytes = preinitBufferPool.getLastAllocationSize();
     // Acceleration structures don't need to be added here because their storage is already accounted for in buffers
     return stats;
 }
@@ -100,9 +144,34 @@ Job JobResourcePoolContainer::acquireJob(JobFlagMask flags, const char* jobName)
     }
     jobData->jobIdInPool = jobsAcquiredCount++;
     jobData->flags = flags;
+    jobData->handleCount = 1;
+    jobData->record.identifiesAccesses = flags.contains(JobFlag::PrecomputedAccesses);
 
     auto jobDebugTarget = DebugTarget(deviceImpl->getDebugTarget(), JobTypeName, jobName);
-    return Job(jobData, std::move(jobDebugTarget));
+    Job job = Job(jobData, std::move(jobDebugTarget));
+    if (job.debugTarget->getObjectName() != nullptr)
+        job.cmdBeginDebugLabel(job.debugTarget->getObjectName());
+    return job;
+}
+
+Job JobResourcePoolContainer::acquireSubJob(JobData* parentJobData) {
+    JobData* jobData = jobDataPool.acquireExisting();
+    if (jobData == nullptr) {
+        jobData = jobDataPool.acquireNew(this);
+    }
+    jobData->jobIdInPool = jobsAcquiredCount++;
+    jobData->flags = parentJobData->flags;
+    jobData->handleCount = 1;
+    jobData->record.identifiesAccesses = parentJobData->record.identifiesAccesses;
+    jobData->parentJob = parentJobData;
+
+    // Sub-jobs don't get their own debug label, the commands end up within the label of the parent job
+    return Job(jobData, DebugTarget(deviceImpl->getDebugTarget(), JobTypeName, nullptr));
+}
+
+Job JobResourcePoolContainer::acquireJobReference(Job& job) {
+    job.jobData->handleCount++;
+    return Job(job.jobData, *job.debugTarget.get());
 }
 
 void JobResourcePoolContainer::allocateJobResources(Job& job) {
@@ -114,6 +183,14 @@ void JobResourcePoolContainer::allocateJobResources(Job& job) {
     JobResourcePoolContainer* resourcePool = jobData->resourcePoolImpl;
     uint64_t jobTimestamp = jobData->semaphores.jobSignal.timestamp;
 
+    // Reusable jobs keep the resources allocated by their first enqueue, but each of their enqueues still counts
+    // towards the trim policy of the pool
+    if (jobData->reusable.isAllocated) {
+        resourcePool->applyTrimPolicy(jobTimestamp, jobName);
+        return;
+    }
+    jobData->reusable.isAllocated = jobData->flags.contains(JobFlag::Reusable);
+
     job.finalize();
     resourcePool->tryFreeSubmittedJobs();
     resourcePool->localBufferPool.allocateJobBuffers(&jobData->resources.localBuffers, jobTimestamp, jobName);
@@ -127,9 +204,20 @@ void JobResourcePoolContainer::allocateJobResources(Job& job) {
     for (std::size_t i = 0; i < jobData->record.renderPassCount; i++) {
         jobData->record.renderPassStorage[i].resolveAttachmentViews();
     }
+    for (JobData* subJobData : jobData->subJobs) {
+        for (std::size_t i = 0; i < subJobData->record.renderPassCount; i++) {
+            subJobData->record.renderPassStorage[i].resolveAttachmentViews();
+        }
+    }
+
+    resourcePool->applyTrimPolicy(jobTimestamp, jobName);
 }
 
 void JobResourcePoolContainer::queueReleaseJob(JobData* jobData) {
+    // Reusable jobs may have other handles enqueued
+    if (--jobData->handleCount > 0)
+        return;
+
     JobResourcePoolContainer* resourcePool = jobData->resourcePoolImpl;
     if (resourcePool == nullptr)
         return; // Orphaned job, nothing to do
@@ -154,6 +242,56 @@ JobResourcePoolContainer::~JobResourcePoolContainer() {
     }
 }
 
+void JobResourcePoolContainer::applyTrimPolicy(uint64_t jobTimestamp, const char* jobName) {
+    uint64_t trimmedBytes = 0;
+
+    if (trimPolicy.unusedJobCount > 0) {
+        recentJobTimestamps.push_back(jobTimestamp);
+        if (recentJobTimestamps.size() > trimPolicy.unusedJobCount) {
+            // Anything last used at or before the job that just left the window wasn't used by the last N jobs. The
+            // resources of the current job are never trimmed, since their timestamp can't have been reached yet
+            uint64_t upToTimestamp = tp::min(
+                recentJobTimestamps.front(),
+                deviceImpl->getTimelineManager()->getLastReachedTimestamp(baseQueueIndex));
+            recentJobTimestamps.pop_front();
+
+            uint64_t startSize = getStatistics_().getTotalAllocationBytes();
+            localBufferPool.trim(upToTimestamp);
+            localImagePool.trim(upToTimestamp);
+            localAccelerationStructurePool.trim(upToTimestamp);
+            // Preinitialized buffers can't be trimmed by time, they only get freed due to heap usage below
+            trimmedBytes += startSize - getStatistics_().getTotalAllocationBytes();
+        }
+    }
+
+    if (trimPolicy.heapUsageHighWatermark > 0.0f) {
+        VmaBudget budget = deviceImpl->getMemoryAllocator()->getMemoryHeapBudget(trimPolicyHeapIndex);
+        double usageBytes = static_cast<double>(budget.usage);
+        double budgetBytes = static_cast<double>(budget.budget);
+
+        if (isHeapUsageTrimArmed && usageBytes > trimPolicy.heapUsageHighWatermark * budgetBytes) {
+            uint64_t heapTrimmedBytes = trim_({});
+            trimmedBytes += heapTrimmedBytes;
+            // Don't trim again until the usage falls back under the low watermark, so that the pool doesn't keep
+            // reallocating its memory while the heap stays under pressure. Keep trying while there's nothing to free
+            if (heapTrimmedBytes > 0)
+                isHeapUsageTrimArmed = false;
+        } else if (!isHeapUsageTrimArmed && usageBytes < trimPolicy.heapUsageLowWatermark * budgetBytes) {
+            isHeapUsageTrimArmed = true;
+        }
+    }
+
+    if constexpr (StatisticEventsEnabled) {
+        if (trimmedBytes > 0) {
+            reportStatisticEvent(
+                deviceImpl->getStatisticAggregator(),
+                StatisticEventType::JobResourcePoolTrimmedBytes,
+                trimmedBytes,
+                jobName);
+        }
+    }
+}
+
 void JobResourcePoolContainer::tryFreeSubmittedJobs() {
     // Cannot use callbacks because the job resource pool can be destroyed by the user
     ScratchVector<JobData*> jobsToRelease;
@@ -184,6 +322,12 @@ void JobResourcePoolContainer::tryFreeSubmittedJobs() {
         }
         jobData->resources.commandPools.clear();
 
+        // Sub-jobs can't allocate resources, so they only need to be returned to the pool
+        for (JobData* subJobData : jobData->subJobs) {
+            jobDataPool.release(subJobData);
+        }
+        jobData->subJobs.clear();
+
         jobDataPool.release(jobData);
     }
 }
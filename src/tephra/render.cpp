@@ -22,7 +22,7 @@ void RenderList::beginRecording(CommandPool* commandPool) {
     VkCommandBufferBeginInfo beginInfo;
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.pNext = nullptr;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.flags = commandPool->getCommandBufferUsage() | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
     beginInfo.pInheritanceInfo = vkInheritanceInfo;
 
     throwRetcodeErrors(vkiCommands->beginCommandBuffer(vkCommandBufferHandle, &beginInfo));
@@ -179,12 +179,28 @@ void RenderList::cmdSetDepthBounds(float minDepthBounds, float maxDepthBounds) {
 
 void RenderList::cmdWriteTimestamp(const TimestampQuery& query, PipelineStage stage) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "cmdWriteTimestamp", nullptr);
+    if constexpr (TephraValidationEnabled) {
+        if (queryRecorder->isRecordingReusable()) {
+            reportDebugMessage(
+                DebugMessageSeverity::Error,
+                DebugMessageType::Validation,
+                "Timestamp queries cannot be used in command lists executed by a Job created with JobFlag::Reusable.");
+        }
+    }
     queryRecorder->sampleTimestampQuery(
         vkiCommands, vkCommandBufferHandle, QueryRecorder::getQueryHandle(query), stage, multiviewViewCount);
 }
 
 void RenderList::cmdBeginQueries(ArrayParameter<const RenderQuery* const> queries) {
     TEPHRA_DEBUG_SET_CONTEXT(debugTarget.get(), "cmdBeginQueries", nullptr);
+    if constexpr (TephraValidationEnabled) {
+        if (queryRecorder->isRecordingReusable()) {
+            reportDebugMessage(
+                DebugMessageSeverity::Error,
+                DebugMessageType::Validation,
+                "Render queries cannot be used in command lists executed by a Job created with JobFlag::Reusable.");
+        }
+    }
     queryRecorder->beginSampleRenderQueries(vkiCommands, vkCommandBufferHandle, queries, multiviewViewCount);
 }
 
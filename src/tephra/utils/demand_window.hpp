@@ -0,0 +1,35 @@
+#pragma once
+
+#include "math.hpp"
+#include <cstdint>
+#include <deque>
+
+namespace tp {
+
+// Keeps the demand of a pool observed during its most recent jobs, used for adaptive tp::OverallocationBehavior
+class DemandWindow {
+public:
+    explicit DemandWindow(uint32_t windowSize = 1) : windowSize(tp::max(windowSize, 1u)) {}
+
+    // Records the demand of a finished job, dropping the oldest one outside of the window
+    void record(uint64_t demand) {
+        samples.push_back(demand);
+        if (samples.size() > windowSize)
+            samples.pop_front();
+    }
+
+    // Returns the largest demand within the window
+    uint64_t getPeakDemand() const {
+        uint64_t peakDemand = 0;
+        for (uint64_t demand : samples) {
+            peakDemand = tp::max(peakDemand, demand);
+        }
+        return peakDemand;
+    }
+
+private:
+    uint32_t windowSize;
+    std::deque<uint64_t> samples;
+};
+
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "small_vector.hpp"
+#include <utility>
+
+namespace tp {
+
+// Maps non-overlapping intervals to values, stored sorted in a flat array for fast lookups and iteration. Adjacent
+// intervals mapped to equal values get merged together to keep the number of entries low.
+// TRange must provide getStartPoint() and getEndPoint() methods and a TRange(start, size) constructor.
+// TValue must be trivially copyable and equality comparable.
+template <typename TRange, typename TValue, std::size_t InlineCapacity = 4>
+class FlatIntervalMap {
+public:
+    struct Entry {
+        TRange range;
+        TValue value;
+
+        Entry(TRange range, TValue value) : range(std::move(range)), value(std::move(value)) {}
+    };
+
+    using iterator = Entry*;
+    using const_iterator = const Entry*;
+
+    std::size_t size() const {
+        return entries.size();
+    }
+
+    bool empty() const {
+        return entries.empty();
+    }
+
+    iterator begin() {
+        return entries.begin();
+    }
+
+    iterator end() {
+        return entries.end();
+    }
+
+    const_iterator begin() const {
+        return entries.begin();
+    }
+
+    const_iterator end() const {
+        return entries.end();
+    }
+
+    // Returns the iterator range of all entries overlapping the given range
+    std::pair<iterator, iterator> findOverlapping(const TRange& range) {
+        iterator first = findFirstEndingAfter(range.getStartPoint());
+        iterator last = first;
+        while (last != end() && last->range.getStartPoint() < range.getEndPoint()) {
+            ++last;
+        }
+        return { first, last };
+    }
+
+    // Maps the given range to the value, trimming or splitting the entries it overlaps. Returns the inserted entry,
+    // which may have been merged with its neighbors.
+    iterator assign(const TRange& range, const TValue& value) {
+        auto [first, last] = findOverlapping(range);
+        std::size_t firstIndex = first - begin();
+        std::size_t lastIndex = last - begin();
+
+        // Build the replacement for the overlapped entries, keeping the parts that lie outside of the range
+        Entry replacement[3] = { Entry(range, value), Entry(range, value), Entry(range, value) };
+        std::size_t replacementOffset = 1;
+        std::size_t replacementCount = 1;
+        if (first != last && first->range.getStartPoint() < range.getStartPoint()) {
+            uint64_t startPoint = first->range.getStartPoint();
+            replacement[0] = Entry(makeRange(startPoint, range.getStartPoint()), first->value);
+            replacementOffset = 0;
+            replacementCount++;
+        }
+        if (first != last && (last - 1)->range.getEndPoint() > range.getEndPoint()) {
+            uint64_t endPoint = (last - 1)->range.getEndPoint();
+            replacement[2] = Entry(makeRange(range.getEndPoint(), endPoint), (last - 1)->value);
+            replacementCount++;
+        }
+        TEPHRA_ASSERT(replacementOffset + replacementCount <= 3);
+
+        entries.replace(
+            firstIndex,
+            lastIndex,
+            replacement + replacementOffset,
+            replacement + replacementOffset + replacementCount);
+
+        // Merge the new entry with its neighbors
+        std::size_t newIndex = firstIndex + (1 - replacementOffset);
+        std::size_t mergeFirst = newIndex > 0 ? newIndex - 1 : 0;
+        std::size_t mergeLast = tp::min(newIndex + 2, entries.size());
+        return begin() + coalesce(mergeFirst, mergeLast, newIndex);
+    }
+
+    // Merges adjacent entries with equal values within the index range [firstIndex, lastIndex). Returns the new index
+    // of the entry that was at trackedIndex.
+    std::size_t coalesce(std::size_t firstIndex, std::size_t lastIndex, std::size_t trackedIndex = 0) {
+        if (lastIndex - firstIndex < 2)
+            return trackedIndex;
+
+        std::size_t writeIndex = firstIndex;
+        for (std::size_t readIndex = firstIndex + 1; readIndex < lastIndex; readIndex++) {
+            Entry& writeEntry = entries[writeIndex];
+            const Entry& readEntry = entries[readIndex];
+            if (writeEntry.range.getEndPoint() == readEntry.range.getStartPoint() &&
+                writeEntry.value == readEntry.value) {
+                writeEntry.range = makeRange(writeEntry.range.getStartPoint(), readEntry.range.getEndPoint());
+            } else {
+                entries[++writeIndex] = readEntry;
+            }
+
+            if (readIndex == trackedIndex)
+                trackedIndex = writeIndex;
+        }
+
+        entries.erase(writeIndex + 1, lastIndex);
+        return trackedIndex;
+    }
+
+    // Merges all adjacent entries with equal values
+    void coalesce() {
+        coalesce(0, entries.size());
+    }
+
+    void clear() {
+        entries.clear();
+        entries.shrinkToFit();
+    }
+
+private:
+    SmallVector<Entry, InlineCapacity> entries;
+
+    static TRange makeRange(uint64_t startPoint, uint64_t endPoint) {
+        return TRange(startPoint, endPoint - startPoint);
+    }
+
+    // Binary search for the first entry that ends past the given point
+    iterator findFirstEndingAfter(uint64_t point) {
+        iterator first = begin();
+        std::size_t count = entries.size();
+        while (count > 0) {
+            std::size_t step = count / 2;
+            iterator it = first + step;
+            if (it->range.getEndPoint() <= point) {
+                first = it + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        return first;
+    }
+};
+
+}
@@ -235,7 +235,9 @@ namespace utils {
         tp::BufferView newBuffer = growableBuffer.push(allocationSize);
         if (newBuffer.isNull()) {
             // TODO: Handle out of memory exception, fallback to allocating a smaller buffer
-            uint64_t sizeToAlloc = overallocationBehavior.apply(allocationSize, growableBuffer.getTotalSize());
+            uint64_t peakDemand = tp::max(getPeakDemand(), getAllocatedSize() + allocationSize);
+            uint64_t sizeToAlloc = overallocationBehavior.apply(
+                allocationSize, growableBuffer.getTotalSize(), peakDemand);
 
             std::string regionDebugName;
             if (!debugName.empty()) {
@@ -257,6 +259,11 @@ namespace utils {
     }
 
     void AutoRingBuffer::pop(uint64_t upToTimestamp) {
+        // Nothing gets freed between pops, so the current allocated size is the peak since the last one
+        demandSamples.push_back(getAllocatedSize());
+        if (demandSamples.size() > tp::max(overallocationBehavior.demandWindowSize, 1u))
+            demandSamples.pop_front();
+
         while (!allocationTimestamps.empty()) {
             if (allocationTimestamps.front() <= upToTimestamp) {
                 growableBuffer.pop();
@@ -267,6 +274,14 @@ namespace utils {
         }
     }
 
+    uint64_t AutoRingBuffer::getPeakDemand() const {
+        uint64_t peakDemand = 0;
+        for (uint64_t demand : demandSamples) {
+            peakDemand = tp::max(peakDemand, demand);
+        }
+        return peakDemand;
+    }
+
     uint64_t AutoRingBuffer::trim() {
         uint64_t startSize = getTotalSize();
 
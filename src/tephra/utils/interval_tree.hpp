@@ -0,0 +1,170 @@
+#pragma once
+
+#include "math.hpp"
+#include <utility>
+#include <vector>
+
+namespace tp {
+
+// Index of possibly overlapping intervals, each identified by a small integer id and tagged with a bit mask. Supports
+// finding all intervals overlapping a query interval that also share a bit with the query mask in O(log n + k).
+// Implemented as a treap keyed by interval start, where each node tracks the maximum end point and the union of masks
+// within its subtree, so that non-overlapping subtrees can be skipped.
+template <typename TPoint, typename TMask = uint32_t>
+class IntervalTree {
+public:
+    static constexpr uint32_t InvalidId = ~0u;
+
+    bool contains(uint32_t id) const {
+        return id < nodes.size() && nodes[id].isInserted;
+    }
+
+    // Inserts the interval [start, end) with the given id, which must not be present already
+    void insert(uint32_t id, TPoint start, TPoint end, TMask mask) {
+        TEPHRA_ASSERT(start < end);
+        if (id >= nodes.size())
+            nodes.resize(id + 1);
+        TEPHRA_ASSERT(!nodes[id].isInserted);
+
+        Node& node = nodes[id];
+        node.start = start;
+        node.end = end;
+        node.mask = mask;
+        node.priority = hashId(id);
+        node.left = InvalidId;
+        node.right = InvalidId;
+        node.isInserted = true;
+        updateNode(id);
+
+        auto [leftRoot, rightRoot] = split(root, start, id);
+        root = merge(merge(leftRoot, id), rightRoot);
+    }
+
+    // Removes the interval with the given id, if present
+    void erase(uint32_t id) {
+        if (!contains(id))
+            return;
+
+        const Node& node = nodes[id];
+        auto [leftRoot, rest] = split(root, node.start, id);
+        auto [erased, rightRoot] = split(rest, node.start, id + 1);
+        TEPHRA_ASSERT(erased == id);
+        root = merge(leftRoot, rightRoot);
+        nodes[id].isInserted = false;
+    }
+
+    // Appends the ids of all intervals that overlap [start, end) and share a bit with the mask, in no particular order
+    template <typename TContainer>
+    void findOverlapping(TPoint start, TPoint end, TMask mask, TContainer& ids) const {
+        findOverlapping(root, start, end, mask, ids);
+    }
+
+    void clear() {
+        nodes.clear();
+        root = InvalidId;
+    }
+
+private:
+    struct Node {
+        TPoint start;
+        TPoint end;
+        TMask mask;
+        uint32_t priority;
+        uint32_t left;
+        uint32_t right;
+        // Maximum end point and union of masks of all nodes in this subtree
+        TPoint subtreeEnd;
+        TMask subtreeMask;
+        bool isInserted = false;
+    };
+
+    std::vector<Node> nodes;
+    uint32_t root = InvalidId;
+
+    // Deterministic pseudo-random priority to keep the treap balanced
+    static uint32_t hashId(uint32_t id) {
+        uint32_t x = id + 0x9e3779b9u;
+        x = (x ^ (x >> 16)) * 0x85ebca6bu;
+        x = (x ^ (x >> 13)) * 0xc2b2ae35u;
+        return x ^ (x >> 16);
+    }
+
+    // Orders nodes by their start point, with ties broken by id
+    bool isLess(uint32_t id, TPoint start, uint32_t otherId) const {
+        return nodes[id].start < start || (nodes[id].start == start && id < otherId);
+    }
+
+    void updateNode(uint32_t id) {
+        Node& node = nodes[id];
+        node.subtreeEnd = node.end;
+        node.subtreeMask = node.mask;
+        for (uint32_t child : { node.left, node.right }) {
+            if (child != InvalidId) {
+                node.subtreeEnd = tp::max(node.subtreeEnd, nodes[child].subtreeEnd);
+                node.subtreeMask |= nodes[child].subtreeMask;
+            }
+        }
+    }
+
+    // Splits the subtree into nodes ordered before (start, id) and the rest
+    std::pair<uint32_t, uint32_t> split(uint32_t subtree, TPoint start, uint32_t id) {
+        if (subtree == InvalidId)
+            return { InvalidId, InvalidId };
+
+        Node& node = nodes[subtree];
+        if (isLess(subtree, start, id)) {
+            auto [leftRoot, rightRoot] = split(node.right, start, id);
+            nodes[subtree].right = leftRoot;
+            updateNode(subtree);
+            return { subtree, rightRoot };
+        } else {
+            auto [leftRoot, rightRoot] = split(node.left, start, id);
+            nodes[subtree].left = rightRoot;
+            updateNode(subtree);
+            return { leftRoot, subtree };
+        }
+    }
+
+    // Merges two subtrees where all nodes of the left one are ordered before the right one
+    uint32_t merge(uint32_t leftSubtree, uint32_t rightSubtree) {
+        if (leftSubtree == InvalidId)
+            return rightSubtree;
+        if (rightSubtree == InvalidId)
+            return leftSubtree;
+
+        if (nodes[leftSubtree].priority > nodes[rightSubtree].priority) {
+            uint32_t mergedRight = merge(nodes[leftSubtree].right, rightSubtree);
+            nodes[leftSubtree].right = mergedRight;
+            updateNode(leftSubtree);
+            return leftSubtree;
+        } else {
+            uint32_t mergedLeft = merge(leftSubtree, nodes[rightSubtree].left);
+            nodes[rightSubtree].left = mergedLeft;
+            updateNode(rightSubtree);
+            return rightSubtree;
+        }
+    }
+
+    template <typename TContainer>
+    void findOverlapping(uint32_t subtree, TPoint start, TPoint end, TMask mask, TContainer& ids) const {
+        if (subtree == InvalidId)
+            return;
+
+        const Node& node = nodes[subtree];
+        if (node.subtreeEnd <= start || (node.subtreeMask & mask) == 0)
+            return;
+
+        findOverlapping(node.left, start, end, mask, ids);
+
+        // Nodes to the right start at or after this one
+        if (node.start >= end)
+            return;
+
+        if (node.end > start && (node.mask & mask) != 0)
+            ids.push_back(subtree);
+
+        findOverlapping(node.right, start, end, mask, ids);
+    }
+};
+
+}
@@ -4,6 +4,7 @@
 #include <memory>
 #include <vector>
 #include <deque>
+#include <unordered_map>
 
 namespace tp {
 
@@ -123,4 +124,16 @@ using ScratchVector = std::vector<T, ScratchAllocator<T>>;
 template <typename T>
 using ScratchDeque = std::deque<T, ScratchAllocator<T>>;
 
+template <typename TKey, typename TValue>
+using ScratchUnorderedMap = std::
+    unordered_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>, ScratchAllocator<std::pair<const TKey, TValue>>>;
+
+template <typename TKey, typename TValue>
+using ScratchUnorderedMultimap = std::unordered_multimap<
+    TKey,
+    TValue,
+    std::hash<TKey>,
+    std::equal_to<TKey>,
+    ScratchAllocator<std::pair<const TKey, TValue>>>;
+
 }
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "math.hpp"
+#include <type_traits>
+#include <memory>
+#include <cstring>
+
+namespace tp {
+
+// Vector of trivially copyable elements that keeps up to InlineCapacity of them inside the object itself, only
+// allocating from the heap once that capacity is exceeded
+template <typename T, std::size_t InlineCapacity>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector only supports trivially copyable types.");
+    static_assert(InlineCapacity > 0);
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& other) {
+        append(other.begin(), other.end());
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            append(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector(SmallVector&& other) noexcept {
+        takeFrom(other);
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            heapStorage.reset();
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    T* data() {
+        return heapStorage ? reinterpret_cast<T*>(heapStorage.get()) : reinterpret_cast<T*>(inlineStorage);
+    }
+
+    const T* data() const {
+        return heapStorage ? reinterpret_cast<const T*>(heapStorage.get()) :
+                             reinterpret_cast<const T*>(inlineStorage);
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    std::size_t capacity() const {
+        return storageCapacity;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // Returns true if the elements are currently stored inline, without a heap allocation
+    bool isInline() const {
+        return !heapStorage;
+    }
+
+    T& operator[](std::size_t index) {
+        TEPHRA_ASSERT(index < count);
+        return data()[index];
+    }
+
+    const T& operator[](std::size_t index) const {
+        TEPHRA_ASSERT(index < count);
+        return data()[index];
+    }
+
+    T& front() {
+        return (*this)[0];
+    }
+
+    T& back() {
+        return (*this)[count - 1];
+    }
+
+    iterator begin() {
+        return data();
+    }
+
+    iterator end() {
+        return data() + count;
+    }
+
+    const_iterator begin() const {
+        return data();
+    }
+
+    const_iterator end() const {
+        return data() + count;
+    }
+
+    void reserve(std::size_t newCapacity) {
+        if (newCapacity <= storageCapacity)
+            return;
+
+        auto newStorage = std::make_unique<StorageType[]>(newCapacity);
+        if (count > 0)
+            std::memcpy(newStorage.get(), data(), count * sizeof(T));
+        heapStorage = std::move(newStorage);
+        storageCapacity = newCapacity;
+    }
+
+    void push_back(const T& value) {
+        // The value may reside in our own storage, so copy it before growing
+        T valueCopy = value;
+        if (count == storageCapacity)
+            grow(count + 1);
+        std::memcpy(static_cast<void*>(data() + count), &valueCopy, sizeof(T));
+        count++;
+    }
+
+    template <typename... TArgs>
+    T& emplace_back(TArgs&&... args) {
+        if (count == storageCapacity)
+            grow(count + 1);
+        T* elementPtr = new (data() + count) T(std::forward<TArgs>(args)...);
+        count++;
+        return *elementPtr;
+    }
+
+    void append(const T* first, const T* last) {
+        replace(count, count, first, last);
+    }
+
+    void pop_back() {
+        TEPHRA_ASSERT(count > 0);
+        count--;
+    }
+
+    void erase(std::size_t firstIndex, std::size_t lastIndex) {
+        replace(firstIndex, lastIndex, nullptr, nullptr);
+    }
+
+    // Replaces the elements in the index range [firstIndex, lastIndex) with a copy of the elements in [first, last),
+    // shifting the elements that follow only once. The source elements must not reside in this vector.
+    void replace(std::size_t firstIndex, std::size_t lastIndex, const T* first, const T* last) {
+        TEPHRA_ASSERT(firstIndex <= lastIndex && lastIndex <= count);
+        std::size_t removedCount = lastIndex - firstIndex;
+        std::size_t insertedCount = static_cast<std::size_t>(last - first);
+        std::size_t newCount = count - removedCount + insertedCount;
+
+        if (newCount > storageCapacity)
+            grow(newCount);
+
+        T* dataPtr = data();
+        std::size_t tailCount = count - lastIndex;
+        if (tailCount > 0 && removedCount != insertedCount) {
+            std::memmove(
+                static_cast<void*>(dataPtr + firstIndex + insertedCount), dataPtr + lastIndex, tailCount * sizeof(T));
+        }
+        if (insertedCount > 0)
+            std::memcpy(static_cast<void*>(dataPtr + firstIndex), first, insertedCount * sizeof(T));
+        count = newCount;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    // Frees the heap storage if the elements fit in the inline storage
+    void shrinkToFit() {
+        if (heapStorage && count <= InlineCapacity) {
+            std::unique_ptr<StorageType[]> oldStorage = std::move(heapStorage);
+            if (count > 0)
+                std::memcpy(inlineStorage, oldStorage.get(), count * sizeof(T));
+            storageCapacity = InlineCapacity;
+        }
+    }
+
+private:
+    using StorageType = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    std::size_t count = 0;
+    std::size_t storageCapacity = InlineCapacity;
+    std::unique_ptr<StorageType[]> heapStorage;
+    StorageType inlineStorage[InlineCapacity];
+
+    void grow(std::size_t minCapacity) {
+        reserve(tp::max(minCapacity, storageCapacity * 2));
+    }
+
+    void takeFrom(SmallVector& other) {
+        count = other.count;
+        storageCapacity = other.storageCapacity;
+        if (other.heapStorage) {
+            heapStorage = std::move(other.heapStorage);
+        } else if (count > 0) {
+            std::memcpy(inlineStorage, other.inlineStorage, count * sizeof(T));
+        }
+        other.count = 0;
+        other.storageCapacity = InlineCapacity;
+    }
+};
+
+}
@@ -0,0 +1,92 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace tp {
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+    threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+void ThreadPool::parallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& taskFunc) {
+    if (taskCount == 0)
+        return;
+
+    if (threads.empty() || taskCount == 1) {
+        for (uint32_t taskIndex = 0; taskIndex < taskCount; taskIndex++) {
+            taskFunc(taskIndex);
+        }
+        return;
+    }
+
+    Batch batch;
+    batch.taskFunc = &taskFunc;
+    batch.taskCount = taskCount;
+    batch.unfinishedTaskCount = taskCount;
+
+    std::unique_lock<std::mutex> stateLock(stateMutex);
+    pendingBatches.push_back(&batch);
+    workAvailable.notify_all();
+
+    // Only help with our own batch, so that the wait below is never stuck behind unrelated work. Any tasks taken by
+    // other threads only wait on batches of their own, so they always make progress
+    while (batch.nextTaskIndex < batch.taskCount) {
+        executeTask(&batch, stateLock);
+    }
+    workFinished.wait(stateLock, [&batch]() { return batch.unfinishedTaskCount == 0; });
+
+    std::exception_ptr exception = batch.firstException;
+    stateLock.unlock();
+
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> stateLock(stateMutex);
+        isShuttingDown = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
+    while (true) {
+        workAvailable.wait(stateLock, [this]() { return isShuttingDown || !pendingBatches.empty(); });
+        if (isShuttingDown)
+            return;
+
+        executeTask(pendingBatches.front(), stateLock);
+    }
+}
+
+void ThreadPool::executeTask(Batch* batch, std::unique_lock<std::mutex>& stateLock) {
+    uint32_t taskIndex = batch->nextTaskIndex++;
+    if (batch->nextTaskIndex == batch->taskCount) {
+        // All tasks of the batch have been started, the rest of the work is up to the threads executing them
+        pendingBatches.erase(std::find(pendingBatches.begin(), pendingBatches.end(), batch));
+    }
+
+    stateLock.unlock();
+    std::exception_ptr exception;
+    try {
+        (*batch->taskFunc)(taskIndex);
+    } catch (...) {
+        exception = std::current_exception();
+    }
+    stateLock.lock();
+
+    if (exception && !batch->firstException)
+        batch->firstException = exception;
+    // The batch may be destroyed by its owner as soon as the last task finishes
+    if (--batch->unfinishedTaskCount == 0)
+        workFinished.notify_all();
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tp {
+
+// Fixed set of worker threads for parallelizing internal work, such as recording of command buffers. The calling thread
+// takes part in the work as well, so a pool with zero threads executes everything serially.
+class ThreadPool {
+public:
+    explicit ThreadPool(uint32_t threadCount);
+
+    uint32_t getThreadCount() const {
+        return static_cast<uint32_t>(threads.size());
+    }
+
+    // Invokes the function for each task index in [0, taskCount), distributing the tasks between the worker threads
+    // and the calling thread. Returns after all of them have finished. The first exception thrown by any of the tasks
+    // gets rethrown here. May be called concurrently from multiple threads, including from within the tasks of another
+    // call, in which case the batches of tasks share the worker threads.
+    void parallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& taskFunc);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+private:
+    std::vector<std::thread> threads;
+
+    // The tasks of a single parallelFor call. Lives on the stack of the calling thread until all of them finish
+    struct Batch {
+        const std::function<void(uint32_t)>* taskFunc = nullptr;
+        uint32_t taskCount = 0;
+        uint32_t nextTaskIndex = 0;
+        uint32_t unfinishedTaskCount = 0;
+        std::exception_ptr firstException;
+    };
+
+    // State of the batches, guarded by stateMutex
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    // The batches that still have tasks that haven't been started yet, in the order they were submitted
+    std::deque<Batch*> pendingBatches;
+    bool isShuttingDown = false;
+
+    void workerLoop();
+
+    // Executes the next task of the pending batch. Expects stateMutex to be locked.
+    void executeTask(Batch* batch, std::unique_lock<std::mutex>& stateLock);
+};
+
+}
@@ -13,6 +13,18 @@ PFN_vkVoidFunction checkLoadedProc(PFN_vkVoidFunction procPtr, const char* procN
     return procPtr;
 }
 
+// Loads a device procedure promoted to core, falling back to the alias of the extension it was promoted from
+PFN_vkVoidFunction loadPromotedDeviceProcedure(
+    const VulkanInstanceInterface& vkiInstance,
+    VkDeviceHandle vkDeviceHandle,
+    const char* procName,
+    const char* extProcName) {
+    PFN_vkVoidFunction procPtr = vkiInstance.loadDeviceProcedure(vkDeviceHandle, procName);
+    if (procPtr == nullptr)
+        procPtr = vkiInstance.loadDeviceProcedure(vkDeviceHandle, extProcName);
+    return procPtr;
+}
+
 #define LOAD_EXPORTED_PROCEDURE(fun) \
     reinterpret_cast<PFN_##fun>(checkLoadedProc(vulkanLoader.loadExportedProcedure(#fun), #fun, "exported"))
 #define LOAD_GLOBAL_PROCEDURE(fun) \
@@ -26,6 +38,9 @@ PFN_vkVoidFunction checkLoadedProc(PFN_vkVoidFunction procPtr, const char* procN
     reinterpret_cast<PFN_##fun>(checkLoadedProc(vkiInstance.loadDeviceProcedure(vkDeviceHandle, #fun), #fun, "device"))
 #define LOAD_DEVICE_EXT_PROCEDURE(fun) \
     reinterpret_cast<PFN_##fun>(vkiInstance.loadDeviceProcedure(vkDeviceHandle, #fun))
+#define LOAD_DEVICE_KHR_PROMOTED_PROCEDURE(fun) \
+    reinterpret_cast<PFN_##fun>(checkLoadedProc( \
+        loadPromotedDeviceProcedure(vkiInstance, vkDeviceHandle, #fun, #fun "KHR"), #fun, "device"))
 
 VulkanGlobalInterface::VulkanGlobalInterface() {
     static VulkanLoader vulkanLoader;
@@ -139,6 +154,9 @@ VulkanDeviceInterface::VulkanDeviceInterface(const VulkanInstanceInterface& vkiI
     getSemaphoreCounterValue = LOAD_DEVICE_PROCEDURE(vkGetSemaphoreCounterValue);
     waitSemaphores = LOAD_DEVICE_PROCEDURE(vkWaitSemaphores);
     signalSemaphore = LOAD_DEVICE_PROCEDURE(vkSignalSemaphore);
+    createEvent = LOAD_DEVICE_PROCEDURE(vkCreateEvent);
+    destroyEvent = LOAD_DEVICE_PROCEDURE(vkDestroyEvent);
+    resetEvent = LOAD_DEVICE_PROCEDURE(vkResetEvent);
     getBufferDeviceAddress = LOAD_DEVICE_PROCEDURE(vkGetBufferDeviceAddress);
     createQueryPool = LOAD_DEVICE_PROCEDURE(vkCreateQueryPool);
     destroyQueryPool = LOAD_DEVICE_PROCEDURE(vkDestroyQueryPool);
@@ -226,6 +244,10 @@ VulkanCommandInterface::VulkanCommandInterface(
     cmdClearAttachments = LOAD_DEVICE_PROCEDURE(vkCmdClearAttachments);
     cmdResolveImage = LOAD_DEVICE_PROCEDURE(vkCmdResolveImage);
     cmdPipelineBarrier = LOAD_DEVICE_PROCEDURE(vkCmdPipelineBarrier);
+    // Synchronization2 is always enabled, but its commands may only be exposed through VK_KHR_synchronization2
+    cmdPipelineBarrier2 = LOAD_DEVICE_KHR_PROMOTED_PROCEDURE(vkCmdPipelineBarrier2);
+    cmdSetEvent2 = LOAD_DEVICE_KHR_PROMOTED_PROCEDURE(vkCmdSetEvent2);
+    cmdWaitEvents2 = LOAD_DEVICE_KHR_PROMOTED_PROCEDURE(vkCmdWaitEvents2);
     cmdBeginQuery = LOAD_DEVICE_PROCEDURE(vkCmdBeginQuery);
     cmdEndQuery = LOAD_DEVICE_PROCEDURE(vkCmdEndQuery);
     cmdWriteTimestamp = LOAD_DEVICE_PROCEDURE(vkCmdWriteTimestamp);
@@ -126,6 +126,9 @@ public:
     PFN_vkGetSemaphoreCounterValue getSemaphoreCounterValue = nullptr;
     PFN_vkWaitSemaphores waitSemaphores = nullptr;
     PFN_vkSignalSemaphore signalSemaphore = nullptr;
+    PFN_vkCreateEvent createEvent = nullptr;
+    PFN_vkDestroyEvent destroyEvent = nullptr;
+    PFN_vkResetEvent resetEvent = nullptr;
     PFN_vkGetBufferDeviceAddress getBufferDeviceAddress = nullptr;
     PFN_vkCreateQueryPool createQueryPool = nullptr;
     PFN_vkDestroyQueryPool destroyQueryPool = nullptr;
@@ -218,6 +221,9 @@ public:
     PFN_vkCmdClearAttachments cmdClearAttachments = nullptr;
     PFN_vkCmdResolveImage cmdResolveImage = nullptr;
     PFN_vkCmdPipelineBarrier cmdPipelineBarrier = nullptr;
+    PFN_vkCmdPipelineBarrier2 cmdPipelineBarrier2 = nullptr;
+    PFN_vkCmdSetEvent2 cmdSetEvent2 = nullptr;
+    PFN_vkCmdWaitEvents2 cmdWaitEvents2 = nullptr;
     PFN_vkCmdBeginQuery cmdBeginQuery = nullptr;
     PFN_vkCmdEndQuery cmdEndQuery = nullptr;
     PFN_vkCmdWriteTimestamp cmdWriteTimestamp = nullptr;
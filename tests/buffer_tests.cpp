@@ -1,5 +1,7 @@
 #include "tests_common.hpp"
 
+#include <tephra/utils/growable_ring_buffer.hpp>
+
 namespace TephraIntegrationTests {
 
 // Tests to verify the creation, memory allocation and use of buffers and buffer views,
@@ -207,6 +209,232 @@ public:
         Assert::AreEqual(blockSize * 6, ctx.getLastStatistic(tp::StatisticEventType::JobLocalBufferCommittedBytes));
     }
 
+    TEST_METHOD(JobLocalExportNotAliased) {
+        static const uint64_t blockSize = 1 << 20;
+
+        // Test whether an exported buffer, which counts as used until the end of the job, doesn't get aliased with
+        // a buffer that is only used after the export
+        tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob();
+        auto bufferSetup = tp::BufferSetup(blockSize, tp::BufferUsageMask::None());
+        tp::BufferView bufferA = job.allocateLocalBuffer(bufferSetup);
+        tp::BufferView bufferB = job.allocateLocalBuffer(bufferSetup);
+        tp::BufferView bufferC = job.allocateLocalBuffer(bufferSetup);
+
+        job.cmdFillBuffer(bufferA, 123456);
+        job.cmdExportResource(bufferA, tp::ReadAccess::Transfer);
+        job.cmdFillBuffer(bufferB, 654321);
+        job.cmdCopyBuffer(bufferB, bufferC, { tp::BufferCopyRegion(0, 0, blockSize) });
+
+        tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+        ctx.device->waitForJobSemaphores({ semaphore });
+
+        Assert::AreEqual(blockSize * 3, ctx.getLastStatistic(tp::StatisticEventType::JobLocalBufferRequestedBytes));
+        Assert::AreEqual(blockSize * 3, ctx.getLastStatistic(tp::StatisticEventType::JobLocalBufferCommittedBytes));
+    }
+
+    TEST_METHOD(JobLocalReuseInFlight) {
+        static const uint64_t blockSize = 1 << 20;
+        static const uint32_t jobCount = 3;
+
+        auto readbackSetup = tp::BufferSetup(blockSize * jobCount, tp::BufferUsage::HostMapped);
+        tp::OwningPtr<tp::Buffer> readbackBuffer = ctx.device->allocateBuffer(
+            readbackSetup, tp::MemoryPreference::ReadbackStream);
+
+        // Test whether jobs that are in flight at the same time all alias the same backing buffer, relying on
+        // barriers between the jobs rather than waiting for the previous ones to finish
+        std::vector<tp::JobSemaphore> semaphores;
+        for (uint32_t i = 0; i < jobCount; i++) {
+            tp::Job job = ctx.noOverallocateCtx.jobResourcePool->createJob();
+            tp::BufferView localBuffer = job.allocateLocalBuffer({ blockSize, tp::BufferUsageMask::None() });
+            tp::BufferView readbackView = readbackBuffer->getView(i * blockSize, blockSize);
+
+            job.cmdFillBuffer(localBuffer, i);
+            job.cmdCopyBuffer(localBuffer, readbackView, { tp::BufferCopyRegion(0, 0, blockSize) });
+            job.cmdExportResource(readbackView, tp::ReadAccess::Host);
+
+            semaphores.push_back(ctx.device->enqueueJob(ctx.noOverallocateCtx.queue, std::move(job)));
+            ctx.device->submitQueuedJobs(ctx.noOverallocateCtx.queue);
+        }
+
+        tp::JobResourcePoolStatistics stats = ctx.noOverallocateCtx.jobResourcePool->getStatistics();
+        Assert::AreEqual(1u, stats.bufferAllocationCount);
+        Assert::AreEqual(blockSize, stats.bufferAllocationBytes);
+
+        ctx.device->waitForJobSemaphores(tp::view(semaphores));
+
+        tp::HostReadableMemory readbackMemory = readbackBuffer->mapForHostRead();
+        const uint32_t* valuePtr = readbackMemory.getPtr<uint32_t>();
+        for (uint64_t i = 0; i < blockSize * jobCount / sizeof(uint32_t); i++) {
+            Assert::AreEqual(static_cast<uint32_t>(i * sizeof(uint32_t) / blockSize), valuePtr[i]);
+        }
+    }
+
+    TEST_METHOD(JobLocalTrimPolicy) {
+        static const uint64_t blockSize = 1 << 20;
+
+        // Test whether a backing buffer that wasn't used by the last two jobs gets freed automatically
+        auto noOverallocation = tp::OverallocationBehavior::Exact();
+        auto poolSetup = tp::JobResourcePoolSetup(
+            ctx.noOverallocateCtx.queue, {}, noOverallocation, noOverallocation, noOverallocation);
+        poolSetup.trimPolicy = tp::JobResourcePoolTrimPolicy(2);
+        tp::OwningPtr<tp::JobResourcePool> jobResourcePool = ctx.device->createJobResourcePool(poolSetup);
+
+        std::vector<tp::JobSemaphore> semaphores;
+        for (uint32_t i = 0; i < 3; i++) {
+            // The first job uses a smaller buffer, so that the later jobs need a new backing buffer
+            uint64_t bufferSize = i == 0 ? blockSize : blockSize * 2;
+            tp::Job job = jobResourcePool->createJob();
+            tp::BufferView localBuffer = job.allocateLocalBuffer({ bufferSize, tp::BufferUsageMask::None() });
+            job.cmdFillBuffer(localBuffer, i);
+
+            semaphores.push_back(ctx.device->enqueueJob(ctx.noOverallocateCtx.queue, std::move(job)));
+            ctx.device->submitQueuedJobs(ctx.noOverallocateCtx.queue);
+            if (i == 0)
+                ctx.device->waitForJobSemaphores({ semaphores.back() });
+        }
+
+        Assert::AreEqual(blockSize, ctx.getLastStatistic(tp::StatisticEventType::JobResourcePoolTrimmedBytes));
+        tp::JobResourcePoolStatistics stats = jobResourcePool->getStatistics();
+        Assert::AreEqual(1u, stats.bufferAllocationCount);
+        Assert::AreEqual(blockSize * 2, stats.bufferAllocationBytes);
+
+        ctx.device->waitForJobSemaphores(tp::view(semaphores));
+    }
+
+    TEST_METHOD(JobLocalTrimPolicyHeapUsage) {
+        static const uint64_t blockSize = 1 << 20;
+
+        // Any usage of the heap exceeds the high watermark, but it never falls below the low one
+        auto noOverallocation = tp::OverallocationBehavior::Exact();
+        auto poolSetup = tp::JobResourcePoolSetup(
+            ctx.noOverallocateCtx.queue, {}, noOverallocation, noOverallocation, noOverallocation);
+        poolSetup.trimPolicy = tp::JobResourcePoolTrimPolicy(0, 0.000001f, 0.0f);
+        tp::OwningPtr<tp::JobResourcePool> jobResourcePool = ctx.device->createJobResourcePool(poolSetup);
+
+        // Each job needs a larger buffer, so that it can't reuse the backing buffers of the previous jobs
+        auto submitJob = [&](uint64_t bufferSize) {
+            tp::Job job = jobResourcePool->createJob();
+            tp::BufferView localBuffer = job.allocateLocalBuffer({ bufferSize, tp::BufferUsageMask::None() });
+            job.cmdFillBuffer(localBuffer, 0);
+
+            tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.noOverallocateCtx.queue, std::move(job));
+            ctx.device->submitQueuedJobs(ctx.noOverallocateCtx.queue);
+            ctx.device->waitForJobSemaphores({ semaphore });
+        };
+
+        // Nothing can be freed while the first job is pending, so the policy stays armed
+        submitJob(blockSize);
+        tp::JobResourcePoolStatistics stats = jobResourcePool->getStatistics();
+        Assert::AreEqual(1u, stats.bufferAllocationCount);
+
+        // The backing buffer of the first job gets freed after allocating the second one
+        submitJob(blockSize * 2);
+        Assert::AreEqual(blockSize, ctx.getLastStatistic(tp::StatisticEventType::JobResourcePoolTrimmedBytes));
+        stats = jobResourcePool->getStatistics();
+        Assert::AreEqual(1u, stats.bufferAllocationCount);
+        Assert::AreEqual(blockSize * 2, stats.bufferAllocationBytes);
+
+        // The usage hasn't fallen below the low watermark since, so the pool doesn't get trimmed again
+        submitJob(blockSize * 4);
+        stats = jobResourcePool->getStatistics();
+        Assert::AreEqual(2u, stats.bufferAllocationCount);
+        Assert::AreEqual(blockSize * 6, stats.bufferAllocationBytes);
+    }
+
+    TEST_METHOD(JobLocalAdaptiveOverallocation) {
+        static const uint64_t blockSize = 1 << 20;
+
+        // Test whether the adaptive behavior sizes the backing buffer to the demand plus a quarter of headroom,
+        // which then lets a slightly larger job fit without a new allocation
+        auto poolSetup = tp::JobResourcePoolSetup(ctx.noOverallocateCtx.queue);
+        poolSetup.bufferOverallocationBehavior = tp::OverallocationBehavior::Adaptive(4, 1, 0.25f, 0);
+        tp::OwningPtr<tp::JobResourcePool> jobResourcePool = ctx.device->createJobResourcePool(poolSetup);
+
+        std::vector<tp::JobSemaphore> semaphores;
+        for (uint64_t bufferSize : { blockSize, blockSize + blockSize / 8 }) {
+            tp::Job job = jobResourcePool->createJob();
+            tp::BufferView localBuffer = job.allocateLocalBuffer({ bufferSize, tp::BufferUsageMask::None() });
+            job.cmdFillBuffer(localBuffer, 0);
+
+            semaphores.push_back(ctx.device->enqueueJob(ctx.noOverallocateCtx.queue, std::move(job)));
+            ctx.device->submitQueuedJobs(ctx.noOverallocateCtx.queue);
+        }
+
+        tp::JobResourcePoolStatistics stats = jobResourcePool->getStatistics();
+        Assert::AreEqual(1u, stats.bufferAllocationCount);
+        Assert::AreEqual(blockSize + blockSize / 4, stats.bufferLastAllocationBytes);
+        Assert::AreEqual(blockSize + blockSize / 8, stats.bufferDemandBytes);
+        Assert::AreEqual(blockSize / 8, stats.getBufferWastedBytes());
+
+        ctx.device->waitForJobSemaphores(tp::view(semaphores));
+    }
+
+    TEST_METHOD(PreinitializedAdaptiveOverallocation) {
+        static const uint64_t blockSize = 1 << 20;
+
+        // Same as above, but the demand of preinitialized buffers gets sampled as each job finishes its allocations
+        auto poolSetup = tp::JobResourcePoolSetup(ctx.noOverallocateCtx.queue);
+        poolSetup.preinitBufferOverallocationBehavior = tp::OverallocationBehavior::Adaptive(4, 1, 0.25f, 0);
+        tp::OwningPtr<tp::JobResourcePool> jobResourcePool = ctx.device->createJobResourcePool(poolSetup);
+
+        auto runJob = [&](uint64_t bufferSize) {
+            tp::Job job = jobResourcePool->createJob();
+            tp::BufferView buffer = job.allocatePreinitializedBuffer(
+                { bufferSize, tp::BufferUsage::HostMapped }, tp::MemoryPreference::Host);
+            job.cmdFillBuffer(buffer, 0);
+
+            tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.noOverallocateCtx.queue, std::move(job));
+            ctx.device->submitQueuedJobs(ctx.noOverallocateCtx.queue);
+            ctx.device->waitForJobSemaphores({ semaphore });
+        };
+
+        runJob(blockSize);
+        tp::JobResourcePoolStatistics stats = jobResourcePool->getStatistics();
+        Assert::AreEqual(1u, stats.preinitBufferAllocationCount);
+        Assert::AreEqual(blockSize + blockSize / 4, stats.preinitBufferLastAllocationBytes);
+        Assert::AreEqual(blockSize, stats.preinitBufferDemandBytes);
+
+        // The first job has finished, so the second one fits in the headroom
+        runJob(blockSize + blockSize / 8);
+        stats = jobResourcePool->getStatistics();
+        Assert::AreEqual(1u, stats.preinitBufferAllocationCount);
+        Assert::AreEqual(blockSize + blockSize / 8, stats.preinitBufferDemandBytes);
+        Assert::AreEqual(blockSize / 8, stats.getBufferWastedBytes());
+    }
+
+    TEST_METHOD(AutoRingBufferAdaptiveOverallocation) {
+        static const uint64_t blockSize = 1 << 20;
+
+        // Without headroom, the ring buffer should only grow by what it's missing to cover the peak demand
+        auto ringBuffer = tp::utils::AutoRingBuffer(
+            ctx.device.get(),
+            tp::BufferUsage::HostMapped,
+            tp::MemoryPreference::Host,
+            tp::OverallocationBehavior::Adaptive(2, 1, 0.0f, 0));
+
+        ringBuffer.push(blockSize, 1);
+        Assert::AreEqual(blockSize, ringBuffer.getTotalSize());
+
+        // Nothing gets freed yet, but the allocated size still gets sampled
+        ringBuffer.pop(0);
+        Assert::AreEqual(blockSize, ringBuffer.getPeakDemand());
+
+        ringBuffer.push(blockSize / 2, 2);
+        Assert::AreEqual(blockSize + blockSize / 2, ringBuffer.getTotalSize());
+        Assert::AreEqual(2ull, ringBuffer.getRegionCount());
+
+        ringBuffer.pop(2);
+        Assert::AreEqual(0ull, ringBuffer.getAllocatedSize());
+        Assert::AreEqual(blockSize + blockSize / 2, ringBuffer.getPeakDemand());
+
+        // The peak falls out of the demand window after two more pops
+        ringBuffer.pop(2);
+        Assert::AreEqual(blockSize + blockSize / 2, ringBuffer.getPeakDemand());
+        ringBuffer.pop(2);
+        Assert::AreEqual(0ull, ringBuffer.getPeakDemand());
+    }
+
     TEST_METHOD(PreinitializedWithWait) {
         static const uint64_t bufferSize = 1 << 20;
         tp::MemoryLocation usedLocation;
@@ -297,6 +525,39 @@ public:
         Assert::AreEqual(bufferSize * 2, ctx.device->getMemoryHeapStatistics(usedHeapIndex).allocationBytes);
     }
 
+    TEST_METHOD(UpdateBufferStaged) {
+        static const uint64_t updateSize = 16 * 1024;
+        static const uint32_t updateCount = 16;
+        static const uint64_t bufferSize = updateCount * updateSize;
+
+        auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsage::HostMapped);
+        tp::OwningPtr<tp::Buffer> buffer = ctx.device->allocateBuffer(bufferSetup, tp::MemoryPreference::ReadbackStream);
+
+        // Each update is above the default staging threshold, so they should all get staged in a single preinitialized
+        // buffer and copied to the consecutive ranges of the buffer
+        tp::Job job = ctx.noOverallocateCtx.jobResourcePool->createJob();
+        std::vector<uint32_t> data(updateSize / sizeof(uint32_t));
+        for (uint32_t i = 0; i < updateCount; i++) {
+            std::fill(data.begin(), data.end(), i);
+            auto dataBytes = tp::ArrayParameter<const std::byte>(
+                reinterpret_cast<const std::byte*>(data.data()), updateSize);
+            job.cmdUpdateBuffer(buffer->getView(i * updateSize, updateSize), dataBytes);
+        }
+        job.cmdExportResource(*buffer, tp::ReadAccess::Host);
+
+        tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.noOverallocateCtx.queue, std::move(job));
+        Assert::AreEqual(bufferSize, ctx.getLastStatistic(tp::StatisticEventType::JobPreinitBufferRequestedBytes));
+
+        ctx.device->submitQueuedJobs(ctx.noOverallocateCtx.queue);
+        ctx.device->waitForJobSemaphores({ semaphore });
+
+        tp::HostReadableMemory bufferMemory = buffer->mapForHostRead();
+        const uint32_t* valuePtr = bufferMemory.getPtr<uint32_t>();
+        for (uint64_t i = 0; i < bufferSize / sizeof(uint32_t); i++) {
+            Assert::AreEqual(static_cast<uint32_t>(i * sizeof(uint32_t) / updateSize), valuePtr[i]);
+        }
+    }
+
 private:
     static TephraContext ctx;
 };
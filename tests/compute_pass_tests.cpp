@@ -251,6 +251,98 @@ public:
         Assert::AreNotEqual(jobQueryResult.value, passQueryResult.value);
     }
 
+    // Tests that jobs waiting on another queue only wait at the stages of their dependent accesses when they opt in
+    TEST_METHOD(ComputeCrossQueueWaitStages) {
+        static const uint64_t bufferSize = 1 << 20;
+
+        auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsage::TexelBuffer);
+        tp::OwningPtr<tp::Buffer> exportedBuffer = ctx.device->allocateBuffer(
+            bufferSetup, tp::MemoryPreference::Device, "TestBuffer");
+        tp::OwningPtr<tp::Buffer> otherBuffer = ctx.device->allocateBuffer(
+            bufferSetup, tp::MemoryPreference::Device, "TestBuffer");
+
+        auto imageSetup = tp::ImageSetup(
+            tp::ImageType::Image2D, tp::ImageUsage::SampledImage, tp::Format::COL32_R32_UINT, { 64, 64, 1 });
+        tp::OwningPtr<tp::Image> image = ctx.device->allocateImage(imageSetup, "TestImage");
+
+        // Submits a job to the first compute queue, optionally exporting the buffer to the compute queues. It waits
+        // for the previous consumer job, so that it doesn't overwrite the buffer while it's being read
+        tp::JobSemaphore consumerSemaphore;
+        auto submitProducerJob = [&](bool exportBuffer) {
+            tp::Job job = ctx.asyncCompute0Ctx.jobResourcePool->createJob();
+            if (exportBuffer) {
+                job.cmdFillBuffer(*exportedBuffer, 123456);
+                job.cmdExportResource(*exportedBuffer, tp::ReadAccess::ComputeShaderSampled, tp::QueueType::Compute);
+            }
+            std::vector<tp::JobSemaphore> waitSemaphores;
+            if (!consumerSemaphore.isNull())
+                waitSemaphores.push_back(consumerSemaphore);
+            tp::JobSemaphore semaphore = ctx.device->enqueueJob(
+                ctx.asyncCompute0Ctx.queue, std::move(job), tp::view(waitSemaphores));
+            ctx.device->submitQueuedJobs(ctx.asyncCompute0Ctx.queue);
+            return semaphore;
+        };
+
+        // Submits a job to the second compute queue waiting on the first, with a compute pass of the given accesses
+        tp::JobFlagMask consumerFlags = tp::JobFlag::NarrowSemaphoreWaits;
+        auto submitConsumerJob = [&](tp::JobSemaphore waitSemaphore,
+                                     std::vector<tp::BufferComputeAccess> bufferAccesses,
+                                     std::vector<tp::ImageComputeAccess> imageAccesses,
+                                     bool fillOtherBuffer) {
+            tp::Job job = ctx.asyncCompute1Ctx.jobResourcePool->createJob(consumerFlags);
+            if (fillOtherBuffer)
+                job.cmdFillBuffer(*otherBuffer, 0);
+            job.cmdExecuteComputePass(
+                tp::ComputePassSetup(tp::view(bufferAccesses), tp::view(imageAccesses)),
+                [](tp::ComputeList& inlineList) {});
+            consumerSemaphore = ctx.device->enqueueJob(ctx.asyncCompute1Ctx.queue, std::move(job), { waitSemaphore });
+            ctx.device->submitQueuedJobs(ctx.asyncCompute1Ctx.queue);
+        };
+
+        auto getLastWaitStageMask = [&]() {
+            return ctx.getLastStatistic(tp::StatisticEventType::JobSemaphoreWaitStageMask);
+        };
+        const uint64_t topOfPipeStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        const uint64_t computeStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        const uint64_t transferStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+        // Reading the exported buffer only needs to wait at the compute shader stage
+        tp::JobSemaphore semaphore = submitProducerJob(true);
+        tp::BufferComputeAccess exportedRead = { *exportedBuffer, tp::ComputeAccess::ComputeShaderSampledRead };
+        submitConsumerJob(semaphore, { exportedRead }, {}, false);
+        Assert::AreEqual(computeStage, getLastWaitStageMask());
+
+        // Any write may overwrite data still read by the other queue, so it has to wait as well
+        semaphore = submitProducerJob(true);
+        submitConsumerJob(semaphore, { exportedRead }, {}, true);
+        Assert::AreEqual(computeStage | transferStage, getLastWaitStageMask());
+
+        // Reads of resources that weren't exported don't depend on the other queue
+        semaphore = submitProducerJob(false);
+        tp::BufferComputeAccess otherRead = { *otherBuffer, tp::ComputeAccess::ComputeShaderSampledRead };
+        submitConsumerJob(semaphore, { otherRead }, {}, false);
+        Assert::AreEqual(topOfPipeStage, getLastWaitStageMask());
+
+        // Unless they need a layout transition, which writes to the image
+        semaphore = submitProducerJob(false);
+        tp::ImageComputeAccess imageRead = { *image, tp::ComputeAccess::ComputeShaderSampledRead };
+        submitConsumerJob(semaphore, {}, { imageRead }, false);
+        Assert::AreEqual(computeStage, getLastWaitStageMask());
+
+        // Once the image is in the right layout, reading it again doesn't need to wait
+        semaphore = submitProducerJob(false);
+        submitConsumerJob(semaphore, {}, { imageRead }, false);
+        Assert::AreEqual(topOfPipeStage, getLastWaitStageMask());
+
+        // Without opting in, later jobs on the queue may rely on the wait, so it stays at the top of the pipe
+        consumerFlags = tp::JobFlagMask::None();
+        semaphore = submitProducerJob(true);
+        submitConsumerJob(semaphore, { exportedRead }, {}, false);
+        Assert::AreEqual(topOfPipeStage, getLastWaitStageMask());
+
+        ctx.device->waitForJobSemaphores({ consumerSemaphore });
+    }
+
 private:
     static TephraContext ctx;
     static tp::DescriptorSetLayout ioComputeDescriptorSetLayout;
@@ -1,4 +1,5 @@
 #include "tests_common.hpp"
+#include <thread>
 
 namespace TephraIntegrationTests {
 
@@ -165,6 +166,106 @@ public:
             static_cast<uint64_t>(6), ctx.getLastStatistic(tp::StatisticEventType::JobBufferMemoryBarriersInserted));
     }
 
+    TEST_METHOD(BarriersSplit) {
+        static const uint64_t bufferSize = 1 << 20;
+
+        // Two independent fills between the first fill and the copy that depends on it (Barrier #1). Job-local buffers
+        // could alias each other and add barriers between the fills, so use fresh persistent ones instead
+        std::vector<tp::OwningPtr<tp::Buffer>> buffers;
+        auto recordJob = [&](tp::JobResourcePool* jobResourcePool) {
+            auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsageMask::None());
+            for (int i = 0; i < 4; i++) {
+                buffers.push_back(ctx.device->allocateBuffer(bufferSetup, tp::MemoryPreference::Device, "TestBuffer"));
+            }
+            tp::Buffer& bufferA = *buffers[buffers.size() - 4];
+            tp::Buffer& bufferB = *buffers[buffers.size() - 3];
+            tp::Buffer& bufferC = *buffers[buffers.size() - 2];
+            tp::Buffer& bufferD = *buffers[buffers.size() - 1];
+
+            tp::Job job = jobResourcePool->createJob();
+            job.cmdFillBuffer(bufferA, 123456);
+            job.cmdFillBuffer(bufferB, 654321);
+            job.cmdFillBuffer(bufferC, 456789);
+            job.cmdCopyBuffer(bufferA, bufferD, { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+            return job;
+        };
+
+        // The default distance of two commands is enough to split the barrier
+        tp::Job job = recordJob(ctx.graphicsQueueCtx.jobResourcePool.get());
+        ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+
+        Assert::AreEqual(
+            static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
+        Assert::AreEqual(
+            static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersSplit));
+
+        // A pool requiring more commands in between keeps it as a regular pipeline barrier
+        auto poolSetup = tp::JobResourcePoolSetup(ctx.graphicsQueueCtx.queue);
+        poolSetup.splitBarrierCommandDistance = 3;
+        tp::OwningPtr<tp::JobResourcePool> jobResourcePool = ctx.device->createJobResourcePool(poolSetup);
+
+        job = recordJob(jobResourcePool.get());
+        tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+
+        Assert::AreEqual(
+            static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
+        Assert::AreEqual(
+            static_cast<uint64_t>(0), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersSplit));
+
+        ctx.device->waitForJobSemaphores({ semaphore });
+    }
+
+    TEST_METHOD(BarriersImageLayouts) {
+        static const uint32_t imageSize = 64;
+        static const uint64_t bufferSize = imageSize * imageSize * sizeof(uint32_t);
+
+        auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsage::ImageTransfer);
+        tp::OwningPtr<tp::Buffer> srcBuffer = ctx.device->allocateBuffer(
+            bufferSetup, tp::MemoryPreference::Device, "TestBuffer");
+        auto readbackSetup = tp::BufferSetup(bufferSize, tp::BufferUsage::HostMapped | tp::BufferUsage::ImageTransfer);
+        tp::OwningPtr<tp::Buffer> readbackBuffer = ctx.device->allocateBuffer(
+            readbackSetup, tp::MemoryPreference::ReadbackStream, "TestBuffer");
+
+        auto imageSetup = tp::ImageSetup(
+            tp::ImageType::Image2D,
+            tp::ImageUsage::TransferSrc | tp::ImageUsage::TransferDst,
+            tp::Format::COL32_R32_UINT,
+            { imageSize, imageSize, 1 });
+        tp::OwningPtr<tp::Image> image = ctx.device->allocateImage(imageSetup, "TestImage");
+        auto copyRegion = tp::BufferImageCopyRegion(0, image->getWholeRange().pickMipLevel(0), {}, image->getExtent());
+
+        tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob();
+        job.cmdFillBuffer(*srcBuffer, 123456);
+        // Read after write of the buffer together with the initial layout transition of the image (Barrier #1,
+        // Mem barrier #1, Image barrier #1)
+        job.cmdCopyBufferToImage(*srcBuffer, *image, { copyRegion });
+        // Read after write of the image along with its transition to the transfer source layout (Barrier #2,
+        // Image barrier #2)
+        job.cmdCopyImageToBuffer(*image, *readbackBuffer, { copyRegion });
+        // Export to the host (Barrier #3, Mem barrier #2)
+        job.cmdExportResource(*readbackBuffer, tp::ReadAccess::Host);
+
+        tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+
+        Assert::AreEqual(
+            static_cast<uint64_t>(3), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
+        Assert::AreEqual(
+            static_cast<uint64_t>(2), ctx.getLastStatistic(tp::StatisticEventType::JobBufferMemoryBarriersInserted));
+        Assert::AreEqual(
+            static_cast<uint64_t>(2), ctx.getLastStatistic(tp::StatisticEventType::JobImageMemoryBarriersInserted));
+
+        // The data only makes it through intact if each barrier carries the right stages, accesses and layouts
+        ctx.device->waitForJobSemaphores({ semaphore });
+        tp::HostReadableMemory readAccess = readbackBuffer->mapForHostRead();
+        Assert::IsFalse(readAccess.isNull());
+        for (uint32_t value : readAccess.getArrayView<uint32_t>()) {
+            Assert::AreEqual(123456u, value);
+        }
+    }
+
     TEST_METHOD(BarriersExport) {
         static const uint64_t bufferSize = 1 << 20;
 
@@ -208,6 +309,346 @@ public:
             static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
     }
 
+    TEST_METHOD(BarriersExportQueueFamilyTransfer) {
+        static const uint64_t bufferSize = 1 << 20;
+
+        // Only meaningful when the compute queues belong to another queue family
+        uint32_t graphicsFamilyIndex = ctx.physicalDevice->getQueueTypeInfo(tp::QueueType::Graphics).queueFamilyIndex;
+        uint32_t computeFamilyIndex = ctx.physicalDevice->getQueueTypeInfo(tp::QueueType::Compute).queueFamilyIndex;
+        if (graphicsFamilyIndex == computeFamilyIndex)
+            return;
+
+        auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsageMask::None());
+        tp::OwningPtr<tp::Buffer> bufferA = ctx.device->allocateBuffer(
+            bufferSetup, tp::MemoryPreference::Device, "TestBuffer");
+        tp::OwningPtr<tp::Buffer> bufferB = ctx.device->allocateBuffer(
+            bufferSetup, tp::MemoryPreference::Device, "TestBuffer");
+
+        // The write gets synchronized together with the ownership release, 1 barrier expected
+        tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob();
+        job.cmdFillBuffer(*bufferA, 123456);
+        job.cmdExportResource(*bufferA, tp::ReadAccess::Transfer, tp::QueueType::Compute);
+        tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+        Assert::AreEqual(
+            static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
+        Assert::AreEqual(
+            static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobBufferMemoryBarriersInserted));
+
+        // The compute queue acquires the buffer with a matching barrier
+        job = ctx.asyncCompute0Ctx.jobResourcePool->createJob();
+        job.cmdCopyBuffer(*bufferA, *bufferB, { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+        semaphore = ctx.device->enqueueJob(ctx.asyncCompute0Ctx.queue, std::move(job), { semaphore });
+        ctx.device->submitQueuedJobs(ctx.asyncCompute0Ctx.queue);
+
+        ctx.device->waitForJobSemaphores({ semaphore });
+    }
+
+    TEST_METHOD(BarriersCached) {
+        static const uint64_t bufferSize = 1 << 20;
+
+        auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsageMask::None());
+        tp::OwningPtr<tp::Buffer> bufferA = ctx.device->allocateBuffer(
+            bufferSetup, tp::MemoryPreference::Device, "TestBuffer");
+        tp::OwningPtr<tp::Buffer> bufferB = ctx.device->allocateBuffer(
+            bufferSetup, tp::MemoryPreference::Device, "TestBuffer");
+
+        auto submitFrameJob = [&]() {
+            tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob(tp::JobFlag::CachedBarriers);
+            job.cmdFillBuffer(*bufferA, 123456);
+            job.cmdCopyBuffer(*bufferA, *bufferB, { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+            ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+            ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+        };
+
+        // Job 1 starts with fresh buffers, job 2 with the states left by job 1, so both need their barriers prepared
+        submitFrameJob();
+        submitFrameJob();
+        uint64_t hitCount = ctx.getLastStatistic(tp::StatisticEventType::JobBarrierCacheHits);
+        uint64_t missCount = ctx.getLastStatistic(tp::StatisticEventType::JobBarrierCacheMisses);
+        uint64_t barrierCount = ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted);
+
+        // Job 3 starts with the same states as job 2, so it can reuse its barriers
+        submitFrameJob();
+        Assert::AreEqual(hitCount + 1, ctx.getLastStatistic(tp::StatisticEventType::JobBarrierCacheHits));
+        Assert::AreEqual(missCount, ctx.getLastStatistic(tp::StatisticEventType::JobBarrierCacheMisses));
+        Assert::AreEqual(barrierCount, ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
+    }
+
+    TEST_METHOD(BarriersReordered) {
+        static const uint64_t bufferSize = 1 << 20;
+
+        // Use persistent buffers, job-local ones could alias and depend on each other
+        auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsageMask::None());
+        tp::OwningPtr<tp::Buffer> buffers[4];
+        for (tp::OwningPtr<tp::Buffer>& buffer : buffers) {
+            buffer = ctx.device->allocateBuffer(bufferSetup, tp::MemoryPreference::Device, "TestBuffer");
+        }
+
+        tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob(tp::JobFlag::ReorderCommands);
+
+        // Recorded order needs a barrier after each fill, the second fill can be moved ahead of the first copy
+        job.cmdFillBuffer(*buffers[0], 123456);
+        job.cmdCopyBuffer(*buffers[0], *buffers[1], { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+        job.cmdFillBuffer(*buffers[2], 654321);
+        job.cmdCopyBuffer(*buffers[2], *buffers[3], { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+
+        ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+
+        Assert::AreEqual(
+            static_cast<uint64_t>(1),
+            ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersSavedByReordering));
+        Assert::AreEqual(
+            static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
+        Assert::AreEqual(
+            static_cast<uint64_t>(2), ctx.getLastStatistic(tp::StatisticEventType::JobBufferMemoryBarriersInserted));
+    }
+
+    TEST_METHOD(BarriersPrecomputedAccesses) {
+        static const uint64_t bufferSize = 1 << 20;
+
+        tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob(tp::JobFlag::PrecomputedAccesses);
+
+        // Same as BarriersDependentOps, but with the job-local buffers only resolved after recording
+        auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsageMask::None());
+        tp::BufferView bufferA = job.allocateLocalBuffer(bufferSetup);
+        tp::BufferView bufferB = job.allocateLocalBuffer(bufferSetup);
+
+        job.cmdFillBuffer(bufferA, 123456);
+        job.cmdCopyBuffer(bufferA, bufferB, { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+        job.cmdFillBuffer(bufferA, 654321);
+        job.cmdCopyBuffer(bufferB, bufferA, { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+
+        ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+
+        Assert::AreEqual(
+            static_cast<uint64_t>(3), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
+        Assert::AreEqual(
+            static_cast<uint64_t>(3), ctx.getLastStatistic(tp::StatisticEventType::JobBufferMemoryBarriersInserted));
+    }
+
+    TEST_METHOD(BarriersFoldedToGlobal) {
+        static const uint64_t bufferSize = 1 << 20;
+
+        // Allow at most 2 buffer memory barriers per pipeline barrier
+        tp::OverallocationBehavior noOverallocation = tp::OverallocationBehavior::Exact();
+        auto poolSetup = tp::JobResourcePoolSetup(
+            ctx.graphicsQueueCtx.queue, {}, noOverallocation, noOverallocation, noOverallocation, 2);
+        tp::OwningPtr<tp::JobResourcePool> jobResourcePool = ctx.device->createJobResourcePool(poolSetup);
+
+        auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsageMask::None());
+        tp::OwningPtr<tp::Buffer> buffers[4];
+        for (tp::OwningPtr<tp::Buffer>& buffer : buffers) {
+            buffer = ctx.device->allocateBuffer(bufferSetup, tp::MemoryPreference::Device, "TestBuffer");
+        }
+
+        // The second fills all depend on the first ones through the same pipeline barrier
+        tp::Job job = jobResourcePool->createJob();
+        for (tp::OwningPtr<tp::Buffer>& buffer : buffers) {
+            job.cmdFillBuffer(*buffer, 123456);
+        }
+        for (tp::OwningPtr<tp::Buffer>& buffer : buffers) {
+            job.cmdFillBuffer(*buffer, 654321);
+        }
+
+        tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+
+        Assert::AreEqual(
+            static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
+        Assert::AreEqual(
+            static_cast<uint64_t>(4), ctx.getLastStatistic(tp::StatisticEventType::JobBufferMemoryBarriersFolded));
+        Assert::AreEqual(
+            static_cast<uint64_t>(0), ctx.getLastStatistic(tp::StatisticEventType::JobBufferMemoryBarriersInserted));
+
+        ctx.device->waitForJobSemaphores({ semaphore });
+    }
+
+    TEST_METHOD(SubJobsMerged) {
+        static const uint32_t subJobCount = 4;
+        static const uint64_t sliceSize = 1024;
+        static const uint64_t bufferSize = subJobCount * sliceSize;
+
+        tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob();
+        tp::BufferView localBuffer = job.allocateLocalBuffer(tp::BufferSetup(bufferSize, tp::BufferUsageMask::None()));
+
+        auto readbackSetup = tp::BufferSetup(bufferSize, tp::BufferUsage::HostMapped);
+        tp::OwningPtr<tp::Buffer> readbackBuffer = ctx.device->allocateBuffer(
+            readbackSetup, tp::MemoryPreference::ReadbackStream);
+
+        std::vector<tp::Job> subJobs;
+        for (uint32_t i = 0; i < subJobCount; i++) {
+            subJobs.push_back(job.createSubJob());
+        }
+
+        // Each sub-job fills the buffer from its own slice onwards, so every slice should end up filled by the sub-job
+        // of the same index as long as they get merged in order
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < subJobCount; i++) {
+            threads.emplace_back([&subJobs, &localBuffer, i]() {
+                subJobs[i].cmdFillBuffer(localBuffer.getView(i * sliceSize, (subJobCount - i) * sliceSize), i);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        job.mergeSubJobs(tp::view(subJobs));
+        job.cmdCopyBuffer(localBuffer, *readbackBuffer, { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+        job.cmdExportResource(*readbackBuffer, tp::ReadAccess::Host);
+
+        tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+        ctx.device->waitForJobSemaphores({ semaphore });
+
+        tp::HostReadableMemory readbackMemory = readbackBuffer->mapForHostRead();
+        const uint32_t* valuePtr = readbackMemory.getPtr<uint32_t>();
+        for (uint64_t i = 0; i < bufferSize / sizeof(uint32_t); i++) {
+            Assert::AreEqual(static_cast<uint32_t>(i * sizeof(uint32_t) / sliceSize), valuePtr[i]);
+        }
+    }
+
+    TEST_METHOD(StatisticCountersAggregated) {
+        tp::StatisticCounters countersBefore = ctx.device->getStatisticCounters();
+
+        tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob();
+        tp::BufferView buffer = job.allocateLocalBuffer(tp::BufferSetup(1 << 20, tp::BufferUsageMask::None()));
+        job.cmdFillBuffer(buffer, 123456);
+
+        ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+
+        tp::StatisticCounters countersAfter = ctx.device->getStatisticCounters();
+
+        // Each phase of the job got timed exactly once
+        for (tp::StatisticEventType type : { tp::StatisticEventType::JobResourceAllocationNanoseconds,
+                                             tp::StatisticEventType::JobExportBroadcastNanoseconds,
+                                             tp::StatisticEventType::JobBarrierPreparationNanoseconds,
+                                             tp::StatisticEventType::JobCommandRecordingNanoseconds,
+                                             tp::StatisticEventType::QueueSubmitNanoseconds }) {
+            Assert::AreEqual(countersBefore.getEventCount(type) + 1, countersAfter.getEventCount(type));
+        }
+
+        // The other events get aggregated as well
+        tp::StatisticEventType bufferBytesType = tp::StatisticEventType::JobLocalBufferRequestedBytes;
+        Assert::AreEqual(
+            countersBefore.getCounterTotal(bufferBytesType) + (1 << 20),
+            countersAfter.getCounterTotal(bufferBytesType));
+    }
+
+    TEST_METHOD(ReusableJobResubmitted) {
+        static const uint64_t bufferSize = 1 << 16;
+        static const uint32_t submitCount = 3;
+
+        tp::OwningPtr<tp::Buffer> sourceBuffer = ctx.device->allocateBuffer(
+            tp::BufferSetup(bufferSize, tp::BufferUsageMask::None()), tp::MemoryPreference::Device);
+        tp::OwningPtr<tp::Buffer> readbackBuffer = ctx.device->allocateBuffer(
+            tp::BufferSetup(bufferSize, tp::BufferUsage::HostMapped), tp::MemoryPreference::ReadbackStream);
+
+        // The reusable job only reads the source buffer, its exit state assumes a transfer read
+        tp::Job reusableJob = ctx.graphicsQueueCtx.jobResourcePool->createJob(tp::JobFlag::Reusable);
+        reusableJob.cmdCopyBuffer(*sourceBuffer, *readbackBuffer, { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+        reusableJob.cmdExportResource(*readbackBuffer, tp::ReadAccess::Host);
+
+        for (uint32_t i = 0; i < submitCount; i++) {
+            // Writing the source buffer between submissions changes its state away from the compiled one, so each
+            // submission of the reusable job needs its fix-up barrier to see the new contents
+            tp::Job fillJob = ctx.graphicsQueueCtx.jobResourcePool->createJob();
+            fillJob.cmdFillBuffer(*sourceBuffer, i + 1);
+            ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(fillJob));
+
+            tp::JobSemaphore semaphore = ctx.device->enqueueReusableJob(ctx.graphicsQueueCtx.queue, reusableJob);
+            Assert::IsFalse(semaphore.isNull());
+            ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+            ctx.device->waitForJobSemaphores({ semaphore });
+
+            tp::HostReadableMemory readbackMemory = readbackBuffer->mapForHostRead();
+            const uint32_t* valuePtr = readbackMemory.getPtr<uint32_t>();
+            for (uint64_t j = 0; j < bufferSize / sizeof(uint32_t); j++) {
+                Assert::AreEqual(i + 1, valuePtr[j]);
+            }
+        }
+    }
+
+    TEST_METHOD(ReusableJobEnqueuedTwiceRejected) {
+        tp::OwningPtr<tp::Buffer> buffer = ctx.device->allocateBuffer(
+            tp::BufferSetup(1 << 16, tp::BufferUsageMask::None()), tp::MemoryPreference::Device);
+
+        tp::Job reusableJob = ctx.graphicsQueueCtx.jobResourcePool->createJob(tp::JobFlag::Reusable);
+        reusableJob.cmdFillBuffer(*buffer, 123456);
+
+        tp::JobSemaphore semaphore = ctx.device->enqueueReusableJob(ctx.graphicsQueueCtx.queue, reusableJob);
+
+        // The second enqueue would overwrite the semaphores of the first one before it got submitted
+        Assert::ExpectException<tp::UnsupportedOperationError>(
+            [&]() { ctx.device->enqueueReusableJob(ctx.graphicsQueueCtx.queue, reusableJob); });
+
+        // Once submitted, it can be enqueued again
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+        semaphore = ctx.device->enqueueReusableJob(ctx.graphicsQueueCtx.queue, reusableJob);
+        Assert::IsFalse(semaphore.isNull());
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+        ctx.device->waitForJobSemaphores({ semaphore });
+    }
+
+#ifdef TEPHRA_ENABLE_DEBUG_TEPHRA_VALIDATION
+    TEST_METHOD(ReusableJobUnsupportedCommandsRejected) {
+        tp::Job reusableJob = ctx.graphicsQueueCtx.jobResourcePool->createJob(tp::JobFlag::Reusable);
+        tp::CommandPool* commandPool = reusableJob.createCommandPool();
+        tp::TimestampQuery query;
+        ctx.device->createTimestampQueries({ &query });
+        tp::RenderQuery renderQuery;
+        ctx.device->createRenderQueries({ tp::RenderQueryType::Occlusion }, { &renderQuery });
+        uint32_t expectedErrorCount = 6;
+
+        // Queries recorded into the job's command lists are rejected just like the ones recorded into the job
+        tp::ComputeList computeList;
+        reusableJob.cmdExecuteComputePass(tp::ComputePassSetup({}, {}), tp::viewOne(computeList));
+        tp::RenderList renderList;
+        reusableJob.cmdExecuteRenderPass(
+            tp::RenderPassSetup(tp::DepthStencilAttachment(), {}, {}, {}, tp::Rect2D({ 0, 0 }, { 64, 64 })),
+            tp::viewOne(renderList));
+
+        // The job never gets enqueued, so none of these reach the device
+        ctx.testReportHandler.beginExpectingErrors();
+        reusableJob.allocateLocalBuffer(tp::BufferSetup(1 << 16, tp::BufferUsageMask::None()));
+        reusableJob.allocateLocalImage(tp::ImageSetup(
+            tp::ImageType::Image2D, tp::ImageUsage::TransferDst, tp::Format::COL32_R8G8B8A8_UNORM, { 64, 64, 1 }));
+        reusableJob.cmdWriteTimestamp(query, tp::PipelineStage::TopOfPipe);
+
+        computeList.beginRecording(commandPool);
+        computeList.cmdWriteTimestamp(query, tp::PipelineStage::BottomOfPipe);
+        computeList.endRecording();
+
+        renderList.beginRecording(commandPool);
+        renderList.cmdWriteTimestamp(query, tp::PipelineStage::BottomOfPipe);
+        renderList.cmdBeginQueries({ &renderQuery });
+        renderList.cmdEndQueries({ &renderQuery });
+        renderList.endRecording();
+        if (ctx.physicalDevice->isExtensionAvailable(tp::DeviceExtension::KHR_AccelerationStructure)) {
+            reusableJob.cmdBuildAccelerationStructuresKHR({});
+            expectedErrorCount++;
+        }
+        Assert::AreEqual(expectedErrorCount, ctx.testReportHandler.endExpectingErrors());
+    }
+
+    TEST_METHOD(ForeignSubJobMergeRejected) {
+        tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob();
+        tp::Job otherJob = ctx.graphicsQueueCtx.jobResourcePool->createJob();
+        std::vector<tp::Job> subJobs;
+        subJobs.push_back(otherJob.createSubJob());
+
+        // The foreign sub-job must be skipped rather than merged, leaving it intact for its own parent
+        ctx.testReportHandler.beginExpectingErrors();
+        job.mergeSubJobs(tp::view(subJobs));
+        Assert::AreEqual(1u, ctx.testReportHandler.endExpectingErrors());
+
+        otherJob.mergeSubJobs(tp::view(subJobs));
+    }
+#endif
+
 private:
     static TephraContext ctx;
 };
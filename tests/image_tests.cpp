@@ -317,6 +317,92 @@ public:
             format, dimSize, 6, ctx.getLastStatistic(tp::StatisticEventType::JobLocalImageCommittedBytes));
     }
 
+    TEST_METHOD(JobLocalAliasImageMemory) {
+        tp::Format format = tp::Format::COL32_R8G8B8A8_SRGB;
+        uint32_t dimSize = 1024;
+
+        // Test whether images of different sizes and non-overlapping execution can share the same memory when
+        // placed into memory blocks
+        tp::OwningPtr<tp::JobResourcePool> jobResourcePool = ctx.device->createJobResourcePool(
+            tp::JobResourcePoolSetup(ctx.graphicsQueueCtx.queue, tp::JobResourcePoolFlag::AliasImageMemory));
+
+        tp::Job job = jobResourcePool->createJob();
+        auto imageSetup = tp::ImageSetup(
+            tp::ImageType::Image2D,
+            tp::ImageUsage::TransferSrc | tp::ImageUsage::TransferDst,
+            format,
+            { dimSize, dimSize, 1 });
+        tp::ImageView imageA = job.allocateLocalImage(imageSetup);
+        imageSetup.extent = { dimSize / 2, dimSize / 2, 1 };
+        tp::ImageView imageB = job.allocateLocalImage(imageSetup);
+        imageSetup.extent = { dimSize / 4, dimSize / 4, 1 };
+        tp::ImageView imageC = job.allocateLocalImage(imageSetup);
+
+        job.cmdClearImage(imageA, tp::ClearValue::ColorFloat(1.0f, 0.0f, 1.0f, 0.0f));
+        job.cmdClearImage(imageB, tp::ClearValue::ColorFloat(0.0f, 1.0f, 1.0f, 0.0f));
+        job.cmdClearImage(imageC, tp::ClearValue::ColorFloat(1.0f, 1.0f, 0.0f, 0.0f));
+
+        ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+
+        // All three images should fit in the memory of the largest one
+        uint64_t requestedBytes = ctx.getLastStatistic(tp::StatisticEventType::JobLocalImageRequestedBytes);
+        uint64_t committedBytes = ctx.getLastStatistic(tp::StatisticEventType::JobLocalImageCommittedBytes);
+        testExpected2DImageSize(format, dimSize, 1, committedBytes);
+        Assert::IsTrue(committedBytes < requestedBytes);
+
+        ctx.device->waitForIdle();
+    }
+
+    TEST_METHOD(JobLocalAliasImageMemoryOrdered) {
+        static const uint32_t dimSize = 256;
+        static const uint64_t imageBytes = dimSize * dimSize;
+
+        // Test that the layout transition of an image placed into memory previously used by another image doesn't
+        // overwrite the memory while the other image is still being accessed
+        tp::OwningPtr<tp::JobResourcePool> jobResourcePool = ctx.device->createJobResourcePool(
+            tp::JobResourcePoolSetup(ctx.graphicsQueueCtx.queue, tp::JobResourcePoolFlag::AliasImageMemory));
+
+        tp::Job job = jobResourcePool->createJob();
+        auto imageSetup = tp::ImageSetup(
+            tp::ImageType::Image2D,
+            tp::ImageUsage::TransferSrc | tp::ImageUsage::TransferDst,
+            tp::Format::COL8_R8_UINT,
+            { dimSize, dimSize, 1 });
+        tp::ImageView imageA = job.allocateLocalImage(imageSetup);
+        tp::ImageView imageB = job.allocateLocalImage(imageSetup);
+
+        auto readbackSetup = tp::BufferSetup(imageBytes, tp::BufferUsage::HostMapped | tp::BufferUsage::ImageTransfer);
+        tp::OwningPtr<tp::Buffer> readbackBufferA = ctx.device->allocateBuffer(
+            readbackSetup, tp::MemoryPreference::ReadbackStream);
+        tp::OwningPtr<tp::Buffer> readbackBufferB = ctx.device->allocateBuffer(
+            readbackSetup, tp::MemoryPreference::ReadbackStream);
+        auto copyRegion = tp::BufferImageCopyRegion(0, imageA.getWholeRange().pickMipLevel(0), {}, imageA.getExtent());
+
+        // Image B is only used after image A, so they get the same memory
+        job.cmdClearImage(imageA, tp::ClearValue::ColorUInt(1, 0, 0, 0));
+        job.cmdCopyImageToBuffer(imageA, *readbackBufferA, { copyRegion });
+        job.cmdClearImage(imageB, tp::ClearValue::ColorUInt(2, 0, 0, 0));
+        job.cmdCopyImageToBuffer(imageB, *readbackBufferB, { copyRegion });
+        job.cmdExportResource(*readbackBufferA, tp::ReadAccess::Host);
+        job.cmdExportResource(*readbackBufferB, tp::ReadAccess::Host);
+
+        tp::JobSemaphore semaphore = ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+        ctx.device->waitForJobSemaphores({ semaphore });
+
+        uint64_t requestedBytes = ctx.getLastStatistic(tp::StatisticEventType::JobLocalImageRequestedBytes);
+        uint64_t committedBytes = ctx.getLastStatistic(tp::StatisticEventType::JobLocalImageCommittedBytes);
+        Assert::IsTrue(committedBytes < requestedBytes);
+
+        tp::HostReadableMemory readbackMemoryA = readbackBufferA->mapForHostRead();
+        tp::HostReadableMemory readbackMemoryB = readbackBufferB->mapForHostRead();
+        const uint8_t* valuePtrA = readbackMemoryA.getPtr<uint8_t>();
+        const uint8_t* valuePtrB = readbackMemoryB.getPtr<uint8_t>();
+        Assert::IsTrue(std::all_of(valuePtrA, valuePtrA + imageBytes, [](uint8_t value) { return value == 1; }));
+        Assert::IsTrue(std::all_of(valuePtrB, valuePtrB + imageBytes, [](uint8_t value) { return value == 2; }));
+    }
+
     TEST_METHOD(ImageLayouts) {
         // Test that barriers with image layout transitions are inserted where expected
         auto imageSetup = tp::ImageSetup(
@@ -350,6 +436,7 @@ public:
         job.cmdCopyImage(layer0, layer1, { copyRegion });
 
         // No barrier here for layer 0, already in correct layout, layer2 memory barrier can extend previous barriers
+        // and gets merged with the one of layer1
         job.cmdCopyImage(layer0, layer2, { copyRegion });
 
         // Discard sets image layout to undefined, no barrier expected for this
@@ -364,7 +451,38 @@ public:
         Assert::AreEqual(
             static_cast<uint64_t>(3), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
         Assert::AreEqual(
-            static_cast<uint64_t>(6), ctx.getLastStatistic(tp::StatisticEventType::JobImageMemoryBarriersInserted));
+            static_cast<uint64_t>(5), ctx.getLastStatistic(tp::StatisticEventType::JobImageMemoryBarriersInserted));
+    }
+
+    TEST_METHOD(ImageBarriersMerged) {
+        static const uint32_t arrayLayerCount = 8;
+
+        auto imageSetup = tp::ImageSetup(
+            tp::ImageType::Image2D,
+            tp::ImageUsage::TransferSrc | tp::ImageUsage::TransferDst,
+            tp::Format::COL32_R8G8B8A8_SRGB,
+            { 256, 256, 1 },
+            4,
+            arrayLayerCount);
+
+        tp::Job job = ctx.graphicsQueueCtx.jobResourcePool->createJob();
+        tp::ImageView image = job.allocateLocalImage(imageSetup);
+
+        // Each clear transitions its own layer, but all of them share the first barrier
+        for (uint32_t layer = 0; layer < arrayLayerCount; layer++) {
+            tp::ImageView layerView = image.createView(
+                tp::ImageViewSetup(tp::ImageViewType::View2D, { tp::ImageAspect::Color, 0, ~0u, layer, 1 }));
+            job.cmdClearImage(layerView, tp::ClearValue::ColorFloat(1.0f, 0.0f, 0.0f, 0.0f));
+        }
+
+        ctx.device->enqueueJob(ctx.graphicsQueueCtx.queue, std::move(job));
+        ctx.device->submitQueuedJobs(ctx.graphicsQueueCtx.queue);
+
+        // The transitions of contiguous layers get merged into one image memory barrier
+        Assert::AreEqual(
+            static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobPipelineBarriersInserted));
+        Assert::AreEqual(
+            static_cast<uint64_t>(1), ctx.getLastStatistic(tp::StatisticEventType::JobImageMemoryBarriersInserted));
     }
 
     TEST_METHOD(ImageMipmapCreation) {
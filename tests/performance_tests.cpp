@@ -0,0 +1,506 @@
+#include "tests_common.hpp"
+#include "../src/tephra/utils/flat_interval_map.hpp"
+#include "../src/tephra/utils/interval_tree.hpp"
+#include "../src/tephra/device/cross_queue_sync.hpp"
+#include "../src/tephra/job/aliasing_suballocator.hpp"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace TephraIntegrationTests {
+
+// Simplified buffer range with the same ordering semantics as the one used by the access maps
+struct BenchmarkRange {
+    uint64_t offset;
+    uint64_t size;
+
+    BenchmarkRange(uint64_t offset, uint64_t size) : offset(offset), size(size) {}
+
+    uint64_t getStartPoint() const {
+        return offset;
+    }
+
+    uint64_t getEndPoint() const {
+        return offset + size;
+    }
+
+    bool operator<(const BenchmarkRange& other) const {
+        return getEndPoint() <= other.getStartPoint();
+    }
+};
+
+struct BenchmarkValue {
+    uint32_t accessMask;
+    uint32_t barrierIndex;
+
+    bool operator==(const BenchmarkValue& other) const {
+        return accessMask == other.accessMask && barrierIndex == other.barrierIndex;
+    }
+};
+
+// Reference implementation of range assignment over std::map, matching how the buffer access map used to work
+inline void assignMapRange(
+    std::map<BenchmarkRange, BenchmarkValue>& map,
+    BenchmarkRange range,
+    BenchmarkValue value) {
+    auto rangeIts = map.equal_range(range);
+    auto it = rangeIts.first;
+    while (it != rangeIts.second) {
+        BenchmarkRange entryRange = it->first;
+        BenchmarkValue entryValue = it->second;
+        it = map.erase(it);
+        if (entryRange.getStartPoint() < range.getStartPoint()) {
+            map.emplace_hint(
+                it, BenchmarkRange(entryRange.offset, range.getStartPoint() - entryRange.offset), entryValue);
+        }
+        if (entryRange.getEndPoint() > range.getEndPoint()) {
+            map.emplace_hint(
+                it,
+                BenchmarkRange(range.getEndPoint(), entryRange.getEndPoint() - range.getEndPoint()),
+                entryValue);
+        }
+    }
+    map.emplace_hint(rangeIts.second, range, value);
+}
+
+// Reference implementation of the export registry that the per-queue export logs replaced: a single lock around
+// a map of the exports of each resource, with a fixed size cache of recent exports sorted by timestamp
+class ReferenceExportRegistry {
+public:
+    using ExportEntry = tp::QueueExportLog::ExportEntry;
+
+    void broadcastExport(const ExportEntry& exportEntry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tp::VkBufferHandle vkBufferHandle = std::get<tp::NewBufferAccess>(exportEntry.access).vkResourceHandle;
+        exportedResources[vkBufferHandle].push_back(exportEntry);
+
+        if (exportCache.size() >= ExportCacheSize)
+            exportCache.pop_front();
+        auto insertIt = exportCache.rbegin();
+        for (; insertIt != exportCache.rend(); ++insertIt) {
+            if (insertIt->first <= exportEntry.semaphore.timestamp)
+                break;
+        }
+        exportCache.insert(insertIt.base(), { exportEntry.semaphore.timestamp, vkBufferHandle });
+    }
+
+    void queryExports(
+        const tp::TimelinePeriod& period,
+        uint32_t dstQueueFamilyIndex,
+        tp::ScratchVector<ExportEntry>& incomingExports) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto processExports = [&](std::vector<ExportEntry>& resourceEntry) {
+            for (ExportEntry& exportEntry : resourceEntry) {
+                if (exportEntry.dstQueueFamilyIndex == dstQueueFamilyIndex &&
+                    exportEntry.semaphore.queue == period.srcQueue &&
+                    exportEntry.semaphore.timestamp > period.fromTimestamp &&
+                    exportEntry.semaphore.timestamp <= period.toTimestamp) {
+                    incomingExports.push_back(exportEntry);
+                    exportEntry.currentQueueFamilyIndex = exportEntry.dstQueueFamilyIndex;
+                }
+            }
+        };
+
+        auto comp = [](uint64_t value, const auto& element) { return value < element.first; };
+        auto startIt = std::upper_bound(exportCache.begin(), exportCache.end(), period.fromTimestamp, comp);
+        if (startIt == exportCache.begin() && exportCache.size() >= ExportCacheSize) {
+            for (auto& [vkBufferHandle, resourceEntry] : exportedResources)
+                processExports(resourceEntry);
+        } else {
+            for (auto it = startIt; it != exportCache.end() && it->first <= period.toTimestamp; ++it) {
+                processExports(exportedResources[it->second]);
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t ExportCacheSize = 1024;
+
+    std::unordered_map<tp::VkBufferHandle, std::vector<ExportEntry>> exportedResources;
+    std::deque<std::pair<uint64_t, tp::VkBufferHandle>> exportCache;
+    std::mutex mutex;
+};
+
+// Reference implementation of the aliasing suballocator that walked all previous allocations sorted by offset for every
+// new one and placed it at the first fitting offset, for a single unbounded backing allocation
+class ReferenceAliasingSuballocator {
+public:
+    uint64_t allocate(uint64_t requiredSize, tp::ResourceUsageRange usageRange, uint64_t requiredAlignment) {
+        uint64_t offset = 0;
+        std::size_t sortedIndex = 0;
+        for (std::size_t i = 0; i < allocations.size(); i++) {
+            const Allocation& otherAllocation = allocations[i];
+            if (!usageRange.isOverlapping(otherAllocation.usageRange))
+                continue;
+            if (offset + requiredSize <= otherAllocation.offset)
+                break;
+
+            uint64_t unalignedOffset = otherAllocation.offset + otherAllocation.size;
+            offset = tp::roundUpToPoTMultiple(unalignedOffset, requiredAlignment);
+            sortedIndex = i + 1;
+        }
+
+        allocations.insert(allocations.begin() + sortedIndex, { usageRange, offset, requiredSize });
+        usedSize = tp::max(usedSize, offset + requiredSize);
+        return offset;
+    }
+
+    uint64_t getUsedSize() const {
+        return usedSize;
+    }
+
+private:
+    struct Allocation {
+        tp::ResourceUsageRange usageRange;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    std::vector<Allocation> allocations;
+    uint64_t usedSize = 0;
+};
+
+template <typename TFunc>
+double measureMilliseconds(TFunc func) {
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Microbenchmarks of internal data structures. They report their timings to the test log and only check that the
+// compared implementations produce equivalent results.
+TEST_CLASS(PerformanceTests) {
+public:
+    TEST_METHOD(BufferAccessRangeContainers) {
+        constexpr uint64_t RangeCount = 10000;
+        constexpr uint64_t RangeSize = 256;
+        constexpr uint64_t LookupCount = 100000;
+
+        // Generate suballocation-like accesses in random order, with a few larger ones spanning multiple ranges
+        std::mt19937 rng(1234);
+        std::vector<std::pair<BenchmarkRange, BenchmarkValue>> accesses;
+        for (uint64_t i = 0; i < RangeCount; i++) {
+            uint64_t rangeCount = (i % 16 == 0) ? 4 : 1;
+            auto range = BenchmarkRange((rng() % RangeCount) * RangeSize, rangeCount * RangeSize);
+            accesses.push_back({ range, BenchmarkValue{ static_cast<uint32_t>(rng() % 4), 0 } });
+        }
+        std::vector<BenchmarkRange> lookups;
+        for (uint64_t i = 0; i < LookupCount; i++) {
+            lookups.push_back(BenchmarkRange((rng() % RangeCount) * RangeSize + rng() % RangeSize, 1));
+        }
+
+        auto wholeRange = BenchmarkRange(0, ~0ull);
+        auto defaultValue = BenchmarkValue{ 0, 0 };
+
+        std::map<BenchmarkRange, BenchmarkValue> referenceMap;
+        uint64_t referenceSum = 0;
+        double referenceInsertTime = measureMilliseconds([&]() {
+            referenceMap.emplace(wholeRange, defaultValue);
+            for (const auto& [range, value] : accesses) {
+                assignMapRange(referenceMap, range, value);
+            }
+        });
+        double referenceLookupTime = measureMilliseconds([&]() {
+            for (const BenchmarkRange& range : lookups) {
+                auto rangeIts = referenceMap.equal_range(range);
+                for (auto it = rangeIts.first; it != rangeIts.second; ++it) {
+                    referenceSum += it->second.accessMask;
+                }
+            }
+        });
+
+        tp::FlatIntervalMap<BenchmarkRange, BenchmarkValue> flatMap;
+        uint64_t flatSum = 0;
+        double flatInsertTime = measureMilliseconds([&]() {
+            flatMap.assign(wholeRange, defaultValue);
+            for (const auto& [range, value] : accesses) {
+                flatMap.assign(range, value);
+            }
+        });
+        double flatLookupTime = measureMilliseconds([&]() {
+            for (const BenchmarkRange& range : lookups) {
+                auto [firstIt, lastIt] = flatMap.findOverlapping(range);
+                for (auto it = firstIt; it != lastIt; ++it) {
+                    flatSum += it->value.accessMask;
+                }
+            }
+        });
+
+        std::string report = "std::map: " + std::to_string(referenceMap.size()) + " ranges, insert " +
+            std::to_string(referenceInsertTime) + " ms, lookup " + std::to_string(referenceLookupTime) + " ms\n" +
+            "FlatIntervalMap: " + std::to_string(flatMap.size()) + " ranges, insert " +
+            std::to_string(flatInsertTime) + " ms, lookup " + std::to_string(flatLookupTime) + " ms\n";
+        Logger::WriteMessage(report.c_str());
+
+        // Both containers must describe the same state, the flat one just merges identical neighbors
+        Assert::AreEqual(referenceSum, flatSum);
+        Assert::IsTrue(flatMap.size() <= referenceMap.size());
+    }
+
+    TEST_METHOD(ImageAccessLayerIndex) {
+        constexpr uint32_t LayerCount = 2048;
+        constexpr uint32_t MipLevelCount = 8;
+        constexpr uint32_t LookupCount = 100000;
+
+        // Simulate per-layer, per-mip streaming into a large texture array
+        struct LayerRange {
+            uint32_t baseLayer;
+            uint32_t layerCount;
+            uint32_t mipMask;
+        };
+        std::vector<LayerRange> ranges;
+        for (uint32_t layer = 0; layer < LayerCount; layer++) {
+            for (uint32_t mip = 0; mip < MipLevelCount; mip++) {
+                ranges.push_back({ layer, 1, 1u << mip });
+            }
+        }
+        std::mt19937 rng(1234);
+        std::vector<LayerRange> lookups;
+        for (uint32_t i = 0; i < LookupCount; i++) {
+            uint32_t baseLayer = rng() % LayerCount;
+            lookups.push_back({ baseLayer, static_cast<uint32_t>(1 + rng() % 4), 1u << (rng() % MipLevelCount) });
+        }
+
+        auto isOverlapping = [](const LayerRange& a, const LayerRange& b) {
+            return a.baseLayer < b.baseLayer + b.layerCount && b.baseLayer < a.baseLayer + a.layerCount &&
+                (a.mipMask & b.mipMask) != 0;
+        };
+
+        uint64_t linearSum = 0;
+        double linearLookupTime = measureMilliseconds([&]() {
+            for (const LayerRange& lookup : lookups) {
+                for (uint32_t i = 0; i < ranges.size(); i++) {
+                    if (isOverlapping(lookup, ranges[i]))
+                        linearSum += i;
+                }
+            }
+        });
+
+        tp::IntervalTree<uint32_t> tree;
+        std::vector<uint32_t> foundIds;
+        uint64_t treeSum = 0;
+        double treeInsertTime = measureMilliseconds([&]() {
+            for (uint32_t i = 0; i < ranges.size(); i++) {
+                tree.insert(i, ranges[i].baseLayer, ranges[i].baseLayer + ranges[i].layerCount, ranges[i].mipMask);
+            }
+        });
+        double treeLookupTime = measureMilliseconds([&]() {
+            for (const LayerRange& lookup : lookups) {
+                foundIds.clear();
+                tree.findOverlapping(lookup.baseLayer, lookup.baseLayer + lookup.layerCount, lookup.mipMask, foundIds);
+                for (uint32_t id : foundIds) {
+                    treeSum += id;
+                }
+            }
+        });
+
+        std::string report = "Linear scan: " + std::to_string(ranges.size()) + " ranges, lookup " +
+            std::to_string(linearLookupTime) + " ms\n" + "IntervalTree: insert " + std::to_string(treeInsertTime) +
+            " ms, lookup " + std::to_string(treeLookupTime) + " ms\n";
+        Logger::WriteMessage(report.c_str());
+
+        Assert::AreEqual(linearSum, treeSum);
+    }
+
+    TEST_METHOD(AliasingSuballocatorPacking) {
+        constexpr uint32_t BufferCount = 5000;
+        constexpr uint64_t CommandCount = 20000;
+        constexpr uint64_t Alignment = 256;
+
+        // Generate job-local buffer requests of varying sizes, most of them short-lived with a few used for a large
+        // part of the job
+        struct BufferRequest {
+            uint64_t size;
+            tp::ResourceUsageRange usage;
+        };
+        std::mt19937 rng(1234);
+        std::vector<BufferRequest> requests;
+        for (uint32_t i = 0; i < BufferCount; i++) {
+            BufferRequest request;
+            request.size = (Alignment << (rng() % 12)) + (rng() % 16) * Alignment;
+            uint64_t usageLength = (i % 32 == 0) ? rng() % CommandCount : rng() % 200;
+            request.usage.firstUsage = rng() % CommandCount;
+            request.usage.lastUsage = tp::min(request.usage.firstUsage + usageLength, CommandCount - 1);
+            requests.push_back(request);
+        }
+
+        // Checks that no two buffers with overlapping usage got overlapping memory
+        auto validateOffsets = [&](const std::vector<BufferRequest>& allocated, const std::vector<uint64_t>& offsets) {
+            for (std::size_t i = 0; i < allocated.size(); i++) {
+                for (std::size_t j = i + 1; j < allocated.size(); j++) {
+                    if (allocated[i].usage.isOverlapping(allocated[j].usage)) {
+                        Assert::IsTrue(
+                            offsets[i] + allocated[i].size <= offsets[j] ||
+                            offsets[j] + allocated[j].size <= offsets[i]);
+                    }
+                }
+            }
+        };
+
+        // The reference allocates buffers sorted only by their size, like the job-local buffer allocator used to
+        std::vector<BufferRequest> referenceRequests = requests;
+        std::vector<uint64_t> referenceOffsets;
+        ReferenceAliasingSuballocator referenceSuballocator;
+        double referenceTime = measureMilliseconds([&]() {
+            std::stable_sort(
+                referenceRequests.begin(),
+                referenceRequests.end(),
+                [](const BufferRequest& left, const BufferRequest& right) { return left.size > right.size; });
+            for (const BufferRequest& request : referenceRequests) {
+                referenceOffsets.push_back(referenceSuballocator.allocate(request.size, request.usage, Alignment));
+            }
+        });
+
+        std::vector<BufferRequest> sortedRequests = requests;
+        std::vector<uint64_t> offsets;
+        std::unique_ptr<tp::AliasingSuballocator> suballocator;
+        double time = measureMilliseconds([&]() {
+            std::sort(sortedRequests.begin(), sortedRequests.end(), [](const auto& left, const auto& right) {
+                return tp::AliasingSuballocator::isAllocatedBefore(left.size, left.usage, right.size, right.usage);
+            });
+            suballocator = std::make_unique<tp::AliasingSuballocator>(tp::ArrayParameter<const uint64_t>());
+            for (const BufferRequest& request : sortedRequests) {
+                auto [backingIndex, offset] = suballocator->allocate(request.size, request.usage, Alignment);
+                Assert::AreEqual(0u, backingIndex);
+                offsets.push_back(offset);
+            }
+        });
+
+        std::string report = "First-fit linear scan: " + std::to_string(referenceTime) + " ms, used size " +
+            std::to_string(referenceSuballocator.getUsedSize()) + " bytes\n" + "Best-fit interval tree: " +
+            std::to_string(time) + " ms, used size " + std::to_string(suballocator->getUsedSize()) + " bytes\n";
+        Logger::WriteMessage(report.c_str());
+
+        validateOffsets(referenceRequests, referenceOffsets);
+        validateOffsets(sortedRequests, offsets);
+    }
+
+    TEST_METHOD(CrossQueueExportLog) {
+        constexpr uint32_t QueueCount = 8;
+        constexpr uint32_t ExportsPerSecond = 10000;
+        constexpr uint32_t FrameCount = 60;
+        constexpr uint32_t ExportsPerFrame = ExportsPerSecond / FrameCount;
+
+        // Simulate a second of async streaming, where each queue signals one job per frame that exports freshly
+        // streamed buffers to the next queue, while querying the exports of the other queues that it has caught up to.
+        // The timestamps are global across queues, the same as the ones assigned by the timeline manager
+        std::vector<tp::DeviceQueue> queues;
+        std::vector<uint32_t> queueFamilyIndices;
+        for (uint32_t queueIndex = 0; queueIndex < QueueCount; queueIndex++) {
+            queues.push_back(tp::DeviceQueue(tp::QueueType::Compute, queueIndex));
+            queueFamilyIndices.push_back(queueIndex % 2);
+        }
+        auto getTimestamp = [](uint32_t frameIndex, uint32_t queueIndex) -> uint64_t {
+            return static_cast<uint64_t>(frameIndex) * QueueCount + queueIndex + 1;
+        };
+        auto makeExport = [&](uint32_t frameIndex, uint32_t queueIndex, uint32_t exportIndex) {
+            uint64_t bufferIndex = (static_cast<uint64_t>(frameIndex) * QueueCount + queueIndex) * ExportsPerFrame +
+                exportIndex + 1;
+            auto vkBufferHandle = tp::VkBufferHandle(reinterpret_cast<VkBuffer>(bufferIndex));
+            tp::JobSemaphore semaphore;
+            semaphore.queue = queues[queueIndex];
+            semaphore.timestamp = getTimestamp(frameIndex, queueIndex);
+            auto access = tp::NewBufferAccess(
+                vkBufferHandle,
+                static_cast<uint32_t>(bufferIndex),
+                tp::BufferAccessRange(0, 1 << 16),
+                tp::ResourceAccess(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT));
+            uint32_t dstQueueIndex = (queueIndex + 1) % QueueCount;
+            return tp::QueueExportLog::ExportEntry{
+                semaphore, access, queueFamilyIndices[queueIndex], queueFamilyIndices[dstQueueIndex]
+            };
+        };
+
+        // Runs the simulation on a thread per queue, returning the number of incoming exports seen by each queue
+        auto simulate = [&](auto broadcastExport, auto queryExports) {
+            std::vector<std::atomic<uint32_t>> exportedFrameCounts(QueueCount);
+            std::vector<uint64_t> incomingCounts(QueueCount, 0);
+            std::vector<std::thread> threads;
+            for (uint32_t queueIndex = 0; queueIndex < QueueCount; queueIndex++) {
+                threads.emplace_back([&, queueIndex]() {
+                    std::vector<uint64_t> queriedTimestamps(QueueCount, 0);
+                    auto queryCaughtUpExports = [&]() {
+                        tp::ScratchVector<tp::QueueExportLog::ExportEntry> incomingExports;
+                        for (uint32_t srcQueueIndex = 0; srcQueueIndex < QueueCount; srcQueueIndex++) {
+                            uint32_t srcFrameCount = exportedFrameCounts[srcQueueIndex].load();
+                            if (srcFrameCount == 0)
+                                continue;
+                            tp::TimelinePeriod period;
+                            period.srcQueue = queues[srcQueueIndex];
+                            period.fromTimestamp = queriedTimestamps[srcQueueIndex];
+                            period.toTimestamp = getTimestamp(srcFrameCount - 1, srcQueueIndex);
+                            if (period.toTimestamp > period.fromTimestamp) {
+                                queryExports(period, queueIndex, incomingExports);
+                                queriedTimestamps[srcQueueIndex] = period.toTimestamp;
+                            }
+                        }
+                        incomingCounts[queueIndex] += incomingExports.size();
+                    };
+
+                    for (uint32_t frameIndex = 0; frameIndex < FrameCount; frameIndex++) {
+                        for (uint32_t exportIndex = 0; exportIndex < ExportsPerFrame; exportIndex++) {
+                            broadcastExport(makeExport(frameIndex, queueIndex, exportIndex));
+                        }
+                        exportedFrameCounts[queueIndex].store(frameIndex + 1);
+                        queryCaughtUpExports();
+                    }
+
+                    // Wait for the other queues to finish before catching up on the rest of their exports
+                    for (uint32_t srcQueueIndex = 0; srcQueueIndex < QueueCount; srcQueueIndex++) {
+                        while (exportedFrameCounts[srcQueueIndex].load() < FrameCount)
+                            std::this_thread::yield();
+                    }
+                    queryCaughtUpExports();
+                });
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            return incomingCounts;
+        };
+
+        ReferenceExportRegistry referenceRegistry;
+        std::vector<uint64_t> referenceCounts;
+        double referenceTime = measureMilliseconds([&]() {
+            referenceCounts = simulate(
+                [&](const auto& exportEntry) { referenceRegistry.broadcastExport(exportEntry); },
+                [&](const tp::TimelinePeriod& period, uint32_t dstQueueIndex, auto& incomingExports) {
+                    referenceRegistry.queryExports(period, queueFamilyIndices[dstQueueIndex], incomingExports);
+                });
+        });
+
+        std::vector<std::unique_ptr<tp::QueueExportLog>> exportLogs;
+        for (uint32_t queueIndex = 0; queueIndex < QueueCount; queueIndex++) {
+            exportLogs.push_back(std::make_unique<tp::QueueExportLog>(queueFamilyIndices));
+        }
+        std::vector<uint64_t> logCounts;
+        double logTime = measureMilliseconds([&]() {
+            logCounts = simulate(
+                [&](const auto& exportEntry) {
+                    exportLogs[exportEntry.semaphore.queue.index]->addExport(exportEntry);
+                },
+                [&](const tp::TimelinePeriod& period, uint32_t dstQueueIndex, auto& incomingExports) {
+                    exportLogs[period.srcQueue.index]->queryExports(
+                        period.fromTimestamp, period.toTimestamp, dstQueueIndex, incomingExports);
+                });
+        });
+
+        std::string report = "Global export registry: " + std::to_string(referenceTime) + " ms\n" +
+            "Per-queue export logs: " + std::to_string(logTime) + " ms\n";
+        Logger::WriteMessage(report.c_str());
+
+        // Every queue must see all the exports meant for its family exactly once
+        uint64_t familyExportCount = static_cast<uint64_t>(QueueCount / 2) * FrameCount * ExportsPerFrame;
+        for (uint32_t queueIndex = 0; queueIndex < QueueCount; queueIndex++) {
+            Assert::AreEqual(familyExportCount, referenceCounts[queueIndex]);
+            Assert::AreEqual(familyExportCount, logCounts[queueIndex]);
+        }
+    }
+};
+
+}
@@ -100,6 +100,160 @@ public:
             device->createJobResourcePool(setup)->createJob().createCommandPool();
         }
     }
+
+    TEST_METHOD(BackgroundCompilation) {
+        static const uint64_t bufferSize = 1 << 16;
+        static const uint32_t jobCount = 4;
+        TestReportHandler debugHandler;
+
+        tp::ApplicationSetup appSetup;
+        appSetup.debugReportHandler = &debugHandler;
+        tp::OwningPtr<tp::Application> app = tp::Application::createApplication(appSetup);
+
+        tp::ArrayView<const tp::PhysicalDevice> physicalDevices = app->getPhysicalDevices();
+        Assert::AreNotEqual(static_cast<std::size_t>(0), physicalDevices.size());
+
+        tp::DeviceQueue queues[] = { tp::DeviceQueue(tp::QueueType::Compute, 0), tp::QueueType::Graphics };
+
+        auto deviceSetup = tp::DeviceSetup(&physicalDevices[0], view(queues));
+        deviceSetup.backgroundCompileQueues = view(queues);
+        tp::OwningPtr<tp::Device> device = app->createDevice(deviceSetup);
+
+        auto bufferSetup = tp::BufferSetup(bufferSize, tp::BufferUsage::HostMapped);
+        tp::OwningPtr<tp::Buffer> buffer = device->allocateBuffer(
+            bufferSetup, tp::MemoryPreference::Host, "TestBuffer");
+        tp::OwningPtr<tp::JobResourcePool> jobResourcePool = device->createJobResourcePool(
+            tp::JobResourcePoolSetup(queues[0]));
+
+        // Each job overwrites the value written by the previous one, so they must get compiled and submitted in order
+        tp::JobSemaphore lastSemaphore;
+        for (uint32_t jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+            tp::Job job = jobResourcePool->createJob();
+            job.cmdFillBuffer(*buffer, jobIndex);
+            job.cmdExportResource(*buffer, tp::ReadAccess::Host);
+            lastSemaphore = device->enqueueJob(queues[0], std::move(job));
+        }
+
+        device->submitQueuedJobs(queues[0]);
+        device->waitForJobSemaphores({ lastSemaphore });
+
+        tp::HostReadableMemory readAccess = buffer->mapForHostRead();
+        Assert::IsFalse(readAccess.isNull());
+        for (uint32_t value : readAccess.getArrayView<uint32_t>()) {
+            Assert::AreEqual(jobCount - 1, value);
+        }
+        readAccess = {};
+
+        // A resource exported from another queue gets acquired when the semaphore is passed to enqueueJob
+        tp::OwningPtr<tp::Buffer> sharedBuffer = device->allocateBuffer(
+            tp::BufferSetup(bufferSize, tp::BufferUsageMask::None()), tp::MemoryPreference::Device, "SharedBuffer");
+        tp::OwningPtr<tp::JobResourcePool> graphicsJobResourcePool = device->createJobResourcePool(
+            tp::JobResourcePoolSetup(queues[1]));
+        {
+            tp::Job job = graphicsJobResourcePool->createJob();
+            job.cmdFillBuffer(*sharedBuffer, 123456);
+            job.cmdExportResource(*sharedBuffer, tp::ReadAccess::Transfer, tp::QueueType::Compute);
+            tp::JobSemaphore exportSemaphore = device->enqueueJob(queues[1], std::move(job));
+            device->submitQueuedJobs(queues[1]);
+
+            tp::Job copyJob = jobResourcePool->createJob();
+            copyJob.cmdCopyBuffer(*sharedBuffer, *buffer, { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+            copyJob.cmdExportResource(*buffer, tp::ReadAccess::Host);
+            lastSemaphore = device->enqueueJob(queues[0], std::move(copyJob), { exportSemaphore });
+        }
+
+        // Resources can be destroyed and the pool trimmed while the jobs using them are still being compiled
+        {
+            tp::OwningPtr<tp::Buffer> tempBuffer = device->allocateBuffer(
+                tp::BufferSetup(bufferSize, tp::BufferUsageMask::None()), tp::MemoryPreference::Device, "TempBuffer");
+            for (uint32_t jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+                tp::Job job = jobResourcePool->createJob();
+                tp::BufferView localBuffer = job.allocateLocalBuffer(
+                    tp::BufferSetup(bufferSize, tp::BufferUsageMask::None()));
+                job.cmdFillBuffer(*tempBuffer, jobIndex);
+                job.cmdCopyBuffer(*tempBuffer, localBuffer, { tp::BufferCopyRegion{ 0, 0, bufferSize } });
+                lastSemaphore = device->enqueueJob(queues[0], std::move(job));
+            }
+        }
+        jobResourcePool->trim();
+
+        device->submitQueuedJobs(queues[0]);
+        device->waitForJobSemaphores({ lastSemaphore });
+
+        readAccess = buffer->mapForHostRead();
+        for (uint32_t value : readAccess.getArrayView<uint32_t>()) {
+            Assert::AreEqual(123456u, value);
+        }
+    }
+
+    TEST_METHOD(ParallelRecording) {
+        static const uint64_t regionSize = 1 << 12;
+        static const uint32_t regionCount = 32;
+        static const uint32_t jobCount = 8;
+        TestReportHandler debugHandler;
+
+        tp::ApplicationSetup appSetup;
+        appSetup.debugReportHandler = &debugHandler;
+        tp::OwningPtr<tp::Application> app = tp::Application::createApplication(appSetup);
+
+        tp::ArrayView<const tp::PhysicalDevice> physicalDevices = app->getPhysicalDevices();
+        Assert::AreNotEqual(static_cast<std::size_t>(0), physicalDevices.size());
+
+        // Records the same large jobs on a device with the given number of recording threads and returns the result.
+        // The jobs get compiled in parallel, each recording its own segments on the same threads
+        auto runJobs = [&](uint32_t recordingThreadCount) {
+            tp::DeviceQueue queue = tp::QueueType::Graphics;
+            auto deviceSetup = tp::DeviceSetup(&physicalDevices[0], tp::viewOne(queue));
+            deviceSetup.recordingThreadCount = recordingThreadCount;
+            tp::OwningPtr<tp::Device> device = app->createDevice(deviceSetup);
+
+            auto bufferSetup = tp::BufferSetup(regionSize * regionCount, tp::BufferUsage::HostMapped);
+            tp::OwningPtr<tp::Buffer> hostBuffer = device->allocateBuffer(
+                bufferSetup, tp::MemoryPreference::Host, "HostBuffer");
+            tp::OwningPtr<tp::Buffer> tempBuffer = device->allocateBuffer(
+                tp::BufferSetup(regionSize * regionCount, tp::BufferUsageMask::None()),
+                tp::MemoryPreference::Device,
+                "TempBuffer");
+            tp::OwningPtr<tp::JobResourcePool> jobResourcePool = device->createJobResourcePool(
+                tp::JobResourcePoolSetup(queue));
+
+            // Each copy depends on the fill before it, so every region adds barriers to cut the jobs at. Later jobs
+            // overwrite the regions written by the earlier ones in a different order
+            tp::JobSemaphore lastSemaphore;
+            for (uint32_t jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+                tp::Job job = jobResourcePool->createJob(tp::JobFlag::ParallelRecording);
+                for (uint32_t regionIndex = 0; regionIndex < regionCount; regionIndex++) {
+                    uint64_t srcOffset = regionIndex * regionSize;
+                    uint64_t dstOffset = ((regionIndex + jobIndex) % regionCount) * regionSize;
+                    job.cmdFillBuffer(tempBuffer->getView(srcOffset, regionSize), jobIndex * regionCount + regionIndex);
+                    job.cmdCopyBuffer(
+                        *tempBuffer, *hostBuffer, { tp::BufferCopyRegion{ srcOffset, dstOffset, regionSize } });
+                }
+                job.cmdExportResource(*hostBuffer, tp::ReadAccess::Host);
+                lastSemaphore = device->enqueueJob(queue, std::move(job));
+            }
+
+            device->submitQueuedJobs(queue);
+            device->waitForJobSemaphores({ lastSemaphore });
+
+            tp::HostReadableMemory readAccess = hostBuffer->mapForHostRead();
+            Assert::IsFalse(readAccess.isNull());
+            tp::ArrayView<const uint32_t> values = readAccess.getArrayView<uint32_t>();
+            return std::vector<uint32_t>(values.begin(), values.end());
+        };
+
+        std::vector<uint32_t> serialValues = runJobs(0);
+        std::vector<uint32_t> parallelValues = runJobs(4);
+        Assert::IsTrue(serialValues == parallelValues);
+
+        // Also check the values themselves, in case both got them wrong the same way
+        uint32_t lastJobIndex = jobCount - 1;
+        for (uint32_t regionIndex = 0; regionIndex < regionCount; regionIndex++) {
+            uint32_t srcRegionIndex = (regionIndex + regionCount - lastJobIndex % regionCount) % regionCount;
+            uint32_t expectedValue = lastJobIndex * regionCount + srcRegionIndex;
+            Assert::AreEqual(expectedValue, parallelValues[regionIndex * regionSize / sizeof(uint32_t)]);
+        }
+    }
 };
 
 }
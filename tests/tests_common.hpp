@@ -4,6 +4,7 @@
 #include "CppUnitTest.h"
 #include <tephra/tephra.hpp>
 #include <tephra/utils/standard_report_handler.hpp>
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -25,7 +26,11 @@ public:
         Logger::WriteMessage("\n");
 
         if (message.severity == tp::DebugMessageSeverity::Error) {
-            tp::utils::StandardReportHandler::triggerDebugTrap();
+            if (isExpectingErrors) {
+                expectedErrorCount++;
+            } else {
+                tp::utils::StandardReportHandler::triggerDebugTrap();
+            }
         }
     }
 
@@ -52,8 +57,21 @@ public:
         return lastCounterValues[static_cast<int>(eventType)];
     }
 
+    // Counts the reported errors instead of trapping, for tests that exercise validation itself
+    void beginExpectingErrors() {
+        isExpectingErrors = true;
+        expectedErrorCount = 0;
+    }
+
+    uint32_t endExpectingErrors() {
+        isExpectingErrors = false;
+        return expectedErrorCount;
+    }
+
 protected:
     std::array<uint64_t, tp::StatisticEventTypeEnumView::size()> lastCounterValues{};
+    std::atomic<bool> isExpectingErrors{ false };
+    std::atomic<uint32_t> expectedErrorCount{ 0 };
 };
 
 inline tp::ShaderModule loadShader(tp::Device* device, std::string path) {